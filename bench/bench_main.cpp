@@ -0,0 +1,353 @@
+// bench/bench_main.cpp - Robo Rex micro-benchmarks
+// Runs each motion/command hot path in a tight loop and prints one JSON
+// line per benchmark on the command channel:
+//   {"bench":"leg_tick_walk","iters":...,"ns_op":...,"cycles_op":...,"allocs_op":...,"bytes_op":...,"stack_bytes":...}
+// Built instead of src/main.cpp by env:bench (host) and env:bench_esp32.
+// tools/rexbench.py captures, compares and checks the results.
+
+#include <Arduino.h>
+
+#include "ServoBus.h"
+#include "LineReader.h"
+#include "CommandRouter.h"
+#include "CommandQueue.h"
+#include "Log.h"
+#include "Mem.h"
+#include "Cycles.h"
+#include "Transport.h"
+#include "Servo_Functions/Neck_Function.h"
+#include "Servo_Functions/Head_Function.h"
+#include "Servo_Functions/Pelvis_Function.h"
+#include "Servo_Functions/Spine_Function.h"
+#include "Servo_Functions/Tail_Function.h"
+#include "Servo_Functions/Leg_Function.h"
+
+#if defined(REX_NATIVE)
+#include <NativeHost.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+// Minimum measured time per benchmark
+#ifndef BENCH_MIN_MS
+#define BENCH_MIN_MS 200
+#endif
+
+// Stack painted below the benchmark's caller to find its peak depth
+#ifndef BENCH_STACK_PROBE
+#define BENCH_STACK_PROBE 4096
+#endif
+
+// ========== Cycle Source ==========
+// Cycles::now() is the CPU cycle counter on the ESP32 but nanoseconds on
+// the host, so host cycles come from the TSC where there is one.
+static inline uint64_t cpuCycles() {
+#if defined(REX_NATIVE) && (defined(__x86_64__) || defined(__i386__))
+  return __rdtsc();
+#else
+  return Cycles::now();
+#endif
+}
+
+static const char* targetName() {
+#if defined(REX_NATIVE)
+  return "native";
+#else
+  return "esp32";
+#endif
+}
+
+// ========== Sink Transport ==========
+// Stands in for the command channel while a benchmark runs: replies and
+// log lines are discarded (so their formatting cost is still measured)
+// and input bytes come from a buffer the pipeline benchmark fills.
+class BenchTransport : public Transport {
+public:
+  const char* name() const override { return "bench"; }
+  bool begin() override { return true; }
+
+  void feed(const char* s) {
+    _in = s;
+    _len = strlen(s);
+    _pos = 0;
+  }
+
+  int available() override { return (int)(_len - _pos); }
+  int read() override { return _pos < _len ? (uint8_t)_in[_pos++] : -1; }
+  int peek() override { return _pos < _len ? (uint8_t)_in[_pos] : -1; }
+  size_t readBytes(char* buf, size_t len) {
+    size_t n = 0;
+    while (n < len && _pos < _len) buf[n++] = _in[_pos++];
+    return n;
+  }
+  size_t write(const uint8_t*, size_t len) override { return len; }
+  int availableForWrite() override { return 4096; }
+  using Transport::write;
+
+private:
+  const char* _in = "";
+  size_t      _len = 0;
+  size_t      _pos = 0;
+};
+
+// ========== Fixture ==========
+static ServoBus       servoBus;
+static LineReader     g_lineReader;
+static BenchTransport g_sink;
+static volatile uint32_t g_blackhole = 0;   // keeps pure results alive
+
+// Same channel map as src/main.cpp
+static void beginMotion() {
+  Neck::Map neckMap;
+  neckMap.yaw = 0;
+  Neck::begin(&servoBus, neckMap);
+
+  Head::Map headMap;
+  headMap.jaw   = 1;
+  headMap.pitch = 2;
+  Head::begin(&servoBus, headMap);
+
+  Pelvis::Map pelvisMap;
+  pelvisMap.roll = 3;
+  Pelvis::begin(&servoBus, pelvisMap);
+
+  Spine::Map spineMap;
+  spineMap.spineYaw = 4;
+  Spine::begin(&servoBus, spineMap);
+
+  Tail::Map tailMap;
+  tailMap.wag = 5;
+  Tail::begin(&servoBus, tailMap);
+
+  Leg::Map legMap;
+  legMap.R_hipX  = 6;
+  legMap.R_hipY  = 7;
+  legMap.R_knee  = 8;
+  legMap.R_ankle = 9;
+  legMap.R_foot  = 10;
+  legMap.L_hipX  = 11;
+  legMap.L_hipY  = 12;
+  legMap.L_knee  = 13;
+  legMap.L_ankle = 14;
+  legMap.L_foot  = 15;
+  Leg::begin(&servoBus, legMap);
+
+  CommandRouter::begin(&servoBus);
+  CommandQueue::begin();
+
+  for (uint8_t ch = 0; ch < 16; ch++) {
+    servoBus.attach(ch);
+  }
+}
+
+// Mirrors handleCommand() in src/main.cpp
+static void handleCommand(char* line, size_t len) {
+  if (!line || !len) return;
+
+  LOG_I("[CMD] RX: %s", Log::text(line, len));
+
+  CommandRouter::handleLine(line, len);
+}
+
+// Wait (briefly) for the drain task so log output from one benchmark is
+// not formatted on another benchmark's clock
+static void settleLog() {
+  for (uint8_t i = 0; i < 100 && Log::pending(); ++i) delay(1);
+}
+
+// The router parses lines in place, so literals go through a line buffer
+// like LineReader's
+static char g_line[LINE_READER_MAX_LINE + 1];
+static size_t lineOf(const char* lit) {
+  const size_t len = strlen(lit);
+  memcpy(g_line, lit, len + 1);
+  return len;
+}
+static void handleLit(const char* line) { CommandRouter::handleLine(g_line, lineOf(line)); }
+
+// Angles vary per iteration so the skip-unchanged paths never short-cut
+static inline float sweepDeg(uint32_t i) { return 30.0f + (float)(i & 63); }
+
+// ========== Benchmarks ==========
+struct Bench {
+  const char* name;
+  void (*prepare)();
+  void (*run)(uint32_t i);
+};
+
+static const char kJsonLine[] =
+  "{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"move_forward\",\"phase\":\"start\"}";
+static const char kPipelineInput[] = "rex_posture 0.5\n";
+
+static const Bench kBenches[] = {
+  { "servo_deg_to_us", nullptr,
+    [](uint32_t i) { g_blackhole += servoBus.degToUs(6, sweepDeg(i)); } },
+  { "servo_write_deg_gpio", nullptr,
+    [](uint32_t i) { servoBus.writeDegrees(0, sweepDeg(i)); } },
+  { "servo_write_deg_pca", nullptr,
+    [](uint32_t i) { servoBus.writeDegrees(6, sweepDeg(i)); } },
+  { "leg_tick_idle", [] { Leg::stop(); },
+    [](uint32_t) { Leg::tick(); } },
+  { "leg_tick_walk", [] { Leg::walkForward(1.0f); },
+    [](uint32_t) { Leg::tick(); } },
+  { "router_line_verb", nullptr,
+    [](uint32_t) { handleLit("rex_stride_set 0.6"); } },
+  { "router_line_json", nullptr,
+    [](uint32_t i) {
+      handleLit(kJsonLine);
+      if ((i & 15) == 15) CommandRouter::tick();
+    } },
+  { "handle_command", nullptr,
+    [](uint32_t) { handleCommand(g_line, lineOf("rex_posture 0.5")); } },
+  { "pipeline_rx_line", nullptr,
+    [](uint32_t) {
+      // RX bytes -> LineReader -> handleCommand, as loop() does
+      g_sink.feed(kPipelineInput);
+      g_lineReader.poll(g_sink);
+      char* data;
+      size_t len;
+      while (g_lineReader.next(data, len) == LineReader::LINE) {
+        handleCommand(data, len);
+      }
+    } },
+};
+
+struct Result {
+  uint32_t iters;
+  double   nsOp;
+  double   cyclesOp;
+  double   allocsOp;
+  double   bytesOp;
+  uint32_t stackBytes;
+};
+
+// ---------------- Peak stack ----------------
+// Paint BENCH_STACK_PROBE bytes below the caller, run one iteration from
+// the same caller, then find the deepest byte it overwrote. Both probes
+// are the same function called from the same frame, so their buffers
+// line up (the read-back sees what the paint pass left, hence the pragma).
+// BENCH_STACK_PROBE means "at least".
+static const uint8_t kPaint = 0xA5;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+static __attribute__((noinline)) uint32_t stackProbe(bool paint) {
+  volatile uint8_t pad[BENCH_STACK_PROBE];
+  if (paint) {
+    for (uint32_t i = 0; i < sizeof(pad); ++i) pad[i] = kPaint;
+    return 0;
+  }
+  uint32_t untouched = 0;
+  while (untouched < sizeof(pad) && pad[untouched] == kPaint) ++untouched;
+  return (uint32_t)sizeof(pad) - untouched;
+}
+#pragma GCC diagnostic pop
+
+static __attribute__((noinline)) uint32_t peakStack(const Bench& b, uint32_t i) {
+  stackProbe(true);
+  b.run(i);
+  return stackProbe(false);
+}
+
+static Result measure(const Bench& b) {
+  if (b.prepare) b.prepare();
+  for (uint32_t i = 0; i < 64; ++i) b.run(i);   // warm caches and lazy init
+  settleLog();
+
+  Result r = {};
+  r.stackBytes = peakStack(b, 64);
+  settleLog();
+
+  uint64_t ns = 0;
+  uint64_t cycles = 0;
+  uint32_t batch = 16;
+  const uint32_t allocs0 = Mem::allocs();
+  const uint32_t bytes0 = Mem::allocBytes();
+
+  while (ns < (uint64_t)BENCH_MIN_MS * 1000000ULL) {
+    const uint64_t c0 = cpuCycles();
+    const uint32_t t0 = Cycles::now();
+    for (uint32_t k = 0; k < batch; ++k) b.run(r.iters + k);
+    const uint32_t t1 = Cycles::now();
+    const uint64_t c1 = cpuCycles();
+
+    ns += Cycles::toNs(t1 - t0);
+    cycles += c1 - c0;
+    r.iters += batch;
+    if (batch < 1024) batch *= 2;
+
+    // Between batches: let the log drain catch up and feed the watchdog
+    settleLog();
+    yield();
+  }
+
+  r.nsOp     = (double)ns / r.iters;
+  r.cyclesOp = (double)cycles / r.iters;
+  r.allocsOp = (double)(Mem::allocs() - allocs0) / r.iters;
+  r.bytesOp  = (double)(Mem::allocBytes() - bytes0) / r.iters;
+  return r;
+}
+
+static void runAll() {
+  Transport& out = defaultTransport();
+
+#if defined(ARDUINO_ARCH_ESP32)
+  out.printf("{\"suite\":\"rexbench\",\"target\":\"%s\",\"cpu_mhz\":%u,\"min_ms\":%u}\r\n",
+             targetName(), (unsigned)getCpuFrequencyMhz(), (unsigned)BENCH_MIN_MS);
+#else
+  out.printf("{\"suite\":\"rexbench\",\"target\":\"%s\",\"min_ms\":%u}\r\n",
+             targetName(), (unsigned)BENCH_MIN_MS);
+#endif
+
+  for (const Bench& b : kBenches) {
+    setConsole(g_sink);
+    const Result r = measure(b);
+    settleLog();
+    setConsole(defaultTransport());
+
+    out.printf("{\"bench\":\"%s\",\"iters\":%u,\"ns_op\":%.1f,\"cycles_op\":%.1f,"
+               "\"allocs_op\":%.3f,\"bytes_op\":%.1f,\"stack_bytes\":%u}\r\n",
+               b.name, (unsigned)r.iters, r.nsOp, r.cyclesOp, r.allocsOp, r.bytesOp,
+               (unsigned)r.stackBytes);
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  out.printf("{\"suite_done\":true,\"stack_free\":%u,\"heap_free\":%u}\r\n",
+             (unsigned)uxTaskGetStackHighWaterMark(nullptr), (unsigned)ESP.getFreeHeap());
+#else
+  out.printf("{\"suite_done\":true}\r\n");
+#endif
+}
+
+// ========== Arduino Entry Points ==========
+void setup() {
+  Serial.begin(115200);
+#if !defined(REX_NATIVE)
+  delay(2000);  // let the USB/UART monitor attach before results stream
+#endif
+
+  if (!console().begin()) {
+    Serial.println(F("[Bench] ERROR: command channel failed to open"));
+  }
+  Log::begin();
+
+  servoBus.begin();
+  beginMotion();
+  settleLog();
+
+  runAll();
+}
+
+void loop() {
+#if defined(REX_NATIVE)
+  NativeHost::requestStop();
+#else
+  // Send any line to run the suite again
+  g_lineReader.poll(console());
+  char* data;
+  size_t len;
+  if (g_lineReader.next(data, len) != LineReader::NONE) runAll();
+  delay(10);
+#endif
+}
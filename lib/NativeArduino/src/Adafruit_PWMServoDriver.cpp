@@ -0,0 +1,115 @@
+#include "Adafruit_PWMServoDriver.h"
+#include "NativeHost.h"
+#include <stdio.h>
+
+// PCA9685 registers used by the driver
+static const uint8_t PCA9685_MODE1     = 0x00;
+static const uint8_t PCA9685_LED0_ON_L = 0x06;
+static const uint8_t PCA9685_PRESCALE  = 0xFE;
+static const uint8_t MODE1_SLEEP       = 0x10;
+static const uint8_t MODE1_AI          = 0x20;
+static const uint8_t MODE1_RESTART     = 0x80;
+
+uint8_t Adafruit_PWMServoDriver::read8(uint8_t reg) {
+  _i2c->beginTransmission(_addr);
+  _i2c->write(reg);
+  _i2c->endTransmission();
+  _i2c->requestFrom(_addr, (uint8_t)1);
+  const int v = _i2c->read();
+  return v < 0 ? 0 : (uint8_t)v;
+}
+
+uint8_t Adafruit_PWMServoDriver::write8(uint8_t reg, uint8_t value) {
+  _i2c->beginTransmission(_addr);
+  _i2c->write(reg);
+  _i2c->write(value);
+  return _i2c->endTransmission();
+}
+
+// The library would dereference a null I2C device here
+bool Adafruit_PWMServoDriver::begun(const char* call) {
+  if (_dev) return true;
+  if (!_warned) {
+    fprintf(stderr, "[Adafruit_PWMServoDriver] %s() before begin() refused\n", call);
+    _warned = true;
+  }
+  return false;
+}
+
+// Like the library: a new device each call, which exists from here on
+// even though begin() fails when nothing answers at the address
+bool Adafruit_PWMServoDriver::begin(uint8_t prescale) {
+  delete _dev;
+  _dev = new Device{_addr};
+  _i2c->beginTransmission(_addr);
+  if (_i2c->endTransmission() != 0) return false;
+  reset();
+  if (prescale) {
+    write8(PCA9685_PRESCALE, prescale);
+  } else {
+    setPWMFreq(1000);
+  }
+  return true;
+}
+
+void Adafruit_PWMServoDriver::reset() {
+  write8(PCA9685_MODE1, MODE1_RESTART);
+  delay(10);
+}
+
+void Adafruit_PWMServoDriver::sleep() {
+  if (!begun("sleep")) return;
+  write8(PCA9685_MODE1, read8(PCA9685_MODE1) | MODE1_SLEEP);
+  delay(5);
+}
+
+void Adafruit_PWMServoDriver::wakeup() {
+  if (!begun("wakeup")) return;
+  write8(PCA9685_MODE1, read8(PCA9685_MODE1) & ~MODE1_SLEEP);
+}
+
+void Adafruit_PWMServoDriver::setPWMFreq(float freq) {
+  if (!begun("setPWMFreq")) return;
+  freq = constrain(freq, 1.0f, 3500.0f);
+  const float prescale = ((float)_oscillator / (freq * 4096.0f)) + 0.5f - 1.0f;
+  const uint8_t oldmode = read8(PCA9685_MODE1);
+  write8(PCA9685_MODE1, (oldmode & ~MODE1_RESTART) | MODE1_SLEEP);
+  write8(PCA9685_PRESCALE, (uint8_t)constrain(prescale, 3.0f, 255.0f));
+  write8(PCA9685_MODE1, oldmode);
+  delay(5);
+  write8(PCA9685_MODE1, oldmode | MODE1_RESTART | MODE1_AI);
+}
+
+uint8_t Adafruit_PWMServoDriver::setPWM(uint8_t num, uint16_t on, uint16_t off) {
+  if (!begun("setPWM")) return 4;   // Wire's "other error"
+  _i2c->beginTransmission(_addr);
+  _i2c->write((uint8_t)(PCA9685_LED0_ON_L + 4 * num));
+  _i2c->write((uint8_t)on);
+  _i2c->write((uint8_t)(on >> 8));
+  _i2c->write((uint8_t)off);
+  _i2c->write((uint8_t)(off >> 8));
+  const uint8_t err = _i2c->endTransmission();
+  if (err == 0 && num < 16) {
+    _on[num] = on;
+    _off[num] = off;
+    NativeHost::setPcaCounts(_addr, num, off);
+  }
+  return err;
+}
+
+void Adafruit_PWMServoDriver::setPin(uint8_t num, uint16_t val, bool invert) {
+  val = val > 4095 ? 4095 : val;
+  if (invert) val = 4095 - val;
+  if (val == 4095) {
+    setPWM(num, 4096, 0);
+  } else if (val == 0) {
+    setPWM(num, 0, 4096);
+  } else {
+    setPWM(num, 0, val);
+  }
+}
+
+uint16_t Adafruit_PWMServoDriver::getPWM(uint8_t num, bool off) const {
+  if (num >= 16) return 0;
+  return off ? _off[num] : _on[num];
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "Wire.h"
+
+// ========== Adafruit_PWMServoDriver (host stand-in) ==========
+// Every register access is a real TwoWire transaction, so an absent chip
+// fails the same way and bus time is accounted. MODE1 updates are
+// read-modify-write like the library's. Output counts are recorded per
+// port in NativeHost. The library allocates its I2C device in begin(),
+// whether or not the chip answers, and dereferences it in every call
+// after; here begin() allocates a placeholder the same way (so it shows
+// in Mem's counters) and the calls are refused (no bus traffic, setPWM()
+// returns an error) until it has run.
+class Adafruit_PWMServoDriver {
+public:
+  Adafruit_PWMServoDriver(uint8_t addr = 0x40, TwoWire& i2c = Wire) : _addr(addr), _i2c(&i2c) {}
+
+  bool    begin(uint8_t prescale = 0);
+  void    reset();
+  void    sleep();
+  void    wakeup();
+  void    setOscillatorFrequency(uint32_t freq) { _oscillator = freq; }
+  uint32_t getOscillatorFrequency() const { return _oscillator; }
+  void    setPWMFreq(float freq);
+  uint8_t setPWM(uint8_t num, uint16_t on, uint16_t off);
+  void    setPin(uint8_t num, uint16_t val, bool invert = false);
+  uint16_t getPWM(uint8_t num, bool off = false) const;
+
+private:
+  uint8_t read8(uint8_t reg);
+  uint8_t write8(uint8_t reg, uint8_t value);
+  bool    begun(const char* call);
+
+  uint8_t  _addr;
+  TwoWire* _i2c;
+  struct Device { uint8_t addr; };
+  Device*  _dev = nullptr;   // never freed but on a second begin(), like the library's
+  bool     _warned = false;
+  uint32_t _oscillator = 27000000;
+  uint16_t _on[16] = {};
+  uint16_t _off[16] = {};
+};
@@ -0,0 +1,283 @@
+#include "Arduino.h"
+#include "NativeHost.h"
+#include <chrono>
+#include <map>
+#include <stdarg.h>
+#include <thread>
+#include <unistd.h>
+
+// ========== Clock ==========
+
+namespace {
+
+using Mono = std::chrono::steady_clock;
+
+const Mono::time_point g_start = Mono::now();
+NativeHost::ClockMode  g_clockMode = NativeHost::REAL_TIME;
+uint64_t               g_virtualUs = 0;
+bool                   g_stop = false;
+void                 (*g_advanceHook)() = nullptr;
+bool                   g_serialEnabled = true;
+
+bool     g_i2cPresent[128] = {};
+uint32_t g_i2cTransactions = 0;
+uint64_t g_i2cBusyUs = 0;
+
+struct I2cRegs {
+  uint8_t r[256] = {};
+  uint8_t ptr = 0;
+};
+I2cRegs g_i2cRegs[128];   // fixed, so the stand-in itself never allocates
+
+struct I2cOutage {
+  uint64_t atUs;
+  uint64_t untilUs;
+  bool     started;
+};
+std::map<uint8_t, I2cOutage> g_i2cOutage;
+
+uint16_t g_gpioPulse[64] = {};
+struct PcaPorts { uint16_t counts[16] = {}; };
+PcaPorts g_pca[128];
+
+struct I2cDefaults {
+  I2cDefaults() { g_i2cPresent[0x40] = true; }
+} g_i2cDefaults;
+
+} // namespace
+
+void NativeHost::setClockMode(ClockMode mode) {
+  if (mode == g_clockMode) return;
+  // Continue from the current time so timestamps never jump backwards
+  if (mode == VIRTUAL) g_virtualUs = nowUs();
+  g_clockMode = mode;
+}
+
+NativeHost::ClockMode NativeHost::clockMode() { return g_clockMode; }
+
+uint64_t NativeHost::nowUs() {
+  if (g_clockMode == VIRTUAL) return g_virtualUs;
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Mono::now() - g_start).count();
+}
+
+static void advanceVirtual(uint64_t us) {
+  g_virtualUs += us;
+  if (g_advanceHook) g_advanceHook();
+}
+
+void NativeHost::advanceUs(uint64_t us) {
+  if (g_clockMode == VIRTUAL) advanceVirtual(us);
+}
+
+void NativeHost::setAdvanceHook(void (*hook)()) { g_advanceHook = hook; }
+void NativeHost::setSerialEnabled(bool on) { g_serialEnabled = on; }
+
+void NativeHost::requestStop() { g_stop = true; }
+bool NativeHost::stopRequested() { return g_stop; }
+
+// ========== I2C / Output Bookkeeping ==========
+
+void NativeHost::setI2cPresent(uint8_t addr, bool present) { g_i2cPresent[addr & 0x7F] = present; }
+
+void NativeHost::setI2cOutage(uint8_t addr, uint64_t atUs, uint64_t forUs) {
+  g_i2cOutage[addr & 0x7F] = { atUs, atUs + forUs, false };
+}
+
+// Power loss at the start of an outage: registers and outputs clear once
+static bool inOutage(uint8_t addr) {
+  auto it = g_i2cOutage.find(addr);
+  if (it == g_i2cOutage.end()) return false;
+  I2cOutage& o = it->second;
+  const uint64_t now = NativeHost::nowUs();
+  if (now < o.atUs) return false;
+  if (!o.started) {
+    o.started = true;
+    g_i2cRegs[addr] = I2cRegs();
+    g_pca[addr] = PcaPorts();
+  }
+  return now < o.untilUs;
+}
+
+bool NativeHost::i2cPresent(uint8_t addr) {
+  addr &= 0x7F;
+  return g_i2cPresent[addr] && !inOutage(addr);
+}
+
+uint8_t NativeHost::i2cRegister(uint8_t addr, uint8_t reg) {
+  return g_i2cRegs[addr & 0x7F].r[reg];
+}
+
+// Called by TwoWire for acknowledged transfers: a write sets the register
+// pointer and stores the rest, a read returns registers from the pointer
+void nativeI2cWrite(uint8_t addr, const uint8_t* data, size_t len) {
+  if (!len) return;
+  I2cRegs& regs = g_i2cRegs[addr & 0x7F];
+  regs.ptr = data[0];
+  for (size_t i = 1; i < len; ++i) regs.r[regs.ptr++] = data[i];
+}
+
+void nativeI2cRead(uint8_t addr, uint8_t* data, size_t len) {
+  I2cRegs& regs = g_i2cRegs[addr & 0x7F];
+  for (size_t i = 0; i < len; ++i) data[i] = regs.r[regs.ptr++];
+}
+
+uint32_t NativeHost::i2cTransactions() { return g_i2cTransactions; }
+uint64_t NativeHost::i2cBusyUs() { return g_i2cBusyUs; }
+
+// Called by TwoWire for every addressed transfer
+void nativeI2cTransfer(uint32_t busUs) {
+  ++g_i2cTransactions;
+  g_i2cBusyUs += busUs;
+  NativeHost::advanceUs(busUs);
+}
+
+uint16_t NativeHost::gpioPulseUs(uint8_t pin) { return pin < 64 ? g_gpioPulse[pin] : 0; }
+void NativeHost::setGpioPulseUs(uint8_t pin, uint16_t us) { if (pin < 64) g_gpioPulse[pin] = us; }
+
+uint16_t NativeHost::pcaCounts(uint8_t addr, uint8_t port) {
+  inOutage(addr);
+  return port < 16 ? g_pca[addr & 0x7F].counts[port] : 0;
+}
+
+void NativeHost::setPcaCounts(uint8_t addr, uint8_t port, uint16_t counts) {
+  if (port < 16) g_pca[addr & 0x7F].counts[port] = counts;
+}
+
+// ========== Arduino Time API ==========
+
+unsigned long millis() { return (unsigned long)(uint32_t)(NativeHost::nowUs() / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)NativeHost::nowUs(); }
+
+void delayMicroseconds(unsigned int us) {
+  if (g_clockMode == NativeHost::VIRTUAL) {
+    advanceVirtual(us);
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void delay(unsigned long ms) {
+  if (g_clockMode == NativeHost::VIRTUAL) {
+    advanceVirtual((uint64_t)ms * 1000);
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {}
+
+// ========== GPIO ==========
+
+static uint8_t g_pinLevel[64] = {};
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t val) { if (pin < 64) g_pinLevel[pin] = val ? HIGH : LOW; }
+int  digitalRead(uint8_t pin) { return pin < 64 ? g_pinLevel[pin] : LOW; }
+
+// ========== Print ==========
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (!write(*buffer++)) break;
+    ++n;
+  }
+  return n;
+}
+
+static size_t printNumber(Print& p, unsigned long v, int base, bool negative) {
+  if (base < 2) base = DEC;
+  char buf[8 * sizeof(long) + 2];
+  char* s = &buf[sizeof(buf) - 1];
+  *s = '\0';
+  do {
+    const unsigned d = (unsigned)(v % (unsigned)base);
+    *--s = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+    v /= (unsigned)base;
+  } while (v);
+  if (negative) *--s = '-';
+  return p.write(s);
+}
+
+size_t Print::print(long v, int base) {
+  if (base == DEC && v < 0) return printNumber(*this, 0UL - (unsigned long)v, base, true);
+  return printNumber(*this, (unsigned long)v, base, false);
+}
+
+size_t Print::print(unsigned long v, int base) { return printNumber(*this, v, base, false); }
+
+size_t Print::print(double v, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, v);
+  return write(buf);
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  const int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n <= 0) return 0;
+  return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+// ========== Serial ==========
+
+HardwareSerial Serial;
+
+// Unbuffered so boot prints interleave correctly with the stdio transport
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (!g_serialEnabled) return size;
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n = ::write(STDOUT_FILENO, buffer + done, size - done);
+    if (n <= 0) break;
+    done += (size_t)n;
+  }
+  return done;
+}
+
+void HardwareSerial::flush() {}
+
+// ========== Entry Point ==========
+// Runs setup() once, then loop() until stopped. Options:
+//   --virtual   use the virtual clock (also REX_CLOCK=virtual)
+//   --ms N      stop after N ms of firmware time
+//   --loops N   stop after N loop() calls
+//   --pca-outage AT:FOR   the PCA9685 (0x40) loses power at AT ms for FOR ms
+//               (0:FOR = missing at boot)
+
+__attribute__((weak)) int main(int argc, char** argv) {
+  uint64_t runUs = 0;
+  unsigned long loops = 0;
+
+  const char* clock = getenv("REX_CLOCK");
+  if (clock && strcmp(clock, "virtual") == 0) NativeHost::setClockMode(NativeHost::VIRTUAL);
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--virtual") == 0) {
+      NativeHost::setClockMode(NativeHost::VIRTUAL);
+    } else if (strcmp(argv[i], "--ms") == 0 && i + 1 < argc) {
+      runUs = strtoull(argv[++i], nullptr, 10) * 1000ULL;
+    } else if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc) {
+      loops = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--pca-outage") == 0 && i + 1 < argc) {
+      unsigned long atMs = 0, forMs = 0;
+      if (sscanf(argv[++i], "%lu:%lu", &atMs, &forMs) == 2) {
+        NativeHost::setI2cOutage(0x40, atMs * 1000ULL, forMs * 1000ULL);
+      }
+    } else {
+      fprintf(stderr, "usage: %s [--virtual] [--ms N] [--loops N] [--pca-outage AT:FOR]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  setup();
+  for (unsigned long n = 0; !NativeHost::stopRequested(); ++n) {
+    if (loops && n >= loops) break;
+    if (runUs && NativeHost::nowUs() >= runUs) break;
+    loop();
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+// ========== Arduino core (host stand-in) ==========
+// Minimal host implementation of the Arduino API used by the firmware, for
+// env:native. Time comes from NativeHost's clock (real or virtual).
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#ifndef PI
+#define PI      3.1415926535897932384626433832795
+#endif
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI  6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define LOW    0x0
+#define HIGH   0x1
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+// ---------------- Time ----------------
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// ---------------- GPIO ----------------
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+
+// ---------------- Math helpers ----------------
+template <typename T, typename L, typename H>
+inline T constrain(T amt, L low, H high) {
+  return amt < (T)low ? (T)low : (amt > (T)high ? (T)high : amt);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ---------------- Sketch entry points ----------------
+void setup();
+void loop();
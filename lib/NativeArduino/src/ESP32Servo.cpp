@@ -0,0 +1,37 @@
+#include "ESP32Servo.h"
+#include "NativeHost.h"
+
+int Servo::attach(int pin, int minUs, int maxUs) {
+  if (pin < 0 || pin >= 64) return 0;
+  _pin = pin;
+  _min = minUs;
+  _max = maxUs;
+  return 1;
+}
+
+void Servo::detach() {
+  if (_pin < 0) return;
+  NativeHost::setGpioPulseUs((uint8_t)_pin, 0);
+  _pin = -1;
+  _us = 0;
+}
+
+// Values below the minimum pulse are angles, as in the real library
+void Servo::write(int value) {
+  if (value < _min) {
+    value = constrain(value, 0, 180);
+    value = (int)map(value, 0, 180, _min, _max);
+  }
+  writeMicroseconds(value);
+}
+
+void Servo::writeMicroseconds(int value) {
+  if (_pin < 0) return;
+  _us = constrain(value, _min, _max);
+  NativeHost::setGpioPulseUs((uint8_t)_pin, (uint16_t)_us);
+}
+
+int Servo::read() const {
+  if (_max == _min) return 0;
+  return (int)map(_us, _min, _max, 0, 180);
+}
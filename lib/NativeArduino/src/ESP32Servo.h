@@ -0,0 +1,32 @@
+#pragma once
+#include "Arduino.h"
+
+// ========== ESP32Servo (host stand-in) ==========
+// Same interface as madhephaestus/ESP32Servo. Pulses are recorded per pin
+// in NativeHost so a simulator can observe what the GPIO channels output.
+class ESP32PWM {
+public:
+  static void allocateTimer(int timerNumber) { (void)timerNumber; }
+};
+
+class Servo {
+public:
+  static const int DEFAULT_MIN_US = 544;
+  static const int DEFAULT_MAX_US = 2400;
+
+  int  attach(int pin) { return attach(pin, DEFAULT_MIN_US, DEFAULT_MAX_US); }
+  int  attach(int pin, int minUs, int maxUs);
+  void detach();
+  bool attached() const { return _pin >= 0; }
+
+  void write(int value);
+  void writeMicroseconds(int value);
+  int  read() const;
+  int  readMicroseconds() const { return _us; }
+
+private:
+  int _pin = -1;
+  int _min = DEFAULT_MIN_US;
+  int _max = DEFAULT_MAX_US;
+  int _us = 0;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include "Arduino.h"
+#include <memory>
+
+// ========== File (host stand-in) ==========
+// The subset of the ESP32 fs::File API the firmware uses: sequential
+// read/write, seek, size and directory listing. Files are byte vectors
+// held by the filesystem (see LittleFS.h); a write handle replaces the
+// file's contents when it is closed.
+#define FILE_READ  "r"
+#define FILE_WRITE "w"
+
+class LittleFSFS;
+
+class File : public Stream {
+public:
+  File() = default;
+
+  explicit operator bool() const { return _impl != nullptr; }
+
+  size_t read(uint8_t* buf, size_t size);
+  size_t write(const uint8_t* buf, size_t size) override;
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  using Print::write;
+
+  int    available() override;
+  int    read() override;
+  int    peek() override;
+
+  bool   seek(uint32_t pos);
+  size_t position() const;
+  size_t size() const;
+  void   close();
+
+  const char* name() const;    // base name, as on the ESP32
+  const char* path() const;
+  bool        isDirectory() const;
+  File        openNextFile();
+
+private:
+  friend class LittleFSFS;
+  struct Impl;
+  std::shared_ptr<Impl> _impl;
+};
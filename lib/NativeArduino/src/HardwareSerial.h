@@ -0,0 +1,23 @@
+#pragma once
+#include "Stream.h"
+
+// ========== HardwareSerial (host stand-in) ==========
+// Serial carries the boot diagnostics to stdout. It has no input: the
+// command channel on the host is HostTransport (see src/HostTransport.h).
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+  operator bool() const { return true; }
+
+  int    available() override { return 0; }
+  int    read() override { return -1; }
+  int    peek() override { return -1; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int    availableForWrite() override { return 4096; }
+  void   flush() override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
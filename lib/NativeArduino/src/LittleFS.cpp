@@ -0,0 +1,230 @@
+#include "LittleFS.h"
+#include <dirent.h>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+LittleFSFS LittleFS;
+
+// Size of the "spiffs" partition in the default ESP32 partition table
+static const size_t kPartitionBytes = 0x160000;
+
+// ---------------- Store ----------------
+// "/<name>" -> contents; the filesystem is flat like the firmware uses it
+static std::map<std::string, std::vector<uint8_t>>& store() {
+  static std::map<std::string, std::vector<uint8_t>> s;
+  return s;
+}
+
+static std::string diskPath(const std::string& path) {
+  const char* dir = getenv("REX_FS");
+  return (dir && *dir) ? std::string(dir) + path : std::string();
+}
+
+static void saveToDisk(const std::string& path, const std::vector<uint8_t>& data) {
+  const std::string disk = diskPath(path);
+  if (disk.empty()) return;
+  FILE* f = fopen(disk.c_str(), "wb");
+  if (!f || fwrite(data.data(), 1, data.size(), f) != data.size()) perror(disk.c_str());
+  if (f) fclose(f);
+}
+
+static void loadFromDisk() {
+  const char* dir = getenv("REX_FS");
+  if (!dir || !*dir) return;
+  DIR* d = opendir(dir);
+  if (!d) return;
+  while (struct dirent* e = readdir(d)) {
+    if (e->d_name[0] == '.') continue;
+    const std::string path = std::string("/") + e->d_name;
+    FILE* f = fopen(diskPath(path).c_str(), "rb");
+    if (!f) continue;
+    std::vector<uint8_t> data;
+    uint8_t chunk[256];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+    store()[path] = data;
+  }
+  closedir(d);
+}
+
+// In memory it is always formatted; on disk when the directory exists
+static bool formatted() {
+  const char* dir = getenv("REX_FS");
+  if (!dir || !*dir) return true;
+  struct stat st;
+  return stat(dir, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static std::string normalize(const char* path) {
+  if (!path) return std::string();
+  return path[0] == '/' ? std::string(path) : std::string("/") + path;
+}
+
+// ---------------- File ----------------
+struct File::Impl {
+  std::string path;
+  bool dir = false;
+  bool writing = false;
+  std::vector<uint8_t> data;            // snapshot (read) or pending contents (write)
+  size_t pos = 0;
+  std::vector<std::string> entries;     // directory listing
+  size_t next = 0;
+
+  ~Impl() { if (writing) commit(); }
+
+  void commit() {
+    store()[path] = data;
+    saveToDisk(path, data);
+    writing = false;
+  }
+};
+
+size_t File::read(uint8_t* buf, size_t size) {
+  if (!_impl || _impl->dir) return 0;
+  const size_t left = _impl->data.size() - _impl->pos;
+  const size_t n = size < left ? size : left;
+  memcpy(buf, _impl->data.data() + _impl->pos, n);
+  _impl->pos += n;
+  return n;
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+  if (!_impl || !_impl->writing) return 0;
+  auto& d = _impl->data;
+  if (_impl->pos + size > d.size()) d.resize(_impl->pos + size);
+  memcpy(d.data() + _impl->pos, buf, size);
+  _impl->pos += size;
+  return size;
+}
+
+int File::available() {
+  if (!_impl || _impl->dir) return 0;
+  return (int)(_impl->data.size() - _impl->pos);
+}
+
+int File::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int File::peek() {
+  if (!_impl || _impl->dir || _impl->pos >= _impl->data.size()) return -1;
+  return _impl->data[_impl->pos];
+}
+
+bool File::seek(uint32_t pos) {
+  if (!_impl || _impl->dir || pos > _impl->data.size()) return false;
+  _impl->pos = pos;
+  return true;
+}
+
+size_t File::position() const { return _impl ? _impl->pos : 0; }
+size_t File::size() const { return _impl ? _impl->data.size() : 0; }
+
+void File::close() {
+  if (_impl && _impl->writing) _impl->commit();
+  _impl.reset();
+}
+
+const char* File::name() const {
+  if (!_impl) return "";
+  const size_t slash = _impl->path.rfind('/');
+  return _impl->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char* File::path() const { return _impl ? _impl->path.c_str() : ""; }
+bool File::isDirectory() const { return _impl && _impl->dir; }
+
+File File::openNextFile() {
+  File f;
+  if (!_impl || !_impl->dir || _impl->next >= _impl->entries.size()) return f;
+  return LittleFS.open(_impl->entries[_impl->next++].c_str(), FILE_READ);
+}
+
+// ---------------- LittleFS ----------------
+bool LittleFSFS::begin(bool formatOnFail, const char*, uint8_t, const char*) {
+  if (_mounted) return true;
+  if (!formatted() && !(formatOnFail && format())) return false;
+  loadFromDisk();
+  _mounted = true;
+  return true;
+}
+
+// Erases every file (on disk too) and leaves the filesystem unmounted
+bool LittleFSFS::format() {
+  _mounted = false;
+  store().clear();
+  const char* dir = getenv("REX_FS");
+  if (!dir || !*dir) return true;
+  if (DIR* d = opendir(dir)) {
+    while (struct dirent* e = readdir(d)) {
+      if (e->d_name[0] != '.') ::remove(diskPath(std::string("/") + e->d_name).c_str());
+    }
+    closedir(d);
+    return true;
+  }
+  if (mkdir(dir, 0755) != 0) {
+    perror(dir);
+    return false;
+  }
+  return true;
+}
+
+File LittleFSFS::open(const char* path, const char* mode) {
+  File f;
+  if (!_mounted) return f;
+  const std::string p = normalize(path);
+  auto impl = std::make_shared<File::Impl>();
+  impl->path = p;
+
+  if (p == "/") {
+    impl->dir = true;
+    for (const auto& kv : store()) impl->entries.push_back(kv.first);
+  } else if (mode && mode[0] == 'w') {
+    impl->writing = true;
+  } else {
+    auto it = store().find(p);
+    if (it == store().end()) return f;
+    impl->data = it->second;
+  }
+  f._impl = impl;
+  return f;
+}
+
+bool LittleFSFS::exists(const char* path) {
+  const std::string p = normalize(path);
+  return _mounted && (p == "/" || store().count(p) > 0);
+}
+
+bool LittleFSFS::remove(const char* path) {
+  if (!_mounted || store().erase(normalize(path)) == 0) return false;
+  const std::string disk = diskPath(normalize(path));
+  if (!disk.empty()) ::remove(disk.c_str());
+  return true;
+}
+
+bool LittleFSFS::rename(const char* from, const char* to) {
+  const std::string a = normalize(from), b = normalize(to);
+  auto it = store().find(a);
+  if (!_mounted || it == store().end()) return false;
+  std::vector<uint8_t> data = std::move(it->second);
+  store().erase(it);
+  store()[b] = data;
+  const std::string da = diskPath(a), db = diskPath(b);
+  if (!da.empty()) ::rename(da.c_str(), db.c_str());
+  return true;
+}
+
+size_t LittleFSFS::totalBytes() { return kPartitionBytes; }
+
+size_t LittleFSFS::usedBytes() {
+  // LittleFS allocates whole 4 KiB blocks
+  size_t used = 0;
+  for (const auto& kv : store()) used += (kv.second.size() + 4095) / 4096 * 4096;
+  return used;
+}
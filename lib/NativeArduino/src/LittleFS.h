@@ -0,0 +1,29 @@
+#pragma once
+#include "FS.h"
+
+// ========== LittleFS (host stand-in) ==========
+// A flat in-memory filesystem. With REX_FS=<directory> it starts from
+// that directory's files and writes every closed file back to it, so
+// uploaded shows survive a restart of the host program. A directory that
+// does not exist is an unformatted partition: begin(false) fails until
+// format() (or begin(true)) creates it.
+class LittleFSFS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+             uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+  void end() { _mounted = false; }
+  bool format();
+
+  File open(const char* path, const char* mode = FILE_READ);
+  bool exists(const char* path);
+  bool remove(const char* path);
+  bool rename(const char* from, const char* to);
+
+  size_t totalBytes();
+  size_t usedBytes();
+
+private:
+  bool _mounted = false;
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+// ========== Native Host Control ==========
+// Hooks for the host build that have no Arduino equivalent: which clock
+// drives millis()/micros(), when the run loop stops, which I2C devices
+// answer, and what the stand-in drivers last put on each output.
+//
+// Clock modes:
+//   REAL_TIME  millis()/micros() follow the host monotonic clock and
+//              delay() sleeps, so tools see device-like pacing
+//   VIRTUAL    time only moves when the firmware waits (delay(),
+//              delayMicroseconds()) or spends bus time on I2C, so a run
+//              completes as fast as the host can execute it while every
+//              timestamp stays consistent
+namespace NativeHost {
+
+enum ClockMode : uint8_t { REAL_TIME, VIRTUAL };
+
+void      setClockMode(ClockMode mode);
+ClockMode clockMode();
+
+// Current time in microseconds since start (64-bit, never wraps)
+uint64_t nowUs();
+
+// Move virtual time forward; no-op in REAL_TIME mode
+void advanceUs(uint64_t us);
+
+// Called after every virtual time step (delay(), I2C bus time, advanceUs)
+// so a simulation can integrate up to nowUs(). The hook must not wait.
+void setAdvanceHook(void (*hook)());
+
+// ---------------- Serial ----------------
+// Serial writes to stdout unless disabled (keeps tool output clean)
+void setSerialEnabled(bool on);
+
+// ---------------- Run loop ----------------
+void requestStop();
+bool stopRequested();
+
+// ---------------- I2C bus ----------------
+// Devices that ACK their address; 0x40 (PCA9685) is present by default
+void     setI2cPresent(uint8_t addr, bool present);
+bool     i2cPresent(uint8_t addr);
+uint32_t i2cTransactions();
+uint64_t i2cBusyUs();
+
+// Each present device has a 256-byte register file: the first byte of a
+// write sets the register pointer, later bytes (and reads) auto-increment
+uint8_t  i2cRegister(uint8_t addr, uint8_t reg);
+
+// Fault injection: from atUs on, the device at addr NACKs for forUs as if
+// it had lost power. Its registers and outputs are back at 0 (power-on,
+// servos limp) from the start of the outage. One outage per address.
+void     setI2cOutage(uint8_t addr, uint64_t atUs, uint64_t forUs);
+
+// ---------------- Outputs ----------------
+// Last pulse width written to a GPIO servo pin (0 = detached/never)
+uint16_t gpioPulseUs(uint8_t pin);
+void     setGpioPulseUs(uint8_t pin, uint16_t us);
+
+// Last PCA9685 off-count for a port on the driver at addr (0 = off)
+uint16_t pcaCounts(uint8_t addr, uint8_t port);
+void     setPcaCounts(uint8_t addr, uint8_t port, uint16_t counts);
+
+} // namespace NativeHost
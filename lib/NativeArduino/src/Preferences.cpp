@@ -0,0 +1,89 @@
+#include "Preferences.h"
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// ---------------- Store ----------------
+// "<namespace>.<key>" -> value, shared by every Preferences instance
+static std::map<std::string, std::vector<uint8_t>>& store() {
+  static std::map<std::string, std::vector<uint8_t>> s;
+  return s;
+}
+
+static std::string fullKey(const char* ns, const char* key) {
+  return std::string(ns) + "." + key;
+}
+
+static std::string filePath(const std::string& full) {
+  const char* dir = getenv("REX_NVS");
+  return (dir && *dir) ? std::string(dir) + "/" + full : std::string();
+}
+
+// Loads a key from REX_NVS the first time it is asked for
+static std::vector<uint8_t>* lookup(const std::string& full) {
+  auto& s = store();
+  auto it = s.find(full);
+  if (it != s.end()) return &it->second;
+
+  const std::string path = filePath(full);
+  if (path.empty()) return nullptr;
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return nullptr;
+  std::vector<uint8_t> value;
+  uint8_t chunk[256];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) value.insert(value.end(), chunk, chunk + n);
+  fclose(f);
+  return &(s[full] = value);
+}
+
+// ---------------- Preferences ----------------
+bool Preferences::begin(const char* name, bool readOnly) {
+  if (!name || strlen(name) >= sizeof(_ns)) return false;   // NVS namespaces are at most 15 chars
+  strcpy(_ns, name);
+  _readOnly = readOnly;
+  _open = true;
+  return true;
+}
+
+void Preferences::end() { _open = false; }
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!_open) return 0;
+  const std::vector<uint8_t>* v = lookup(fullKey(_ns, key));
+  return v ? v->size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  if (!_open) return 0;
+  const std::vector<uint8_t>* v = lookup(fullKey(_ns, key));
+  if (!v || v->size() > maxLen) return 0;
+  memcpy(buf, v->data(), v->size());
+  return v->size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (!_open || _readOnly) return 0;
+  const std::string full = fullKey(_ns, key);
+  const uint8_t* p = (const uint8_t*)value;
+  store()[full].assign(p, p + len);
+
+  const std::string path = filePath(full);
+  if (!path.empty()) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f || fwrite(value, 1, len, f) != len) perror(path.c_str());
+    if (f) fclose(f);
+  }
+  return len;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!_open || _readOnly) return false;
+  const std::string full = fullKey(_ns, key);
+  store().erase(full);
+  const std::string path = filePath(full);
+  if (!path.empty()) ::remove(path.c_str());
+  return true;
+}
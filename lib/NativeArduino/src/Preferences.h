@@ -0,0 +1,24 @@
+#pragma once
+#include "Arduino.h"
+
+// ========== Preferences (host stand-in) ==========
+// The byte-blob subset of the ESP32 NVS Preferences API. Values live in
+// memory for the run; with REX_NVS=<directory> each key is also kept in
+// <directory>/<namespace>.<key>, so calibration survives a restart of
+// the host program like it survives a reset on the robot.
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false);
+  void end();
+
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t putBytes(const char* key, const void* value, size_t len);
+  bool   remove(const char* key);
+  bool   isKey(const char* key) { return getBytesLength(key) > 0; }
+
+private:
+  char _ns[16] = { 0 };
+  bool _open = false;
+  bool _readOnly = false;
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include "Print.h"
+
+// ========== Stream (host stand-in) ==========
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  // Reads only what is already buffered (no timeout on the host)
+  virtual size_t readBytes(char* buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+      const int c = read();
+      if (c < 0) break;
+      buffer[n++] = (char)c;
+    }
+    return n;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+
+  void setTimeout(unsigned long ms) { _timeout = ms; }
+
+protected:
+  unsigned long _timeout = 1000;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <string.h>
+
+// ========== String (host stand-in) ==========
+// Just enough of Arduino's String for the firmware: construction from C
+// strings, comparison and c_str(). Backed by std::string.
+class String {
+public:
+  String(const char* s = "") : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return (unsigned int)_s.size(); }
+
+  bool equals(const String& o) const { return _s == o._s; }
+  bool equals(const char* o) const { return o && _s == o; }
+  bool operator==(const String& o) const { return equals(o); }
+  bool operator==(const char* o) const { return equals(o); }
+  bool operator!=(const String& o) const { return !equals(o); }
+  bool operator!=(const char* o) const { return !equals(o); }
+
+  String& operator+=(const String& o) { _s += o._s; return *this; }
+  String& operator+=(const char* o) { if (o) _s += o; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : '\0'; }
+
+  void trim() {
+    const size_t b = _s.find_first_not_of(" \t\r\n");
+    const size_t e = _s.find_last_not_of(" \t\r\n");
+    _s = (b == std::string::npos) ? std::string() : _s.substr(b, e - b + 1);
+  }
+
+private:
+  std::string _s;
+};
@@ -0,0 +1,80 @@
+#include "Wire.h"
+#include "NativeHost.h"
+
+// Arduino.cpp
+void nativeI2cTransfer(uint32_t busUs);
+void nativeI2cWrite(uint8_t addr, const uint8_t* data, size_t len);
+void nativeI2cRead(uint8_t addr, uint8_t* data, size_t len);
+
+TwoWire Wire(0);
+TwoWire Wire1(1);
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  (void)sda;
+  (void)scl;
+  if (frequency) _clock = frequency;
+  _begun = true;
+  return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+  if (!frequency) return false;
+  _clock = frequency;
+  return true;
+}
+
+// Address byte + payload, 9 clocks each, plus ~2 clocks for start/stop
+uint32_t TwoWire::busUs(size_t bytes) const {
+  const uint64_t clocks = (uint64_t)(bytes + 1) * 9 + 2;
+  return (uint32_t)((clocks * 1000000ULL + _clock - 1) / _clock);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  _txAddr = address;
+  _txLen = 0;
+  _inTx = true;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (!_inTx || _txLen >= sizeof(_txBuf)) return 0;
+  _txBuf[_txLen++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+  size_t n = 0;
+  while (n < quantity && write(data[n])) ++n;
+  return n;
+}
+
+// Same codes as the ESP32 core: 0 success, 2 address NACK, 4 bus error
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  if (!_inTx) return 4;
+  _inTx = false;
+  if (!_begun) return 4;
+
+  if (!NativeHost::i2cPresent(_txAddr)) {
+    nativeI2cTransfer(busUs(0));
+    return 2;
+  }
+  nativeI2cWrite(_txAddr, _txBuf, _txLen);
+  nativeI2cTransfer(busUs(_txLen));
+  return 0;
+}
+
+// Reads from the device's register pointer; 0 bytes when it NACKs
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop) {
+  (void)sendStop;
+  _rxLen = _rxPos = 0;
+  if (!_begun) return 0;
+  if (!NativeHost::i2cPresent(address)) {
+    nativeI2cTransfer(busUs(0));
+    return 0;
+  }
+  if (quantity > sizeof(_rxBuf)) quantity = sizeof(_rxBuf);
+  nativeI2cRead(address, _rxBuf, quantity);
+  nativeI2cTransfer(busUs(quantity));
+  _rxLen = quantity;
+  return quantity;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Arduino.h"
+
+// ========== TwoWire (host stand-in) ==========
+// Addressed transfers succeed only for devices marked present in
+// NativeHost (0x40 by default, minus injected outages). Each transfer
+// accounts its bus time (9 clocks per byte incl. ACK, plus start/stop)
+// and, under the virtual clock, moves time forward by it, so I2C cost
+// shows up in profiles. Data goes to and comes from the device's
+// register file in NativeHost.
+class TwoWire : public Stream {
+public:
+  explicit TwoWire(uint8_t busNum) : _busNum(busNum) {}
+
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  bool end() { _begun = false; return true; }
+  bool setClock(uint32_t frequency);
+  uint32_t getClock() const { return _clock; }
+  void     setTimeOut(uint16_t ms) { _timeoutMs = ms; }   // transfers never hang here
+  uint16_t getTimeOut() const { return _timeoutMs; }
+
+  void    beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t* data, size_t quantity) override;
+  int    available() override { return _rxLen - _rxPos; }
+  int    read() override { return _rxPos < _rxLen ? _rxBuf[_rxPos++] : -1; }
+  int    peek() override { return _rxPos < _rxLen ? _rxBuf[_rxPos] : -1; }
+  using Print::write;
+
+private:
+  uint32_t busUs(size_t bytes) const;
+
+  uint8_t  _busNum;
+  bool     _begun = false;
+  uint32_t _clock = 100000;
+  uint16_t _timeoutMs = 50;
+  uint8_t  _txAddr = 0;
+  uint8_t  _txBuf[128];   // ESP32 core buffer size
+  size_t   _txLen = 0;
+  bool     _inTx = false;
+  uint8_t  _rxBuf[128];
+  uint8_t  _rxLen = 0;
+  uint8_t  _rxPos = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,365 @@
+// opt/opt_main.cpp - Robo Rex gait parameter optimizer
+// Samples thousands of gait parameter sets (Leg::setGait amplitudes plus
+// the Leg::Tuning shape constants), runs each through the real gait
+// kernel (Leg::solve) and the kinematic model from sim/ on every CPU
+// core, and keeps the Pareto-optimal sets for three objectives:
+//
+//   speed   forward travel in the walking direction (mm/s, higher is better)
+//   sway    body twist about the stance hip, peak-to-peak per step with
+//           the net turn excluded (deg, lower is better)
+//   margin  closest any commanded joint angle gets to its limit (deg,
+//           higher is better; negative means ServoBus clipped it)
+//
+// Each front member is printed as a block of commands that loads it onto
+// the robot (rex_gait, rex_posture, GAIT_TUNE).
+//
+//   pio run -e opt && .pio/build/opt/program --samples 20000 --commands front.txt
+//   .pio/build/opt/program --range speed=1:1 --range hipx=30:60 --json
+//
+// Built instead of src/main.cpp by env:opt.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "CommandQueue.h"
+#include "Servo_Functions/Leg_Function.h"
+#include "SimModel.h"
+
+// ========== Search Space ==========
+enum Dim : uint8_t {
+  SPEED = 0, STRIDE, LIFT, POSTURE,
+  HIPX, HIPY, KNEE, ANKLE, FOOT, EXP,
+  DIM_COUNT
+};
+
+struct Range {
+  const char* key;
+  float lo, hi;
+};
+
+// Default bounds; --range key=lo:hi narrows or pins a dimension
+static Range g_range[DIM_COUNT] = {
+  { "speed",   0.3f,  2.5f },
+  { "stride",  0.2f,  1.0f },
+  { "lift",    0.2f,  1.0f },
+  { "posture", 0.0f,  1.0f },
+  { "hipx",   10.0f, 70.0f },
+  { "hipy",    0.0f, 60.0f },
+  { "knee",    0.0f, 60.0f },
+  { "ankle",   0.0f, 50.0f },
+  { "foot",    0.0f, 40.0f },
+  { "exp",     0.6f,  3.0f },
+};
+
+struct Score {
+  float speed  = 0.0f;
+  float sway   = 0.0f;
+  float margin = 0.0f;
+};
+
+struct Candidate {
+  float v[DIM_COUNT];
+  Score score;
+};
+
+// ========== Options ==========
+struct Options {
+  const char* mode      = "walk";    // walk | back
+  uint32_t samples      = 4096;
+  uint32_t jobs         = 0;         // 0 = one per hardware thread
+  uint32_t seed         = 1;
+  float    seconds      = 10.0f;     // measured time per candidate
+  float    warmup       = 2.0f;      // settle time excluded from the stats
+  float    minSpeed     = 10.0f;     // mm/s a set must reach to be kept
+  const char* commands  = nullptr;   // front as loadable command blocks
+  bool     json         = false;
+  Sim::Config model;
+};
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "usage: %s [--mode walk|back] [--samples N] [--jobs N] [--seed N]\n"
+    "          [--seconds S] [--warmup S] [--min-speed MM_S] [--range KEY=LO:HI ...]\n"
+    "          [--slew DEG_S] [--tau MS] [--hipx-sign 1|-1]\n"
+    "          [--commands FILE] [--json]\n"
+    "  range keys: speed stride lift posture hipx hipy knee ankle foot exp\n",
+    argv0);
+}
+
+static bool parseRange(const char* spec) {
+  const char* eq = strchr(spec, '=');
+  const char* colon = eq ? strchr(eq, ':') : nullptr;
+  if (!colon) return false;
+  for (uint8_t d = 0; d < DIM_COUNT; ++d) {
+    if (strlen(g_range[d].key) != (size_t)(eq - spec) || strncmp(spec, g_range[d].key, eq - spec)) continue;
+    g_range[d].lo = (float)atof(eq + 1);
+    g_range[d].hi = (float)atof(colon + 1);
+    return g_range[d].lo <= g_range[d].hi;
+  }
+  return false;
+}
+
+static bool parse(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    auto num = [&](float& out) { if (!v) return false; out = (float)atof(v); ++i; return true; };
+    auto count = [&](uint32_t& out) { if (!v) return false; out = (uint32_t)strtoul(v, nullptr, 0); ++i; return true; };
+
+    bool ok = true;
+    if      (!strcmp(a, "--mode"))      { ok = v && (!strcmp(v, "walk") || !strcmp(v, "back")); if (ok) { o.mode = v; ++i; } }
+    else if (!strcmp(a, "--range"))     { ok = v && parseRange(v); ++i; }
+    else if (!strcmp(a, "--commands"))  { ok = v; if (v) { o.commands = v; ++i; } }
+    else if (!strcmp(a, "--samples"))   ok = count(o.samples);
+    else if (!strcmp(a, "--jobs"))      ok = count(o.jobs);
+    else if (!strcmp(a, "--seed"))      ok = count(o.seed);
+    else if (!strcmp(a, "--seconds"))   ok = num(o.seconds);
+    else if (!strcmp(a, "--warmup"))    ok = num(o.warmup);
+    else if (!strcmp(a, "--min-speed")) ok = num(o.minSpeed);
+    else if (!strcmp(a, "--slew"))      ok = num(o.model.slewDegPerS);
+    else if (!strcmp(a, "--tau"))       ok = num(o.model.tauMs);
+    else if (!strcmp(a, "--hipx-sign")) ok = num(o.model.hipXSign);
+    else if (!strcmp(a, "--json"))      o.json = true;
+    else ok = false;
+
+    if (!ok) return false;
+  }
+  return o.samples > 0 && o.seconds > 0.0f;
+}
+
+// ========== Sampling ==========
+// splitmix64 keyed by (seed, index): a sample does not depend on which
+// thread draws it, so results are the same for any --jobs
+static uint64_t mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+static void sample(uint32_t seed, uint32_t index, Candidate& c) {
+  uint64_t state = mix(((uint64_t)seed << 32) | index);
+  for (uint8_t d = 0; d < DIM_COUNT; ++d) {
+    state = mix(state);
+    const float u = (float)(state >> 40) / (float)(1u << 24);
+    c.v[d] = g_range[d].lo + u * (g_range[d].hi - g_range[d].lo);
+  }
+}
+
+// The firmware's current defaults (walkForward(1.0) with Leg's initial gait)
+static void defaults(Candidate& c) {
+  const Leg::Tuning t;
+  const Leg::Gait g;
+  c.v[SPEED]   = 1.0f;
+  c.v[STRIDE]  = g.stride;
+  c.v[LIFT]    = g.lift;
+  c.v[POSTURE] = g.posture;
+  c.v[HIPX]    = t.hipXScale;
+  c.v[HIPY]    = t.hipYScale;
+  c.v[KNEE]    = t.kneeScale;
+  c.v[ANKLE]   = t.ankleScale;
+  c.v[FOOT]    = t.footScale;
+  c.v[EXP]     = t.liftExp;
+}
+
+static Leg::Tuning tuningOf(const Candidate& c) {
+  Leg::Tuning t;
+  t.hipXScale  = c.v[HIPX];
+  t.hipYScale  = c.v[HIPY];
+  t.kneeScale  = c.v[KNEE];
+  t.ankleScale = c.v[ANKLE];
+  t.footScale  = c.v[FOOT];
+  t.liftExp    = c.v[EXP];
+  return t;
+}
+
+// ========== Evaluation ==========
+// Same frame grid and phase arithmetic as Leg::tick() under main.cpp's
+// loop: one solve per CONTROL_PERIOD_MS, phase from whole milliseconds.
+static Score evaluate(const Options& o, const Candidate& c) {
+  const Leg::Tuning t = tuningOf(c);
+  Leg::Gait g;
+  g.stride  = c.v[STRIDE];
+  g.lift    = c.v[LIFT];
+  g.posture = c.v[POSTURE];
+  const Leg::Mode mode = strcmp(o.mode, "back") ? Leg::WALK_FWD : Leg::WALK_BWD;
+
+  const Sim::Channels ch;
+  const Leg::Map& m = ch.legs;
+  const uint8_t chans[2][Leg::JOINT_COUNT] = {
+    { m.R_hipX, m.R_hipY, m.R_knee, m.R_ankle, m.R_foot },
+    { m.L_hipX, m.L_hipY, m.L_knee, m.L_ankle, m.L_foot },
+  };
+
+  Sim::Model model;
+  model.begin(o.model, ch);
+
+  const uint32_t frameMs  = CONTROL_PERIOD_MS;
+  const uint32_t warmupMs = (uint32_t)(o.warmup * 1000.0f);
+  const uint32_t endMs    = warmupMs + (uint32_t)(o.seconds * 1000.0f);
+  float margin = 1e9f;
+  bool  measuring = false;
+
+  for (uint32_t ms = 0; ms < endMs; ms += frameMs) {
+    if (!measuring && ms >= warmupMs) {
+      model.resetStats();
+      measuring = true;
+    }
+
+    const float cycle = ms / 1000.0f * c.v[SPEED];
+    Leg::Pose p;
+    Leg::solve(t, g, mode, cycle - floorf(cycle), p);
+
+    for (uint8_t j = 0; j < Leg::JOINT_COUNT; ++j) {
+      const ServoLimits& lim = Leg::limits((Leg::Joint)j);
+      const float a[2] = { p.right[j], p.left[j] };
+      for (uint8_t s = 0; s < 2; ++s) {
+        margin = fminf(margin, fminf(a[s] - lim.minDeg, lim.maxDeg - a[s]));
+        model.setTarget(chans[s][j], constrain(a[s], lim.minDeg, lim.maxDeg));
+      }
+    }
+    model.advanceTo((uint64_t)(ms + frameMs) * 1000u);
+  }
+
+  const Sim::Stats s = model.stats();
+  Score r;
+  r.speed  = (s.seconds > 0.0f ? s.pathMm / s.seconds : 0.0f) * (mode == Leg::WALK_BWD ? -1.0f : 1.0f);
+  r.sway   = s.wobbleDeg;
+  r.margin = margin;
+  if (s.steps < 2) r.speed = 0.0f;   // never changes feet: no stance to score, not a walk
+  return r;
+}
+
+// ========== Thread Pool ==========
+// Workers pull candidate indices from a shared counter until none are left
+static void runAll(const Options& o, std::vector<Candidate>& all, uint32_t jobs) {
+  std::atomic<size_t> next(0);
+  auto worker = [&] {
+    for (size_t i = next++; i < all.size(); i = next++) all[i].score = evaluate(o, all[i]);
+  };
+
+  std::vector<std::thread> pool;
+  for (uint32_t j = 1; j < jobs; ++j) pool.emplace_back(worker);
+  worker();
+  for (std::thread& th : pool) th.join();
+}
+
+// ========== Pareto Front ==========
+static bool dominates(const Score& a, const Score& b) {
+  const bool noWorse = a.speed >= b.speed && a.sway <= b.sway && a.margin >= b.margin;
+  const bool better  = a.speed >  b.speed || a.sway <  b.sway || a.margin >  b.margin;
+  return noWorse && better;
+}
+
+static std::vector<size_t> paretoFront(const std::vector<Candidate>& all, float minSpeed) {
+  std::vector<size_t> front;
+  for (size_t i = 0; i < all.size(); ++i) {
+    if (all[i].score.speed < minSpeed) continue;
+    bool dominated = false;
+    for (size_t k = 0; k < all.size() && !dominated; ++k) {
+      dominated = k != i && all[k].score.speed >= minSpeed && dominates(all[k].score, all[i].score);
+    }
+    if (!dominated) front.push_back(i);
+  }
+  std::sort(front.begin(), front.end(),
+            [&](size_t a, size_t b) { return all[a].score.speed > all[b].score.speed; });
+  return front;
+}
+
+// ========== Output ==========
+static void printRow(const char* label, const Candidate& c) {
+  printf("%-8s %7.1f %6.1f %+6.1f ", label, c.score.speed, c.score.sway, c.score.margin);
+  for (uint8_t d = 0; d < DIM_COUNT; ++d) printf(" %6.2f", c.v[d]);
+  printf("\n");
+}
+
+static void printJson(const char* label, size_t index, const Candidate& c) {
+  printf("{\"set\":\"%s\",\"sample\":%u,\"speed_mm_s\":%.2f,\"sway_deg\":%.2f,\"margin_deg\":%.2f",
+         label, (unsigned)index, c.score.speed, c.score.sway, c.score.margin);
+  for (uint8_t d = 0; d < DIM_COUNT; ++d) printf(",\"%s\":%.3f", g_range[d].key, c.v[d]);
+  printf("}\n");
+}
+
+// Commands that load a set: send after the walk verb, which resets the speed
+static void writeCommands(FILE* f, const char* label, const Candidate& c) {
+  fprintf(f, "# %s: %.1f mm/s, sway %.1f deg/step, margin %+.1f deg\n",
+          label, c.score.speed, c.score.sway, c.score.margin);
+  fprintf(f, "rex_gait %.3f %.3f %.3f\n", c.v[SPEED], c.v[STRIDE], c.v[LIFT]);
+  fprintf(f, "rex_posture %.3f\n", c.v[POSTURE]);
+  for (uint8_t d = HIPX; d < DIM_COUNT; ++d) fprintf(f, "GAIT_TUNE %s %.3f\n", g_range[d].key, c.v[d]);
+  fprintf(f, "\n");
+}
+
+// ========== Entry Point ==========
+// Replaces NativeArduino's weak main(): no setup()/loop() sketch here.
+void setup() {}
+void loop() {}
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parse(argc, argv, o)) {
+    usage(argv[0]);
+    return 2;
+  }
+  uint32_t jobs = o.jobs ? o.jobs : std::thread::hardware_concurrency();
+  if (jobs == 0) jobs = 1;
+
+  // Slot 0 is the current firmware gait, for reference
+  std::vector<Candidate> all(o.samples + 1);
+  defaults(all[0]);
+  for (uint32_t i = 1; i < all.size(); ++i) sample(o.seed, i, all[i]);
+
+  const auto wallStart = std::chrono::steady_clock::now();
+  runAll(o, all, jobs);
+  const double wallMs =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+  const std::vector<size_t> front = paretoFront(all, o.minSpeed);
+
+  if (o.json) {
+    printJson("current", 0, all[0]);
+    for (size_t n = 0; n < front.size(); ++n) {
+      char label[16];
+      snprintf(label, sizeof(label), "P%u", (unsigned)(n + 1));
+      printJson(label, front[n], all[front[n]]);
+    }
+  } else {
+    printf("[Opt] %s: %u sets x %.0f s simulated on %u threads in %.0f ms; %u on the Pareto front\n",
+           o.mode, (unsigned)o.samples, o.seconds, (unsigned)jobs, wallMs, (unsigned)front.size());
+    printf("%-8s %7s %6s %6s ", "set", "mm/s", "sway", "margin");
+    for (uint8_t d = 0; d < DIM_COUNT; ++d) printf(" %6.6s", g_range[d].key);
+    printf("\n");
+    printRow("current", all[0]);
+    for (size_t n = 0; n < front.size(); ++n) {
+      char label[16];
+      snprintf(label, sizeof(label), "P%u", (unsigned)(n + 1));
+      printRow(label, all[front[n]]);
+    }
+  }
+
+  if (o.commands) {
+    FILE* f = fopen(o.commands, "w");
+    if (!f) {
+      perror(o.commands);
+      return 1;
+    }
+    fprintf(f, "# Pareto-optimal gait sets (%s). Send one block after %s;\n",
+            o.mode, strcmp(o.mode, "back") ? "WALK_FORWARD" : "WALK_BACKWARD");
+    fprintf(f, "# the walk verbs reset the speed, rex_gait sets it again.\n\n");
+    for (size_t n = 0; n < front.size(); ++n) {
+      char label[16];
+      snprintf(label, sizeof(label), "P%u", (unsigned)(n + 1));
+      writeCommands(f, label, all[front[n]]);
+    }
+    fclose(f);
+  }
+  return 0;
+}
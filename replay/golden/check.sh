@@ -0,0 +1,42 @@
+#!/bin/sh
+# replay/golden/check.sh - replay every golden trace against the current firmware
+#   replay/golden/check.sh            build env:replay and replay each *.rxt
+#   replay/golden/check.sh --record   first re-record each *.rxt from its
+#                                     session (*.txt, same name) with env:native
+# Exit status 1 when any trace does not replay. Re-record only when a
+# change to the servo output is meant, and commit the new .rxt with it.
+# REPLAY=<program> and NATIVE=<program> use prebuilt binaries instead of
+# building with pio.
+#
+# A session is the console input of a freshly booted robot, one command
+# per line, timed with "@+<ms>" (see CommandQueue.h); it is recorded for
+# one second past its last timed line.
+set -e
+cd "$(dirname "$0")/../.."
+dir=replay/golden
+
+# Calibration and stored shows would change the pulses: boot blank
+unset REX_NVS REX_FS
+
+if [ "$1" = "--record" ]; then
+  if [ -z "$NATIVE" ]; then
+    pio run -s -e native
+    NATIVE=.pio/build/native/program
+  fi
+  for session in "$dir"/*.txt; do
+    ms=$(sed -n 's/^@+\([0-9]*\).*/\1/p' "$session" | sort -n | tail -n 1)
+    REX_RECORD="${session%.txt}.rxt" "$NATIVE" --virtual --ms $(( ${ms:-0} + 1000 )) < "$session" > /dev/null
+    echo "recorded ${session%.txt}.rxt"
+  done
+fi
+
+if [ -z "$REPLAY" ]; then
+  pio run -s -e replay
+  REPLAY=.pio/build/replay/program
+fi
+
+status=0
+for golden in "$dir"/*.rxt; do
+  "$REPLAY" "$golden" || status=1
+done
+exit $status
@@ -0,0 +1,323 @@
+// replay/replay_main.cpp - Robo Rex trace replayer
+// Boots the real firmware (src/main.cpp) on the virtual clock, feeds the
+// input lines and frames of a recorded trace (see src/Recorder.h) through
+// the command transport at their recorded times, records the servo
+// pulses again and diffs them against the recording. A minute-long
+// session replays in well under a second.
+//
+//   REX_RECORD=golden.rxt .pio/build/native/program --virtual < session.txt
+//   pio run -e replay && .pio/build/replay/program golden.rxt
+//   .pio/build/replay/program golden.rxt --tolerance 4 --out new.rxt
+//   replay/golden/check.sh        replays the committed golden traces
+//
+// Exit status 0 when every recorded servo state is reproduced (within
+// --tolerance µs, up to --window ms early or late), 1 on a difference or
+// when the firmware allocated heap after setup() (see src/Mem.h;
+// --allow-allocs reports the count without failing).
+// Golden traces should start at boot (REX_RECORD, or REC_START right
+// after reset): the replay starts from a freshly booted robot.
+//
+// Built with src/main.cpp by env:replay.
+
+#include <Arduino.h>
+#include <NativeHost.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "Mem.h"
+#include "Recorder.h"
+#include "Transport.h"
+
+// ========== Options ==========
+struct Options {
+  const char* golden    = nullptr;
+  const char* out       = nullptr;   // write the replayed trace here
+  uint32_t tolUs        = 2;         // pulse difference still accepted
+  uint32_t windowMs     = 2;         // timing slack for each servo state
+  uint32_t maxReport    = 10;        // differences printed
+  bool     verbose      = false;     // show firmware output
+  bool     allowAllocs  = false;     // heap use after boot is not a failure
+};
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "usage: %s GOLDEN.rxt [--tolerance US] [--window MS] [--out FILE]\n"
+    "          [--max-report N] [--verbose] [--allow-allocs]\n",
+    argv0);
+}
+
+static bool parse(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    auto count = [&](uint32_t& out) { if (!v) return false; out = (uint32_t)strtoul(v, nullptr, 0); ++i; return true; };
+
+    bool ok = true;
+    if      (!strcmp(a, "--tolerance"))  ok = count(o.tolUs);
+    else if (!strcmp(a, "--window"))     ok = count(o.windowMs);
+    else if (!strcmp(a, "--max-report")) ok = count(o.maxReport);
+    else if (!strcmp(a, "--out"))        { ok = v; if (v) { o.out = v; ++i; } }
+    else if (!strcmp(a, "--verbose"))    o.verbose = true;
+    else if (!strcmp(a, "--allow-allocs")) o.allowAllocs = true;
+    else if (a[0] != '-' && !o.golden)   o.golden = a;
+    else ok = false;
+
+    if (!ok) return false;
+  }
+  return o.golden != nullptr;
+}
+
+// ========== Trace Contents ==========
+struct Input {
+  uint64_t us;     // when the recording transport poll read it
+  bool     frame;
+  std::vector<uint8_t> bytes;
+};
+
+struct ServoState {
+  uint64_t us;
+  uint16_t pulse[SERVO_COUNT];
+};
+
+struct Session {
+  std::vector<Input>      inputs;
+  std::vector<ServoState> states;
+  uint64_t                endUs = 0;
+};
+
+static bool decode(const std::vector<uint8_t>& buf, Session& t) {
+  Recorder::Reader rd(buf.data(), buf.size());
+  if (!rd.valid()) return false;
+
+  Recorder::Record r;
+  while (rd.next(r)) {
+    t.endUs = r.us;
+    if (r.tag == Recorder::SERVOS) {
+      ServoState s;
+      s.us = r.us;
+      memcpy(s.pulse, rd.pulses(), sizeof(s.pulse));
+      t.states.push_back(s);
+    } else {
+      t.inputs.push_back({ r.rxUs, r.tag == Recorder::FRAME, std::vector<uint8_t>(r.data, r.data + r.len) });
+    }
+  }
+  return !rd.error();
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) out.insert(out.end(), chunk, chunk + n);
+  fclose(f);
+  return true;
+}
+
+// ========== Replay Transport ==========
+// Hands each recorded input to LineReader once the time its recording
+// poll read it has come, so it is dispatched in the same loop pass:
+// lines with a '\n' terminator, frames between 0x00 delimiters. Replies
+// are discarded (or printed with --verbose).
+class ReplayTransport : public Transport {
+public:
+  ReplayTransport(const std::vector<Input>& inputs, bool echo) : _inputs(inputs), _echo(echo) {
+    // Room for every input at once, so the harness never allocates while
+    // the firmware's steady-state allocations are counted
+    size_t total = 0;
+    for (const Input& in : inputs) total += in.bytes.size() + 2;
+    _pending.reserve(total);
+  }
+
+  void setStart(uint32_t us) { _startUs = us; }
+  bool drained() const { return _next >= _inputs.size() && _pos >= _pending.size(); }
+
+  const char* name() const override { return "replay"; }
+  bool begin() override { return true; }
+  int  available() override { pump(); return (int)(_pending.size() - _pos); }
+  int  read() override { pump(); return _pos < _pending.size() ? _pending[_pos++] : -1; }
+  int  peek() override { pump(); return _pos < _pending.size() ? _pending[_pos] : -1; }
+  size_t write(const uint8_t* data, size_t len) override {
+    if (_echo) fwrite(data, 1, len, stdout);
+    return len;
+  }
+  int availableForWrite() override { return 4096; }
+  using Transport::write;
+
+private:
+  void pump() {
+    if (_pos >= _pending.size()) {
+      _pending.clear();
+      _pos = 0;
+    }
+    const uint64_t now = (uint32_t)(micros() - _startUs);
+    while (_next < _inputs.size() && _inputs[_next].us <= now) {
+      const Input& in = _inputs[_next++];
+      if (in.frame) _pending.push_back(0x00);
+      _pending.insert(_pending.end(), in.bytes.begin(), in.bytes.end());
+      _pending.push_back(in.frame ? 0x00 : '\n');
+    }
+  }
+
+  const std::vector<Input>& _inputs;
+  bool     _echo;
+  uint32_t _startUs = 0;
+  size_t   _next = 0;
+  std::vector<uint8_t> _pending;
+  size_t   _pos = 0;
+};
+
+// Growable trace sink for the replayed recording
+class VectorSink : public Print {
+public:
+  std::vector<uint8_t> bytes;
+  size_t write(const uint8_t* data, size_t len) override {
+    bytes.insert(bytes.end(), data, data + len);
+    return len;
+  }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  using Print::write;
+};
+
+// ========== Comparison ==========
+static uint32_t worstDiff(const uint16_t* a, const uint16_t* b, uint8_t& worstCh) {
+  uint32_t worst = 0;
+  worstCh = 0;
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    const uint32_t d = (uint32_t)abs((int)a[ch] - (int)b[ch]);
+    if (d > worst) {
+      worst = d;
+      worstCh = ch;
+    }
+  }
+  return worst;
+}
+
+// Index of the last state at or before us (or -1)
+static long stateAt(const std::vector<ServoState>& v, uint64_t us) {
+  long lo = 0, hi = (long)v.size() - 1, found = -1;
+  while (lo <= hi) {
+    const long mid = (lo + hi) / 2;
+    if (v[mid].us <= us) { found = mid; lo = mid + 1; } else { hi = mid - 1; }
+  }
+  return found;
+}
+
+// Every state in `want` must be held by `have` at some point within the
+// window around its time. Returns the number of misses.
+static uint32_t compare(const char* label, const std::vector<ServoState>& want,
+                        const std::vector<ServoState>& have, const Options& o, uint32_t& reported) {
+  static const uint16_t kOff[SERVO_COUNT] = { 0 };
+  const uint64_t win = (uint64_t)o.windowMs * 1000u;
+  uint32_t misses = 0;
+
+  for (const ServoState& w : want) {
+    long i = stateAt(have, w.us > win ? w.us - win : 0);
+    bool matched = false;
+    uint32_t best = UINT32_MAX;
+    uint8_t bestCh = 0;
+    for (; !matched && i < (long)have.size(); ++i) {
+      if (i >= 0 && have[i].us > w.us + win) break;
+      const uint16_t* p = i >= 0 ? have[i].pulse : kOff;
+      uint8_t ch;
+      const uint32_t d = worstDiff(w.pulse, p, ch);
+      if (d < best) { best = d; bestCh = ch; }
+      matched = d <= o.tolUs;
+    }
+    if (matched) continue;
+
+    ++misses;
+    if (reported < o.maxReport) {
+      const long at = stateAt(have, w.us);
+      printf("  %s t=%.3f s ch %u: want %u, got %u (closest within the window is %u us off)\n",
+             label, w.us / 1e6, (unsigned)bestCh, (unsigned)w.pulse[bestCh],
+             (unsigned)(at >= 0 ? have[at].pulse[bestCh] : 0), (unsigned)best);
+      ++reported;
+    }
+  }
+  return misses;
+}
+
+// ========== Entry Point ==========
+// Replaces NativeArduino's weak main(); setup()/loop() are the firmware's.
+int main(int argc, char** argv) {
+  Options o;
+  if (!parse(argc, argv, o)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> goldenBytes;
+  Session golden;
+  if (!readFile(o.golden, goldenBytes)) {
+    perror(o.golden);
+    return 2;
+  }
+  if (!decode(goldenBytes, golden)) {
+    fprintf(stderr, "%s: not a valid trace (or truncated)\n", o.golden);
+    if (golden.states.empty()) return 2;
+  }
+
+  NativeHost::setClockMode(NativeHost::VIRTUAL);
+  NativeHost::setSerialEnabled(o.verbose);
+
+  ReplayTransport transport(golden.inputs, o.verbose);
+  VectorSink sink;
+  sink.bytes.reserve(goldenBytes.size() * 2 + 65536);   // see ReplayTransport
+  setConsole(transport);
+  Recorder::arm(sink);
+
+  const auto wallStart = std::chrono::steady_clock::now();
+  setup();
+  transport.setStart(Recorder::stats().startUs);
+
+  // Run to the end of the recording plus one control frame
+  const uint64_t endUs = Recorder::stats().startUs + golden.endUs + 20000u;
+  while (NativeHost::nowUs() < endUs || !transport.drained()) {
+    loop();
+  }
+  Recorder::stop();
+  const uint32_t allocs = Mem::allocsSinceBoot();
+  const double wallMs =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+  // States past the end of the recording have nothing to compare against
+  Session replay;
+  decode(sink.bytes, replay);
+  const uint64_t cutUs = golden.endUs + (uint64_t)o.windowMs * 1000u;
+  while (!replay.states.empty() && replay.states.back().us > cutUs) replay.states.pop_back();
+  if (o.out) {
+    FILE* f = fopen(o.out, "wb");
+    if (!f || fwrite(sink.bytes.data(), 1, sink.bytes.size(), f) != sink.bytes.size()) perror(o.out);
+    if (f) fclose(f);
+  }
+
+  printf("[Replay] %s: %u inputs, %u servo states, %.1f s replayed in %.0f ms (%.0fx real time)\n",
+         o.golden, (unsigned)golden.inputs.size(), (unsigned)golden.states.size(),
+         golden.endUs / 1e6, wallMs, wallMs > 0 ? golden.endUs / 1e3 / wallMs : 0.0);
+
+  uint32_t reported = 0;
+  const uint32_t missing = compare("golden", golden.states, replay.states, o, reported);
+  const uint32_t extra   = compare("replay", replay.states, golden.states, o, reported);
+  const bool inputsOk = replay.inputs.size() == golden.inputs.size();
+  if (!inputsOk) {
+    printf("  inputs: golden %u, replayed %u\n", (unsigned)golden.inputs.size(), (unsigned)replay.inputs.size());
+  }
+
+  const bool heapOk = !allocs || o.allowAllocs;
+  if (allocs) {
+    printf("  heap: %u allocations after boot%s\n", (unsigned)allocs, heapOk ? " (allowed)" : "");
+  }
+
+  if (!missing && !extra && inputsOk && heapOk) {
+    printf("[Replay] PASS (tolerance %u us, window %u ms)\n", (unsigned)o.tolUs, (unsigned)o.windowMs);
+    return 0;
+  }
+  printf("[Replay] FAIL: %u golden states not reproduced, %u replayed states not in the golden trace, "
+         "%u heap allocations after boot\n",
+         (unsigned)missing, (unsigned)extra, (unsigned)(heapOk ? 0 : allocs));
+  return 1;
+}
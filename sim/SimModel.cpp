@@ -0,0 +1,250 @@
+#include "SimModel.h"
+#include <math.h>
+#include <NativeHost.h>
+
+namespace Sim {
+
+// ========== Setup ==========
+
+void Model::begin(const ServoBus* bus, const Config& cfg, const Channels& ch) {
+  _bus = bus;
+  _cfg = cfg;
+  _ch  = ch;
+  start(NativeHost::nowUs());
+}
+
+void Model::begin(const Config& cfg, const Channels& ch, uint64_t startUs) {
+  _bus = nullptr;
+  _cfg = cfg;
+  _ch  = ch;
+  for (uint8_t c = 0; c < SERVO_COUNT; ++c) _target[c] = 90.0f;
+  _driven = 0;
+  start(startUs);
+}
+
+void Model::setTarget(uint8_t ch, float deg) {
+  if (ch >= SERVO_COUNT) return;
+  _target[ch] = deg;
+  _driven |= 1u << ch;
+}
+
+void Model::start(uint64_t us) {
+  _started = false;
+  _us = us;
+  _x = _y = _yaw = 0.0f;
+  _heading = _twist = 0.0f;
+  _stanceMm[RIGHT] = _stanceMm[LEFT] = 0.0f;
+  _strideMm[RIGHT] = _strideMm[LEFT] = 0.0f;
+
+  // Servos start where they were last commanded
+  for (uint8_t c = 0; c < SERVO_COUNT; ++c) _actual[c] = targetDeg(c);
+  solveLeg(RIGHT);
+  solveLeg(LEFT);
+  _height = fmaxf(-_foot[RIGHT].z, -_foot[LEFT].z);
+  _prev[RIGHT] = _foot[RIGHT];
+  _prev[LEFT]  = _foot[LEFT];
+  _started = true;
+  resetStats();
+}
+
+void Model::resetStats() {
+  _statUs = _us;
+  _x0 = _x;
+  _y0 = _y;
+  _yaw0 = _yaw;
+  _path = 0.0f;
+  _heightSum = 0.0;
+  _samples = 0;
+  _hMin = _hMax = _height;
+  _comMin = _comMax = _comY;
+  _twistMin = _twistMax = _twist;
+  _twistSum = 0.0f;
+  _stances = 0;
+  _rollMin = _rollMax = _actual[_ch.pelvisRoll];
+  _lagMax = 0.0f;
+  _clear[RIGHT] = _clear[LEFT] = 0.0f;
+  _steps = 0;
+  _stepSum = 0.0f;
+  _haveTouch = false;
+}
+
+// ========== Servo Model ==========
+
+// Commanded angle: the last pulse mapped back through the channel limits.
+// A channel that is off holds its current angle.
+float Model::targetDeg(uint8_t ch) const {
+  if (!_bus) return _target[ch];
+  const uint16_t us = _bus->lastMicroseconds(ch);
+  if (us == 0) return _started ? _actual[ch] : 90.0f;
+
+  const ServoLimits& lim = _bus->limits(ch);
+  if (lim.maxPulse == lim.minPulse) return lim.minDeg;
+  const float t = (float)(us - lim.minPulse) / (float)(lim.maxPulse - lim.minPulse);
+  return lim.minDeg + t * (lim.maxDeg - lim.minDeg);
+}
+
+// ========== Kinematics ==========
+
+void Model::solveLeg(Side s) {
+  const Leg::Map& m = _ch.legs;
+  const uint8_t hipX  = s == RIGHT ? m.R_hipX  : m.L_hipX;
+  const uint8_t hipY  = s == RIGHT ? m.R_hipY  : m.L_hipY;
+  const uint8_t knee  = s == RIGHT ? m.R_knee  : m.L_knee;
+  const uint8_t ankle = s == RIGHT ? m.R_ankle : m.L_ankle;
+  const uint8_t foot  = s == RIGHT ? m.R_foot  : m.L_foot;
+
+  const float thigh = _cfg.hipXSign * (_actual[hipX] - 90.0f) - (_actual[hipY] - 90.0f);
+  const float shin  = thigh + (_actual[knee] - 90.0f);
+  const float meta  = shin - (_actual[ankle] - 90.0f);
+  const float toe   = meta - (_actual[foot] - 90.0f);
+
+  const float k = (float)DEG_TO_RAD;
+  const float a[4] = { thigh * k, shin * k, meta * k, toe * k };
+  const float len[4] = { _cfg.thighMm, _cfg.shinMm, _cfg.metaMm, _cfg.toeMm };
+
+  float x = 0.0f, z = 0.0f;
+  for (uint8_t i = 0; i < 4; ++i) {
+    x += len[i] * sinf(a[i]);
+    z -= len[i] * cosf(a[i]);
+  }
+  _foot[s].x = x;
+  _foot[s].z = z;
+}
+
+// ========== Integration ==========
+
+void Model::advanceTo(uint64_t us) {
+  if (!_started) return;
+  const float dt = _cfg.stepUs / 1e6f;
+  while (_us + _cfg.stepUs <= us) {
+    _us += _cfg.stepUs;
+    step(dt);
+  }
+}
+
+void Model::step(float dt) {
+  // Servos chase their targets
+  const float alpha = _cfg.tauMs > 0.0f ? fminf(1.0f, dt * 1000.0f / _cfg.tauMs) : 1.0f;
+  const float maxStep = _cfg.slewDegPerS * dt;
+  for (uint8_t c = 0; c < SERVO_COUNT; ++c) {
+    const float err = targetDeg(c) - _actual[c];
+    float d = err * alpha;
+    if (d > maxStep) d = maxStep;
+    if (d < -maxStep) d = -maxStep;
+    _actual[c] += d;
+    const bool driven = _bus ? _bus->lastMicroseconds(c) != 0 : (_driven >> c) & 1u;
+    if (fabsf(err) > _lagMax && driven) _lagMax = fabsf(err);
+  }
+
+  _prev[RIGHT] = _foot[RIGHT];
+  _prev[LEFT]  = _foot[LEFT];
+  solveLeg(RIGHT);
+  solveLeg(LEFT);
+
+  // The lower foot carries the body
+  _height = fmaxf(-_foot[RIGHT].z, -_foot[LEFT].z);
+  for (uint8_t s = RIGHT; s <= LEFT; ++s) {
+    _foot[s].contact = (-_foot[s].z >= _height - _cfg.contactMm);
+    const float lift = _height + _foot[s].z;
+    if (lift > _clear[s]) _clear[s] = lift;
+  }
+
+  // Contact feet push the body: their backward motion is forward travel
+  const float dxR = _prev[RIGHT].x - _foot[RIGHT].x;
+  const float dxL = _prev[LEFT].x  - _foot[LEFT].x;
+  const bool  both = _foot[RIGHT].contact && _foot[LEFT].contact;
+
+  // The carrying foot; in double support the one taking the load (moving
+  // down relative to the hip), the other is being picked up or set down
+  const float dzR = _foot[RIGHT].z - _prev[RIGHT].z;
+  const float dzL = _foot[LEFT].z  - _prev[LEFT].z;
+  const Side stance = (!_foot[LEFT].contact || (both && dzR <= dzL)) ? RIGHT : LEFT;
+  const float push  = stance == RIGHT ? dxR : dxL;
+  const float other = stance == RIGHT ? dxL : dxR;
+
+  float forward, twist;
+  if (both && dxR * dxL > 0.0f) {
+    // Both feet pushing: the difference between the sides twists the body
+    forward = 0.5f * (dxR + dxL);
+    twist   = _cfg.turnCoupling * (dxR - dxL) / _cfg.hipWidthMm;
+  } else {
+    // A foot moving against the carrying one slides and does not push.
+    // Like a swing leg, its motion counters the push's yaw about the
+    // stance hip, so only the imbalance between the legs twists the body.
+    forward = push;
+    twist   = (stance == RIGHT ? 1.0f : -1.0f) * _cfg.turnCoupling * (push + other) / _cfg.hipWidthMm;
+  }
+
+  // The twist is released when the other foot takes over; the heading then
+  // moves by the difference between the two legs' last strides
+  _stanceMm[stance] += push;
+  if (stance != _stance) {
+    _strideMm[_stance] = _stanceMm[_stance];
+    _stanceMm[_stance] = 0.0f;
+    _stance  = stance;
+    _heading += _cfg.turnCoupling * 0.5f * (_strideMm[RIGHT] - _strideMm[LEFT]) / _cfg.hipWidthMm;
+    _twistSum += _twistMax - _twistMin;
+    ++_stances;
+    _twist = _twistMin = _twistMax = 0.0f;
+  } else {
+    _twist += twist;
+    if (_twist < _twistMin) _twistMin = _twist;
+    if (_twist > _twistMax) _twistMax = _twist;
+  }
+  _yaw = _heading + _twist;
+  _x += forward * cosf(_yaw);
+  _y += forward * sinf(_yaw);
+  _path += forward;
+
+  // Touchdowns: a foot going from swing to contact
+  for (uint8_t s = RIGHT; s <= LEFT; ++s) {
+    if (!_foot[s].contact || _prev[s].contact) continue;
+    const float side = (s == RIGHT ? -0.5f : 0.5f) * _cfg.hipWidthMm;
+    const float fx = _x + _foot[s].x * cosf(_yaw) - side * sinf(_yaw);
+    const float fy = _y + _foot[s].x * sinf(_yaw) + side * cosf(_yaw);
+    if (_haveTouch) {
+      // Distance along the heading, so the hip width does not count
+      _stepSum += fabsf((fx - _touchX) * cosf(_yaw) + (fy - _touchY) * sinf(_yaw));
+      ++_steps;
+    }
+    _touchX = fx;
+    _touchY = fy;
+    _haveTouch = true;
+  }
+
+  // Sway: spine and tail yaw shift the centre of mass sideways
+  const float spine = (_actual[_ch.spineYaw] - 90.0f) * DEG_TO_RAD;
+  const float tail  = (_actual[_ch.tailWag]  - 90.0f) * DEG_TO_RAD;
+  _comY = _cfg.spineMass * _cfg.spineMm * sinf(spine) + _cfg.tailMass * _cfg.tailMm * sinf(spine + tail);
+
+  const float roll = _actual[_ch.pelvisRoll];
+  _heightSum += _height;
+  ++_samples;
+  if (_height < _hMin) _hMin = _height;
+  if (_height > _hMax) _hMax = _height;
+  if (_comY < _comMin) _comMin = _comY;
+  if (_comY > _comMax) _comMax = _comY;
+  if (roll < _rollMin) _rollMin = roll;
+  if (roll > _rollMax) _rollMax = roll;
+}
+
+Stats Model::stats() const {
+  Stats s = {};
+  s.seconds        = (_us - _statUs) / 1e6f;
+  s.distanceMm     = hypotf(_x - _x0, _y - _y0);
+  s.pathMm         = _path;
+  s.yawDeg         = (_yaw - _yaw0) * RAD_TO_DEG;
+  s.steps          = _steps;
+  s.stepMm         = _steps ? _stepSum / _steps : 0.0f;
+  s.clearanceMm[0] = _clear[RIGHT];
+  s.clearanceMm[1] = _clear[LEFT];
+  s.heightMm       = _samples ? (float)(_heightSum / _samples) : _height;
+  s.bobMm          = _hMax - _hMin;
+  s.swayMm         = _comMax - _comMin;
+  s.wobbleDeg      = _stances ? _twistSum * RAD_TO_DEG / _stances : 0.0f;
+  s.rollDeg        = _rollMax - _rollMin;
+  s.lagDeg         = _lagMax;
+  return s;
+}
+
+} // namespace Sim
@@ -0,0 +1,170 @@
+#pragma once
+#include <Arduino.h>
+#include "ServoBus.h"
+#include "Servo_Functions/Leg_Function.h"
+
+// ========== Kinematic Simulator Model ==========
+// Follows the pulses the real firmware writes through ServoBus and turns
+// them into joint angles, foot positions and body motion.
+//
+// Servos:  each channel chases its commanded angle (pulse mapped back
+//          through the channel's ServoLimits) with a first-order lag,
+//          capped at a slew rate.
+// Legs:    planar chain in the sagittal plane, hip at the origin, x
+//          forward, z up. Joint offsets from 90 deg set the segment
+//          angles from vertical:
+//            thigh = ±hipX - hipY  shin = thigh + knee
+//            meta  = shin - ankle  toe  = meta - foot
+//          All joints at 90 deg hang the leg straight down. Leg_Function.cpp
+//          lifts the foot while its swing falls from +1 to -1 and plants
+//          it while the swing rises again, so for WALK_FORWARD to walk
+//          forward a rising hipX carries the foot back under the hip:
+//          hipXSign = -1. +1 models a servo mounted the other way round.
+// Ground:  the lower foot carries the body; a foot within contactMm of it
+//          is in contact. In double support the carrying foot is the one
+//          taking the load (moving down); a foot moving against it slides.
+//          The carrying foot does not slide, so its backward motion
+//          relative to the hip moves the body forward.
+// Heading: the stance push and the other leg's opposite motion twist the
+//          body about the stance hip (turnCoupling of their imbalance).
+//          The twist is released when the other foot takes over, and the
+//          heading moves by turnCoupling of the difference between the
+//          two legs' last strides, so asymmetric strides turn.
+// Sway:    lateral centre-of-mass shift from spine and tail yaw, body
+//          height bob, pelvis roll and heading wobble (the twist's
+//          peak-to-peak swing per stance).
+//
+// Without a bus the commanded angles come from setTarget() instead, and
+// the model touches no globals, so host tools can run one per thread.
+namespace Sim {
+
+struct Config {
+  // Servo response
+  float slewDegPerS = 400.0f;   // no-load speed (~0.15 s / 60 deg)
+  float tauMs       = 25.0f;    // first-order lag time constant
+
+  // Segment lengths (mm)
+  float thighMm    = 60.0f;
+  float shinMm     = 60.0f;
+  float metaMm     = 35.0f;
+  float toeMm      = 25.0f;
+  float hipWidthMm = 70.0f;
+  float hipXSign   = -1.0f;    // see Legs above
+
+  // Sway model: mass fraction and lever arm of spine and tail
+  float spineMass = 0.25f;
+  float spineMm   = 90.0f;
+  float tailMass  = 0.15f;
+  float tailMm    = 160.0f;
+
+  float contactMm    = 2.0f;    // foot counts as loaded this close to the ground
+  float turnCoupling = 0.25f;   // leg push imbalance that becomes yaw
+  uint32_t stepUs    = 1000;    // integration step
+};
+
+// Channels the model reads (defaults match src/main.cpp)
+struct Channels {
+  Leg::Map legs;
+  uint8_t  pelvisRoll = 3;
+  uint8_t  spineYaw   = 4;
+  uint8_t  tailWag    = 5;
+};
+
+enum Side : uint8_t { RIGHT = 0, LEFT = 1 };
+
+struct Foot {
+  float x = 0.0f;        // toe tip relative to the hip, mm forward
+  float z = 0.0f;        // toe tip relative to the hip, mm up (negative)
+  bool  contact = false;
+};
+
+// Whole-run results
+struct Stats {
+  float    seconds;          // simulated time
+  float    distanceMm;       // straight-line body displacement
+  float    pathMm;           // integrated forward travel
+  float    yawDeg;           // net heading change
+  uint32_t steps;            // touchdowns (both feet)
+  float    stepMm;           // mean distance between consecutive touchdowns
+  float    clearanceMm[2];   // highest swing-foot lift per side
+  float    heightMm;         // mean hip height
+  float    bobMm;            // hip height peak-to-peak
+  float    swayMm;           // lateral COM shift peak-to-peak
+  float    wobbleDeg;        // heading swing per step, net turn excluded
+  float    rollDeg;          // pelvis roll peak-to-peak
+  float    lagDeg;           // worst commanded-vs-actual joint error
+};
+
+class Model {
+public:
+  void begin(const ServoBus* bus, const Config& cfg = Config(), const Channels& ch = Channels());
+
+  // Bus-less: all servos start at 90 deg and follow setTarget()
+  void begin(const Config& cfg = Config(), const Channels& ch = Channels(), uint64_t startUs = 0);
+  void setTarget(uint8_t ch, float deg);
+
+  // Integrate up to the given time (whole steps only)
+  void advanceTo(uint64_t us);
+
+  // Clear statistics (state is kept)
+  void resetStats();
+
+  // ---------------- Queries ----------------
+  float       jointDeg(uint8_t ch) const { return ch < SERVO_COUNT ? _actual[ch] : 0.0f; }
+  const Foot& foot(Side s) const { return _foot[s]; }
+  float       bodyX() const { return _x; }
+  float       bodyY() const { return _y; }
+  float       yawDeg() const { return _yaw * RAD_TO_DEG; }
+  float       heightMm() const { return _height; }
+  float       comY() const { return _comY; }
+  uint64_t    timeUs() const { return _us; }
+  Stats       stats() const;
+
+private:
+  void  start(uint64_t us);
+  float targetDeg(uint8_t ch) const;
+  void  step(float dt);
+  void  solveLeg(Side s);
+
+  const ServoBus* _bus = nullptr;
+  Config   _cfg;
+  Channels _ch;
+  uint64_t _us = 0;
+  bool     _started = false;
+
+  float _actual[SERVO_COUNT] = {};
+  float _target[SERVO_COUNT] = {};   // bus-less commands
+  uint32_t _driven = 0;              // bus-less: channels given a target
+  Foot  _foot[2];
+  Foot  _prev[2];
+
+  float _x = 0.0f, _y = 0.0f, _yaw = 0.0f;
+  float _heading = 0.0f;            // yaw after the last stance handover
+  float _twist = 0.0f;              // yaw about the stance hip since then
+  Side  _stance = RIGHT;            // carrying foot
+  float _stanceMm[2] = {};          // push so far in the current stance
+  float _strideMm[2] = {};          // push over the last finished stance
+  float _height = 0.0f;
+  float _comY = 0.0f;
+
+  // Statistics
+  uint64_t _statUs = 0;
+  float    _x0 = 0.0f, _y0 = 0.0f, _yaw0 = 0.0f;
+  float    _path = 0.0f;
+  double   _heightSum = 0.0;
+  uint32_t _samples = 0;
+  float    _hMin = 0.0f, _hMax = 0.0f;
+  float    _comMin = 0.0f, _comMax = 0.0f;
+  float    _twistMin = 0.0f, _twistMax = 0.0f;   // in the current stance
+  float    _twistSum = 0.0f;    // peak-to-peak twist of finished stances
+  uint32_t _stances = 0;
+  float    _rollMin = 0.0f, _rollMax = 0.0f;
+  float    _lagMax = 0.0f;
+  float    _clear[2] = {};
+  uint32_t _steps = 0;
+  float    _stepSum = 0.0f;
+  bool     _haveTouch = false;
+  float    _touchX = 0.0f, _touchY = 0.0f;
+};
+
+} // namespace Sim
@@ -0,0 +1,363 @@
+// sim/sim_main.cpp - Robo Rex kinematic simulator
+// Links the real Leg, Spine, Tail and Pelvis modules and ServoBus (over
+// the NativeArduino driver stand-ins), runs them on the virtual clock at
+// the firmware's control frame rate, and feeds the written pulses into
+// Sim::Model (servo lag + leg kinematics). Minutes of walking take
+// milliseconds, so gait changes in Leg_Function.cpp can be checked
+// without reflashing.
+//
+//   pio run -e sim && .pio/build/sim/program --mode walk --seconds 120
+//   .pio/build/sim/program --mode left --speed 0.8 --csv turn.csv
+//   .pio/build/sim/program --gait run --speed 2 --look-every 0.5 --budget 0
+//   .pio/build/sim/program --pca-outage 5:0.3
+//
+// The servo current estimate (ServoBus::frame()) is reported with and
+// without the scheduler's slewing; --budget 0 turns the scheduler off.
+// --pca-outage AT:FOR cuts the PCA9685 off the I2C stand-in for FOR s at
+// AT s (as a power loss: its outputs drop) and reports how long after it
+// answers again the link monitor has the legs' pulses back.
+//
+// Built instead of src/main.cpp by env:sim.
+
+#include <Arduino.h>
+#include <NativeHost.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ServoBus.h"
+#include "CommandQueue.h"
+#include "Log.h"
+#include "Transport.h"
+#include "Servo_Functions/Neck_Function.h"
+#include "Servo_Functions/Head_Function.h"
+#include "Servo_Functions/Pelvis_Function.h"
+#include "Servo_Functions/Spine_Function.h"
+#include "Servo_Functions/Tail_Function.h"
+#include "Servo_Functions/Leg_Function.h"
+#include "SimModel.h"
+
+// ========== Options ==========
+struct Options {
+  const char* mode     = "walk";   // walk | back | left | right | idle
+  const char* gait     = "walk";   // walk | run (Leg::setGait pace)
+  float seconds        = 60.0f;    // measured time
+  float warmup         = 2.0f;     // settle time excluded from the stats
+  float speed          = 1.0f;
+  float stride         = 1.0f;
+  float lift           = 0.8f;
+  float posture        = 0.5f;
+  float spine          = 0.5f;     // Spine::setYaw01
+  float tail           = 0.5f;     // Tail::setYaw01
+  float pelvis         = 0.5f;     // Pelvis::setRoll01
+  float wagEvery       = 0.0f;     // Tail::wag() period in s (0 = never)
+  float lookEvery      = 0.0f;     // swing neck, jaw, head and tail end to end (0 = never)
+  float budgetMa       = SERVO_CURRENT_BUDGET_MA;   // ServoBus current cap (0 = off)
+  float outageAt       = 0.0f;     // PCA9685 outage start in s after warmup
+  float outageFor      = 0.0f;     // and length (0 = none)
+  const char* csv      = nullptr;  // per-sample trajectory output
+  uint32_t csvEveryMs  = CONTROL_PERIOD_MS;
+  bool  json           = false;
+  bool  verbose        = false;
+  Sim::Config model;
+};
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "usage: %s [--mode walk|back|left|right|idle] [--seconds S] [--warmup S]\n"
+    "          [--speed HZ] [--stride 0..1] [--lift 0..1] [--gait walk|run] [--posture 0..1]\n"
+    "          [--spine 0..1] [--tail 0..1] [--pelvis 0..1] [--wag-every S]\n"
+    "          [--look-every S] [--budget MA] [--pca-outage AT:FOR]\n"
+    "          [--slew DEG_S] [--tau MS] [--hipx-sign 1|-1]\n"
+    "          [--csv FILE] [--csv-every MS] [--json] [--verbose]\n",
+    argv0);
+}
+
+static bool parse(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    auto num = [&](float& out) { if (!v) return false; out = (float)atof(v); ++i; return true; };
+
+    bool ok = true;
+    if      (!strcmp(a, "--mode"))      { ok = v; if (v) { o.mode = v; ++i; } }
+    else if (!strcmp(a, "--gait"))      { ok = v; if (v) { o.gait = v; ++i; } }
+    else if (!strcmp(a, "--csv"))       { ok = v; if (v) { o.csv = v; ++i; } }
+    else if (!strcmp(a, "--csv-every")) { ok = v; if (v) { o.csvEveryMs = (uint32_t)atoi(v); ++i; } }
+    else if (!strcmp(a, "--seconds"))   ok = num(o.seconds);
+    else if (!strcmp(a, "--warmup"))    ok = num(o.warmup);
+    else if (!strcmp(a, "--speed"))     ok = num(o.speed);
+    else if (!strcmp(a, "--stride"))    ok = num(o.stride);
+    else if (!strcmp(a, "--lift"))      ok = num(o.lift);
+    else if (!strcmp(a, "--posture"))   ok = num(o.posture);
+    else if (!strcmp(a, "--spine"))     ok = num(o.spine);
+    else if (!strcmp(a, "--tail"))      ok = num(o.tail);
+    else if (!strcmp(a, "--pelvis"))    ok = num(o.pelvis);
+    else if (!strcmp(a, "--wag-every")) ok = num(o.wagEvery);
+    else if (!strcmp(a, "--look-every")) ok = num(o.lookEvery);
+    else if (!strcmp(a, "--budget"))    ok = num(o.budgetMa);
+    else if (!strcmp(a, "--pca-outage")) {
+      ok = v && sscanf(v, "%f:%f", &o.outageAt, &o.outageFor) == 2 && o.outageFor > 0.0f;
+      ++i;
+    }
+    else if (!strcmp(a, "--slew"))      ok = num(o.model.slewDegPerS);
+    else if (!strcmp(a, "--tau"))       ok = num(o.model.tauMs);
+    else if (!strcmp(a, "--hipx-sign")) ok = num(o.model.hipXSign);
+    else if (!strcmp(a, "--json"))      o.json = true;
+    else if (!strcmp(a, "--verbose"))   o.verbose = true;
+    else ok = false;
+
+    if (!ok) return false;
+  }
+  return true;
+}
+
+// ========== Quiet Console ==========
+// Firmware replies and log lines are discarded unless --verbose
+class NullTransport : public Transport {
+public:
+  const char* name() const override { return "sim"; }
+  bool   begin() override { return true; }
+  int    available() override { return 0; }
+  int    read() override { return -1; }
+  int    peek() override { return -1; }
+  size_t write(const uint8_t*, size_t len) override { return len; }
+  int    availableForWrite() override { return 4096; }
+  using Transport::write;
+};
+
+// ========== Firmware Fixture ==========
+static ServoBus      servoBus;
+static NullTransport g_null;
+static Sim::Model    g_model;
+
+// --pca-outage: when the PCA9685 answered again and when every attached
+// leg channel had its pulse back on the stand-in's outputs
+static uint64_t g_outageEndUs = UINT64_MAX;
+static uint64_t g_restoredUs  = 0;
+
+static bool legsRestored() {
+  for (uint8_t ch = PCA9685_FIRST_CHANNEL; ch < SERVO_COUNT; ++ch) {
+    if (servoBus.isAttached(ch) && servoBus.lastMicroseconds(ch) &&
+        !NativeHost::pcaCounts(PCA9685_I2C_ADDRESS, ch - PCA9685_FIRST_CHANNEL)) return false;
+  }
+  return true;
+}
+
+// Same channel map as src/main.cpp
+static void beginMotion(Sim::Channels& ch) {
+  Neck::Map neckMap;
+  neckMap.yaw = 0;
+  Neck::begin(&servoBus, neckMap);
+
+  Head::Map headMap;
+  headMap.jaw   = 1;
+  headMap.pitch = 2;
+  Head::begin(&servoBus, headMap);
+
+  Pelvis::Map pelvisMap;
+  pelvisMap.roll = ch.pelvisRoll;
+  Pelvis::begin(&servoBus, pelvisMap);
+
+  Spine::Map spineMap;
+  spineMap.spineYaw = ch.spineYaw;
+  Spine::begin(&servoBus, spineMap);
+
+  Tail::Map tailMap;
+  tailMap.wag = ch.tailWag;
+  Tail::begin(&servoBus, tailMap);
+
+  Leg::begin(&servoBus, ch.legs);
+}
+
+static void startGait(const Options& o) {
+  Leg::setPosture(o.posture);
+  Spine::setYaw01(o.spine);
+  Tail::setYaw01(o.tail);
+  Pelvis::setRoll01(o.pelvis);
+
+  if      (!strcmp(o.mode, "walk"))  Leg::walkForward(o.speed);
+  else if (!strcmp(o.mode, "back"))  Leg::walkBackward(o.speed);
+  else if (!strcmp(o.mode, "left"))  Leg::turnLeft(o.speed);
+  else if (!strcmp(o.mode, "right")) Leg::turnRight(o.speed);
+  else                               Leg::stop();
+
+  if (Leg::mode() != Leg::IDLE) {
+    Leg::setGait(o.speed, o.stride, o.lift, strcmp(o.gait, "run") ? Leg::PACE_WALK : Leg::PACE_RUN);
+  }
+}
+
+// Body and aux moves a host sends while the robot walks (LOOK_LEFT,
+// JAW_OPEN, ...): what the current scheduler slews around the legs
+static void lookAround(bool side) {
+  const float a01 = side ? 1.0f : 0.0f;
+  Neck::setYaw01(a01);
+  Head::setJaw01(a01);
+  Head::setPitch01(a01);
+  Tail::setYaw01(a01);
+}
+
+// ========== Report ==========
+static void report(const Options& o, const Sim::Stats& s, double wallMs) {
+  const float speedMmS = s.seconds > 0.0f ? s.pathMm / s.seconds : 0.0f;
+  const float turnDegS = s.seconds > 0.0f ? s.yawDeg / s.seconds : 0.0f;
+  const ServoCurrentStats& cs = servoBus.currentStats();
+  const PcaLinkStats& pl = servoBus.pcaLinkStats();
+  const double restoreMs = g_restoredUs ? (g_restoredUs - g_outageEndUs) / 1000.0 : -1.0;
+
+  if (o.json) {
+    printf("{\"mode\":\"%s\",\"sim_s\":%.2f,\"wall_ms\":%.1f,\"distance_mm\":%.1f,\"path_mm\":%.1f,"
+           "\"speed_mm_s\":%.2f,\"yaw_deg\":%.2f,\"turn_deg_s\":%.3f,\"steps\":%u,\"step_mm\":%.2f,"
+           "\"clear_r_mm\":%.2f,\"clear_l_mm\":%.2f,\"height_mm\":%.2f,\"bob_mm\":%.2f,"
+           "\"sway_mm\":%.2f,\"wobble_deg\":%.2f,\"roll_deg\":%.2f,\"lag_deg\":%.2f,"
+           "\"peak_ma\":%u,\"unslewed_peak_ma\":%u,\"slewed\":%u,\"over\":%u,"
+           "\"pca_restore_ms\":%.2f,\"pca_probes\":%u}\n",
+           o.mode, s.seconds, wallMs, s.distanceMm, s.pathMm, speedMmS, s.yawDeg, turnDegS,
+           (unsigned)s.steps, s.stepMm, s.clearanceMm[0], s.clearanceMm[1], s.heightMm, s.bobMm,
+           s.swayMm, s.wobbleDeg, s.rollDeg, s.lagDeg,
+           (unsigned)cs.peakMa, (unsigned)cs.unlimitedPeakMa, (unsigned)cs.limited, (unsigned)cs.over,
+           restoreMs, (unsigned)pl.probes);
+    return;
+  }
+
+  printf("[Sim] %s %.2f Hz: %.1f s simulated in %.1f ms (%.0fx real time)\n",
+         o.mode, Leg::speedHz(), s.seconds, wallMs, wallMs > 0 ? s.seconds * 1000.0 / wallMs : 0.0);
+  printf("  Travel:    %.1f mm net, %.1f mm path, %.1f mm/s\n", s.distanceMm, s.pathMm, speedMmS);
+  printf("  Heading:   %+.1f deg (%+.2f deg/s)\n", s.yawDeg, turnDegS);
+  printf("  Steps:     %u, mean step %.1f mm\n", (unsigned)s.steps, s.stepMm);
+  printf("  Clearance: right %.1f mm, left %.1f mm\n", s.clearanceMm[0], s.clearanceMm[1]);
+  printf("  Body:      hip height %.1f mm, bob %.1f mm p-p\n", s.heightMm, s.bobMm);
+  printf("  Sway:      COM %.1f mm p-p, heading %.1f deg/step, pelvis roll %.1f deg p-p\n",
+         s.swayMm, s.wobbleDeg, s.rollDeg);
+  printf("  Servo lag: worst %.1f deg behind command\n", s.lagDeg);
+  printf("  Current:   peak %u mA (%u mA unslewed), budget %u mA, %u frames slewed, %u over budget\n",
+         (unsigned)cs.peakMa, (unsigned)cs.unlimitedPeakMa, (unsigned)o.budgetMa,
+         (unsigned)cs.limited, (unsigned)cs.over);
+  if (o.outageFor > 0.0f) {
+    if (restoreMs < 0.0) {
+      printf("  PCA9685:   out for %.0f ms, legs NOT restored (%u probes)\n",
+             o.outageFor * 1000.0f, (unsigned)pl.probes);
+    } else {
+      printf("  PCA9685:   out for %.0f ms, legs restored %.1f ms after it answered "
+             "(%u probes, restore %u us)\n",
+             o.outageFor * 1000.0f, restoreMs, (unsigned)pl.probes, (unsigned)pl.lastRestoreUs);
+    }
+  }
+}
+
+// ========== Entry Point ==========
+// Replaces NativeArduino's weak main(): no setup()/loop() sketch here.
+void setup() {}
+void loop() {}
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parse(argc, argv, o)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  NativeHost::setClockMode(NativeHost::VIRTUAL);
+  NativeHost::setSerialEnabled(o.verbose);
+  if (o.verbose) {
+    console().begin();
+    Log::begin();
+  } else {
+    setConsole(g_null);
+  }
+
+  Sim::Channels ch;
+  servoBus.begin();
+  servoBus.setCurrentBudget((uint32_t)o.budgetMa);
+  beginMotion(ch);
+
+  g_model.begin(&servoBus, o.model, ch);
+  NativeHost::setAdvanceHook([] { g_model.advanceTo(NativeHost::nowUs()); });
+
+  FILE* csv = o.csv ? fopen(o.csv, "w") : nullptr;
+  if (o.csv && !csv) {
+    perror(o.csv);
+    return 1;
+  }
+  if (csv) fprintf(csv, "t_s,body_x,body_y,yaw_deg,height,r_x,r_z,r_contact,l_x,l_z,l_contact,com_y\n");
+
+  const uint64_t t0 = NativeHost::nowUs();
+  const auto wallStart = std::chrono::steady_clock::now();
+  const uint64_t warmupUs = (uint64_t)(o.warmup * 1e6f);
+  if (o.outageFor > 0.0f) {
+    const uint64_t atUs = t0 + warmupUs + (uint64_t)(o.outageAt * 1e6f);
+    const uint64_t forUs = (uint64_t)(o.outageFor * 1e6f);
+    NativeHost::setI2cOutage(PCA9685_I2C_ADDRESS, atUs, forUs);
+    g_outageEndUs = atUs + forUs;
+  }
+
+  startGait(o);
+
+  // Control frames on the firmware's fixed grid (see loop() in main.cpp)
+  const uint64_t endUs    = t0 + warmupUs + (uint64_t)(o.seconds * 1e6f);
+  uint64_t nextFrame = t0;
+  uint64_t nextWag   = o.wagEvery > 0.0f ? t0 + warmupUs : UINT64_MAX;
+  uint64_t nextLook  = o.lookEvery > 0.0f ? t0 + warmupUs : UINT64_MAX;
+  uint64_t nextCsv   = t0 + warmupUs;
+  bool     lookSide  = false;
+  bool     measuring = false;
+
+  while (NativeHost::nowUs() < endUs) {
+    const uint64_t now = NativeHost::nowUs();
+    if (!measuring && now >= t0 + warmupUs) {
+      g_model.resetStats();
+      servoBus.resetCurrentStats();
+      measuring = true;
+    }
+
+    if (now >= nextWag) {
+      Tail::wag();   // blocks like on the robot; the model keeps integrating
+      nextWag += (uint64_t)(o.wagEvery * 1e6f);
+      continue;
+    }
+
+    if (now >= nextLook) {
+      lookSide = !lookSide;
+      lookAround(lookSide);
+      nextLook += (uint64_t)(o.lookEvery * 1e6f);
+    }
+
+    if (now >= nextFrame) {
+      Leg::tick();
+      servoBus.frame();
+      nextFrame += CONTROL_PERIOD_MS * 1000u;
+      if (nextFrame <= now) nextFrame = now + CONTROL_PERIOD_MS * 1000u;
+    }
+
+    // PCA9685 link monitor, between frames like in loop()
+    servoBus.poll();
+    if (!g_restoredUs && NativeHost::nowUs() >= g_outageEndUs && legsRestored()) {
+      g_restoredUs = NativeHost::nowUs();
+    }
+
+    if (csv && measuring && now >= nextCsv) {
+      const Sim::Foot& r = g_model.foot(Sim::RIGHT);
+      const Sim::Foot& l = g_model.foot(Sim::LEFT);
+      fprintf(csv, "%.3f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%.2f,%.2f,%d,%.2f\n",
+              (now - t0 - warmupUs) / 1e6, g_model.bodyX(), g_model.bodyY(), g_model.yawDeg(),
+              g_model.heightMm(), r.x, r.z, r.contact ? 1 : 0, l.x, l.z, l.contact ? 1 : 0, g_model.comY());
+      nextCsv += o.csvEveryMs * 1000u;
+    }
+
+    // Sleep to the next event, like the firmware between frames
+    uint64_t next = nextFrame;
+    if (nextWag < next) next = nextWag;
+    if (nextLook < next) next = nextLook;
+    if (csv && measuring && nextCsv < next) next = nextCsv;
+    if (o.outageFor > 0.0f && next > now + 1000) next = now + 1000;   // loop()'s 1 ms passes
+    if (next > endUs) next = endUs;
+    if (next > NativeHost::nowUs()) delayMicroseconds((unsigned int)(next - NativeHost::nowUs()));
+  }
+
+  const double wallMs =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  if (csv) fclose(csv);
+  report(o, g_model.stats(), wallMs);
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include "Boot.h"
+#include "CommandTable.h"
+#include "Log.h"
+#include "Transport.h"
+
+#if !defined(REX_NATIVE)
+#include <esp_system.h>
+#endif
+
+namespace Boot {
+
+// ---------------- Internal state ----------------
+static uint32_t g_at[PHASE_COUNT] = { 0 };
+
+static const char* const kPhaseNames[PHASE_COUNT] = {
+  "setup", "servo_bus", "pose", "console", "ready",
+};
+
+void mark(Phase phase) {
+  // micros() can legitimately read 0 at the very start; keep 0 for "not reached"
+  if (phase < PHASE_COUNT) g_at[phase] = micros() | 1u;
+}
+
+uint32_t    at(Phase phase) { return phase < PHASE_COUNT ? g_at[phase] : 0; }
+const char* phaseName(Phase phase) { return kPhaseNames[phase < PHASE_COUNT ? phase : SETUP]; }
+
+const char* resetReason() {
+#if defined(REX_NATIVE)
+  return "host";
+#else
+  switch (esp_reset_reason()) {
+    case ESP_RST_POWERON:   return "power-on";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:       return "watchdog";
+    case ESP_RST_DEEPSLEEP: return "deep-sleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    default:                return "unknown";
+  }
+#endif
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+// BOOT: reset reason and the time each setup() phase finished (ms since
+// the application started)
+static void cmdBoot(const Args&) {
+  Print& out = console();
+  out.print(F("[Boot] reset="));
+  out.print(resetReason());
+  out.print(F(" fast="));
+  out.print(REX_FAST_BOOT);
+  out.print(F(" pose="));
+  out.print(g_at[POSE] / 1000.0f, 1);
+  out.print(F(" ms target="));
+  out.print(REX_BOOT_TARGET_MS);
+  out.println(g_at[POSE] / 1000u > REX_BOOT_TARGET_MS ? F(" ms (over)") : F(" ms"));
+
+  for (uint8_t p = 0; p < PHASE_COUNT; ++p) {
+    out.print(F("  "));
+    out.print(kPhaseNames[p]);
+    out.print(F(": "));
+    if (g_at[p]) {
+      out.print(g_at[p] / 1000.0f, 1);
+      out.println(F(" ms"));
+    } else {
+      out.println(F("-"));
+    }
+  }
+}
+
+static const CommandTable::Entry kBootCommands[] = {
+  { CMD_VERB("BOOT"), cmdBoot },
+};
+
+void begin() {
+  CommandTable::add(kBootCommands);
+
+  LOG_I("[Boot] Holding pose %.1f ms after start, ready at %.1f ms (reset: %s)",
+        g_at[POSE] / 1000.0f, g_at[READY] / 1000.0f, resetReason());
+  if (g_at[POSE] / 1000u > REX_BOOT_TARGET_MS) {
+    LOG_W("[Boot] Pose took longer than the %u ms target", (unsigned)REX_BOOT_TARGET_MS);
+  }
+}
+
+} // namespace Boot
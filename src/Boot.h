@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+
+// ========== Boot Configuration ==========
+// Fast boot (1): setup() brings the servos up and writes the neutral
+// stance before anything else; the console opens afterwards without
+// waiting for a host, and the banner goes through the log ring, which
+// drains in the background. 0 keeps the old behaviour of waiting up to
+// 5 s for the serial monitor (after the pose is held) so the banner is
+// seen live.
+#ifndef REX_FAST_BOOT
+#define REX_FAST_BOOT 1
+#endif
+
+// Reset-to-holding-pose budget (ms); BOOT flags boots that exceed it
+#ifndef REX_BOOT_TARGET_MS
+#define REX_BOOT_TARGET_MS 300
+#endif
+
+// ========== Boot Timeline ==========
+// Timestamps of the setup() phases, in micros() since the application
+// started (the ROM and second-stage bootloader run before that clock and
+// are not included).
+//   SETUP      setup() entered
+//   SERVO_BUS  LEDC timers reserved, PCA9685 probed and clocked
+//   POSE       every joint attached and written to its neutral angle
+//   CONSOLE    command transport open
+//   READY      banner queued, first control frame due
+namespace Boot {
+
+enum Phase : uint8_t {
+  SETUP = 0, SERVO_BUS, POSE, CONSOLE, READY, PHASE_COUNT
+};
+
+void        mark(Phase phase);
+uint32_t    at(Phase phase);        // µs; 0 if the phase has not been reached
+const char* phaseName(Phase phase);
+
+// Why the chip last reset ("power-on", "brownout", ...)
+const char* resetReason();
+
+// Register the BOOT command and log the timeline (call once, after READY)
+void begin();
+
+} // namespace Boot
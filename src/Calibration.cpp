@@ -0,0 +1,228 @@
+#include "Calibration.h"
+#include <Preferences.h>
+#include "CommandTable.h"
+#include "Log.h"
+#include "Transport.h"
+
+namespace Calibration {
+
+// ---------------- Internal state ----------------
+static ServoBus* SB = nullptr;
+
+// NVS layout: one blob, read whole at boot. kVersion changes whenever
+// Channel or Blob do, so an old blob is ignored instead of misread.
+static const char* const kNamespace = "rexcal";
+static const char* const kKey       = "table";
+static const uint16_t    kVersion   = 1;
+
+struct Blob {
+  uint16_t version;
+  uint16_t mask;                // calibrated channels
+  Channel  ch[SERVO_COUNT];
+};
+
+static Blob g_live   = { kVersion, 0, {} };   // what ServoBus is using
+static Blob g_stored = { kVersion, 0, {} };   // what NVS holds
+
+// Pulse tables hold µs * 16 in 16 bits
+static const uint16_t kPulseMin = 100;
+static const uint16_t kPulseMax = 4000;
+
+static bool valid(const Channel& c) {
+  return c.minPulse >= kPulseMin && c.minPulse < c.maxPulse && c.maxPulse <= kPulseMax &&
+         c.minDeg < c.maxDeg && c.maxDeg <= SERVO_TABLE_DEGREES &&
+         c.trimUs >= -CAL_TRIM_MAX && c.trimUs <= CAL_TRIM_MAX;
+}
+
+static inline bool calibrated(const Blob& b, uint8_t ch) { return b.mask & (1u << ch); }
+
+// ---------------- Apply ----------------
+static void apply(uint8_t ch) {
+  if (calibrated(g_live, ch)) {
+    const Channel& c = g_live.ch[ch];
+    SB->setCalibration(ch, ServoLimits(c.minPulse, c.maxPulse, c.minDeg, c.maxDeg), c.trimUs);
+  } else {
+    SB->clearCalibration(ch);
+  }
+}
+
+// Starting point for an edit: the live calibration, else the limits the
+// module attached the channel with
+static Channel& edit(uint8_t ch) {
+  Channel& c = g_live.ch[ch];
+  if (!calibrated(g_live, ch)) {
+    const ServoLimits& lim = SB->limits(ch);
+    c = { lim.minPulse, lim.maxPulse, (uint8_t)lim.minDeg, (uint8_t)lim.maxDeg, 0 };
+    g_live.mask |= (uint16_t)(1u << ch);
+  }
+  return c;
+}
+
+uint16_t uncommitted() {
+  uint16_t dirty = g_live.mask ^ g_stored.mask;
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    if (calibrated(g_live, ch) && calibrated(g_stored, ch) &&
+        memcmp(&g_live.ch[ch], &g_stored.ch[ch], sizeof(Channel)) != 0) {
+      dirty |= (uint16_t)(1u << ch);
+    }
+  }
+  return dirty;
+}
+
+// ---------------- NVS ----------------
+static bool load() {
+  Preferences prefs;
+  if (!prefs.begin(kNamespace, true)) return false;   // namespace not created yet
+  Blob b;
+  const size_t n = prefs.getBytes(kKey, &b, sizeof(b));
+  prefs.end();
+  if (n != sizeof(b) || b.version != kVersion) return false;
+
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    if (calibrated(b, ch) && !valid(b.ch[ch])) {
+      LOG_W("[Cal] Ignoring invalid stored calibration for ch %u", ch);
+      b.mask &= (uint16_t)~(1u << ch);
+    }
+  }
+  g_stored = b;
+  return true;
+}
+
+static bool store() {
+  Preferences prefs;
+  if (!prefs.begin(kNamespace, false)) return false;
+  g_live.version = kVersion;
+  const bool ok = prefs.putBytes(kKey, &g_live, sizeof(g_live)) == sizeof(g_live);
+  prefs.end();
+  if (ok) g_stored = g_live;
+  return ok;
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+// Channel in num[0] plus `values` more numbers; warns and returns false otherwise
+static bool args(const Args& a, const char* verb, uint8_t values, uint8_t& ch) {
+  const uint8_t need = (uint8_t)((1u << (values + 1)) - 1);
+  if ((a.present & need) != need || a.num[0] < 0 || a.num[0] >= SERVO_COUNT) {
+    LOG_W("[Cal] %s: expected <ch 0-15> and %u value(s)", verb, values);
+    return false;
+  }
+  ch = (uint8_t)a.num[0];
+  return true;
+}
+
+// Start from the current values, apply set(), keep the result if valid;
+// a rejected edit leaves the channel (and whether it is calibrated) as it was
+static void editChannel(const Args& a, const char* verb, uint8_t values, void (*set)(Channel&, const Args&)) {
+  uint8_t ch;
+  if (!args(a, verb, values, ch)) return;
+  const bool wasCalibrated = calibrated(g_live, ch);
+  Channel& c = edit(ch);
+  const Channel before = c;
+  set(c, a);
+
+  if (!valid(c)) {
+    LOG_W("[Cal] %s: out of range (pulses %u-%u us, degrees 0-180, min < max, trim +/-%u us)",
+          verb, kPulseMin, kPulseMax, CAL_TRIM_MAX);
+    c = before;
+    if (!wasCalibrated) g_live.mask &= (uint16_t)~(1u << ch);
+    return;
+  }
+  apply(ch);
+  LOG_I("[Cal] ch %u: %u-%u us", ch, c.minPulse, c.maxPulse);
+  LOG_I("[Cal] ch %u: %u-%u deg, trim %d us", ch, c.minDeg, c.maxDeg, c.trimUs);
+}
+
+static int32_t toInt(float v) { return (int32_t)(v < 0.0f ? v - 0.5f : v + 0.5f); }
+
+static void cmdCalUs(const Args& a) {
+  editChannel(a, "CAL_US", 2, [](Channel& c, const Args& a) {
+    c.minPulse = (uint16_t)constrain(toInt(a.num[1]), 0, 65535);
+    c.maxPulse = (uint16_t)constrain(toInt(a.num[2]), 0, 65535);
+  });
+}
+
+static void cmdCalDeg(const Args& a) {
+  editChannel(a, "CAL_DEG", 2, [](Channel& c, const Args& a) {
+    c.minDeg = (uint8_t)constrain(toInt(a.num[1]), 0, 255);
+    c.maxDeg = (uint8_t)constrain(toInt(a.num[2]), 0, 255);
+  });
+}
+
+static void cmdCalTrim(const Args& a) {
+  editChannel(a, "CAL_TRIM", 1, [](Channel& c, const Args& a) {
+    c.trimUs = (int16_t)constrain(toInt(a.num[1]), -32768, 32767);
+  });
+}
+
+static void cmdCalClear(const Args& a) {
+  uint8_t ch;
+  if (!args(a, "CAL_CLEAR", 0, ch)) return;
+  g_live.mask &= (uint16_t)~(1u << ch);
+  apply(ch);
+  LOG_I("[Cal] ch %u: compiled-in limits", ch);
+}
+
+static void cmdCalCommit(const Args&) {
+  if (store()) {
+    LOG_I("[Cal] Committed %u calibrated channel(s) to NVS", (unsigned)__builtin_popcount(g_live.mask));
+  } else {
+    LOG_E("[Cal] ERROR: NVS write failed");
+  }
+}
+
+// CAL: effective limits of every channel (* calibrated, + not committed)
+static void cmdCal(const Args&) {
+  Print& out = console();
+  const uint16_t dirty = uncommitted();
+  out.print(F("[Cal] calibrated="));
+  out.print(__builtin_popcount(g_live.mask));
+  out.print(F(" uncommitted="));
+  out.println(__builtin_popcount(dirty));
+
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    const ServoLimits& lim = SB->limits(ch);
+    out.print(F("  ch "));
+    out.print(ch);
+    out.print(F(": "));
+    out.print(lim.minPulse);
+    out.print('-');
+    out.print(lim.maxPulse);
+    out.print(F(" us, "));
+    out.print(lim.minDeg, 0);
+    out.print('-');
+    out.print(lim.maxDeg, 0);
+    out.print(F(" deg, trim "));
+    out.print(SB->trim(ch));
+    out.print(F(" us"));
+    if (SB->isCalibrated(ch)) out.print(F(" *"));
+    if (dirty & (1u << ch))   out.print(F(" +"));
+    out.println();
+  }
+}
+
+static const CommandTable::Entry kCalibrationCommands[] = {
+  { CMD_VERB("CAL"),        cmdCal },
+  { CMD_VERB("CAL_US"),     cmdCalUs },
+  { CMD_VERB("CAL_DEG"),    cmdCalDeg },
+  { CMD_VERB("CAL_TRIM"),   cmdCalTrim },
+  { CMD_VERB("CAL_CLEAR"),  cmdCalClear },
+  { CMD_VERB("CAL_COMMIT"), cmdCalCommit },
+};
+
+void begin(ServoBus* bus) {
+  SB = bus;
+  CommandTable::add(kCalibrationCommands);
+  if (!SB) return;
+
+  if (load()) {
+    g_live = g_stored;
+    for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+      if (calibrated(g_live, ch)) apply(ch);
+    }
+    LOG_I("[Cal] Loaded %u calibrated channel(s) from NVS", (unsigned)__builtin_popcount(g_live.mask));
+  }
+}
+
+} // namespace Calibration
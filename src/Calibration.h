@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include "ServoBus.h"
+
+// ========== Calibration Store ==========
+// Per-channel pulse limits, degree range and neutral trim, kept in NVS so
+// a servo can be trimmed without a rebuild. The compiled-in limits of
+// the body modules (LIM_KNEE, LIM_ROLL, ...) stay the defaults; a
+// calibrated channel overrides them in ServoBus, which compiles the
+// values into its degree tables.
+//
+// Edits apply live (the joint moves to its trimmed position at once) and
+// are lost on reset until CAL_COMMIT writes them:
+//   CAL                          list channels (* = calibrated, + = not committed)
+//   CAL_US <ch> <min> <max>      pulse limits, µs
+//   CAL_DEG <ch> <min> <max>     degree range mapped onto them
+//   CAL_TRIM <ch> <us>           neutral offset added to every degree write
+//   CAL_CLEAR <ch>               back to the compiled-in limits
+//   CAL_COMMIT                   store all channels in NVS
+namespace Calibration {
+
+// Stored form of one channel (8 bytes)
+struct Channel {
+  uint16_t minPulse;
+  uint16_t maxPulse;
+  uint8_t  minDeg;
+  uint8_t  maxDeg;
+  int16_t  trimUs;
+};
+
+// Trim range accepted by CAL_TRIM (µs)
+#define CAL_TRIM_MAX 300
+
+// Load the stored calibration (a single NVS read), apply it to bus and
+// register the CAL commands. Call right after ServoBus::begin() so the
+// first neutral stance is already calibrated.
+void begin(ServoBus* bus);
+
+// Channels whose live values differ from NVS
+uint16_t uncommitted();
+
+} // namespace Calibration
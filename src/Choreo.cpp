@@ -0,0 +1,468 @@
+#include "Choreo.h"
+#include <LittleFS.h>
+#include "CommandQueue.h"
+#include "CommandTable.h"
+#include "Log.h"
+#include "Transport.h"
+
+namespace Choreo {
+
+// ---------------- Internal state ----------------
+static ServoBus* SB = nullptr;
+static bool      g_mounted = false;
+
+static const uint8_t kMagic[4]   = { 'R', 'X', 'M', '1' };
+static const size_t  kHeaderSize = 16;
+static const char* const kExt = ".rxm";
+static const char* const kTempPath = "/upload.tmp";
+
+// "/" + name + ".rxm" + NUL
+static const size_t kPathMax = 1 + REX_PROTO_FILE_NAME + 4 + 1;
+
+struct Header {
+  uint16_t frameMs;
+  uint16_t periodUs;
+  uint16_t mask;
+  uint16_t flags;
+  uint32_t frames;
+};
+
+static inline uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+static bool readHeader(File& f, Header& h) {
+  uint8_t raw[kHeaderSize];
+  if (f.read(raw, sizeof(raw)) != sizeof(raw) || memcmp(raw, kMagic, sizeof(kMagic)) != 0) return false;
+  h.frameMs  = get16(&raw[4]);
+  h.periodUs = get16(&raw[6]);
+  h.mask     = get16(&raw[8]);
+  h.flags    = get16(&raw[10]);
+  h.frames   = get32(&raw[12]);
+  return true;
+}
+
+// Mounted on first use, never formatted: that takes seconds, erases
+// every show and must not hide inside a command handler. A partition that
+// does not mount (fresh or corrupt) stays unusable until CHOREO_FORMAT.
+static bool mount() {
+  if (!g_mounted) {
+    g_mounted = LittleFS.begin(false);
+    if (!g_mounted) LOG_E("[Choreo] ERROR: LittleFS mount failed (unformatted? CHOREO_FORMAT ERASE)");
+  }
+  return g_mounted;
+}
+
+static bool validName(const char* s, size_t len) {
+  if (len == 0 || len > REX_PROTO_FILE_NAME) return false;
+  for (size_t i = 0; i < len; ++i) {
+    const char c = s[i];
+    if (!isalnum((unsigned char)c) && c != '_' && c != '-') return false;
+  }
+  return true;
+}
+
+static void pathFor(const char* name, char* out) {
+  snprintf(out, kPathMax, "/%s%s", name, kExt);
+}
+
+// ---------------- Player ----------------
+// Two blocks consumed in turn: tick() reads the current one and moves to
+// the other when it is spent; refill() tops up whichever is empty.
+static File     g_file;
+static char     g_name[REX_PROTO_FILE_NAME + 1] = { 0 };
+static bool     g_playing = false;
+static uint8_t  g_block[2][CHOREO_BLOCK_SIZE];
+static uint16_t g_blockLen[2] = { 0, 0 };
+static uint8_t  g_cur = 0;
+static uint16_t g_pos = 0;
+static uint32_t g_fileLeft = 0;            // record bytes not yet read from flash
+static uint16_t g_periodUs = 20000;
+static uint16_t g_counts[SERVO_COUNT];     // per channel, as of the staged record
+static uint32_t g_lastFrame = 0;           // frame of the staged record
+
+// The next record, decoded but not yet due
+static bool     g_staged = false;
+static uint32_t g_nextFrame = 0;
+static uint16_t g_nextMask = 0;
+
+static Stats g_stats = { 0, 0, 0, 0 };
+
+static inline uint32_t buffered() {
+  return (uint32_t)(g_blockLen[g_cur] - g_pos) + g_blockLen[g_cur ^ 1];
+}
+
+static int readByte() {
+  if (g_pos >= g_blockLen[g_cur]) return -1;
+  const uint8_t b = g_block[g_cur][g_pos++];
+  if (g_pos == g_blockLen[g_cur]) {
+    // Block spent: hand it to refill() and continue in the other one
+    g_blockLen[g_cur] = 0;
+    g_pos = 0;
+    g_cur ^= 1;
+  }
+  return b;
+}
+
+static bool readVarint(uint32_t& v) {
+  v = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    const int b = readByte();
+    if (b < 0) return false;
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static bool refill() {
+  for (uint8_t k = 0; k < 2; ++k) {
+    const uint8_t b = g_cur ^ k;
+    if (g_blockLen[b] || !g_fileLeft) continue;
+    const size_t want = g_fileLeft < CHOREO_BLOCK_SIZE ? g_fileLeft : CHOREO_BLOCK_SIZE;
+    const size_t n = g_file.read(g_block[b], want);
+    if (n != want) return false;
+    g_blockLen[b] = (uint16_t)n;
+    g_fileLeft -= n;
+    ++g_stats.refills;
+  }
+  return true;
+}
+
+enum Step : uint8_t { STAGED, WAIT, END, BAD };
+
+// Decode the next record into g_counts / g_next*. Only starts when the
+// whole record is guaranteed to be buffered, so a record is never split
+// across a refill.
+static Step stage() {
+  const uint32_t avail = buffered();
+  if (avail == 0 && g_fileLeft == 0) return END;
+  if (avail < CHOREO_MAX_RECORD && g_fileLeft > 0) return WAIT;
+
+  uint32_t delta;
+  if (!readVarint(delta)) return BAD;
+  const int lo = readByte();
+  const int hi = readByte();
+  if (lo < 0 || hi < 0) return BAD;
+  const uint16_t mask = (uint16_t)(lo | (hi << 8));
+
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    if (!(mask & (1u << ch))) continue;
+    uint32_t z;
+    if (!readVarint(z)) return BAD;
+    g_counts[ch] = (uint16_t)(g_counts[ch] + (int32_t)((z >> 1) ^ (0u - (z & 1))));
+  }
+
+  g_lastFrame += delta;
+  g_nextFrame = g_lastFrame;
+  g_nextMask  = mask;
+  g_staged    = true;
+  return STAGED;
+}
+
+static void apply(uint16_t mask) {
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    if (!(mask & (1u << ch))) continue;
+    const int32_t us = (int32_t)(((uint32_t)g_counts[ch] * g_periodUs + 2048) >> 12) + SB->trim(ch);
+    SB->writeMicroseconds(ch, (uint16_t)constrain(us, 0, 65535));
+  }
+}
+
+bool play(const char* name) {
+  if (!SB || !validName(name, strlen(name))) {
+    LOG_W("[Choreo] Bad name (A-Z a-z 0-9 _ -, up to %u chars)", REX_PROTO_FILE_NAME);
+    return false;
+  }
+  if (!mount()) return false;
+  stop();
+
+  char path[kPathMax];
+  pathFor(name, path);
+  g_file = LittleFS.open(path, FILE_READ);
+  if (!g_file) {
+    LOG_W("[Choreo] No show named %s", Log::text(name));
+    return false;
+  }
+
+  Header h;
+  if (!readHeader(g_file, h) || h.frameMs != CONTROL_PERIOD_MS || h.periodUs == 0) {
+    LOG_E("[Choreo] ERROR: %s is not an RXM1 file for %u ms frames", Log::text(name), CONTROL_PERIOD_MS);
+    g_file.close();
+    return false;
+  }
+
+  strcpy(g_name, name);
+  g_periodUs   = h.periodUs;
+  g_fileLeft   = g_file.size() - kHeaderSize;
+  g_blockLen[0] = g_blockLen[1] = 0;
+  g_cur = 0;
+  g_pos = 0;
+  memset(g_counts, 0, sizeof(g_counts));
+  g_lastFrame = 0;
+  g_staged    = false;
+  g_stats     = { 0, h.frames, 0, 0 };
+
+  if (!refill()) {
+    LOG_E("[Choreo] ERROR: read failed: %s", Log::text(name));
+    g_file.close();
+    return false;
+  }
+  g_playing = true;
+  LOG_I("[Choreo] Playing %s: %lu frames (%lu ms)", Log::text(name),
+        (unsigned long)h.frames, (unsigned long)h.frames * CONTROL_PERIOD_MS);
+  return true;
+}
+
+void stop() {
+  if (g_playing) {
+    LOG_I("[Choreo] Stopped %s at frame %lu", Log::text(g_name), (unsigned long)g_stats.frame);
+  }
+  g_playing = false;
+  g_staged  = false;
+  if (g_file) g_file.close();
+}
+
+bool playing() { return g_playing; }
+
+void tick() {
+  if (!g_playing) return;
+
+  // Apply every record due by this frame
+  for (;;) {
+    if (!g_staged) {
+      const Step s = stage();
+      if (s == END) break;
+      if (s == WAIT) {
+        // Flash fell behind: hold this frame rather than skip records
+        ++g_stats.underruns;
+        return;
+      }
+      if (s == BAD) {
+        LOG_E("[Choreo] ERROR: %s is corrupt near frame %lu", Log::text(g_name), (unsigned long)g_lastFrame);
+        g_playing = false;
+        return;
+      }
+    }
+    if (g_nextFrame > g_stats.frame) break;
+    apply(g_nextMask);
+    g_staged = false;
+  }
+
+  if (++g_stats.frame >= g_stats.frames) {
+    g_playing = false;
+    LOG_I("[Choreo] Finished %s (%lu underruns)", Log::text(g_name), (unsigned long)g_stats.underruns);
+  }
+}
+
+void poll() {
+  if (!g_playing) {
+    if (g_file) g_file.close();   // show ended in tick()
+    return;
+  }
+  if (!refill()) {
+    LOG_E("[Choreo] ERROR: read failed: %s", Log::text(g_name));
+    stop();
+  }
+}
+
+const Stats& stats() { return g_stats; }
+
+// ---------------- Upload ----------------
+static struct Upload {
+  File     file;
+  char     name[REX_PROTO_FILE_NAME + 1];
+  uint32_t size;
+  uint32_t offset;
+  uint16_t crc;
+  bool     active;
+} g_up = { File(), { 0 }, 0, 0, 0xFFFF, false };
+
+static RexProto::FileAck ack(uint8_t status) {
+  RexProto::FileAck a;
+  a.status = status;
+  a.offset = g_up.offset;
+  return a;
+}
+
+static RexProto::FileAck abortUpload(uint8_t status) {
+  if (g_up.file) g_up.file.close();
+  LittleFS.remove(kTempPath);
+  g_up.active = false;
+  return ack(status);
+}
+
+RexProto::FileAck fileBegin(const RexProto::FileBegin& m) {
+  if (g_up.active) abortUpload(RexProto::FILE_OK);
+  g_up.offset = 0;
+  if (!validName(m.name, strlen(m.name))) return ack(RexProto::FILE_ERR_NAME);
+  if (!mount()) return ack(RexProto::FILE_ERR_OPEN);
+  if (m.size > LittleFS.totalBytes() - LittleFS.usedBytes()) return ack(RexProto::FILE_ERR_SIZE);
+
+  g_up.file = LittleFS.open(kTempPath, FILE_WRITE);
+  if (!g_up.file) return ack(RexProto::FILE_ERR_OPEN);
+  strcpy(g_up.name, m.name);
+  g_up.size   = m.size;
+  g_up.crc    = 0xFFFF;
+  g_up.active = true;
+  return ack(RexProto::FILE_OK);
+}
+
+RexProto::FileAck fileData(const RexProto::FileData& m) {
+  if (!g_up.active) return ack(RexProto::FILE_ERR_STATE);
+  // A resent chunk (lost ack) gets the real offset back so the host can resume
+  if (m.offset != g_up.offset) return ack(RexProto::FILE_ERR_OFFSET);
+  if (g_up.offset + m.len > g_up.size) return abortUpload(RexProto::FILE_ERR_SIZE);
+  if (g_up.file.write(m.data, m.len) != m.len) return abortUpload(RexProto::FILE_ERR_WRITE);
+
+  g_up.crc = RexProto::crc16(m.data, m.len, g_up.crc);
+  g_up.offset += m.len;
+  return ack(RexProto::FILE_OK);
+}
+
+RexProto::FileAck fileEnd(const RexProto::FileEnd& m) {
+  if (!g_up.active) return ack(RexProto::FILE_ERR_STATE);
+  g_up.file.close();
+  if (g_up.offset != g_up.size || m.crc != g_up.crc) {
+    LOG_W("[Choreo] Upload of %s failed its CRC check", Log::text(g_up.name));
+    return abortUpload(RexProto::FILE_ERR_CRC);
+  }
+
+  char path[kPathMax];
+  pathFor(g_up.name, path);
+  if (g_playing && strcmp(g_name, g_up.name) == 0) stop();
+  LittleFS.remove(path);
+  if (!LittleFS.rename(kTempPath, path)) return abortUpload(RexProto::FILE_ERR_WRITE);
+
+  g_up.active = false;
+  LOG_I("[Choreo] Stored %s (%lu bytes)", Log::text(g_up.name), (unsigned long)g_up.size);
+  return ack(RexProto::FILE_OK);
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+// Show name from the first token after the verb (numeric names included)
+static bool nameArg(const Args& a, const char* verb, char* out) {
+  const LineToken& t = (a.present & 1) ? a.text[0] : a.word;
+  if (!t.ptr || !validName(t.ptr, t.len)) {
+    LOG_W("[Choreo] %s: expected a name (A-Z a-z 0-9 _ -, up to %u chars)", verb, REX_PROTO_FILE_NAME);
+    return false;
+  }
+  memcpy(out, t.ptr, t.len);
+  out[t.len] = '\0';
+  return true;
+}
+
+static void cmdChoreo(const Args&) {
+  Print& out = console();
+  out.print(F("[Choreo] "));
+  if (g_playing) {
+    out.print(F("playing "));
+    out.print(g_name);
+  } else {
+    out.print(F("idle"));
+  }
+  out.print(F(" frame="));
+  out.print(g_stats.frame);
+  out.print('/');
+  out.print(g_stats.frames);
+  out.print(F(" underruns="));
+  out.print(g_stats.underruns);
+  out.print(F(" refills="));
+  out.println(g_stats.refills);
+
+  if (!mount()) return;
+  out.print(F("[Choreo] flash "));
+  out.print((unsigned long)LittleFS.usedBytes());
+  out.print('/');
+  out.print((unsigned long)LittleFS.totalBytes());
+  out.print(F(" bytes, buffer "));
+  out.print(2 * CHOREO_BLOCK_SIZE);
+  out.println(F(" bytes"));
+}
+
+static void cmdChoreoList(const Args&) {
+  if (!mount()) return;
+  Print& out = console();
+  File dir = LittleFS.open("/");
+  uint16_t count = 0;
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    const char* name = f.name();
+    const size_t len = strlen(name);
+    if (f.isDirectory() || len <= 4 || strcmp(name + len - 4, kExt) != 0) continue;
+
+    Header h;
+    const bool ok = readHeader(f, h);
+    out.print(F("  "));
+    out.write(name, len - 4);
+    out.print(F(": "));
+    out.print((unsigned long)f.size());
+    out.print(F(" bytes"));
+    if (ok) {
+      out.print(F(", "));
+      out.print((unsigned long)h.frames * h.frameMs);
+      out.print(F(" ms"));
+    } else {
+      out.print(F(", not RXM1"));
+    }
+    out.println();
+    ++count;
+  }
+  out.print(F("[Choreo] "));
+  out.print(count);
+  out.println(F(" show(s)"));
+}
+
+static void cmdChoreoPlay(const Args& a) {
+  char name[REX_PROTO_FILE_NAME + 1];
+  if (nameArg(a, "CHOREO_PLAY", name)) play(name);
+}
+
+static void cmdChoreoDelete(const Args& a) {
+  char name[REX_PROTO_FILE_NAME + 1];
+  if (!nameArg(a, "CHOREO_DELETE", name) || !mount()) return;
+  if (g_playing && strcmp(g_name, name) == 0) stop();
+
+  char path[kPathMax];
+  pathFor(name, path);
+  if (LittleFS.remove(path)) {
+    LOG_I("[Choreo] Deleted %s", Log::text(name));
+  } else {
+    LOG_W("[Choreo] No show named %s", Log::text(name));
+  }
+}
+
+// Blocks loop() for as long as the flash takes, so only on request, with
+// the word spelled out
+static void cmdChoreoFormat(const Args& a) {
+  if (!a.word.equals("ERASE")) {
+    LOG_W("[Choreo] CHOREO_FORMAT erases every show; send CHOREO_FORMAT ERASE");
+    return;
+  }
+  stop();
+  if (g_up.active) abortUpload(RexProto::FILE_OK);
+
+  const uint32_t t0 = millis();
+  LittleFS.end();
+  g_mounted = LittleFS.format() && LittleFS.begin(false);
+  if (g_mounted) {
+    LOG_I("[Choreo] Formatted in %lu ms", (unsigned long)(millis() - t0));
+  } else {
+    LOG_E("[Choreo] ERROR: LittleFS format failed");
+  }
+}
+
+static const CommandTable::Entry kChoreoCommands[] = {
+  { CMD_VERB("CHOREO"),        cmdChoreo },
+  { CMD_VERB("CHOREO_LIST"),   cmdChoreoList },
+  { CMD_VERB("CHOREO_PLAY"),   cmdChoreoPlay },
+  { CMD_VERB("CHOREO_STOP"),   [](const Args&) { stop(); } },
+  { CMD_VERB("CHOREO_DELETE"), cmdChoreoDelete },
+  { CMD_VERB("CHOREO_FORMAT"), cmdChoreoFormat },
+};
+
+void begin(ServoBus* bus) {
+  SB = bus;
+  CommandTable::add(kChoreoCommands);
+}
+
+} // namespace Choreo
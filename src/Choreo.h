@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+#include "RexProtocol.h"
+#include "ServoBus.h"
+
+// ========== Choreo Configuration ==========
+// The player holds two blocks of the file in RAM and refills the spent one
+// from flash in loop(), outside the control frame. A block must hold a few
+// frames of the densest show (CHOREO_MAX_RECORD bytes per frame).
+#ifndef CHOREO_BLOCK_SIZE
+#define CHOREO_BLOCK_SIZE 256
+#endif
+
+// Longest possible record: frame delta, mask, 16 count deltas
+#define CHOREO_MAX_RECORD (5 + 2 + 3 * SERVO_COUNT)
+
+// ========== Choreography Files ==========
+// Motion shows stored in the LittleFS partition as /<name>.rxm and played
+// back on the control frame grid, so a walk-roar-wag sequence runs with
+// frame accuracy and without a host sending commands in real time.
+//
+// Format (little-endian):
+//   header (16 bytes)
+//     "RXM1" | frameMs u16 (= CONTROL_PERIOD_MS) | periodUs u16 (PWM period the
+//     counts refer to, 20000) | channel mask u16 | flags u16 (0) | frames u32
+//   records, in frame order
+//     frame delta (LEB128, frames since the previous record; the first is
+//     counted from frame 0) | changed-channel mask (u16) | per set bit, the
+//     change in PCA9685 counts from that channel's previous value (zigzag
+//     LEB128; every channel starts at 0)
+// A channel's pulse is counts * periodUs / 4096 µs plus its calibration
+// trim. Frames without a record hold the previous pulses; playback ends
+// after `frames` frames. tools/rexmotion.py compiles keyframe timelines into
+// shows and uploads, lists and plays them.
+//
+// RAM use is two blocks plus one decoded record, whatever the file length.
+// While a show plays it owns the servos (gait and sweep are paused); if
+// flash falls behind, the show holds its frame and counts an underrun.
+//
+//   CHOREO                  player and filesystem status
+//   CHOREO_LIST             stored shows with size and length
+//   CHOREO_PLAY <name>      start a show (stops the one playing)
+//   CHOREO_STOP             stop; the servos hold their last pulses
+//   CHOREO_DELETE <name>    remove a show
+//   CHOREO_FORMAT ERASE     format the partition (erases every show, blocks
+//                           for seconds; the only way a fresh one is set up)
+namespace Choreo {
+
+// Register the CHOREO commands. The filesystem is mounted on first use so
+// it costs nothing at boot, and is never formatted implicitly.
+void begin(ServoBus* bus);
+
+// Start / stop a show by name (no path, no extension)
+bool play(const char* name);
+void stop();
+bool playing();
+
+// Control frame: apply the records due this frame (decodes from RAM only)
+void tick();
+
+// Main loop: refill spent blocks from flash and finish a stopped show
+void poll();
+
+struct Stats {
+  uint32_t frame;       // frames played of the current / last show
+  uint32_t frames;      // its length
+  uint32_t underruns;   // frames held because no record was buffered
+  uint32_t refills;     // blocks read from flash
+};
+const Stats& stats();
+
+// ---------------- Upload ----------------
+// FILE_BEGIN / FILE_DATA / FILE_END frames (RexProtocol.h). Data goes to a
+// temporary file that replaces /<name>.rxm only when size and CRC match.
+RexProto::FileAck fileBegin(const RexProto::FileBegin& m);
+RexProto::FileAck fileData(const RexProto::FileData& m);
+RexProto::FileAck fileEnd(const RexProto::FileEnd& m);
+
+} // namespace Choreo
@@ -0,0 +1,181 @@
+#include "CommandQueue.h"
+#include "CommandTable.h"
+#include "Transport.h"
+#include <string.h>
+
+namespace CommandQueue {
+
+// ---------------- Internal state ----------------
+// Lines live in fixed slots; the heap orders slot indices by (atMs, seq)
+struct Slot {
+  uint32_t atMs;
+  uint32_t seq;           // arrival order breaks ties
+  uint8_t  len;
+  char     line[LINE_READER_MAX_LINE + 1];
+};
+
+static Slot    g_slots[CMD_QUEUE_CAPACITY];
+static uint8_t g_heap[CMD_QUEUE_CAPACITY];   // min-heap of slot indices
+static uint8_t g_free[CMD_QUEUE_CAPACITY];   // free slot stack
+static uint8_t g_size = 0;
+static uint8_t g_freeTop = 0;
+static uint32_t g_seq = 0;
+static bool    g_init = false;
+
+static char    g_exec[LINE_READER_MAX_LINE + 1];   // line handed out by popDue()
+static Stats   g_stats = { 0, 0, 0, 0, 0, 0 };
+
+static_assert(CMD_QUEUE_CAPACITY <= 127, "heap indices are 8-bit");
+static_assert(LINE_READER_MAX_LINE <= 255, "queued lines store an 8-bit length");
+
+// Wrap-safe "a is before b" on the millis() clock
+static inline bool before(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+
+static inline bool less(uint8_t a, uint8_t b) {
+  const Slot& x = g_slots[a];
+  const Slot& y = g_slots[b];
+  if (x.atMs != y.atMs) return before(x.atMs, y.atMs);
+  return before(x.seq, y.seq);
+}
+
+static void siftUp(uint8_t i) {
+  while (i > 0) {
+    const uint8_t parent = (i - 1) / 2;
+    if (!less(g_heap[i], g_heap[parent])) break;
+    const uint8_t t = g_heap[i]; g_heap[i] = g_heap[parent]; g_heap[parent] = t;
+    i = parent;
+  }
+}
+
+static void siftDown(uint8_t i) {
+  for (;;) {
+    const uint8_t l = 2 * i + 1;
+    const uint8_t r = l + 1;
+    uint8_t m = i;
+    if (l < g_size && less(g_heap[l], g_heap[m])) m = l;
+    if (r < g_size && less(g_heap[r], g_heap[m])) m = r;
+    if (m == i) break;
+    const uint8_t t = g_heap[i]; g_heap[i] = g_heap[m]; g_heap[m] = t;
+    i = m;
+  }
+}
+
+static void init() {
+  g_size = 0;
+  g_freeTop = CMD_QUEUE_CAPACITY;
+  for (uint8_t i = 0; i < CMD_QUEUE_CAPACITY; ++i) {
+    g_free[i] = CMD_QUEUE_CAPACITY - 1 - i;
+  }
+  g_init = true;
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+// SYNC <host_ms>  ->  SYNC <host_ms> <device_ms>
+// host_ms is echoed verbatim so large host clocks keep full precision
+static void cmdSync(const Args& a) {
+  Print& out = console();
+  const uint32_t deviceMs = millis();
+  out.print(F("SYNC "));
+  if (a.text[0].ptr) {
+    out.write((const uint8_t*)a.text[0].ptr, a.text[0].len);
+  } else {
+    out.print('0');
+  }
+  out.print(' ');
+  out.println(deviceMs);
+}
+
+static void cmdQueue(const Args&) {
+  Print& out = console();
+  out.print(F("[Queue] depth="));
+  out.print(depth());
+  out.print(F("/"));
+  out.print(CMD_QUEUE_CAPACITY);
+  out.print(F(" queued="));
+  out.print(g_stats.queued);
+  out.print(F(" executed="));
+  out.print(g_stats.executed);
+  out.print(F(" late="));
+  out.print(g_stats.late);
+  out.print(F(" (max "));
+  out.print(g_stats.maxLateMs);
+  out.print(F(" ms) rejected="));
+  out.print(g_stats.rejected);
+  out.print(F(" dropped="));
+  out.println(g_stats.dropped);
+}
+
+static const CommandTable::Entry kQueueCommands[] = {
+  { CMD_VERB("SYNC"),        cmdSync },
+  { CMD_VERB("QUEUE"),       cmdQueue },
+  { CMD_VERB("QUEUE_CLEAR"), [](const Args&) { clear(); } },
+};
+
+// ---------------- Public API ----------------
+void begin() {
+  if (!g_init) init();
+  CommandTable::add(kQueueCommands);
+}
+
+bool push(uint32_t atMs, const char* line, size_t len) {
+  if (!g_init) init();
+
+  if ((int32_t)(atMs - millis()) > (int32_t)CMD_QUEUE_HORIZON_MS) {
+    ++g_stats.rejected;
+    return false;
+  }
+  if (g_freeTop == 0 || len > LINE_READER_MAX_LINE) {
+    ++g_stats.dropped;
+    return false;
+  }
+
+  const uint8_t idx = g_free[--g_freeTop];
+  Slot& s = g_slots[idx];
+  s.atMs = atMs;
+  s.seq  = g_seq++;
+  s.len  = (uint8_t)len;
+  memcpy(s.line, line, len);
+  s.line[len] = '\0';
+
+  g_heap[g_size] = idx;
+  siftUp(g_size);
+  ++g_size;
+  ++g_stats.queued;
+  return true;
+}
+
+bool popDue(uint32_t frameMs, char*& line, size_t& len) {
+  if (g_size == 0) return false;
+
+  const uint8_t idx = g_heap[0];
+  const Slot& s = g_slots[idx];
+
+  // Due in this frame if its time is before the frame's midpoint
+  if (!before(s.atMs, frameMs + CONTROL_PERIOD_MS / 2)) return false;
+
+  const uint32_t lateMs = before(s.atMs, frameMs) ? frameMs - s.atMs : 0;
+  if (lateMs > CONTROL_PERIOD_MS) ++g_stats.late;
+  if (lateMs > g_stats.maxLateMs) g_stats.maxLateMs = lateMs;
+
+  memcpy(g_exec, s.line, s.len + 1);
+  line = g_exec;
+  len  = s.len;
+
+  g_heap[0] = g_heap[--g_size];
+  siftDown(0);
+  g_free[g_freeTop++] = idx;
+  ++g_stats.executed;
+  return true;
+}
+
+void clear() {
+  init();
+}
+
+size_t depth() { return g_size; }
+
+const Stats& stats() { return g_stats; }
+
+} // namespace CommandQueue
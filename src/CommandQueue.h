@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "LineReader.h"
+
+// ========== Command Queue Configuration ==========
+// Pending timestamped commands (each holds one line)
+#ifndef CMD_QUEUE_CAPACITY
+#define CMD_QUEUE_CAPACITY 16
+#endif
+
+// Commands scheduled further ahead than this are rejected (bad clock sync)
+#ifndef CMD_QUEUE_HORIZON_MS
+#define CMD_QUEUE_HORIZON_MS 60000UL
+#endif
+
+// Control frame period shared with the main loop
+#ifndef CONTROL_PERIOD_MS
+#define CONTROL_PERIOD_MS 20
+#endif
+
+namespace CommandQueue {
+
+// ========== Scheduling ==========
+// Lines may carry an execution time on the device clock (millis()):
+//   @123456 WALK_FORWARD          absolute device time
+//   @+250 ROAR                    relative to arrival
+//   {"at":123456, "target":...}   JSON schema / legacy JSON
+// The host learns the device clock with the SYNC handshake:
+//   host -> SYNC <host_ms>
+//   dev  -> SYNC <host_ms> <device_ms>
+// offset = device_ms - (host_ms + rtt / 2)
+
+// Register SYNC / QUEUE / QUEUE_CLEAR with CommandTable
+void begin();
+
+// Queue a line for execution at device time atMs.
+// Returns false when the queue is full or atMs is beyond the horizon.
+bool push(uint32_t atMs, const char* line, size_t len);
+
+// Pop the next line due in the frame starting at frameMs. A command is due
+// in the frame nearest to its timestamp (within half a period).
+// The line is a copy the caller may rewrite; it stays valid until the
+// next popDue().
+bool popDue(uint32_t frameMs, char*& line, size_t& len);
+
+// Drop everything pending
+void clear();
+
+// ========== Statistics ==========
+struct Stats {
+  uint32_t queued;        // accepted by push()
+  uint32_t executed;      // returned by popDue()
+  uint32_t late;          // executed more than one frame after their time
+  uint32_t rejected;      // beyond the horizon
+  uint32_t dropped;       // queue full
+  uint32_t maxLateMs;     // worst lateness seen
+};
+
+size_t       depth();
+const Stats& stats();
+
+} // namespace CommandQueue
@@ -1,5 +1,13 @@
 #include "CommandRouter.h"
 #include <ArduinoJson.h>
+#include "Choreo.h"
+#include "CommandTable.h"
+#include "CommandQueue.h"
+#include "LineReader.h"
+#include "Log.h"
+#include "RexProtocol.h"
+#include "Trace.h"
+#include "Transport.h"
 
 // Motion modules
 #include "Servo_Functions/Leg_Function.h"
@@ -12,6 +20,8 @@
 namespace CommandRouter {
 
 // ---------------- Internal state ----------------
+static ServoBus* SB = nullptr;      // Pointer to ServoBus (binary joint frames)
+
 static float g_pelvisLevel = 0.50f; // 0..1
 static float g_spineLevel  = 0.50f; // 0..1
 static float g_headPitch   = 0.50f; // 0..1  (up/down)
@@ -49,187 +59,560 @@ static void applyAnalogs() {
   applyTailYaw(g_tailYaw);
 }
 
-void begin() {
-  g_pelvisLevel = 0.50f;
-  g_spineLevel  = 0.50f;
-  g_headPitch   = 0.50f;
-  g_neckYaw     = 0.50f;
-  g_tailYaw     = 0.50f;
-  applyAnalogs();
+// ---------------- JSON schema ids ----------------
+// Field values are resolved to small enums once, right after parsing, so
+// the handlers below never compare strings.
+enum Part : uint8_t { PART_NONE = 0, PART_LEGS, PART_PELVIS, PART_SPINE, PART_HEAD, PART_NECK, PART_TAIL,
+                      PART_FULL_BODY, PART_COUNT };
+enum Phase : uint8_t { PHASE_NONE = 0, PHASE_START, PHASE_HOLD, PHASE_STOP };
+enum Action : uint8_t {
+  ACT_NONE = 0,
+  ACT_MOVE_FORWARD, ACT_MOVE_BACKWARD, ACT_MOVE_LEFT, ACT_MOVE_RIGHT,   // legs
+  ACT_PELVIS_UP, ACT_PELVIS_DOWN,
+  ACT_SPINE_UP,  ACT_SPINE_DOWN,
+  ACT_HEAD_UP,   ACT_HEAD_DOWN,
+  ACT_NECK_LEFT, ACT_NECK_RIGHT,
+  ACT_TAIL_LEFT, ACT_TAIL_RIGHT,
+  ACT_UP, ACT_DOWN, ACT_LEFT, ACT_RIGHT                                 // fullBody
+};
+
+struct NameId {
+  uint32_t    id;      // CMD_ID(name)
+  const char* name;
+  uint8_t     value;
+};
+
+static const NameId kParts[] = {
+  { CMD_VERB("legs"),   PART_LEGS },
+  { CMD_VERB("pelvis"), PART_PELVIS },
+  { CMD_VERB("spine"),  PART_SPINE },
+  { CMD_VERB("head"),   PART_HEAD },
+  { CMD_VERB("neck"),   PART_NECK },
+  { CMD_VERB("tail"),   PART_TAIL },
+};
+
+static const NameId kPhases[] = {
+  { CMD_VERB("start"), PHASE_START },
+  { CMD_VERB("hold"),  PHASE_HOLD },
+  { CMD_VERB("stop"),  PHASE_STOP },
+};
+
+static const NameId kActions[] = {
+  { CMD_VERB("move_forward"),  ACT_MOVE_FORWARD },
+  { CMD_VERB("move_backward"), ACT_MOVE_BACKWARD },
+  { CMD_VERB("move_left"),     ACT_MOVE_LEFT },
+  { CMD_VERB("move_right"),    ACT_MOVE_RIGHT },
+  { CMD_VERB("pelvis_up"),     ACT_PELVIS_UP },
+  { CMD_VERB("pelvis_down"),   ACT_PELVIS_DOWN },
+  { CMD_VERB("spine_up"),      ACT_SPINE_UP },
+  { CMD_VERB("spine_down"),    ACT_SPINE_DOWN },
+  { CMD_VERB("head_up"),       ACT_HEAD_UP },
+  { CMD_VERB("head_down"),     ACT_HEAD_DOWN },
+  { CMD_VERB("neck_left"),     ACT_NECK_LEFT },
+  { CMD_VERB("neck_right"),    ACT_NECK_RIGHT },
+  { CMD_VERB("tail_left"),     ACT_TAIL_LEFT },
+  { CMD_VERB("tail_right"),    ACT_TAIL_RIGHT },
+  { CMD_VERB("up"),            ACT_UP },
+  { CMD_VERB("down"),          ACT_DOWN },
+  { CMD_VERB("left"),          ACT_LEFT },
+  { CMD_VERB("right"),         ACT_RIGHT },
+};
+
+// Hash once, then compare ids; the name check only runs on an id match
+template <size_t N>
+static uint8_t lookupId(const NameId (&table)[N], const char* s) {
+  if (!s || !*s) return 0;
+  const uint32_t h = CommandTable::hash(s, strlen(s));
+  for (size_t i = 0; i < N; ++i) {
+    if (table[i].id == h && strcmp(table[i].name, s) == 0) return table[i].value;
+  }
+  return 0;
 }
 
+static inline bool isActive(Phase phase) { return phase == PHASE_START || phase == PHASE_HOLD; }
+
 // ---------------- Helpers for new JSON schema ----------------
-static void handleLegs(const String& command, const String& phase) {
-  if (phase == "start" || phase == "hold") {
-    if (command == "move_forward")       { Leg::walkForward(0.8f); }
-    else if (command == "move_backward") { Leg::walkBackward(0.8f); }
-    else if (command == "move_left")     { Leg::turnLeft(0.8f); }
-    else if (command == "move_right")    { Leg::turnRight(0.8f); }
-  } else if (phase == "stop") {
+static void handleLegs(Action command, Phase phase) {
+  if (isActive(phase)) {
+    if (command == ACT_MOVE_FORWARD)       { Leg::walkForward(0.8f); }
+    else if (command == ACT_MOVE_BACKWARD) { Leg::walkBackward(0.8f); }
+    else if (command == ACT_MOVE_LEFT)     { Leg::turnLeft(0.8f); }
+    else if (command == ACT_MOVE_RIGHT)    { Leg::turnRight(0.8f); }
+  } else if (phase == PHASE_STOP) {
     Leg::stop();
   }
 }
 
-static void handlePelvis(const String& command, const String& phase) {
-  if (phase == "start" || phase == "hold") {
-    if (command == "pelvis_up")   g_pelvisLevel = clamp01(g_pelvisLevel + NUDGE_FINE);
-    if (command == "pelvis_down") g_pelvisLevel = clamp01(g_pelvisLevel - NUDGE_FINE);
+static void handlePelvis(Action command, Phase phase) {
+  if (isActive(phase)) {
+    if (command == ACT_PELVIS_UP)   g_pelvisLevel = clamp01(g_pelvisLevel + NUDGE_FINE);
+    if (command == ACT_PELVIS_DOWN) g_pelvisLevel = clamp01(g_pelvisLevel - NUDGE_FINE);
     Pelvis::stabilize(g_pelvisLevel);
-  } else if (phase == "stop") {
+  } else if (phase == PHASE_STOP) {
     // Keep last position (or uncomment to re-center):
     // g_pelvisLevel = 0.5f; Pelvis::stabilize(g_pelvisLevel);
   }
 }
 
-static void handleSpine(const String& command, const String& phase) {
-  if (phase == "start" || phase == "hold") {
-    if (command == "spine_up")   g_spineLevel = clamp01(g_spineLevel + NUDGE_FINE);
-    if (command == "spine_down") g_spineLevel = clamp01(g_spineLevel - NUDGE_FINE);
+static void handleSpine(Action command, Phase phase) {
+  if (isActive(phase)) {
+    if (command == ACT_SPINE_UP)   g_spineLevel = clamp01(g_spineLevel + NUDGE_FINE);
+    if (command == ACT_SPINE_DOWN) g_spineLevel = clamp01(g_spineLevel - NUDGE_FINE);
     Spine::set(g_spineLevel);
-  } else if (phase == "stop") {
+  } else if (phase == PHASE_STOP) {
     // Keep last position (or re-center if you prefer)
   }
 }
 
-static void handleHead(const String& command, const String& phase) {
-  if (phase == "start" || phase == "hold") {
-    if (command == "head_up")   g_headPitch = clamp01(g_headPitch + NUDGE_FINE);
-    if (command == "head_down") g_headPitch = clamp01(g_headPitch - NUDGE_FINE);
+static void handleHead(Action command, Phase phase) {
+  if (isActive(phase)) {
+    if (command == ACT_HEAD_UP)   g_headPitch = clamp01(g_headPitch + NUDGE_FINE);
+    if (command == ACT_HEAD_DOWN) g_headPitch = clamp01(g_headPitch - NUDGE_FINE);
     applyHeadPitch(g_headPitch);
   }
 }
 
-static void handleNeck(const String& command, const String& phase) {
-  if (phase == "start" || phase == "hold") {
-    if (command == "neck_left")  g_neckYaw = clamp01(g_neckYaw - NUDGE_FINE);
-    if (command == "neck_right") g_neckYaw = clamp01(g_neckYaw + NUDGE_FINE);
+static void handleNeck(Action command, Phase phase) {
+  if (isActive(phase)) {
+    if (command == ACT_NECK_LEFT)  g_neckYaw = clamp01(g_neckYaw - NUDGE_FINE);
+    if (command == ACT_NECK_RIGHT) g_neckYaw = clamp01(g_neckYaw + NUDGE_FINE);
     applyNeckYaw(g_neckYaw);
   }
 }
 
-static void handleTail(const String& command, const String& phase) {
-  if (phase == "start" || phase == "hold") {
-    if (command == "tail_left")  g_tailYaw = clamp01(g_tailYaw - NUDGE_FINE);
-    if (command == "tail_right") g_tailYaw = clamp01(g_tailYaw + NUDGE_FINE);
+static void handleTail(Action command, Phase phase) {
+  if (isActive(phase)) {
+    if (command == ACT_TAIL_LEFT)  g_tailYaw = clamp01(g_tailYaw - NUDGE_FINE);
+    if (command == ACT_TAIL_RIGHT) g_tailYaw = clamp01(g_tailYaw + NUDGE_FINE);
     applyTailYaw(g_tailYaw);
   }
 }
 
 // Fallback for full-body directional (if you choose to use it)
-static void handleFullBody(const String& command, const String& phase) {
-  if (phase == "stop") {
+static void handleFullBody(Action command, Phase phase) {
+  if (phase == PHASE_STOP) {
     Leg::stop();
     return;
   }
-  if (phase == "start" || phase == "hold") {
-    if (command == "up")        { Leg::walkForward(0.7f); }
-    else if (command == "down") { Leg::walkBackward(0.7f); }
-    else if (command == "left") { Leg::turnLeft(0.7f); }
-    else if (command == "right"){ Leg::turnRight(0.7f); }
+  if (isActive(phase)) {
+    if (command == ACT_UP)         { Leg::walkForward(0.7f); }
+    else if (command == ACT_DOWN)  { Leg::walkBackward(0.7f); }
+    else if (command == ACT_LEFT)  { Leg::turnLeft(0.7f); }
+    else if (command == ACT_RIGHT) { Leg::turnRight(0.7f); }
   }
 }
 
 // ---------------- Legacy command support ----------------
+// rex_* verbs live in the shared CommandTable, so raw lines ("rex_roar"),
+// legacy JSON ({"cmd":"rex_gait","speed":0.7}) and main.cpp verbs resolve
+// through the same lookup. JSON keys map onto positional args via `keys`.
+using CommandTable::Args;
+
+static void legacySpineNudge(float delta) {
+  g_spineLevel = clamp01(g_spineLevel + delta);
+  Spine::set(g_spineLevel);
+}
+
+static void legacyGait(const Args& a) {
+  const float speed  = a.get(0, 0.7f);
+  const float stride = a.get(1, 0.6f);
+  const float lift   = a.get(2, 0.4f);
+  Leg::setGait(speed, stride, lift, a.word.equals("run") ? Leg::PACE_RUN : Leg::PACE_WALK);
+}
+
+static constexpr CommandTable::Entry kLegacyCommands[] = {
+  { CMD_VERB("rex_walk_forward"),  [](const Args&) { Leg::walkForward(0.7f); } },
+  { CMD_VERB("rex_walk_backward"), [](const Args&) { Leg::walkBackward(0.7f); } },
+  { CMD_VERB("rex_turn_left"),     [](const Args&) { Leg::turnLeft(0.6f); } },
+  { CMD_VERB("rex_turn_right"),    [](const Args&) { Leg::turnRight(0.6f); } },
+  { CMD_VERB("rex_stop"),          [](const Args&) { Leg::stop(); } },
+
+  { CMD_VERB("rex_spine_up"),      [](const Args&) { legacySpineNudge(+NUDGE_FINE); } },
+  { CMD_VERB("rex_spine_down"),    [](const Args&) { legacySpineNudge(-NUDGE_FINE); } },
+  { CMD_VERB("rex_tail_wag"),      [](const Args&) { /* optional legacy tail wag */ } },
+
+  { CMD_VERB("rex_gait"),          legacyGait, { "speed", "stride", "lift" }, "mode" },
+  { CMD_VERB("rex_speed_adjust"),  [](const Args& a) { Leg::adjustSpeed(a.get(0, 0.1f)); }, { "delta" } },
+  { CMD_VERB("rex_stride_set"),    [](const Args& a) { Leg::setStride  (a.get(0, 0.6f)); }, { "value" } },
+  { CMD_VERB("rex_echo"),          [](const Args& a) { setEcho(a.get(0, 1.0f) != 0.0f); }, { "on" } },
+  { CMD_VERB("rex_posture"),       [](const Args& a) { Leg::setPosture (a.get(0, 0.5f)); }, { "level" } },
+};
+
 static void handleLegacyJson(const JsonDocument& doc) {
-  const String cmd = doc["cmd"] | "";
-
-  if (cmd == "rex_walk_forward") { Leg::walkForward(0.7f); return; }
-  if (cmd == "rex_walk_backward"){ Leg::walkBackward(0.7f); return; }
-  if (cmd == "rex_turn_left")    { Leg::turnLeft(0.6f);    return; }
-  if (cmd == "rex_turn_right")   { Leg::turnRight(0.6f);   return; }
-  if (cmd == "rex_stop")         { Leg::stop();            return; }
-
-  if (cmd == "rex_spine_up")     { g_spineLevel  = clamp01(g_spineLevel + NUDGE_FINE);  Spine::set(g_spineLevel);  return; }
-  if (cmd == "rex_spine_down")   { g_spineLevel  = clamp01(g_spineLevel - NUDGE_FINE);  Spine::set(g_spineLevel);  return; }
-  if (cmd == "rex_tail_wag")     { /* optional legacy tail wag */ return; }
-
-  if (cmd == "rex_gait") {
-    const float speed  = doc["speed"]  | 0.7f;
-    const float stride = doc["stride"] | 0.6f;
-    const float lift   = doc["lift"]   | 0.4f;
-    const String mode  = doc["mode"]   | String("walk");
-    Leg::setGait(speed, stride, lift, mode);
+  const char* cmd = doc["cmd"] | "";
+  const CommandTable::Entry* e = CommandTable::find(cmd);
+
+  if (!e) {
+    // Unknown legacy command
+    LOG_W("Unknown legacy JSON cmd: %s", Log::text(cmd));
     return;
   }
 
-  if (cmd == "rex_speed_adjust") { Leg::adjustSpeed(doc["delta"] | 0.1f); return; }
-  if (cmd == "rex_stride_set")   { Leg::setStride  (doc["value"] | 0.6f); return; }
-  if (cmd == "rex_posture")      { Leg::setPosture (doc["level"] | 0.5f); return; }
+  Args args;
+  for (uint8_t i = 0; i < COMMAND_MAX_ARGS; ++i) {
+    if (!e->keys[i]) continue;
+    JsonVariantConst v = doc[e->keys[i]];
+    if (v.is<float>()) {
+      args.num[i] = v.as<float>();
+      args.present |= (uint8_t)(1u << i);
+    }
+  }
+  if (e->wordKey) {
+    const char* w = doc[e->wordKey] | (const char*)nullptr;
+    if (w) {
+      args.word.ptr = w;
+      args.word.len = (uint8_t)strlen(w);
+    }
+  }
 
-  // Unknown legacy command
-  Serial.print(F("Unknown legacy JSON cmd: "));
-  Serial.println(cmd);
+  TRACE_MARK(DISPATCH);
+  e->fn(args);
 }
 
-static void handleLegacyRaw(const String& s) {
-  if (s == "rex_walk_forward") { Leg::walkForward(0.7f); return; }
-  if (s == "rex_walk_backward"){ Leg::walkBackward(0.7f); return; }
-  if (s == "rex_turn_left")    { Leg::turnLeft(0.6f); return; }
-  if (s == "rex_turn_right")   { Leg::turnRight(0.6f); return; }
-  if (s == "rex_stop")         { Leg::stop(); return; }
+// ---------------- Coalescing ----------------
+// Held UI buttons resend the same message many times per frame. Messages
+// only record the newest (command, phase) per part; tick() applies at most
+// one per part per control frame, so work stays flat as the rate rises.
+struct Pending {
+  Action command;
+  Phase  phase;
+  bool   valid;
+};
+
+static Pending        g_pending[PART_COUNT];
+static CoalesceStats  g_coalesce = { 0, 0, 0 };
+
+static void queueSchema(Part part, Action command, Phase phase) {
+  Pending& p = g_pending[part];
+  if (p.valid) ++g_coalesce.superseded;
+  p.command = command;
+  p.phase   = phase;
+  p.valid   = true;
+  ++g_coalesce.received;
+}
 
-  if (s == "rex_spine_up")     { g_spineLevel = clamp01(g_spineLevel + NUDGE_FINE); Spine::set(g_spineLevel); return; }
-  if (s == "rex_spine_down")   { g_spineLevel = clamp01(g_spineLevel - NUDGE_FINE); Spine::set(g_spineLevel); return; }
+static void applySchema(Part part, Action command, Phase phase) {
+  TRACE_MARK(DISPATCH);
+  switch (part) {
+    case PART_LEGS:      handleLegs(command, phase);     break;
+    case PART_PELVIS:    handlePelvis(command, phase);   break;
+    case PART_SPINE:     handleSpine(command, phase);    break;
+    case PART_HEAD:      handleHead(command, phase);     break;
+    case PART_NECK:      handleNeck(command, phase);     break;
+    case PART_TAIL:      handleTail(command, phase);     break;
+    case PART_FULL_BODY: handleFullBody(command, phase); break;
+    default: break;
+  }
+}
+
+// ---------------- JSON parsing ----------------
+// The document and filter are static: parsing costs no stack beyond the
+// parser itself, and the filter keeps only the keys the router understands,
+// so unknown fields never reach the pool.
+static StaticJsonDocument<256> g_doc;
+
+// One filter slot per key: the schema's six plus every key a legacy verb
+// reads (a key two verbs share is counted twice, which only over-sizes it)
+static constexpr size_t filterKeys() {
+  size_t n = 6;
+  for (const CommandTable::Entry& e : kLegacyCommands) {
+    for (uint8_t i = 0; i < COMMAND_MAX_ARGS; ++i) n += e.keys[i] ? 1 : 0;
+    n += e.wordKey ? 1 : 0;
+  }
+  return n;
+}
+static StaticJsonDocument<JSON_OBJECT_SIZE(filterKeys())> g_filter;
+
+// The parse is zero-copy: strings stay in the line, which the parser
+// rewrites. A line still needed afterwards (timestamped JSON for the
+// queue, the echo) is kept here first.
+static char g_kept[LINE_READER_MAX_LINE + 1];
+
+static bool g_echo = false;
+
+static void buildFilter() {
+  g_filter.clear();
+  g_filter["target"]  = true;
+  g_filter["part"]    = true;
+  g_filter["command"] = true;
+  g_filter["phase"]   = true;
+  g_filter["cmd"]     = true;
+  g_filter["at"]      = true;
+
+  // Every JSON key a legacy verb reads
+  for (const CommandTable::Entry& e : kLegacyCommands) {
+    for (uint8_t i = 0; i < COMMAND_MAX_ARGS; ++i) {
+      if (e.keys[i]) g_filter[e.keys[i]] = true;
+    }
+    if (e.wordKey) g_filter[e.wordKey] = true;
+  }
+
+  // A dropped key would silently filter that field out of every line
+  if (g_filter.overflowed()) {
+    LOG_E("[CMD] JSON filter overflowed (%u B): legacy keys dropped", (unsigned)g_filter.capacity());
+  }
+}
+
+// ---------------- Binary frames ----------------
+static_assert(LINE_READER_MAX_LINE >= REX_PROTO_MAX_WIRE, "LineReader buffer must hold a full binary frame");
+
+static ProtoStats g_proto = { 0, 0, 0, 0, 0, 0 };
+static bool       g_haveSeq = false;
+static uint8_t    g_rxSeq = 0;
+static uint8_t    g_txSeq = 0;
+static uint32_t   g_streamMs = 0;
+static bool       g_streaming = false;
+
+bool sendFrame(uint8_t type, const uint8_t* payload, size_t len) {
+  Transport& out = console();
+  uint8_t wire[REX_PROTO_MAX_WIRE];
+  const size_t n = RexProto::encode(type, g_txSeq++, payload, len, wire, sizeof(wire));
+  if (n == 0 || out.availableForWrite() < (int)n) {
+    ++g_proto.txDropped;
+    return false;
+  }
+  out.write(wire, n);
+  return true;
+}
 
-  Serial.print(F("Unknown raw cmd: "));
-  Serial.println(s);
+static void applyJoints(const RexProto::SetJoints& m) {
+  if (!SB) return;
+  TRACE_MARK(DISPATCH);
+  for (uint8_t ch = 0; ch < REX_PROTO_JOINTS && ch < SERVO_COUNT; ++ch) {
+    if (m.us[ch]) SB->writeMicroseconds(ch, m.us[ch]);
+  }
+  g_streaming = true;
+  g_streamMs  = millis();
+}
+
+static void applyGait(const RexProto::SetGait& m) {
+  TRACE_MARK(DISPATCH);
+  const float speed  = m.speed_mhz / 1000.0f;
+  const float stride = m.stride / 255.0f;
+  const float lift   = m.lift / 255.0f;
+  Leg::setGait(speed, stride, lift, (m.flags & RexProto::GAIT_FLAG_RUN) ? Leg::PACE_RUN : Leg::PACE_WALK);
+
+  switch (m.mode) {
+    case Leg::WALK_FWD: Leg::walkForward(Leg::speedHz());  break;
+    case Leg::WALK_BWD: Leg::walkBackward(Leg::speedHz()); break;
+    case Leg::TURN_L:   Leg::turnLeft(Leg::speedHz());     break;
+    case Leg::TURN_R:   Leg::turnRight(Leg::speedHz());    break;
+    default:            Leg::stop();                       break;
+  }
+  g_streaming = false;   // gait takes the legs back
+}
+
+static void sendTelemetry() {
+  RexProto::Telemetry t;
+  t.ms = millis();
+  for (uint8_t ch = 0; ch < REX_PROTO_JOINTS; ++ch) {
+    t.us[ch] = SB ? SB->lastMicroseconds(ch) : 0;
+  }
+  t.legMode   = (uint8_t)Leg::mode();
+  t.streaming = streaming() ? 1 : 0;
+
+  uint8_t payload[RexProto::TELEMETRY_SIZE];
+  sendFrame(RexProto::MSG_TELEMETRY, payload, RexProto::pack(t, payload));
+}
+
+static void sendFileAck(const RexProto::FileAck& a) {
+  uint8_t payload[RexProto::FILE_ACK_SIZE];
+  sendFrame(RexProto::MSG_FILE_ACK, payload, RexProto::pack(a, payload));
 }
 
 // ---------------- Public API ----------------
-void handleLine(const String& line) {
-  // Try new JSON contract first
-  StaticJsonDocument<384> doc;
-  DeserializationError err = deserializeJson(doc, line);
-
-  if (!err) {
-    const String target  = doc["target"]  | "";
-    const String part    = doc["part"]    | "";
-    const String command = doc["command"] | "";
-    const String phase   = doc["phase"]   | "";
-
-    if (target.length() && command.length() && phase.length()) {
-      // Route primarily by part (more specific than target)
-      if      (part == "legs")   handleLegs(command, phase);
-      else if (part == "pelvis") handlePelvis(command, phase);
-      else if (part == "spine")  handleSpine(command, phase);
-      else if (part == "head")   handleHead(command, phase);
-      else if (part == "neck")   handleNeck(command, phase);
-      else if (part == "tail")   handleTail(command, phase);
-      else {
-        // Fallback: fullBody panel or generic directions
-        if (target == "fullBody") handleFullBody(command, phase);
-      }
+void begin(ServoBus* bus) {
+  SB = bus;
+  CommandTable::add(kLegacyCommands);
+  buildFilter();
 
-      // Optional echo for debugging over Serial:
-      Serial.print(F("RX OK: "));
-      serializeJson(doc, Serial);
-      Serial.println();
+  g_pelvisLevel = 0.50f;
+  g_spineLevel  = 0.50f;
+  g_headPitch   = 0.50f;
+  g_neckYaw     = 0.50f;
+  g_tailYaw     = 0.50f;
+  applyAnalogs();
+}
+
+// Route one line now. `scheduled` lines come back from CommandQueue and
+// must not be queued again.
+static void routeLine(char* line, size_t len, bool scheduled) {
+  if (!line || !len) return;
+
+  // Timestamped raw line: "@<device_ms> ..." or "@+<delay_ms> ..."
+  if (line[0] == '@') {
+    const bool relative = (len > 1 && line[1] == '+');
+    const char* digits = line + (relative ? 2 : 1);
+    char* end = nullptr;
+    const uint32_t t = strtoul(digits, &end, 10);
+    size_t rest = end - line;
+    while (rest < len && (line[rest] == ' ' || line[rest] == '\t')) ++rest;
+    if (end == digits || rest >= len) {
+      LOG_W("[CMD] Bad timestamp");
+      return;
+    }
+    const uint32_t atMs = relative ? millis() + t : t;
+    if (!CommandQueue::push(atMs, line + rest, len - rest)) {
+      LOG_W("[CMD] Schedule rejected");
+    }
+    return;
+  }
+
+  // Not JSON → raw verb path (main.cpp verbs and legacy rex_* share the table)
+  if (line[0] != '{') {
+    if (!CommandTable::dispatch(line, len)) {
+      LOG_W("[CMD] Unknown: %s", Log::text(line, len));
+    }
+    return;
+  }
+
+  // JSON: parse the line in place, keeping only known keys
+  const bool keep = g_echo || (!scheduled && strstr(line, "\"at\""));
+  if (keep) {
+    memcpy(g_kept, line, len);
+    g_kept[len] = '\0';
+  }
+  DeserializationError err = deserializeJson(g_doc, line, len, DeserializationOption::Filter(g_filter));
+  if (err) {
+    LOG_W("JSON error: %s", err.c_str());
+    return;
+  }
+  TRACE_MARK(PARSE);
+
+  // Timestamped JSON: {"at": <device_ms>, ...} goes to the queue whole
+  if (!scheduled) {
+    JsonVariantConst at = g_doc["at"];
+    if (!at.isNull()) {
+      if (!CommandQueue::push(at.as<uint32_t>(), g_kept, len)) {
+        LOG_W("[CMD] Schedule rejected");
+      }
       return;
     }
+  }
+
+  const char* target  = g_doc["target"]  | "";
+  const char* action  = g_doc["command"] | "";
+  const Action command = (Action)lookupId(kActions, action);
+  const Phase  phase   = (Phase) lookupId(kPhases,  g_doc["phase"] | "");
+
+  if (target[0] && action[0] && phase != PHASE_NONE) {
+    // Route primarily by part (more specific than target)
+    Part part = (Part)lookupId(kParts, g_doc["part"] | "");
+    if (part == PART_NONE && strcmp(target, "fullBody") == 0) {
+      // Fallback: fullBody panel or generic directions
+      part = PART_FULL_BODY;
+    }
 
-    // If it wasn't the new schema, try legacy JSON ("cmd": "rex_*")
-    if (doc.containsKey("cmd")) {
-      handleLegacyJson(doc);
+    // A stop halts the legs whatever the command (a remote's release packet)
+    const bool stop = phase == PHASE_STOP && (part == PART_LEGS || part == PART_FULL_BODY);
+    if (command != ACT_NONE || stop) {
+      if (part != PART_NONE) queueSchema(part, command, phase);
+
+      // Optional echo for debugging over Serial
+      if (g_echo) LOG_I("RX OK: %s", Log::text(g_kept, len));
       return;
     }
+  }
+
+  // If it wasn't the new schema, try legacy JSON ("cmd": "rex_*")
+  if (g_doc.containsKey("cmd")) {
+    handleLegacyJson(g_doc);
+    return;
+  }
+
+  // Unknown JSON shape
+  if (keep) LOG_W("Unknown JSON: %s", Log::text(g_kept, len));
+  else      LOG_W("Unknown JSON (%u bytes)", (unsigned)len);
+}
+
+void handleLine(char* line, size_t len) {
+  routeLine(line, len, false);
+}
 
-    // Unknown JSON shape
-    Serial.print(F("Unknown JSON: "));
-    serializeJson(doc, Serial);
-    Serial.println();
+void execute(char* line, size_t len) {
+  routeLine(line, len, true);
+}
+
+void handleFrame(const uint8_t* cobs, size_t len) {
+  uint8_t scratch[REX_PROTO_MAX_RAW];
+  RexProto::Frame f;
+  if (!RexProto::decode(cobs, len, scratch, f)) {
+    ++g_proto.errors;
     return;
   }
 
-  // Not JSON → legacy raw string path
-  String s = line;
-  s.trim();
-  if (s.length()) {
-    handleLegacyRaw(s);
+  // A jump ahead of less than half the sequence space counts lost frames;
+  // anything else is a repeat or a late (reordered) frame. Either way the
+  // frame itself is still applied.
+  const uint8_t skipped = (uint8_t)(f.seq - g_rxSeq - 1);
+  if (!g_haveSeq || skipped < 128) {
+    if (g_haveSeq) g_proto.seqGaps += skipped;
+    g_rxSeq = f.seq;
+    g_haveSeq = true;
+  } else {
+    ++g_proto.duplicates;
+  }
+  ++g_proto.frames;
+  TRACE_MARK(PARSE);
+
+  switch (f.type) {
+    case RexProto::MSG_SET_JOINTS: {
+      RexProto::SetJoints m;
+      if (RexProto::unpack(f, m)) applyJoints(m); else ++g_proto.errors;
+      break;
+    }
+    case RexProto::MSG_SET_GAIT: {
+      RexProto::SetGait m;
+      if (RexProto::unpack(f, m)) applyGait(m); else ++g_proto.errors;
+      break;
+    }
+    case RexProto::MSG_TELEMETRY_REQ:
+      sendTelemetry();
+      break;
+    case RexProto::MSG_FILE_BEGIN: {
+      RexProto::FileBegin m;
+      if (RexProto::unpack(f, m)) sendFileAck(Choreo::fileBegin(m)); else ++g_proto.errors;
+      break;
+    }
+    case RexProto::MSG_FILE_DATA: {
+      RexProto::FileData m;
+      if (RexProto::unpack(f, m)) sendFileAck(Choreo::fileData(m)); else ++g_proto.errors;
+      break;
+    }
+    case RexProto::MSG_FILE_END: {
+      RexProto::FileEnd m;
+      if (RexProto::unpack(f, m)) sendFileAck(Choreo::fileEnd(m)); else ++g_proto.errors;
+      break;
+    }
+    default:
+      ++g_proto.unknown;
+      break;
+  }
+}
+
+bool streaming() {
+  if (g_streaming && (millis() - g_streamMs) > REX_STREAM_HOLD_MS) {
+    g_streaming = false;
   }
+  return g_streaming;
 }
 
+const ProtoStats& protoStats() { return g_proto; }
+
+void setEcho(bool on) { g_echo = on; }
+bool echo() { return g_echo; }
+
 void tick() {
-  // no-op for now (placeholder for smoothing if needed)
+  // Apply the newest schema message per part, once per control frame
+  for (uint8_t part = PART_NONE + 1; part < PART_COUNT; ++part) {
+    Pending& p = g_pending[part];
+    if (!p.valid) continue;
+    p.valid = false;
+    applySchema((Part)part, p.command, p.phase);
+    ++g_coalesce.applied;
+  }
 }
 
+const CoalesceStats& coalesceStats() { return g_coalesce; }
+
 } // namespace CommandRouter
\ No newline at end of file
@@ -1,21 +1,74 @@
 #pragma once
 #include <Arduino.h>
+#include "ServoBus.h"
+
+// SET_JOINTS frames keep ownership of the servos this long after the last one
+#ifndef REX_STREAM_HOLD_MS
+#define REX_STREAM_HOLD_MS 250
+#endif
 
 namespace CommandRouter {
 
-// Initialize internal state and set neutral positions (call from setup()).
-void begin();
+// Register the legacy rex_* verbs with CommandTable, reset internal state
+// and set neutral positions (call from setup(), after the motion modules).
+// bus is used by binary SET_JOINTS / TELEMETRY frames.
+void begin(ServoBus* bus);
 
 // Handle a single newline-delimited message (JSON or legacy string).
 // New JSON contract (preferred):
 //   {"target":"legsPelvis","part":"legs","command":"move_forward","phase":"start"}
 // Legacy JSON:
 //   {"cmd":"rex_walk_forward","speed":0.7}
-// Legacy raw string:
-//   rex_roar
-void handleLine(const String& line);
+// Legacy raw string / any registered verb (see CommandTable):
+//   rex_walk_forward
+//   rex_gait 0.7 0.6 0.4 run
+// Timestamped lines are queued instead (see CommandQueue.h):
+//   @123456 WALK_FORWARD      {"at":123456,"target":...}
+// `line` is a trimmed, NUL-terminated view of `len` bytes (LineReader
+// output). JSON is parsed in place, which rewrites the line.
+void handleLine(char* line, size_t len);
+
+// Run a line popped from CommandQueue (its timestamp is ignored)
+void execute(char* line, size_t len);
+
+// Handle one binary frame: the COBS bytes between the 0x00 delimiters
+// (LineReader::FRAME). See RexProtocol.h for the message set.
+void handleFrame(const uint8_t* cobs, size_t len);
+
+// Send one device -> host frame. Never blocks: returns false (and counts
+// txDropped) when the TX buffer cannot take the whole frame.
+bool sendFrame(uint8_t type, const uint8_t* payload, size_t len);
 
-// Optional periodic work (not required, here for future smoothing).
+// True while streamed SET_JOINTS frames own the servos; the main loop
+// skips gait/sweep updates so they don't overwrite the stream.
+bool streaming();
+
+struct ProtoStats {
+  uint32_t frames;     // valid frames handled
+  uint32_t errors;     // COBS/CRC/length failures
+  uint32_t seqGaps;    // frames lost according to the sequence number
+  uint32_t duplicates; // repeated or out-of-order sequence numbers
+  uint32_t unknown;    // valid frames with an unknown type
+  uint32_t txDropped;  // replies dropped because the TX buffer was full
+};
+const ProtoStats& protoStats();
+
+// Echo accepted JSON lines back as "RX OK: <line>" (off by default).
+// Echo goes through the async log, so it never blocks the control loop.
+// Also toggled with the "rex_echo 1|0" verb.
+void setEcho(bool on);
+bool echo();
+
+// Once per control frame: apply the newest pending JSON schema message
+// per part. Older messages for the same part in the same frame are
+// superseded (latest wins) and only counted.
 void tick();
 
+struct CoalesceStats {
+  uint32_t received;     // schema messages accepted
+  uint32_t applied;      // messages actually applied by tick()
+  uint32_t superseded;   // replaced by a newer message before tick()
+};
+const CoalesceStats& coalesceStats();
+
 } // namespace CommandRouter
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "CommandTable.h"
+#include "Log.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace CommandTable {
+
+// ---------------- Internal state ----------------
+// Open-addressed index, kept at most half full so probes stay short
+static const size_t kSlots = 2 * COMMAND_TABLE_CAPACITY;
+static_assert((kSlots & (kSlots - 1)) == 0, "COMMAND_TABLE_CAPACITY must be a power of two");
+
+static const Entry* g_slots[kSlots] = { nullptr };
+static size_t       g_count = 0;
+
+static inline bool sameName(const Entry* e, const char* name, size_t len) {
+  return strncmp(e->name, name, len) == 0 && e->name[len] == '\0';
+}
+
+// ---------------- Hashing ----------------
+uint32_t hash(const char* s, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; ++i) {
+    h = (h ^ (uint8_t)s[i]) * 16777619u;
+  }
+  return h;
+}
+
+// ---------------- Registration ----------------
+bool add(const Entry* entries, size_t count) {
+  bool ok = true;
+
+  for (size_t n = 0; n < count; ++n) {
+    const Entry* e = &entries[n];
+
+    if (g_count >= COMMAND_TABLE_CAPACITY) {
+      LOG_E("[CmdTable] ERROR: table full, dropped %s", e->name);
+      ok = false;
+      continue;
+    }
+
+    // Lookups hash the wire name, so an entry under any other id is dead
+    if (e->id != hash(e->name, strlen(e->name))) {
+      LOG_E("[CmdTable] ERROR: id 0x%08lx is not CMD_ID(\"%s\"), dropped", (unsigned long)e->id, e->name);
+      ok = false;
+      continue;
+    }
+
+    size_t i = e->id & (kSlots - 1);
+    while (g_slots[i]) {
+      if (g_slots[i]->id == e->id && strcmp(g_slots[i]->name, e->name) == 0) break;
+      i = (i + 1) & (kSlots - 1);
+    }
+
+    if (g_slots[i]) {
+      LOG_E("[CmdTable] ERROR: duplicate verb %s", e->name);
+      ok = false;
+      continue;
+    }
+
+    g_slots[i] = e;
+    ++g_count;
+  }
+
+  return ok;
+}
+
+// ---------------- Lookup ----------------
+const Entry* find(const char* name, size_t len) {
+  const uint32_t h = hash(name, len);
+
+  for (size_t i = h & (kSlots - 1); g_slots[i]; i = (i + 1) & (kSlots - 1)) {
+    if (g_slots[i]->id == h && sameName(g_slots[i], name, len)) {
+      return g_slots[i];
+    }
+  }
+  return nullptr;
+}
+
+bool dispatch(const char* line, size_t len) {
+  LineToken tok[COMMAND_MAX_ARGS + 2];
+  const uint8_t n = LineReader::tokenize(line, len, tok, COMMAND_MAX_ARGS + 2);
+  if (n == 0) return false;
+
+  const Entry* e = find(tok[0].ptr, tok[0].len);
+  if (!e) return false;
+  TRACE_MARK(PARSE);
+
+  // Numeric tokens fill positional args; the first other token is the word
+  Args args;
+  uint8_t slot = 0;
+  for (uint8_t t = 1; t < n; ++t) {
+    char* end = nullptr;
+    const float v = strtof(tok[t].ptr, &end);
+    if (end == tok[t].ptr + tok[t].len && slot < COMMAND_MAX_ARGS) {
+      args.num[slot] = v;
+      args.text[slot] = tok[t];
+      args.present |= (uint8_t)(1u << slot);
+      ++slot;
+    } else if (!args.word.ptr) {
+      args.word = tok[t];
+    }
+  }
+
+  TRACE_MARK(DISPATCH);
+  e->fn(args);
+  return true;
+}
+
+size_t size() { return g_count; }
+
+} // namespace CommandTable
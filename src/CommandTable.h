@@ -0,0 +1,82 @@
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+#include "LineReader.h"
+
+// ========== Command Table Configuration ==========
+// Maximum number of registered verbs across all modules (a power of two)
+#ifndef COMMAND_TABLE_CAPACITY
+#define COMMAND_TABLE_CAPACITY 128
+#endif
+
+// Numeric arguments a verb can take (raw tokens or legacy JSON keys)
+#define COMMAND_MAX_ARGS 4
+
+// Compile-time verb id: CMD_ID("WALK_FORWARD") folds to a constant
+#define CMD_ID(name) (std::integral_constant<uint32_t, CommandTable::hash(name)>::value)
+
+// Id and name from one literal, for { id, name, ... } tables:
+//   { CMD_VERB("WALK_FORWARD"), cmdWalkForward }
+#define CMD_VERB(name) CMD_ID(name), name
+
+namespace CommandTable {
+
+// ========== Hashing ==========
+// FNV-1a over a NUL-terminated string, usable in constant expressions
+constexpr uint32_t hash(const char* s, uint32_t h = 2166136261u) {
+  return *s ? hash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+// FNV-1a over a length-delimited view (runtime lookups)
+uint32_t hash(const char* s, size_t len);
+
+// ========== Arguments ==========
+// Positional numeric arguments plus one optional word (e.g. gait mode).
+// Raw lines fill these from tokens after the verb; legacy JSON fills them
+// from the keys listed in the entry.
+struct Args {
+  float     num[COMMAND_MAX_ARGS];
+  uint8_t   present = 0;     // bit i set when num[i] was supplied
+  LineToken word;            // first non-numeric token, or the entry's word key
+  LineToken text[COMMAND_MAX_ARGS];   // raw token behind num[i] (raw lines only)
+
+  inline float get(uint8_t i, float dflt) const {
+    return (i < COMMAND_MAX_ARGS && (present & (1u << i))) ? num[i] : dflt;
+  }
+};
+
+typedef void (*Handler)(const Args& args);
+
+// ========== Registry Entry ==========
+// Tables list { CMD_VERB(name), fn } and only legacy verbs add keys/wordKey;
+// the defaults keep the short form complete (C++14 aggregate)
+struct Entry {
+  uint32_t    id;                           // CMD_ID(name)
+  const char* name;                         // verb as sent on the wire
+  Handler     fn;
+  const char* keys[COMMAND_MAX_ARGS] = {};  // legacy JSON keys for num[0..3] (optional)
+  const char* wordKey = nullptr;            // legacy JSON key for word (optional)
+};
+
+// ========== Registration ==========
+// Register a module's entries (the array must outlive the table).
+// Returns false if the table is full, a verb is already registered or an
+// id does not match its name; those entries are dropped and logged.
+bool add(const Entry* entries, size_t count);
+
+template <size_t N>
+inline bool add(const Entry (&entries)[N]) { return add(entries, N); }
+
+// ========== Lookup & Dispatch ==========
+// O(1) lookup by verb; returns nullptr when unknown
+const Entry* find(const char* name, size_t len);
+inline const Entry* find(const char* name) { return find(name, strlen(name)); }
+
+// Tokenize a raw line ("VERB [arg ...]") and run its handler.
+// Returns false when the verb is not registered.
+bool dispatch(const char* line, size_t len);
+
+// Number of registered verbs
+size_t size();
+
+} // namespace CommandTable
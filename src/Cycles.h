@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+// ========== Cycle Counter ==========
+// Cheap high-resolution timestamps for tracing and profiling. On the
+// ESP32 this is the CPU cycle counter (wraps every ~17 s at 240 MHz, so
+// only differences of short intervals are meaningful). Other builds use
+// a nanosecond steady clock and treat one nanosecond as one cycle.
+#if !defined(ARDUINO_ARCH_ESP32)
+#include <chrono>
+#endif
+
+namespace Cycles {
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+inline uint32_t now() { return ESP.getCycleCount(); }
+inline uint32_t perUs() { return getCpuFrequencyMhz(); }
+
+#else
+
+inline uint32_t now() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t perUs() { return 1000; }
+
+#endif
+
+// Convert a cycle difference to nanoseconds
+inline uint32_t toNs(uint32_t cycles) {
+  return (uint32_t)((uint64_t)cycles * 1000u / perUs());
+}
+
+} // namespace Cycles
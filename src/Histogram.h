@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ========== Log2 Histogram ==========
+// Fixed-size latency histogram for 32-bit samples (e.g. nanoseconds).
+// Bucket 0 holds zero; bucket i holds [2^(i-1), 2^i). Recording is a few
+// instructions and never allocates, so it is safe in the control loop.
+class Histogram {
+public:
+  static const uint8_t kBuckets = 33;
+
+  void reset() {
+    for (uint8_t i = 0; i < kBuckets; ++i) _bins[i] = 0;
+    _count = 0;
+    _sum = 0;
+    _min = UINT32_MAX;
+    _max = 0;
+  }
+
+  Histogram() { reset(); }
+
+  inline void record(uint32_t v) {
+    ++_bins[bucketOf(v)];
+    ++_count;
+    _sum += v;
+    if (v < _min) _min = v;
+    if (v > _max) _max = v;
+  }
+
+  uint32_t count() const { return _count; }
+  uint32_t min()   const { return _count ? _min : 0; }
+  uint32_t max()   const { return _max; }
+  uint32_t mean()  const { return _count ? (uint32_t)(_sum / _count) : 0; }
+  uint64_t sum()   const { return _sum; }
+  uint32_t bin(uint8_t i) const { return i < kBuckets ? _bins[i] : 0; }
+
+  // Upper bound of the bucket holding the p-th percentile (0..100),
+  // clamped to the largest sample seen
+  uint32_t percentile(float p) const {
+    if (_count == 0) return 0;
+    uint32_t rank = (uint32_t)(p / 100.0f * (float)_count + 0.5f);
+    if (rank < 1) rank = 1;
+    if (rank > _count) rank = _count;
+
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < kBuckets; ++i) {
+      seen += _bins[i];
+      if (seen >= rank) {
+        const uint32_t upper = (i == 0) ? 0 : (i >= 32 ? UINT32_MAX : (1u << i) - 1);
+        return upper < _max ? upper : _max;
+      }
+    }
+    return _max;
+  }
+
+  static inline uint8_t bucketOf(uint32_t v) {
+    return v ? (uint8_t)(32 - __builtin_clz(v)) : 0;
+  }
+
+private:
+  uint32_t _bins[kBuckets];
+  uint32_t _count;
+  uint64_t _sum;
+  uint32_t _min;
+  uint32_t _max;
+};
@@ -0,0 +1,129 @@
+#if defined(REX_NATIVE)
+#include "HostTransport.h"
+#include <NativeHost.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// ========== Setup ==========
+
+static void setNonBlocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  if (flags >= 0) fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+bool HostTransport::begin() {
+  if (_in >= 0) return true;
+
+  if (_mode == STDIO) {
+    _in = STDIN_FILENO;
+    _out = STDOUT_FILENO;
+    setNonBlocking(_in);
+    return true;
+  }
+
+  const int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+    perror("[Transport] posix_openpt");
+    if (fd >= 0) close(fd);
+    return false;
+  }
+
+  // Raw 8-bit link, like a USB-CDC port: no echo, no line editing
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  snprintf(_path, sizeof(_path), "%s", ptsname(fd));
+  setNonBlocking(fd);
+  _in = _out = fd;
+  fprintf(stderr, "[Transport] pty ready at %s\n", _path);
+  return true;
+}
+
+// ========== Input ==========
+
+bool HostTransport::fill() {
+  if (_head < _tail) return true;
+  if (_in < 0) return false;
+
+  _head = _tail = 0;
+  const ssize_t n = ::read(_in, _buf, sizeof(_buf));
+  if (n > 0) _tail = (size_t)n;
+  return _tail > 0;
+}
+
+int HostTransport::available() {
+  fill();
+  return (int)(_tail - _head);
+}
+
+int HostTransport::read() {
+  return fill() ? _buf[_head++] : -1;
+}
+
+int HostTransport::peek() {
+  return fill() ? _buf[_head] : -1;
+}
+
+size_t HostTransport::readBytes(char* buf, size_t len) {
+  size_t got = 0;
+  while (got < len && fill()) {
+    size_t n = _tail - _head;
+    if (n > len - got) n = len - got;
+    memcpy(buf + got, &_buf[_head], n);
+    _head += n;
+    got += n;
+  }
+  return got;
+}
+
+// Real time: sleep in poll() until the fd is readable. On the virtual
+// clock nothing arrives while time stands still, so poll per millisecond.
+bool HostTransport::waitForInput(uint32_t timeoutMs) {
+  if (fill()) return true;
+  if (_in < 0 || NativeHost::clockMode() == NativeHost::VIRTUAL) return Transport::waitForInput(timeoutMs);
+
+  struct pollfd p = { _in, POLLIN, 0 };
+  poll(&p, 1, (int)timeoutMs);
+  if (fill()) return true;
+  if (p.revents & (POLLHUP | POLLERR)) delay(timeoutMs);   // closed: nothing will arrive
+  return false;
+}
+
+// ========== Output ==========
+
+size_t HostTransport::write(const uint8_t* data, size_t len) {
+  if (_out < 0) return 0;
+
+  // Like the USB-CDC driver: wait a little for a slow reader, then give up
+  size_t done = 0;
+  uint8_t waits = 0;
+  while (done < len) {
+    const ssize_t n = ::write(_out, data + done, len - done);
+    if (n > 0) {
+      done += (size_t)n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EINTR) && waits++ < 10) {
+      struct pollfd p = { _out, POLLOUT, 0 };
+      poll(&p, 1, 10);
+    } else {
+      break;   // peer closed or not reading
+    }
+  }
+  return done;
+}
+
+int HostTransport::availableForWrite() {
+  if (_out < 0) return 0;
+  struct pollfd p = { _out, POLLOUT, 0 };
+  return (poll(&p, 1, 0) == 1 && (p.revents & POLLOUT)) ? (int)sizeof(_buf) : 0;
+}
+
+#endif // REX_NATIVE
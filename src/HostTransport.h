@@ -0,0 +1,45 @@
+#pragma once
+#if defined(REX_NATIVE)
+#include "Transport.h"
+
+// ========== Host Transport (native builds) ==========
+// Command channel for the native firmware build:
+//   STDIO  read stdin, write stdout (pipe test scripts straight in)
+//   PTY    open a pseudo-terminal and print its path to stderr; tools
+//          then connect to it exactly like a USB serial port
+// Reads never block. Writes wait only on the host side, so a slow
+// reader shows up as a full TX buffer just like on the device.
+class HostTransport : public Transport {
+public:
+  enum Mode : uint8_t { STDIO, PTY };
+
+  void configure(Mode mode) { _mode = mode; }
+
+  const char* name() const override { return _mode == PTY ? "pty" : "stdio"; }
+  bool begin() override;
+
+  // Slave device path in PTY mode ("" before begin())
+  const char* path() const { return _path; }
+
+  int    available() override;
+  int    read() override;
+  int    peek() override;
+  size_t readBytes(char* buf, size_t len);
+  size_t write(const uint8_t* data, size_t len) override;
+  int    availableForWrite() override;
+  bool   waitForInput(uint32_t timeoutMs) override;
+  using Transport::write;
+
+private:
+  bool fill();
+
+  Mode    _mode = STDIO;
+  int     _in = -1;
+  int     _out = -1;
+  char    _path[64] = "";
+  uint8_t _buf[512];
+  size_t  _head = 0;     // next unread byte in _buf
+  size_t  _tail = 0;     // end of valid bytes in _buf
+};
+
+#endif // REX_NATIVE
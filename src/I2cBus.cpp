@@ -0,0 +1,225 @@
+#include "I2cBus.h"
+#include "CommandTable.h"
+#include "Log.h"
+#include "Mem.h"
+#include "Transport.h"
+
+// Bus workers are FreeRTOS tasks on the ESP32; elsewhere poll() runs them
+#if defined(ARDUINO_ARCH_ESP32)
+#define I2C_USE_TASKS 1
+#else
+#define I2C_USE_TASKS 0
+#endif
+
+namespace I2cBus {
+
+// ---------------- Bus table ----------------
+struct BusConfig {
+  const char* name;
+  TwoWire*    wire;
+  int8_t      sda;
+  int8_t      scl;
+  uint32_t    clockHz;
+  uint8_t     priority;   // worker task (a job on the PCA bus would preempt the loop)
+  uint8_t     core;
+};
+
+static const BusConfig kBus[BUS_COUNT] = {
+  { "pca", &Wire,  PCA9685_SDA_PIN, PCA9685_SCL_PIN, 100000,           3,                     1 },
+  { "imu", &Wire1, IMU_SDA_PIN,     IMU_SCL_PIN,     I2C_IMU_CLOCK_HZ, I2C_IMU_TASK_PRIORITY, I2C_IMU_TASK_CORE },
+};
+
+// ---------------- Internal state ----------------
+struct Worker {
+  void      (*job)();
+  const char* name;
+  uint16_t    periodMs;
+  uint32_t    dueUs;
+};
+
+// Each bus's stats are written only by its owner (loop task or worker);
+// I2C_RESET asks the owner to clear them at its next record
+static Stats         g_stats[BUS_COUNT];
+static Worker        g_worker[BUS_COUNT] = {};
+static bool          g_begun[BUS_COUNT] = { true, false };   // ServoBus::begin() starts Wire
+static volatile bool g_resetReq[BUS_COUNT] = {};
+static uint32_t      g_sinceMs = 0;
+
+static inline void applyReset(Bus bus) {
+  if (!g_resetReq[bus]) return;
+  g_stats[bus].xferNs.reset();
+  g_stats[bus].lateUs.reset();
+  g_stats[bus].errors = 0;
+  g_resetReq[bus] = false;
+}
+
+TwoWire& wire(Bus bus) { return *kBus[bus < BUS_COUNT ? bus : PCA].wire; }
+
+void record(Bus bus, uint32_t cycles, bool ok) {
+  if (bus >= BUS_COUNT) return;
+  applyReset(bus);
+  g_stats[bus].xferNs.record(Cycles::toNs(cycles));
+  if (!ok) ++g_stats[bus].errors;
+}
+
+const Stats& stats(Bus bus) { return g_stats[bus < BUS_COUNT ? bus : PCA]; }
+
+void reset() {
+  for (uint8_t b = 0; b < BUS_COUNT; ++b) g_resetReq[b] = true;
+  g_sinceMs = millis();
+}
+
+// ---------------- Accounted transfers ----------------
+bool writeReg(Bus bus, uint8_t addr, uint8_t reg, uint8_t value) {
+  TwoWire& w = wire(bus);
+  Transfer xfer(bus);
+  w.beginTransmission(addr);
+  w.write(reg);
+  w.write(value);
+  if (w.endTransmission() == 0) return true;
+  xfer.fail();
+  return false;
+}
+
+bool readRegs(Bus bus, uint8_t addr, uint8_t reg, uint8_t* data, uint8_t n) {
+  TwoWire& w = wire(bus);
+  Transfer xfer(bus);
+  w.beginTransmission(addr);
+  w.write(reg);
+  if (w.endTransmission(false) != 0 || w.requestFrom(addr, n) != n) {
+    xfer.fail();
+    return false;
+  }
+  for (uint8_t i = 0; i < n; ++i) data[i] = (uint8_t)w.read();
+  return true;
+}
+
+bool probe(Bus bus, uint8_t addr) {
+  TwoWire& w = wire(bus);
+  Transfer xfer(bus);
+  w.beginTransmission(addr);
+  if (w.endTransmission() == 0) return true;
+  xfer.fail();
+  return false;
+}
+
+// ---------------- Workers ----------------
+// Lateness is measured against the job's fixed grid; after a stall the
+// grid re-aligns instead of running the missed slots back to back
+static void runJob(Bus bus) {
+  Worker& w = g_worker[bus];
+  const uint32_t now = micros();
+  const uint32_t late = now - w.dueUs;
+  applyReset(bus);
+  g_stats[bus].lateUs.record(late);
+  w.dueUs += (uint32_t)w.periodMs * 1000u;
+  if (late >= (uint32_t)w.periodMs * 1000u) w.dueUs = now + (uint32_t)w.periodMs * 1000u;
+  w.job();
+}
+
+#if I2C_USE_TASKS
+static void busTask(void* arg) {
+  const Bus bus = (Bus)(uintptr_t)arg;
+  const TickType_t period = pdMS_TO_TICKS(g_worker[bus].periodMs);
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    vTaskDelayUntil(&wake, period ? period : 1);
+    runJob(bus);
+  }
+}
+#endif
+
+void run(Bus bus, const char* name, void (*job)(), uint16_t periodMs) {
+  if (bus >= BUS_COUNT || !job || g_worker[bus].job) return;
+  const BusConfig& cfg = kBus[bus];
+  if (!g_begun[bus]) {
+    cfg.wire->begin(cfg.sda, cfg.scl, cfg.clockHz);
+    cfg.wire->setTimeOut(I2C_TIMEOUT_MS);
+    g_begun[bus] = true;
+  }
+
+  Worker& w = g_worker[bus];
+  w.name = name;
+  w.periodMs = periodMs ? periodMs : 1;
+  w.dueUs = micros() + (uint32_t)w.periodMs * 1000u;
+  w.job = job;
+  LOG_I("[I2C] %s bus: %s every %u ms", cfg.name, name, (unsigned)w.periodMs);
+
+#if I2C_USE_TASKS
+  TaskHandle_t task = nullptr;
+  xTaskCreatePinnedToCore(busTask, name, I2C_TASK_STACK, (void*)(uintptr_t)bus,
+                          cfg.priority, &task, cfg.core);
+  Mem::watchTask(name, task);
+#endif
+}
+
+void poll() {
+#if !I2C_USE_TASKS
+  for (uint8_t b = 0; b < BUS_COUNT; ++b) {
+    Worker& w = g_worker[b];
+    if (w.job && (int32_t)(micros() - w.dueUs) >= 0) runJob((Bus)b);
+  }
+#endif
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+static void printUs(uint32_t ns) {
+  Print& out = console();
+  out.print(' ');
+  out.print(ns / 1000.0f, 1);
+}
+
+// I2C: per bus, who drives it, transfer count / errors / latency (µs),
+// share of the window spent on the bus, and worker lateness
+static void cmdI2c(const Args&) {
+  Print& out = console();
+  const uint32_t elapsedMs = millis() - g_sinceMs;
+  out.print(F("[I2C] window="));
+  out.print(elapsedMs);
+  out.println(F(" ms"));
+  out.println(F("  bus: owner clock n err min mean p99 max (us) use% | late p99 max (us)"));
+
+  for (uint8_t b = 0; b < BUS_COUNT; ++b) {
+    const BusConfig& cfg = kBus[b];
+    const Stats& s = g_stats[b];
+    const Histogram& h = s.xferNs;
+    out.print(F("  "));
+    out.print(cfg.name);
+    out.print(F(": "));
+    out.print(g_worker[b].job ? g_worker[b].name : (b == PCA ? "loop" : "-"));
+    out.print(' ');
+    out.print(g_begun[b] ? cfg.wire->getClock() / 1000 : 0);
+    out.print(F("k "));
+    out.print(h.count());
+    out.print(' ');
+    out.print(s.errors);
+    printUs(h.min());
+    printUs(h.mean());
+    printUs(h.percentile(99));
+    printUs(h.max());
+    out.print(' ');
+    out.print(elapsedMs ? (float)h.sum() / 10000.0f / (float)elapsedMs : 0.0f, 2);
+    if (s.lateUs.count()) {
+      out.print(F(" | "));
+      out.print(s.lateUs.percentile(99));
+      out.print(' ');
+      out.println(s.lateUs.max());
+    } else {
+      out.println();
+    }
+  }
+}
+
+static const CommandTable::Entry kI2cCommands[] = {
+  { CMD_VERB("I2C"),       cmdI2c },
+  { CMD_VERB("I2C_RESET"), [](const Args&) { reset(); } },
+};
+
+void begin() {
+  reset();
+  CommandTable::add(kI2cCommands);
+}
+
+} // namespace I2cBus
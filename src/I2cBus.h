@@ -0,0 +1,105 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include "Cycles.h"
+#include "Histogram.h"
+#include "ServoBus.h"
+
+// ========== I2C Bus Configuration ==========
+// IMU bus pins (Wire1). The PCA9685 bus (Wire) uses PCA9685_SDA/SCL_PIN.
+#ifndef IMU_SDA_PIN
+#define IMU_SDA_PIN 8
+#endif
+#ifndef IMU_SCL_PIN
+#define IMU_SCL_PIN 9
+#endif
+
+#ifndef I2C_IMU_CLOCK_HZ
+#define I2C_IMU_CLOCK_HZ 400000
+#endif
+
+// Longest transfer on a bus this module starts (the core's default is 50 ms)
+#ifndef I2C_TIMEOUT_MS
+#define I2C_TIMEOUT_MS 5
+#endif
+
+// Bus workers (ESP32). The control loop runs at priority 1 on
+// ARDUINO_RUNNING_CORE; the IMU worker runs on the other core, so its
+// transfers and its waits on Wire1 never hold up a control frame.
+#ifndef I2C_IMU_TASK_PRIORITY
+#define I2C_IMU_TASK_PRIORITY 2
+#endif
+#ifndef I2C_IMU_TASK_CORE
+#define I2C_IMU_TASK_CORE 0
+#endif
+#ifndef I2C_TASK_STACK
+#define I2C_TASK_STACK 3072
+#endif
+
+// ========== I2C Bus Manager ==========
+// The robot has two I2C controllers, each with its own owner:
+//   PCA  Wire   PCA9685 frame commits and link checks, from the control
+//               loop task (ServoBus); nothing else touches this bus
+//   IMU  Wire1  IMU FIFO reads, from a worker task of its own
+// Each controller serialises its own transfers, and a bus is only used by
+// its owner. A slow or stuck IMU transfer therefore waits on Wire1, in the
+// IMU task on the other core, and never in a control frame.
+//
+// Every transfer made through this module (or timed with Transfer) counts
+// toward its bus: transfers, errors, time on the bus (use %) and transfer
+// latency. Periodic bus jobs also record how late the worker started them.
+// On the host, jobs run inline from poll() in loop(); there is one thread.
+//
+//   I2C          per-bus owner, transfers, errors, latency, use %
+//   I2C_RESET    start a new statistics window
+namespace I2cBus {
+
+enum Bus : uint8_t { PCA = 0, IMU, BUS_COUNT };
+
+TwoWire& wire(Bus bus);
+
+// Register the I2C commands
+void begin();
+
+// Run job every periodMs on the bus's worker (starts the controller on
+// first use). One job per bus.
+void run(Bus bus, const char* name, void (*job)(), uint16_t periodMs);
+
+// Main loop: run due jobs inline where there are no worker tasks (host)
+void poll();
+
+// ---------------- Accounted transfers ----------------
+bool writeReg(Bus bus, uint8_t addr, uint8_t reg, uint8_t value);
+// Register read with a repeated start; n up to the controller's buffer (128)
+bool readRegs(Bus bus, uint8_t addr, uint8_t reg, uint8_t* data, uint8_t n);
+// Address-only probe
+bool probe(Bus bus, uint8_t addr);
+
+// Record one transfer made some other way (cycles from Cycles::now())
+void record(Bus bus, uint32_t cycles, bool ok);
+
+// Times the enclosing transfer (e.g. a driver call) on a bus
+class Transfer {
+public:
+  explicit Transfer(Bus bus) : _bus(bus), _start(Cycles::now()) {}
+  ~Transfer() { record(_bus, Cycles::now() - _start, _ok); }
+  void fail() { _ok = false; }
+
+  Transfer(const Transfer&) = delete;
+  Transfer& operator=(const Transfer&) = delete;
+
+private:
+  Bus      _bus;
+  uint32_t _start;
+  bool     _ok = true;
+};
+
+struct Stats {
+  Histogram xferNs;    // per transfer, ns
+  Histogram lateUs;    // job start after its slot, µs
+  uint32_t  errors;
+};
+const Stats& stats(Bus bus);
+void reset();
+
+} // namespace I2cBus
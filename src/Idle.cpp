@@ -0,0 +1,183 @@
+#include "Idle.h"
+#include "CommandTable.h"
+#include "Log.h"
+#include "Transport.h"
+
+#if !defined(REX_NATIVE)
+#include <string.h>
+#if CONFIG_PM_ENABLE
+#include <driver/uart.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#endif
+#endif
+
+namespace Idle {
+
+// ---------------- Internal state ----------------
+static ServoBus* g_bus = nullptr;
+static uint32_t  g_quietMs = IDLE_QUIET_MS;
+static Policy    g_policy = HOLD;
+static uint32_t  g_lastActiveMs = 0;
+static uint32_t  g_enterMs = 0;
+static uint32_t  g_busyFromUs = 0;   // end of the last input wait
+static bool      g_asleep = false;
+static Stats     g_stats = {};
+#if !defined(REX_NATIVE)
+static uint32_t  g_cpuMhz = 0;       // clock to restore
+#endif
+
+// ---------------- CPU ----------------
+static void cpuIdle(bool on) {
+#if !defined(REX_NATIVE)
+  if (on) {
+    g_cpuMhz = getCpuFrequencyMhz();
+    setCpuFrequencyMhz(IDLE_CPU_MHZ);
+  } else if (g_cpuMhz) {
+    setCpuFrequencyMhz(g_cpuMhz);
+  }
+#if CONFIG_PM_ENABLE && IDLE_LIGHT_SLEEP
+  if (strcmp(console().name(), "uart0") == 0) {
+    const int mhz = on ? IDLE_CPU_MHZ : (int)g_cpuMhz;
+    esp_pm_config_esp32s3_t pm = {};
+    pm.max_freq_mhz = mhz;
+    pm.min_freq_mhz = mhz;
+    pm.light_sleep_enable = on;
+    if (on) {
+      uart_set_wakeup_threshold(UART_NUM_0, 3);
+      esp_sleep_enable_uart_wakeup(UART_NUM_0);
+    }
+    esp_pm_configure(&pm);
+  }
+#endif
+#else
+  (void)on;
+#endif
+}
+
+// ---------------- Transitions ----------------
+static const char* policyName(Policy p) {
+  return p == RELEASE ? "release" : "hold";
+}
+
+static void enter() {
+  g_asleep = true;
+  g_enterMs = millis();
+  g_busyFromUs = micros();
+  ++g_stats.entries;
+  LOG_I("[Idle] quiet for %lu ms: servo refresh stopped (%s)",
+        (unsigned long)g_quietMs, policyName(g_policy));
+  if (g_policy == RELEASE && g_bus) g_bus->setPcaSleep(true);
+  cpuIdle(true);
+}
+
+static void leave() {
+  const uint32_t t0 = micros();
+  cpuIdle(false);
+  if (g_bus && g_bus->isPcaAsleep()) g_bus->setPcaSleep(false);
+  const uint32_t us = micros() - t0;
+
+  g_asleep = false;
+  g_lastActiveMs = millis();
+  g_stats.idleMs += g_lastActiveMs - g_enterMs;
+  g_stats.lastWakeUs = us;
+  if (us > g_stats.maxWakeUs) g_stats.maxWakeUs = us;
+  LOG_I("[Idle] input after %lu ms idle, awake in %lu us",
+        (unsigned long)(g_lastActiveMs - g_enterMs), (unsigned long)us);
+}
+
+// ---------------- Main loop ----------------
+void poll(bool busy) {
+  if (g_asleep) return;
+  const uint32_t now = millis();
+  if (busy) {
+    g_lastActiveMs = now;
+    return;
+  }
+  if (g_quietMs && (uint32_t)(now - g_lastActiveMs) >= g_quietMs) enter();
+}
+
+void activity() {
+  if (g_asleep) leave();   // input read on a housekeeping pass
+  g_lastActiveMs = millis();
+}
+
+bool asleep() {
+  return g_asleep;
+}
+
+bool wait() {
+  g_stats.busyUs += micros() - g_busyFromUs;
+  const bool input = console().waitForInput(IDLE_WAKE_MS);
+  g_busyFromUs = micros();
+
+  if (input) {
+    leave();
+    return true;
+  }
+
+  // Housekeeping: keep the current estimate (POWER) on the idle draw
+  ++g_stats.wakeups;
+  if (g_bus) g_bus->frame();
+  return false;
+}
+
+const Stats& stats() {
+  return g_stats;
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+static void cmdIdle(const Args& a) {
+  if (a.present & 1) {
+    g_quietMs = a.num[0] > 0 ? (uint32_t)a.num[0] : 0;
+    if (a.word.equals("hold"))    g_policy = HOLD;
+    if (a.word.equals("release")) g_policy = RELEASE;
+    g_lastActiveMs = millis();
+  }
+
+  Print& out = console();
+  out.print(F("[Idle] "));
+  out.print(g_asleep ? F("idle") : F("awake"));
+  if (g_quietMs) {
+    out.print(F(", idle after "));
+    out.print(g_quietMs);
+    out.print(F(" ms quiet ("));
+    out.print(policyName(g_policy));
+    out.println(')');
+  } else {
+    out.println(F(", never idles"));
+  }
+
+  // CPU share while idle: time outside the input wait over idle time
+  const uint32_t idleMs = g_stats.idleMs + (g_asleep ? millis() - g_enterMs : 0);
+  const uint32_t busyUs = g_stats.busyUs + (g_asleep ? micros() - g_busyFromUs : 0);
+  out.print(F("[Idle] "));
+  out.print(g_stats.entries);
+  out.print(F(" entries, "));
+  out.print(idleMs);
+  out.print(F(" ms idle, CPU busy "));
+  out.print(idleMs ? busyUs / 10.0f / idleMs : 0.0f, 2);
+  out.print(F("% of it, "));
+  out.print(g_stats.wakeups);
+  out.println(F(" housekeeping wake-ups"));
+
+  out.print(F("[Idle] wake latency last "));
+  out.print(g_stats.lastWakeUs);
+  out.print(F(" us, max "));
+  out.print(g_stats.maxWakeUs);
+  out.println(F(" us"));
+}
+
+static const CommandTable::Entry kIdleCommands[] = {
+  { CMD_VERB("IDLE"), cmdIdle },
+};
+
+void begin(ServoBus* bus) {
+  g_bus = bus;
+  g_lastActiveMs = millis();
+  CommandTable::add(kIdleCommands);
+}
+
+} // namespace Idle
@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+#include "ServoBus.h"
+
+// ========== Idle Configuration ==========
+// No input and nothing moving for this long puts the robot in idle mode
+// (0 = never; IDLE <ms> changes it at runtime)
+#ifndef IDLE_QUIET_MS
+#define IDLE_QUIET_MS 10000
+#endif
+
+// Longest wait for input before a housekeeping pass while idle
+#ifndef IDLE_WAKE_MS
+#define IDLE_WAKE_MS 1000
+#endif
+
+// CPU clock while idle (MHz; 80 keeps the UART and LEDC clocks exact)
+#ifndef IDLE_CPU_MHZ
+#define IDLE_CPU_MHZ 80
+#endif
+
+// Automatic light sleep while idle on the UART transport (needs
+// CONFIG_PM_ENABLE). The UART wakes the chip on RX edges, so the first
+// byte or two of the waking line can be lost; send a newline first.
+// USB-CDC would drop its link, so it only gets the lower clock.
+#ifndef IDLE_LIGHT_SLEEP
+#define IDLE_LIGHT_SLEEP 1
+#endif
+
+// ========== Idle Manager ==========
+// With the legs in IDLE and no input, loop() would still run a control
+// frame every 20 ms and rewrite the neutral stance over I2C. After the
+// quiet period the idle manager stops framing: the PCA9685 and the LEDC
+// channels keep generating the last pulses on their own (HOLD), or the
+// PCA9685 is put to sleep so the legs go limp (RELEASE). The CPU drops
+// its clock and blocks on the transport's RX event (Transport::
+// waitForInput), waking once per IDLE_WAKE_MS for housekeeping.
+//
+// Any input wakes it: the clock and the PCA9685 are restored and the
+// control frame runs in the same loop pass, well within one frame.
+//
+//   IDLE                              state, wake latency, idle CPU share
+//   IDLE <quiet_ms> [hold|release]    quiet period (0 = never) and policy
+namespace Idle {
+
+enum Policy : uint8_t { HOLD = 0, RELEASE };
+
+// Register the IDLE command
+void begin(ServoBus* bus);
+
+// Main loop, after the control frame: `busy` while anything needs frames
+// (gait, sweep, show, stream, queued commands, telemetry, slewing)
+void poll(bool busy);
+
+// Input was handled (wakes the robot, keeps it awake for another quiet period)
+void activity();
+
+bool asleep();
+
+// While asleep, instead of delay(): block until input or the housekeeping
+// timeout. Returns true when input woke the robot. loop() runs no control
+// frame while asleep and re-times the next one to the end of the wait.
+bool wait();
+
+struct Stats {
+  uint32_t entries;      // times idle was entered
+  uint32_t idleMs;       // time spent idle (finished stretches)
+  uint32_t busyUs;       // CPU time outside the input wait while idle
+  uint32_t wakeups;      // housekeeping passes (no input)
+  uint32_t lastWakeUs;   // input seen -> clock and servos restored
+  uint32_t maxWakeUs;
+};
+const Stats& stats();
+
+} // namespace Idle
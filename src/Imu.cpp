@@ -0,0 +1,175 @@
+#include "Imu.h"
+#include <atomic>
+#include "CommandTable.h"
+#include "I2cBus.h"
+#include "Log.h"
+#include "Transport.h"
+
+namespace Imu {
+
+// ---------------- Internal state ----------------
+static Stats g_stats = {};
+
+// Seqlock: the worker bumps g_seq to odd, writes, bumps to even; readers
+// retry while it is odd or moved
+static std::atomic<uint32_t> g_seq(0);
+static Sample g_sample = {};
+
+const Stats& stats() { return g_stats; }
+
+bool latest(Sample& out) {
+  for (;;) {
+    const uint32_t s0 = g_seq.load(std::memory_order_acquire);
+    if (s0 & 1) continue;
+    out = g_sample;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (g_seq.load(std::memory_order_relaxed) == s0) return s0 != 0;
+  }
+}
+
+#if defined(IMU_SENSOR_MPU6050)
+// ---------------- MPU6050 ----------------
+static const uint8_t kSmplrtDiv   = 0x19;
+static const uint8_t kConfig      = 0x1A;
+static const uint8_t kGyroConfig  = 0x1B;
+static const uint8_t kAccelConfig = 0x1C;
+static const uint8_t kFifoEn      = 0x23;
+static const uint8_t kUserCtrl    = 0x6A;
+static const uint8_t kPwrMgmt1    = 0x6B;
+static const uint8_t kFifoCountH  = 0x72;
+static const uint8_t kFifoRW      = 0x74;
+static const uint8_t kWhoAmI      = 0x75;
+
+static const uint8_t  kSampleBytes = 12;     // accel XYZ, gyro XYZ (big-endian)
+static const uint8_t  kBurstSamples = 10;    // 120 bytes per transfer
+static const uint16_t kFifoSize = 1024;
+
+static bool     g_ready = false;
+static uint32_t g_retryMs = 0;
+static uint8_t  g_buf[kSampleBytes * kBurstSamples];
+
+static bool reg(uint8_t r, uint8_t v) {
+  return I2cBus::writeReg(I2cBus::IMU, IMU_I2C_ADDRESS, r, v);
+}
+
+// Wake on the gyro PLL, DLPF 44 Hz (1 kHz gyro rate), ±500 deg/s, ±4 g,
+// accel + gyro into a freshly reset FIFO
+static bool setup() {
+  uint8_t who = 0;
+  if (!I2cBus::readRegs(I2cBus::IMU, IMU_I2C_ADDRESS, kWhoAmI, &who, 1)) return false;
+  return reg(kPwrMgmt1, 0x01) &&
+         reg(kSmplrtDiv, (uint8_t)(1000 / IMU_RATE_HZ - 1)) &&
+         reg(kConfig, 0x03) &&
+         reg(kGyroConfig, 1 << 3) &&
+         reg(kAccelConfig, 1 << 3) &&
+         reg(kUserCtrl, 0x04) &&     // FIFO reset
+         reg(kFifoEn, 0x78) &&       // XG YG ZG ACCEL
+         reg(kUserCtrl, 0x40);       // FIFO on
+}
+
+static void publish(const uint8_t* p) {
+  g_seq.fetch_add(1, std::memory_order_acq_rel);
+  for (uint8_t i = 0; i < 3; ++i) {
+    g_sample.accel[i] = (int16_t)((p[2 * i] << 8) | p[2 * i + 1]);
+    g_sample.gyro[i]  = (int16_t)((p[6 + 2 * i] << 8) | p[6 + 2 * i + 1]);
+  }
+  g_sample.us = micros();
+  g_seq.fetch_add(1, std::memory_order_release);
+}
+
+static void lost() {
+  ++g_stats.errors;
+  g_ready = false;
+  g_retryMs = millis() + IMU_RETRY_MS;
+  LOG_W("[IMU] MPU6050 stopped answering, retrying");
+}
+
+// IMU bus worker: (re)discover the sensor, then drain whole samples
+static void job() {
+  if (!g_ready) {
+    if ((int32_t)(millis() - g_retryMs) < 0) return;
+    g_retryMs = millis() + IMU_RETRY_MS;
+    if (!setup()) return;
+    g_ready = true;
+    LOG_I("[IMU] MPU6050 at 0x%02X, %u Hz into the FIFO", IMU_I2C_ADDRESS, (unsigned)IMU_RATE_HZ);
+    return;
+  }
+
+  uint8_t c[2];
+  if (!I2cBus::readRegs(I2cBus::IMU, IMU_I2C_ADDRESS, kFifoCountH, c, 2)) {
+    lost();
+    return;
+  }
+  uint16_t count = (uint16_t)((c[0] << 8) | c[1]);
+  ++g_stats.reads;
+  if (count + kSampleBytes > kFifoSize) {
+    // Full: the oldest samples are gone and the frame alignment with them
+    ++g_stats.overflows;
+    if (!reg(kUserCtrl, 0x44)) lost();
+    return;
+  }
+
+  uint16_t samples = count / kSampleBytes;
+  while (samples) {
+    const uint8_t n = samples < kBurstSamples ? (uint8_t)samples : kBurstSamples;
+    if (!I2cBus::readRegs(I2cBus::IMU, IMU_I2C_ADDRESS, kFifoRW, g_buf, (uint8_t)(n * kSampleBytes))) {
+      lost();
+      return;
+    }
+    g_stats.samples += n;
+    samples -= n;
+    if (!samples) publish(g_buf + (n - 1) * kSampleBytes);
+  }
+}
+#endif
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+static void cmdImu(const Args&) {
+  Print& out = console();
+#if defined(IMU_SENSOR_MPU6050)
+  Sample s;
+  if (latest(s)) {
+    out.print(F("[IMU] accel g"));
+    for (uint8_t i = 0; i < 3; ++i) {
+      out.print(' ');
+      out.print(s.accel[i] / 8192.0f, 3);
+    }
+    out.print(F(", gyro deg/s"));
+    for (uint8_t i = 0; i < 3; ++i) {
+      out.print(' ');
+      out.print(s.gyro[i] / 65.5f, 1);
+    }
+    out.print(F(", "));
+    out.print((uint32_t)(micros() - s.us) / 1000);
+    out.println(F(" ms old"));
+  } else {
+    out.println(F("[IMU] no sample yet"));
+  }
+  out.print(F("[IMU] "));
+  out.print(g_stats.samples);
+  out.print(F(" samples in "));
+  out.print(g_stats.reads);
+  out.print(F(" FIFO reads, "));
+  out.print(g_stats.overflows);
+  out.print(F(" overflows, "));
+  out.print(g_stats.errors);
+  out.println(F(" errors"));
+#else
+  out.println(F("[IMU] not built in (IMU_SENSOR_MPU6050)"));
+#endif
+}
+
+static const CommandTable::Entry kImuCommands[] = {
+  { CMD_VERB("IMU"), cmdImu },
+};
+
+void begin() {
+  CommandTable::add(kImuCommands);
+#if defined(IMU_SENSOR_MPU6050)
+  I2cBus::run(I2cBus::IMU, "imu", job, IMU_POLL_MS);
+#endif
+}
+
+} // namespace Imu
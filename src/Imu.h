@@ -0,0 +1,54 @@
+#pragma once
+#include <Arduino.h>
+
+// ========== IMU Configuration ==========
+// MPU6050 on the IMU bus (I2cBus::IMU, Wire1), built with IMU_SENSOR_MPU6050
+#ifndef IMU_I2C_ADDRESS
+#define IMU_I2C_ADDRESS 0x68
+#endif
+
+// Sample rate into the FIFO (1 kHz / n with the low-pass filter on)
+#ifndef IMU_RATE_HZ
+#define IMU_RATE_HZ 200
+#endif
+
+// FIFO drain period; the 1024-byte FIFO holds 85 samples (425 ms at 200 Hz)
+#ifndef IMU_POLL_MS
+#define IMU_POLL_MS 20
+#endif
+
+// Re-probe period while the sensor does not answer
+#ifndef IMU_RETRY_MS
+#define IMU_RETRY_MS 1000
+#endif
+
+// ========== IMU FIFO Reader ==========
+// The MPU6050 samples accelerometer and gyro into its FIFO at IMU_RATE_HZ;
+// the IMU bus worker drains it every IMU_POLL_MS in bursts (10 samples per
+// transfer) and publishes the newest sample. Reads happen only in the
+// worker, so the control frame just copies the last sample.
+//
+//   IMU    last sample (g, deg/s) and FIFO statistics
+namespace Imu {
+
+struct Sample {
+  int16_t  accel[3];   // raw, 8192 per g (±4 g)
+  int16_t  gyro[3];    // raw, 65.5 per deg/s (±500 deg/s)
+  uint32_t us;         // micros() when it was read out
+};
+
+// Register IMU and start the FIFO reader (no-op without IMU_SENSOR_MPU6050)
+void begin();
+
+// Newest sample; false until the first one arrived
+bool latest(Sample& out);
+
+struct Stats {
+  uint32_t samples;     // read from the FIFO
+  uint32_t reads;       // FIFO drains
+  uint32_t overflows;   // FIFO filled up (samples lost, FIFO reset)
+  uint32_t errors;      // failed transfers (sensor re-probed)
+};
+const Stats& stats();
+
+} // namespace Imu
@@ -0,0 +1,171 @@
+#include "LineReader.h"
+#include "RexProtocol.h"
+#include "Trace.h"
+#include <string.h>
+
+// Longest COBS body between the delimiters
+static const uint16_t kMaxFrame = REX_PROTO_MAX_WIRE - 2;
+static_assert(kMaxFrame <= LINE_READER_MAX_LINE, "a frame must fit the line buffer");
+
+// ========== Helpers ==========
+static inline bool isBlank(char c) { return c == ' ' || c == '\t'; }
+static inline bool isText(char c) { return (c >= 0x20 && c < 0x7F) || c == '\t' || c == '\r'; }
+
+bool LineToken::equals(const char* s) const {
+  if (!ptr || !s) return false;
+  return strncmp(ptr, s, len) == 0 && s[len] == '\0';
+}
+
+// ========== Bulk Read ==========
+
+size_t LineReader::poll(Stream& in) {
+  size_t total = 0;
+
+  // At most two passes: up to the end of the ring, then from the start
+  for (uint8_t pass = 0; pass < 2; ++pass) {
+    const int avail = in.available();
+    if (avail <= 0) break;
+
+    const uint16_t used = (uint16_t)(_head - _tail);
+    const uint16_t space = LINE_READER_RING_SIZE - used;
+    if (space == 0) break;   // caller is behind; leave bytes in the driver FIFO
+
+    const uint16_t start = _head & kMask;
+    uint16_t chunk = LINE_READER_RING_SIZE - start;   // contiguous run
+    if (chunk > space) chunk = space;
+    if ((int)chunk > avail) chunk = (uint16_t)avail;
+
+    // Only ask for what is already buffered so readBytes() never waits
+    const size_t got = in.readBytes(&_ring[start], chunk);
+    _head += (uint16_t)got;
+    total += got;
+    if (got < chunk) break;
+  }
+
+  if (total) TRACE_RX();
+  return total;
+}
+
+// ========== Line Assembly ==========
+
+LineReader::Item LineReader::next(char*& data, size_t& len) {
+  while (_tail != _head) {
+    const char c = (char)_ring[_tail & kMask];
+    ++_tail;
+
+    // ---- Binary frame mode: everything up to the closing 0x00 ----
+    if (_inFrame) {
+      if (c == '\0') {
+        if (_len == 0) continue;   // back-to-back delimiters: still opening
+
+        const uint16_t n = _len;
+        _len = 0;
+        _inFrame = false;
+        ++_frames;
+        data = _line;
+        len  = n;
+        TRACE_START();
+        return FRAME;
+      }
+
+      // A frame's second byte is its type, which is never text, so a
+      // newline after text only ends a line. Longer than any frame: text.
+      if (c == '\n' && _len > 0 && _frameText) {
+        resync();
+      } else if (_len < kMaxFrame) {
+        _line[_len++] = c;
+        _frameText = _frameText && isText(c);
+        continue;
+      } else {
+        resync();
+      }
+      // c continues as text
+    }
+
+    // ---- Text mode ----
+    if (c == '\0') {          // frame start; drop any partial text
+      _inFrame = true;
+      _frameText = true;
+      _overflow = false;
+      _len = 0;
+      continue;
+    }
+
+    if (c == '\r') continue;   // Ignore carriage return
+
+    if (c != '\n') {
+      if (_len < LINE_READER_MAX_LINE) {
+        _line[_len++] = c;
+      } else {
+        _overflow = true;      // keep consuming until the newline
+      }
+      continue;
+    }
+
+    // Complete line
+    if (_overflow) {
+      ++_overflows;
+      _overflow = false;
+      _len = 0;
+      continue;
+    }
+
+    // Trim in place
+    uint16_t end = _len;
+    while (end > 0 && isBlank(_line[end - 1])) --end;
+    uint16_t begin = 0;
+    while (begin < end && isBlank(_line[begin])) ++begin;
+    _line[end] = '\0';
+    _len = 0;
+
+    if (begin == end) continue;   // blank line
+
+    ++_lines;
+    data = &_line[begin];
+    len  = end - begin;
+    TRACE_START();
+    return LINE;
+  }
+
+  return NONE;
+}
+
+uint8_t LineReader::tokenize(const char* line, size_t len, LineToken* out, uint8_t maxTokens) {
+  uint8_t n = 0;
+  size_t  i = 0;
+
+  while (i < len && n < maxTokens) {
+    while (i < len && isBlank(line[i])) ++i;
+    if (i >= len) break;
+
+    const size_t start = i;
+    while (i < len && !isBlank(line[i])) ++i;
+
+    out[n].ptr = &line[start];
+    out[n].len = (uint8_t)(i - start);
+    ++n;
+  }
+
+  return n;
+}
+
+// Leave frame mode. Printable bytes start a text line (text mode never
+// stores carriage returns); anything else was noise and is dropped.
+void LineReader::resync() {
+  uint16_t n = 0;
+  if (_frameText) {
+    for (uint16_t i = 0; i < _len; ++i) {
+      if (_line[i] != '\r') _line[n++] = _line[i];
+    }
+  }
+  _len = n;
+  _inFrame = false;
+  ++_resyncs;
+}
+
+void LineReader::reset() {
+  _tail = _head;
+  _len = 0;
+  _overflow = false;
+  _inFrame = false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <Arduino.h>
+
+// ========== Line Reader Configuration ==========
+// Raw RX bytes buffered between polls (must be a power of two)
+#ifndef LINE_READER_RING_SIZE
+#define LINE_READER_RING_SIZE 256
+#endif
+
+// Longest accepted command line, excluding the newline.
+// Longer lines are dropped whole and counted in overflows().
+#ifndef LINE_READER_MAX_LINE
+#define LINE_READER_MAX_LINE 128
+#endif
+
+// ========== Token View ==========
+// Points into the line it was cut from; not NUL-terminated on its own.
+struct LineToken {
+  const char* ptr = nullptr;
+  uint8_t     len = 0;
+
+  bool equals(const char* s) const;   // exact match against a C string
+};
+
+// --------------------------- LineReader ---------------------------
+// Fixed-capacity serial line assembler. Bytes are pulled from the stream in
+// bulk into a ring buffer, then cut into trimmed, NUL-terminated lines that
+// live in an internal buffer. Nothing here touches the heap.
+//
+// Binary frames (see RexProtocol.h) share the stream: a 0x00 byte switches
+// to frame mode, and the COBS bytes up to the next 0x00 come back as FRAME.
+// Frame mode ends early, and the bytes are read as text again, when it runs
+// past REX_PROTO_MAX_WIRE or a newline follows nothing but text: the 0x00
+// was line noise, and the STOP after it must not be swallowed.
+class LineReader {
+public:
+  enum Item : uint8_t {
+    NONE = 0,   // nothing complete yet
+    LINE,       // trimmed text line, NUL-terminated
+    FRAME       // COBS-encoded frame body, delimiters stripped
+  };
+
+  // Pull everything the stream has buffered into the ring (never blocks).
+  // Returns the number of bytes read.
+  size_t poll(Stream& in);
+
+  // Assemble the next complete line or frame from the ring.
+  // Returns NONE when nothing complete is pending. The view stays valid
+  // until the next call to next(); the caller may rewrite it in place
+  // (the JSON parser does).
+  Item next(char*& data, size_t& len);
+
+  // Split a line on spaces/tabs without copying.
+  // Returns the number of tokens written to out (at most maxTokens).
+  static uint8_t tokenize(const char* line, size_t len, LineToken* out, uint8_t maxTokens);
+
+  // Drop any partial line and buffered bytes
+  void reset();
+
+  // Queries
+  inline uint32_t linesRead() const { return _lines; }
+  inline uint32_t framesRead() const { return _frames; }
+  inline uint32_t overflows() const { return _overflows; }
+  inline uint32_t resyncs()   const { return _resyncs; }     // frame mode abandoned
+  inline size_t   pending()   const { return (uint16_t)(_head - _tail); }
+
+private:
+  void resync();
+
+  uint8_t  _ring[LINE_READER_RING_SIZE];
+  char     _line[LINE_READER_MAX_LINE + 1];
+  uint16_t _head = 0;        // write index (free-running)
+  uint16_t _tail = 0;        // read index (free-running)
+  uint16_t _len  = 0;        // bytes in the partial line
+  bool     _overflow = false;
+  bool     _inFrame = false;
+  bool     _frameText = false;   // frame bytes so far are all printable
+  uint32_t _lines = 0;
+  uint32_t _frames = 0;
+  uint32_t _overflows = 0;
+  uint32_t _resyncs = 0;
+
+  static const uint16_t kMask = LINE_READER_RING_SIZE - 1;
+  static_assert((LINE_READER_RING_SIZE & kMask) == 0, "LINE_READER_RING_SIZE must be a power of two");
+};
@@ -0,0 +1,254 @@
+#include "Log.h"
+#include "Mem.h"
+#include "Transport.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+// Drain from a FreeRTOS task on the ESP32; elsewhere drain inline
+#if defined(ARDUINO_ARCH_ESP32)
+#define LOG_USE_TASK 1
+#else
+#define LOG_USE_TASK 0
+#endif
+
+// Drain task polling period when the ring is empty
+#ifndef LOG_DRAIN_PERIOD_MS
+#define LOG_DRAIN_PERIOD_MS 5
+#endif
+
+namespace Log {
+
+// ---------------- Internal state ----------------
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+// Bounded multi-producer ring: each slot carries a sequence number that
+// says whether it is free for ticket `pos` (seq == pos) or holds the
+// record for ticket `pos` (seq == pos + 1). Producers claim tickets with a
+// CAS on g_head; the single drain advances g_tail.
+struct Slot {
+  std::atomic<uint32_t> seq;
+  uint32_t    ms;
+  const char* fmt;
+  uint8_t     level;
+  uint8_t     argc;
+  uint8_t     types[LOG_MAX_ARGS];
+  union {
+    int32_t     i;
+    uint32_t    u;
+    float       f;
+    const char* s;
+  } vals[LOG_MAX_ARGS];
+  char        text[LOG_TEXT_MAX + 1];
+};
+
+static Slot                  g_ring[LOG_RING_SIZE];
+static std::atomic<uint32_t> g_head(0);
+static uint32_t              g_tail = 0;
+static std::atomic<uint32_t> g_dropped(0);
+static uint32_t              g_reported = 0;     // drops already announced
+static uint32_t              g_written = 0;
+static uint32_t              g_highWater = 0;
+static bool                  g_ringInit = false;
+static bool                  g_started  = false;   // begin() ran: output may start
+
+static void initRing() {
+  for (uint32_t i = 0; i < LOG_RING_SIZE; ++i) {
+    g_ring[i].seq.store(i, std::memory_order_relaxed);
+  }
+  g_ringInit = true;
+}
+
+// ---------------- Producer ----------------
+void push(Level level, const char* fmt, const Arg* args, uint8_t argc) {
+  if (!g_ringInit) initRing();
+
+  uint32_t pos = g_head.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &g_ring[pos & (LOG_RING_SIZE - 1)];
+    const int32_t dif = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+    if (dif == 0) {
+      if (g_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (dif < 0) {
+      // Ring full: drop rather than wait for the drain
+      g_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = g_head.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->ms    = millis();
+  slot->fmt   = fmt;
+  slot->level = level;
+  slot->argc  = argc;
+  slot->text[0] = '\0';
+  for (uint8_t i = 0; i < argc; ++i) {
+    slot->types[i] = args[i].type;
+    if (args[i].type == Arg::TEXT) {
+      const size_t n = args[i].t.len < LOG_TEXT_MAX ? args[i].t.len : LOG_TEXT_MAX;
+      if (n) memcpy(slot->text, args[i].t.ptr, n);
+      slot->text[n] = '\0';
+      slot->vals[i].s = nullptr;
+    } else {
+      slot->vals[i].u = args[i].u;
+      if (args[i].type == Arg::STR) slot->vals[i].s = args[i].s;
+    }
+  }
+  slot->seq.store(pos + 1, std::memory_order_release);
+
+  const uint32_t depth = pos + 1 - g_tail;
+  if (depth > g_highWater) g_highWater = depth;
+
+#if !LOG_USE_TASK
+  if (g_started) drain();
+#endif
+}
+
+// ---------------- Formatting ----------------
+static bool isFlag(char c) { return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0'; }
+
+// Expand one record's printf-style format. Each conversion takes the next
+// captured argument and is rendered according to that argument's type.
+static size_t format(const Slot& r, char* out, size_t cap) {
+  size_t n = 0;
+  uint8_t next = 0;
+
+  for (const char* p = r.fmt; *p && n + 1 < cap; ++p) {
+    if (*p != '%') { out[n++] = *p; continue; }
+    if (p[1] == '%') { out[n++] = '%'; ++p; continue; }
+
+    // %[flags][width][.precision][length]conv
+    char spec[16];
+    size_t s = 0;
+    spec[s++] = '%';
+    ++p;
+    while (*p && (isFlag(*p) || (*p >= '0' && *p <= '9') || *p == '.') && s < sizeof(spec) - 4) {
+      spec[s++] = *p++;
+    }
+    while (*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L') ++p;
+    if (!*p) break;
+    const char conv = *p;
+    if (next >= r.argc) continue;
+
+    const uint8_t i = next++;
+    int w = 0;
+    switch (r.types[i]) {
+      case Arg::INT:
+      case Arg::UINT:
+        if (conv == 'c') {
+          spec[s++] = 'c'; spec[s] = '\0';
+          w = snprintf(out + n, cap - n, spec, (int)r.vals[i].i);
+        } else if (r.types[i] == Arg::INT && conv != 'u' && conv != 'x' && conv != 'X' && conv != 'o') {
+          spec[s++] = 'l'; spec[s++] = 'd'; spec[s] = '\0';
+          w = snprintf(out + n, cap - n, spec, (long)r.vals[i].i);
+        } else {
+          spec[s++] = 'l';
+          spec[s++] = (conv == 'x' || conv == 'X' || conv == 'o') ? conv : 'u';
+          spec[s] = '\0';
+          w = snprintf(out + n, cap - n, spec, (unsigned long)r.vals[i].u);
+        }
+        break;
+      case Arg::FLOAT:
+        spec[s++] = strchr("fFeEgG", conv) ? conv : 'f';
+        spec[s] = '\0';
+        w = snprintf(out + n, cap - n, spec, (double)r.vals[i].f);
+        break;
+      default: {
+        const char* str = (r.types[i] == Arg::TEXT) ? r.text : r.vals[i].s;
+        spec[s++] = 's'; spec[s] = '\0';
+        w = snprintf(out + n, cap - n, spec, str ? str : "(null)");
+        break;
+      }
+    }
+    if (w > 0) n += ((size_t)w < cap - n) ? (size_t)w : cap - n - 1;
+  }
+
+  out[n] = '\0';
+  return n;
+}
+
+// ---------------- Drain ----------------
+// Wait for room in the port's TX buffer (only the drain ever waits), then
+// hand over the line and its CRLF in one write. line needs 2 spare bytes.
+static void writeLine(char* line, size_t len) {
+  Transport& out = console();
+  line[len++] = '\r';
+  line[len++] = '\n';
+#if LOG_USE_TASK
+  while (out.availableForWrite() < (int)len) {
+    vTaskDelay(1);
+  }
+#endif
+  out.write((const uint8_t*)line, len);
+}
+
+size_t drain(size_t maxRecords) {
+  if (!g_ringInit) initRing();
+
+  static char line[LOG_LINE_MAX + 2];
+  size_t count = 0;
+
+  while (count < maxRecords) {
+    Slot& slot = g_ring[g_tail & (LOG_RING_SIZE - 1)];
+    if ((int32_t)(slot.seq.load(std::memory_order_acquire) - (g_tail + 1)) < 0) break;
+
+    size_t n = 0;
+#if LOG_TIMESTAMPS
+    n = snprintf(line, sizeof(line), "[%lu] ", (unsigned long)slot.ms);
+#endif
+    n += format(slot, line + n, LOG_LINE_MAX - n);
+
+    // Release the slot before the (possibly slow) write
+    slot.seq.store(g_tail + LOG_RING_SIZE, std::memory_order_release);
+    ++g_tail;
+
+    writeLine(line, n);
+    ++g_written;
+    ++count;
+  }
+
+  const uint32_t dropped = g_dropped.load(std::memory_order_relaxed);
+  if (dropped != g_reported) {
+    const int n = snprintf(line, LOG_LINE_MAX, "[Log] %lu records dropped",
+                           (unsigned long)(dropped - g_reported));
+    g_reported = dropped;
+    writeLine(line, (size_t)n);
+  }
+
+  return count;
+}
+
+#if LOG_USE_TASK
+static void drainTask(void*) {
+  for (;;) {
+    if (drain() == 0) vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+  }
+}
+#endif
+
+void begin() {
+  if (!g_ringInit) initRing();
+  if (g_started) return;
+  g_started = true;
+#if LOG_USE_TASK
+  // Low priority on the core the Arduino loop does not use
+  TaskHandle_t task = nullptr;
+  xTaskCreatePinnedToCore(drainTask, "log", 4096, nullptr, tskIDLE_PRIORITY + 1, &task, 0);
+  Mem::watchTask("log", task);
+#else
+  drain();   // records pushed before the console was up
+#endif
+}
+
+// ---------------- Statistics ----------------
+Stats stats() {
+  return Stats{ g_written, g_dropped.load(std::memory_order_relaxed), g_highWater };
+}
+
+size_t pending() {
+  return g_head.load(std::memory_order_relaxed) - g_tail;
+}
+
+} // namespace Log
@@ -0,0 +1,147 @@
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+
+// ========== Log Configuration ==========
+// Levels (compile-time filtered: disabled levels compile to nothing and
+// their arguments are never evaluated)
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Record slots in the ring (power of two)
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 32
+#endif
+
+// Arguments per record and bytes of copied text per record
+#define LOG_MAX_ARGS 4
+#ifndef LOG_TEXT_MAX
+#define LOG_TEXT_MAX 96
+#endif
+
+// Longest formatted line written by the drain
+#define LOG_LINE_MAX 160
+
+// Prefix drained lines with the record's millis() timestamp
+#ifndef LOG_TIMESTAMPS
+#define LOG_TIMESTAMPS 0
+#endif
+
+// ========== Logging Macros ==========
+// printf-style format, which must be a string literal (records keep the
+// pointer and format later, on the drain side):
+//   LOG_I("[Leg] Walking forward at %.2f Hz", hz);
+// const char* arguments must also be static strings; wrap anything that
+// lives in a reusable buffer with Log::text() so it is copied.
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(...) Log::write(Log::LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_E(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(...) Log::write(Log::LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_W(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(...) Log::write(Log::LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_I(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(...) Log::write(Log::LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_D(...) ((void)0)
+#endif
+
+namespace Log {
+
+enum Level : uint8_t {
+  LEVEL_ERROR = LOG_LEVEL_ERROR,
+  LEVEL_WARN  = LOG_LEVEL_WARN,
+  LEVEL_INFO  = LOG_LEVEL_INFO,
+  LEVEL_DEBUG = LOG_LEVEL_DEBUG,
+};
+
+// ========== Arguments ==========
+// Copied text (at most one per record, truncated to LOG_TEXT_MAX)
+struct Text {
+  const char* ptr;
+  size_t      len;
+};
+
+inline Text text(const char* s, size_t len) { return Text{ s, len }; }
+inline Text text(const char* s) { return Text{ s, s ? strlen(s) : 0 }; }
+
+// One captured argument; the type picks the conversion at drain time
+struct Arg {
+  enum Type : uint8_t { INT, UINT, FLOAT, STR, TEXT };
+  Type type;
+  union {
+    int32_t     i;
+    uint32_t    u;
+    float       f;
+    const char* s;
+  };
+  Text t;
+
+  Arg(int v)                : type(INT),   i(v) {}
+  Arg(long v)               : type(INT),   i((int32_t)v) {}
+  Arg(unsigned v)           : type(UINT),  u(v) {}
+  Arg(unsigned long v)      : type(UINT),  u((uint32_t)v) {}
+  Arg(float v)              : type(FLOAT), f(v) {}
+  Arg(double v)             : type(FLOAT), f((float)v) {}
+  Arg(const char* v)        : type(STR),   s(v) {}
+  Arg(Text v)               : type(TEXT),  s(nullptr), t(v) {}
+};
+
+// ========== Producer API ==========
+// Never blocks: when the ring is full the record is dropped and counted.
+// Safe to call from any task.
+void push(Level level, const char* fmt, const Arg* args, uint8_t argc);
+
+inline void write(Level level, const char* fmt) { push(level, fmt, nullptr, 0); }
+
+// Records have one text buffer, so a second Text would overwrite the first
+template <typename... A>
+constexpr unsigned textArgs() { return (0u + ... + (std::is_same<A, Text>::value ? 1u : 0u)); }
+
+template <typename... A>
+inline void write(Level level, const char* fmt, const A&... a) {
+  static_assert(sizeof...(A) <= LOG_MAX_ARGS, "too many log arguments");
+  static_assert(textArgs<A...>() <= 1, "at most one Log::text() per record");
+  const Arg args[] = { Arg(a)... };
+  push(level, fmt, args, (uint8_t)sizeof...(A));
+}
+
+// ========== Drain ==========
+// Start the low-priority drain task. Builds without FreeRTOS drain inline
+// from push() instead. Records pushed before begin() wait in the ring
+// (call it once the console is open).
+void begin();
+
+// Format and write up to maxRecords pending records; returns how many
+// were written. Called by the drain task; usable directly to flush.
+size_t drain(size_t maxRecords = LOG_RING_SIZE);
+
+// ========== Statistics ==========
+struct Stats {
+  uint32_t written;     // records formatted and sent
+  uint32_t dropped;     // records lost to a full ring
+  uint32_t highWater;   // most records pending at once
+};
+
+Stats  stats();
+size_t pending();
+
+} // namespace Log
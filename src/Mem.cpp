@@ -0,0 +1,150 @@
+#include "Mem.h"
+#include <new>
+#include <stdlib.h>
+#include "CommandTable.h"
+#include "Log.h"
+#include "Transport.h"
+
+#if !defined(REX_NATIVE)
+#include <esp_heap_caps.h>
+#endif
+
+// ========== Allocation Counters ==========
+// Relaxed atomics: the counters are bumped from any task (and from the
+// host tools' worker threads) and only ever read as totals.
+static uint32_t g_allocs = 0;
+static uint32_t g_allocBytes = 0;
+
+static inline void count(size_t n) {
+  __atomic_add_fetch(&g_allocs, 1u, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&g_allocBytes, (uint32_t)n, __ATOMIC_RELAXED);
+}
+
+#if defined(REX_MEM_WRAP_MALLOC)
+extern "C" {
+void* __real_malloc(size_t n);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t n);
+
+void* __wrap_malloc(size_t n) {
+  count(n);
+  return __real_malloc(n);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+  count(n * size);
+  return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t n) {
+  count(n);
+  return __real_realloc(p, n);
+}
+}
+#else
+// operator new goes through malloc; count it here when malloc is not wrapped
+static void* countedNew(size_t n) {
+  count(n);
+  void* p = malloc(n ? n : 1);
+  if (!p) abort();
+  return p;
+}
+
+void* operator new(size_t n) { return countedNew(n); }
+void* operator new[](size_t n) { return countedNew(n); }
+void  operator delete(void* p) noexcept { free(p); }
+void  operator delete[](void* p) noexcept { free(p); }
+void  operator delete(void* p, size_t) noexcept { free(p); }
+void  operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+namespace Mem {
+
+// ---------------- Internal state ----------------
+struct Task {
+  const char* name;
+  void*       handle;
+};
+
+static Task     g_tasks[MEM_MAX_TASKS];
+static uint8_t  g_taskCount = 0;
+static uint32_t g_bootAllocs = 0;
+static uint32_t g_bootBytes = 0;
+static bool     g_booted = false;
+static bool     g_warned = false;
+
+uint32_t allocs()     { return __atomic_load_n(&g_allocs, __ATOMIC_RELAXED); }
+uint32_t allocBytes() { return __atomic_load_n(&g_allocBytes, __ATOMIC_RELAXED); }
+
+uint32_t allocsSinceBoot() { return g_booted ? allocs() - g_bootAllocs : 0; }
+
+void watchTask(const char* name, void* handle) {
+  if (!handle || g_taskCount >= MEM_MAX_TASKS) return;
+  g_tasks[g_taskCount++] = { name, handle };
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+static void cmdMem(const Args&) {
+  Print& out = console();
+  out.print(F("[Mem] allocations since boot="));
+  out.print(allocsSinceBoot());
+  out.print(F(" ("));
+  out.print(allocBytes() - g_bootBytes);
+  out.print(F(" bytes), during boot="));
+  out.print(g_bootAllocs);
+  out.print(F(" ("));
+  out.print(g_bootBytes);
+  out.println(F(" bytes)"));
+
+#if defined(REX_NATIVE)
+  out.println(F("[Mem] heap and stack figures are device-only"));
+#else
+  // Largest block vs free: how much of the free heap one allocation can use
+  const size_t free    = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  const size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  out.print(F("[Mem] heap free="));
+  out.print((unsigned long)free);
+  out.print(F(" min="));
+  out.print((unsigned long)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+  out.print(F(" largest="));
+  out.print((unsigned long)largest);
+  out.print(F(" fragmentation="));
+  out.print(free ? 100 - (unsigned)(largest * 100 / free) : 0);
+  out.println('%');
+
+  // ESP-IDF reports the high-water mark in bytes
+  for (uint8_t i = 0; i < g_taskCount; ++i) {
+    out.print(F("[Mem] stack "));
+    out.print(g_tasks[i].name);
+    out.print(F(": "));
+    out.print((unsigned long)uxTaskGetStackHighWaterMark((TaskHandle_t)g_tasks[i].handle));
+    out.println(F(" bytes never used"));
+  }
+#endif
+}
+
+static const CommandTable::Entry kMemCommands[] = {
+  { CMD_VERB("MEM"), cmdMem },
+};
+
+void begin() {
+  CommandTable::add(kMemCommands);
+#if !defined(REX_NATIVE)
+  watchTask("loop", xTaskGetCurrentTaskHandle());
+#endif
+  g_bootAllocs = allocs();
+  g_bootBytes  = allocBytes();
+  g_booted = true;
+  LOG_I("[Mem] %lu allocations (%lu bytes) during boot",
+        (unsigned long)g_bootAllocs, (unsigned long)g_bootBytes);
+}
+
+void poll() {
+  if (g_warned || !g_booted || allocs() == g_bootAllocs) return;
+  g_warned = true;
+  LOG_W("[Mem] WARNING: heap allocation after boot (see MEM)");
+}
+
+} // namespace Mem
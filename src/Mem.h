@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+
+// ========== Mem Configuration ==========
+// Tasks whose stack headroom MEM reports
+#ifndef MEM_MAX_TASKS
+#define MEM_MAX_TASKS 4
+#endif
+
+// ========== Memory Monitor ==========
+// After setup() the firmware runs from static buffers only (LineReader,
+// CommandQueue, the log ring, ...), so a heap allocation in steady state
+// is a regression: repeated allocate/free cycles fragment the heap until
+// a long session fails an allocation it could once make.
+//
+// Allocations are counted at the allocator. Device builds link with
+// -Wl,--wrap=malloc/calloc/realloc (REX_MEM_WRAP_MALLOC), which also sees
+// String and library allocations; otherwise only operator new is counted
+// (host builds). env:replay fails a session that allocates after boot.
+//
+//   MEM    allocations since boot, heap free / largest block, stack headroom
+//
+// Filesystem and NVS commands (CHOREO_*, uploads, CAL_COMMIT) allocate
+// inside the drivers while they run; the counters show them like any other.
+namespace Mem {
+
+// Allocation calls (and bytes requested) since power-on
+uint32_t allocs();
+uint32_t allocBytes();
+
+// Allocation calls since begin()
+uint32_t allocsSinceBoot();
+
+// Report the stack headroom of a FreeRTOS task (TaskHandle_t); the
+// calling task of begin() is added as "loop". Ignored on the host.
+void watchTask(const char* name, void* handle);
+
+// End of setup(): later allocations count as steady state. Registers MEM.
+void begin();
+
+// Main loop: warn once when the first steady-state allocation is seen
+void poll();
+
+} // namespace Mem
@@ -0,0 +1,72 @@
+#include "Perf.h"
+#include "CommandTable.h"
+#include "Transport.h"
+
+namespace Perf {
+
+// ---------------- Internal state ----------------
+static Histogram g_hist[SECTION_COUNT];
+static uint32_t  g_sinceMs = 0;   // millis() at the last reset
+
+static const char* const kSectionNames[SECTION_COUNT] = {
+  "frame", "serial_read", "dispatch", "leg_tick", "servo_commit", "animation",
+};
+
+void record(Section section, uint32_t cycles) {
+  if (section < SECTION_COUNT) g_hist[section].record(Cycles::toNs(cycles));
+}
+
+// ---------------- Results ----------------
+const Histogram& histogram(Section section) { return g_hist[section < SECTION_COUNT ? section : FRAME]; }
+const char*      sectionName(Section section) { return kSectionNames[section < SECTION_COUNT ? section : FRAME]; }
+
+void reset() {
+  for (uint8_t s = 0; s < SECTION_COUNT; ++s) g_hist[s].reset();
+  g_sinceMs = millis();
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+static void printUs(uint32_t ns) {
+  Print& out = console();
+  out.print(' ');
+  out.print(ns / 1000.0f, 1);
+}
+
+// PERF: per-section count, min, mean, p99, max (µs) and share of the
+// time since the last reset
+static void cmdPerf(const Args&) {
+  Print& out = console();
+  const uint32_t elapsedMs = millis() - g_sinceMs;
+  out.print(F("[Perf] window="));
+  out.print(elapsedMs);
+  out.println(F(" ms"));
+  out.println(F("  section: n min mean p99 max (us) load%"));
+
+  for (uint8_t s = 0; s < SECTION_COUNT; ++s) {
+    const Histogram& h = g_hist[s];
+    out.print(F("  "));
+    out.print(kSectionNames[s]);
+    out.print(F(": "));
+    out.print(h.count());
+    printUs(h.min());
+    printUs(h.mean());
+    printUs(h.percentile(99));
+    printUs(h.max());
+    out.print(' ');
+    out.println(elapsedMs ? (float)h.sum() / 10000.0f / (float)elapsedMs : 0.0f, 2);
+  }
+}
+
+static const CommandTable::Entry kPerfCommands[] = {
+  { CMD_VERB("PERF"),       cmdPerf },
+  { CMD_VERB("PERF_RESET"), [](const Args&) { reset(); } },
+};
+
+void begin() {
+  reset();
+  CommandTable::add(kPerfCommands);
+}
+
+} // namespace Perf
@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include "Cycles.h"
+#include "Histogram.h"
+
+// ========== Profiler Configuration ==========
+// Compile the section profiler in (1) or out (0). Disabled scopes expand
+// to nothing.
+#ifndef REX_PERF
+#define REX_PERF 1
+#endif
+
+#define PERF_CAT_(a, b) a##b
+#define PERF_CAT(a, b)  PERF_CAT_(a, b)
+
+#if REX_PERF
+#define PERF_SCOPE(section) Perf::Scope PERF_CAT(_perfScope, __LINE__)(Perf::section)
+#else
+#define PERF_SCOPE(section) ((void)0)
+#endif
+
+namespace Perf {
+
+// ========== Sections ==========
+// Where the loop spends its time. Times are inclusive: a servo commit
+// made from Leg::tick counts in both LEG_TICK and SERVO_COMMIT, and
+// everything in a control frame also counts in FRAME.
+//   FRAME         one fixed-rate control frame (budget CONTROL_PERIOD_MS)
+//   SERIAL_READ   pulling transport bytes into LineReader
+//   DISPATCH      routing one line / frame / queued or coalesced command
+//   LEG_TICK      gait update
+//   SERVO_COMMIT  one ServoBus pulse write (GPIO or PCA9685 over I2C)
+//   ANIMATION     blocking scripted moves (ROAR, SNAP, TAIL_WAG, sweep)
+enum Section : uint8_t {
+  FRAME = 0, SERIAL_READ, DISPATCH, LEG_TICK, SERVO_COMMIT, ANIMATION, SECTION_COUNT
+};
+
+// Add one sample of `cycles` to a section
+void record(Section section, uint32_t cycles);
+
+// Times the enclosing block (use PERF_SCOPE)
+class Scope {
+public:
+  explicit Scope(Section section) : _section(section), _start(Cycles::now()) {}
+  ~Scope() { record(_section, Cycles::now() - _start); }
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  Section  _section;
+  uint32_t _start;
+};
+
+// ========== Results ==========
+// Samples are in nanoseconds
+const Histogram& histogram(Section section);
+const char*      sectionName(Section section);
+void             reset();
+
+// Register PERF / PERF_RESET with CommandTable
+void begin();
+
+} // namespace Perf
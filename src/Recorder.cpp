@@ -0,0 +1,309 @@
+#include "Recorder.h"
+#include "CommandTable.h"
+#include "Log.h"
+#include "Transport.h"
+
+#if defined(REX_NATIVE)
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+namespace Recorder {
+
+// ---------------- Internal state ----------------
+static const ServoBus* SB = nullptr;
+static Print*   g_sink = nullptr;
+static Print*   g_armed = nullptr;
+static uint32_t g_lastUs = 0;                 // micros() of the previous record
+static uint32_t g_polledUs = 0;               // micros() of the last transport poll
+static uint16_t g_pulses[SERVO_COUNT];        // state after the last SERVOS record
+static Stats    g_stats = { 0, 0, 0, false };
+
+static const uint8_t kMagic[4] = { 'R', 'X', 'T', '1' };
+
+// Longest record: tag + time + wait + length + a line or frame of up to 255 bytes
+static const size_t kRecordMax = 1 + 5 + 5 + 5 + 256;
+
+// ---------------- RAM sink (REC_START) ----------------
+// All-or-nothing writes, so a full buffer never holds half a record
+class BufferSink : public Print {
+public:
+  void   clear() { _len = 0; }
+  size_t size() const { return _len; }
+  const uint8_t* data() const { return _buf; }
+
+  size_t write(const uint8_t* data, size_t len) override {
+    if (len > sizeof(_buf) - _len) return 0;
+    memcpy(_buf + _len, data, len);
+    _len += len;
+    return len;
+  }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  using Print::write;
+
+private:
+  uint8_t _buf[REC_BUFFER_SIZE];
+  size_t  _len = 0;
+};
+
+static BufferSink g_ram;
+
+#if defined(REX_NATIVE)
+// ---------------- File sink (REX_RECORD) ----------------
+class FileSink : public Print {
+public:
+  bool open(const char* path) { return (_f = fopen(path, "wb")) != nullptr; }
+  void flush() override { if (_f) fflush(_f); }
+
+  size_t write(const uint8_t* data, size_t len) override { return _f ? fwrite(data, 1, len, _f) : 0; }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  using Print::write;
+
+private:
+  FILE* _f = nullptr;
+};
+
+static FileSink g_file;
+#endif
+
+// ---------------- Encoding ----------------
+static inline uint8_t* putVarint(uint8_t* p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+// Record header: tag and time since the previous record
+static uint8_t* beginRecord(uint8_t* p, Tag tag) {
+  const uint32_t now = micros();
+  *p++ = tag;
+  p = putVarint(p, now - g_lastUs);
+  g_lastUs = now;
+  return p;
+}
+
+static void emit(const uint8_t* rec, size_t len) {
+  if (g_sink->write(rec, len) != len) {
+    g_stats.overflow = true;
+    g_sink = nullptr;
+    LOG_W("[Rec] Trace full after %u bytes - recording stopped", (unsigned)g_stats.bytes);
+    return;
+  }
+  g_stats.bytes += len;
+  ++g_stats.records;
+}
+
+static void payloadRecord(Tag tag, const uint8_t* data, size_t len) {
+  if (!g_sink) return;
+  if (len > 255) len = 255;
+  uint8_t rec[kRecordMax];
+  uint8_t* p = beginRecord(rec, tag);
+  const uint32_t wait = g_lastUs - g_polledUs;
+  p = putVarint(p, (int32_t)wait > 0 ? wait : 0);
+  p = putVarint(p, (uint32_t)len);
+  memcpy(p, data, len);
+  emit(rec, (size_t)(p - rec) + len);
+}
+
+// ---------------- Recording ----------------
+bool start(Print& sink) {
+  g_sink = nullptr;
+  g_stats = { 0, 0, 0, false };
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) g_pulses[ch] = 0;
+  if (sink.write(kMagic, sizeof(kMagic)) != sizeof(kMagic)) return false;
+
+  g_sink = &sink;
+  g_lastUs = micros();
+  g_polledUs = g_lastUs;
+  g_stats.startUs = g_lastUs;
+  g_stats.bytes = sizeof(kMagic);
+  return true;
+}
+
+void stop() {
+  if (g_sink) g_sink->flush();
+  g_sink = nullptr;
+}
+
+bool recording() { return g_sink != nullptr; }
+
+void inputPolled() {
+  if (g_sink) g_polledUs = micros();
+}
+
+void inputLine(const char* line, size_t len) {
+  payloadRecord(LINE, (const uint8_t*)line, len);
+#if defined(REX_NATIVE)
+  if (g_sink) g_sink->flush();   // keep the file usable if the host is killed
+#endif
+}
+
+void inputFrame(const uint8_t* cobs, size_t len) {
+  payloadRecord(FRAME, cobs, len);
+}
+
+void servoFrame() {
+  if (!g_sink || !SB) return;
+
+  uint16_t mask = 0;
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    if (SB->lastMicroseconds(ch) != g_pulses[ch]) mask |= (uint16_t)(1u << ch);
+  }
+  if (!mask) return;
+
+  uint8_t rec[1 + 5 + 2 + SERVO_COUNT * 3];
+  uint8_t* p = beginRecord(rec, SERVOS);
+  *p++ = (uint8_t)mask;
+  *p++ = (uint8_t)(mask >> 8);
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+    if (!(mask & (1u << ch))) continue;
+    const uint16_t us = SB->lastMicroseconds(ch);
+    p = putVarint(p, zigzag((int32_t)us - (int32_t)g_pulses[ch]));
+    g_pulses[ch] = us;
+  }
+  emit(rec, (size_t)(p - rec));
+}
+
+const Stats& stats() { return g_stats; }
+
+void arm(Print& sink) { g_armed = &sink; }
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+// REC: recording state and size
+static void cmdRec(const Args&) {
+  Print& out = console();
+  out.print(F("[Rec] "));
+  out.print(recording() ? F("recording") : F("stopped"));
+  out.print(F(" bytes="));
+  out.print(g_stats.bytes);
+  out.print(F(" records="));
+  out.print(g_stats.records);
+  if (g_stats.overflow) out.print(F(" (buffer full)"));
+  out.println();
+}
+
+// REC_START: record into the RAM buffer (replaces its contents)
+static void cmdRecStart(const Args&) {
+  g_ram.clear();
+  start(g_ram);
+  LOG_I("[Rec] Recording (%u byte buffer)", (unsigned)REC_BUFFER_SIZE);
+}
+
+static void cmdRecStop(const Args&) {
+  stop();
+  LOG_I("[Rec] Stopped: %u bytes, %u records", (unsigned)g_stats.bytes, (unsigned)g_stats.records);
+}
+
+// REC_DUMP: the RAM trace as "REC <hex>" lines, then "REC_END <bytes>"
+// (tools/rextrace.py pull turns this back into a trace file)
+static void cmdRecDump(const Args&) {
+  static const char kHex[] = "0123456789abcdef";
+  Print& out = console();
+  const uint8_t* data = g_ram.data();
+  const size_t   size = g_ram.size();
+
+  char line[4 + 64 + 1];
+  memcpy(line, "REC ", 4);
+  for (size_t off = 0; off < size; off += 32) {
+    const size_t n = (size - off < 32) ? size - off : 32;
+    for (size_t i = 0; i < n; ++i) {
+      line[4 + 2 * i]     = kHex[data[off + i] >> 4];
+      line[4 + 2 * i + 1] = kHex[data[off + i] & 0x0F];
+    }
+    out.write((const uint8_t*)line, 4 + 2 * n);
+    out.println();
+  }
+  out.print(F("REC_END "));
+  out.println((unsigned)size);
+}
+
+static const CommandTable::Entry kRecorderCommands[] = {
+  { CMD_VERB("REC"),       cmdRec },
+  { CMD_VERB("REC_START"), cmdRecStart },
+  { CMD_VERB("REC_STOP"),  cmdRecStop },
+  { CMD_VERB("REC_DUMP"),  cmdRecDump },
+};
+
+void begin(const ServoBus* bus) {
+  SB = bus;
+  CommandTable::add(kRecorderCommands);
+
+#if defined(REX_NATIVE)
+  const char* path = getenv("REX_RECORD");
+  if (!g_armed && path && *path) {
+    if (g_file.open(path)) {
+      g_armed = &g_file;
+    } else {
+      perror(path);
+    }
+  }
+#endif
+  if (g_armed) start(*g_armed);
+}
+
+// ---------------- Reading ----------------
+Reader::Reader(const uint8_t* buf, size_t len) : _p(buf), _end(buf + len) {
+  _valid = len >= sizeof(kMagic) && memcmp(buf, kMagic, sizeof(kMagic)) == 0;
+  if (_valid) _p += sizeof(kMagic);
+}
+
+bool Reader::varint(uint32_t& out) {
+  out = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (_p >= _end) return false;
+    const uint8_t b = *_p++;
+    out |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+bool Reader::next(Record& r) {
+  if (!_valid || _error || _p >= _end) return false;
+
+  r.tag  = (Tag)*_p++;
+  r.rxUs = 0;
+  r.data = nullptr;
+  r.len  = 0;
+  r.mask = 0;
+
+  uint32_t dt = 0;
+  if (!varint(dt)) return !(_error = true);
+  _t += dt;
+  r.us = _t;
+
+  if (r.tag == LINE || r.tag == FRAME) {
+    uint32_t wait = 0, len = 0;
+    if (!varint(wait) || !varint(len) || len > (size_t)(_end - _p)) return !(_error = true);
+    r.rxUs = wait < _t ? _t - wait : 0;
+    r.data = _p;
+    r.len  = len;
+    _p += len;
+    return true;
+  }
+
+  if (r.tag == SERVOS) {
+    if (_end - _p < 2) return !(_error = true);
+    r.mask = (uint16_t)(_p[0] | (_p[1] << 8));
+    _p += 2;
+    for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+      if (!(r.mask & (1u << ch))) continue;
+      uint32_t z = 0;
+      if (!varint(z)) return !(_error = true);
+      const int32_t delta = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+      _us[ch] = (uint16_t)((int32_t)_us[ch] + delta);
+    }
+    return true;
+  }
+
+  return !(_error = true);   // unknown tag
+}
+
+} // namespace Recorder
@@ -0,0 +1,97 @@
+#pragma once
+#include <Arduino.h>
+#include "ServoBus.h"
+
+// ========== Recorder Configuration ==========
+// RAM trace buffer used by REC_START (bytes). Host builds can record to a
+// file instead: REX_RECORD=<path> starts a recording at boot.
+#ifndef REC_BUFFER_SIZE
+#define REC_BUFFER_SIZE 16384
+#endif
+
+// ========== Command / Servo Trace ==========
+// Records what the firmware was told and what it did with it: every input
+// line and binary frame as dispatched, and the servo pulses after each
+// dispatch and each control frame. replay/ feeds the inputs back through
+// the real command path on the host and diffs the pulses against the
+// recording, so a gait change can be checked against a golden session.
+//
+// Format: the magic "RXT1", then records of
+//   tag (1 byte) | time since the previous record, µs (LEB128)
+//   LINE     wait (LEB128) | length (LEB128) | line bytes (no terminator)
+//   FRAME    wait (LEB128) | length (LEB128) | COBS bytes between the 0x00 delimiters
+//   SERVOS   changed-channel mask (u16 LE) | per set bit, pulse change
+//            from the previous SERVOS record (zigzag LEB128, µs)
+// wait is how long the input sat in LineReader: the record time is when
+// it was dispatched, record time - wait when the transport poll read it.
+// A SERVOS record is only written when some pulse changed; walking costs
+// about 20 bytes per control frame, an idle robot nothing.
+namespace Recorder {
+
+enum Tag : uint8_t { LINE = 1, FRAME, SERVOS };
+
+// ---------------- Recording ----------------
+// Start a trace into sink (writes the header). A sink that accepts fewer
+// bytes than offered ends the recording (overflow).
+bool start(Print& sink);
+void stop();
+bool recording();
+
+// Capture points (no-ops unless recording). inputPolled() marks a
+// transport poll; inputs dispatched afterwards arrived with it.
+void inputPolled();
+void inputLine(const char* line, size_t len);
+void inputFrame(const uint8_t* cobs, size_t len);
+void servoFrame();   // writes a SERVOS record if any pulse changed
+
+struct Stats {
+  uint32_t startUs;    // micros() when the recording started (trace time 0)
+  uint32_t bytes;      // trace bytes written, header included
+  uint32_t records;
+  bool     overflow;   // the sink filled up and recording stopped
+};
+const Stats& stats();
+
+// Start recording into sink as soon as begin() runs (host tools use this
+// to capture from the same point in setup() as REX_RECORD does)
+void arm(Print& sink);
+
+// Register REC, REC_START, REC_STOP and REC_DUMP with CommandTable, and
+// start an armed (or REX_RECORD) recording. bus supplies the pulses.
+void begin(const ServoBus* bus);
+
+// ---------------- Reading ----------------
+// Walks a trace held in memory. Times are absolute (µs since the
+// header); SERVOS records update pulses(), the full 16-channel state.
+struct Record {
+  Tag            tag;
+  uint64_t       us;
+  uint64_t       rxUs;   // LINE / FRAME: when the poll read it
+  const uint8_t* data;   // LINE / FRAME payload
+  size_t         len;
+  uint16_t       mask;   // SERVOS: channels that changed
+};
+
+class Reader {
+public:
+  Reader(const uint8_t* buf, size_t len);
+
+  bool valid() const { return _valid; }
+  // Next record; false at the end or on a malformed record (see error())
+  bool next(Record& r);
+  bool error() const { return _error; }
+
+  const uint16_t* pulses() const { return _us; }
+
+private:
+  bool varint(uint32_t& out);
+
+  const uint8_t* _p;
+  const uint8_t* _end;
+  uint64_t       _t = 0;
+  uint16_t       _us[SERVO_COUNT] = { 0 };
+  bool           _valid = false;
+  bool           _error = false;
+};
+
+} // namespace Recorder
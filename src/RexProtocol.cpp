@@ -0,0 +1,245 @@
+#include "RexProtocol.h"
+#include <string.h>
+
+namespace RexProto {
+
+// ========== Little-endian Helpers ==========
+static inline void put16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put32(uint8_t* p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+static inline uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t get32(const uint8_t* p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+// ========== CRC-16/CCITT-FALSE ==========
+// poly 0x1021, init 0xFFFF, no reflection, no final xor
+uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (uint8_t b = 0; b < 8; ++b) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// ========== COBS ==========
+
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out, size_t cap) {
+  if (cap == 0) return 0;
+
+  size_t  codeIdx = 0;   // where the current block's code byte goes
+  size_t  o = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i < len; ++i) {
+    if (in[i] == 0) {
+      out[codeIdx] = code;
+      codeIdx = o++;
+      code = 1;
+    } else {
+      if (o >= cap) return 0;
+      out[o++] = in[i];
+      if (++code == 0xFF) {
+        out[codeIdx] = code;
+        codeIdx = o++;
+        code = 1;
+      }
+    }
+    if (o > cap) return 0;
+  }
+
+  out[codeIdx] = code;
+  return o;
+}
+
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t cap) {
+  size_t i = 0;
+  size_t o = 0;
+
+  while (i < len) {
+    const uint8_t code = in[i++];
+    if (code == 0) return 0;                  // delimiter inside a frame
+    if (i + code - 1 > len) return 0;         // block runs past the end
+
+    for (uint8_t k = 1; k < code; ++k) {
+      if (o >= cap) return 0;
+      out[o++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      if (o >= cap) return 0;
+      out[o++] = 0;
+    }
+  }
+
+  return o;
+}
+
+// ========== Framing ==========
+
+size_t encode(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len,
+              uint8_t* out, size_t cap) {
+  if (len > REX_PROTO_MAX_PAYLOAD || cap < 3) return 0;
+
+  uint8_t raw[REX_PROTO_MAX_RAW];
+  raw[0] = type;
+  raw[1] = seq;
+  if (len) memcpy(&raw[2], payload, len);
+  put16(&raw[2 + len], crc16(raw, 2 + len));
+
+  out[0] = 0x00;
+  const size_t n = cobsEncode(raw, 4 + len, &out[1], cap - 2);
+  if (n == 0) return 0;
+  out[1 + n] = 0x00;
+  return n + 2;
+}
+
+bool decode(const uint8_t* cobs, size_t len, uint8_t* scratch, Frame& out) {
+  const size_t n = cobsDecode(cobs, len, scratch, REX_PROTO_MAX_RAW);
+  if (n < 4) return false;
+
+  const uint16_t crc = get16(&scratch[n - 2]);
+  if (crc16(scratch, n - 2) != crc) return false;
+
+  out.type    = scratch[0];
+  out.seq     = scratch[1];
+  out.payload = &scratch[2];
+  out.len     = (uint8_t)(n - 4);
+  return true;
+}
+
+// ========== Payload Packing ==========
+
+size_t pack(const SetJoints& m, uint8_t* out) {
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) put16(&out[2 * i], m.us[i]);
+  return SET_JOINTS_SIZE;
+}
+
+size_t pack(const SetGait& m, uint8_t* out) {
+  put16(&out[0], m.speed_mhz);
+  out[2] = m.stride;
+  out[3] = m.lift;
+  out[4] = m.mode;
+  out[5] = m.flags;
+  return SET_GAIT_SIZE;
+}
+
+size_t pack(const Telemetry& m, uint8_t* out) {
+  put32(&out[0], m.ms);
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) put16(&out[4 + 2 * i], m.us[i]);
+  out[4 + 2 * REX_PROTO_JOINTS]     = m.legMode;
+  out[4 + 2 * REX_PROTO_JOINTS + 1] = m.streaming;
+  return TELEMETRY_SIZE;
+}
+
+size_t pack(const State& m, uint8_t* out) {
+  put32(&out[0], m.ms);
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) put16(&out[4 + 2 * i], m.us[i]);
+  uint8_t* p = &out[4 + 2 * REX_PROTO_JOINTS];
+  put16(&p[0], m.phase);
+  put16(&p[2], m.periodUs);
+  put16(&p[4], m.busyUs);
+  put16(&p[6], m.overruns);
+  p[8]  = m.legMode;
+  p[9]  = m.flags;
+  p[10] = m.cmdQueue;
+  p[11] = m.logPending;
+  p[12] = m.rxPending;
+  return STATE_SIZE;
+}
+
+size_t pack(const FileBegin& m, uint8_t* out) {
+  const size_t n = strnlen(m.name, REX_PROTO_FILE_NAME);
+  put32(&out[0], m.size);
+  memcpy(&out[4], m.name, n);
+  return 4 + n;
+}
+
+size_t pack(const FileData& m, uint8_t* out) {
+  if (m.len > REX_PROTO_FILE_CHUNK) return 0;
+  put32(&out[0], m.offset);
+  memcpy(&out[4], m.data, m.len);
+  return 4 + m.len;
+}
+
+size_t pack(const FileEnd& m, uint8_t* out) {
+  put16(&out[0], m.crc);
+  return FILE_END_SIZE;
+}
+
+size_t pack(const FileAck& m, uint8_t* out) {
+  out[0] = m.status;
+  put32(&out[1], m.offset);
+  return FILE_ACK_SIZE;
+}
+
+bool unpack(const Frame& f, SetJoints& m) {
+  if (f.len != SET_JOINTS_SIZE) return false;
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) m.us[i] = get16(&f.payload[2 * i]);
+  return true;
+}
+
+bool unpack(const Frame& f, SetGait& m) {
+  if (f.len != SET_GAIT_SIZE) return false;
+  m.speed_mhz = get16(&f.payload[0]);
+  m.stride    = f.payload[2];
+  m.lift      = f.payload[3];
+  m.mode      = f.payload[4];
+  m.flags     = f.payload[5];
+  return true;
+}
+
+bool unpack(const Frame& f, Telemetry& m) {
+  if (f.len != TELEMETRY_SIZE) return false;
+  m.ms = get32(&f.payload[0]);
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) m.us[i] = get16(&f.payload[4 + 2 * i]);
+  m.legMode   = f.payload[4 + 2 * REX_PROTO_JOINTS];
+  m.streaming = f.payload[4 + 2 * REX_PROTO_JOINTS + 1];
+  return true;
+}
+
+bool unpack(const Frame& f, State& m) {
+  if (f.len != STATE_SIZE) return false;
+  m.ms = get32(&f.payload[0]);
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) m.us[i] = get16(&f.payload[4 + 2 * i]);
+  const uint8_t* p = &f.payload[4 + 2 * REX_PROTO_JOINTS];
+  m.phase      = get16(&p[0]);
+  m.periodUs   = get16(&p[2]);
+  m.busyUs     = get16(&p[4]);
+  m.overruns   = get16(&p[6]);
+  m.legMode    = p[8];
+  m.flags      = p[9];
+  m.cmdQueue   = p[10];
+  m.logPending = p[11];
+  m.rxPending  = p[12];
+  return true;
+}
+
+bool unpack(const Frame& f, FileBegin& m) {
+  if (f.len < 5 || f.len > 4 + REX_PROTO_FILE_NAME) return false;
+  m.size = get32(&f.payload[0]);
+  memcpy(m.name, &f.payload[4], f.len - 4);
+  m.name[f.len - 4] = '\0';
+  return true;
+}
+
+bool unpack(const Frame& f, FileData& m) {
+  if (f.len < 5) return false;
+  m.offset = get32(&f.payload[0]);
+  m.data   = &f.payload[4];
+  m.len    = (uint8_t)(f.len - 4);
+  return true;
+}
+
+bool unpack(const Frame& f, FileEnd& m) {
+  if (f.len != FILE_END_SIZE) return false;
+  m.crc = get16(&f.payload[0]);
+  return true;
+}
+
+bool unpack(const Frame& f, FileAck& m) {
+  if (f.len != FILE_ACK_SIZE) return false;
+  m.status = f.payload[0];
+  m.offset = get32(&f.payload[1]);
+  return true;
+}
+
+} // namespace RexProto
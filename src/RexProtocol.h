@@ -0,0 +1,170 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ========== Robo Rex Binary Protocol ==========
+// Compact framed messages for high-rate joint streaming, carried on the same
+// serial link as the text commands. Plain C++ with no Arduino dependency so
+// host tools can link the exact same codec.
+//
+// Frame (before COBS):   type:u8  seq:u8  payload[0..REX_PROTO_MAX_PAYLOAD]  crc:u16le
+//   crc = CRC-16/CCITT-FALSE over type, seq and payload
+// Wire:                  0x00  COBS(frame)  0x00
+//   The leading 0x00 lets the text reader switch into frame mode; text lines
+//   never contain 0x00. All multi-byte fields are little-endian.
+
+#define REX_PROTO_MAX_PAYLOAD 64
+#define REX_PROTO_JOINTS      16
+
+// Largest frame on the wire: header + payload + crc, COBS overhead, delimiters
+#define REX_PROTO_MAX_RAW     (2 + REX_PROTO_MAX_PAYLOAD + 2)
+#define REX_PROTO_MAX_WIRE    (REX_PROTO_MAX_RAW + REX_PROTO_MAX_RAW / 254 + 1 + 2)
+
+namespace RexProto {
+
+// ========== Message Types ==========
+// Host -> device: 0x01..0x7F, device -> host: 0x80 | type
+enum Type : uint8_t {
+  MSG_SET_JOINTS    = 0x01,   // SetJoints payload
+  MSG_SET_GAIT      = 0x02,   // SetGait payload
+  MSG_TELEMETRY_REQ = 0x03,   // no payload, answered with MSG_TELEMETRY
+  MSG_FILE_BEGIN    = 0x04,   // FileBegin payload, answered with MSG_FILE_ACK
+  MSG_FILE_DATA     = 0x05,   // FileData payload, answered with MSG_FILE_ACK
+  MSG_FILE_END      = 0x06,   // FileEnd payload, answered with MSG_FILE_ACK
+  MSG_TELEMETRY     = 0x83,   // Telemetry payload
+  MSG_STATE         = 0x84,   // State payload, streamed at the TELEM rate
+  MSG_FILE_ACK      = 0x85,   // FileAck payload
+};
+
+// ========== Payloads ==========
+// SET_JOINTS: commanded pulse per logical channel in µs, 0 = leave unchanged
+struct SetJoints {
+  uint16_t us[REX_PROTO_JOINTS];
+};
+static const size_t SET_JOINTS_SIZE = 2 * REX_PROTO_JOINTS;
+
+// SET_GAIT: mirrors Leg::setGait() plus the locomotion mode to enter
+struct SetGait {
+  uint16_t speed_mhz;   // gait speed in milli-Hz (1000 = 1 Hz)
+  uint8_t  stride;      // 0..255 -> 0.0..1.0
+  uint8_t  lift;        // 0..255 -> 0.0..1.0
+  uint8_t  mode;        // Leg::Mode (IDLE, WALK_FWD, WALK_BWD, TURN_L, TURN_R)
+  uint8_t  flags;       // bit 0: run gait
+};
+static const size_t SET_GAIT_SIZE = 6;
+static const uint8_t GAIT_FLAG_RUN = 0x01;
+
+// TELEMETRY: snapshot of commanded joint state
+struct Telemetry {
+  uint32_t ms;                       // device millis()
+  uint16_t us[REX_PROTO_JOINTS];     // last commanded pulse, 0 = detached
+  uint8_t  legMode;                  // Leg::Mode
+  uint8_t  streaming;                // 1 while SET_JOINTS owns the servos
+};
+static const size_t TELEMETRY_SIZE = 4 + 2 * REX_PROTO_JOINTS + 2;
+
+// STATE: periodic joint state plus control loop timing
+struct State {
+  uint32_t ms;                       // device millis()
+  uint16_t us[REX_PROTO_JOINTS];     // last commanded pulse, 0 = detached
+  uint16_t phase;                    // gait phase 0..65535 -> 0.0..1.0
+  uint16_t periodUs;                 // measured interval between control frames
+  uint16_t busyUs;                   // time spent in the last control frame
+  uint16_t overruns;                 // late control frames (wraps)
+  uint8_t  legMode;                  // Leg::Mode
+  uint8_t  flags;                    // bit 0: streaming
+  uint8_t  cmdQueue;                 // CommandQueue depth
+  uint8_t  logPending;               // records waiting in the log ring
+  uint8_t  rxPending;                // bytes waiting in the LineReader
+};
+static const size_t  STATE_SIZE = 4 + 2 * REX_PROTO_JOINTS + 8 + 5;
+static const uint8_t STATE_FLAG_STREAMING = 0x01;
+
+// ---------------- File upload ----------------
+// BEGIN, DATA..., END; every frame is acknowledged before the host sends
+// the next one, so a slow flash write never overruns the RX buffer.
+#define REX_PROTO_FILE_NAME  24                              // max name length
+#define REX_PROTO_FILE_CHUNK (REX_PROTO_MAX_PAYLOAD - 4)     // data bytes per FILE_DATA
+
+// FILE_BEGIN: start a file of `size` bytes; name is [A-Za-z0-9_-], no extension
+struct FileBegin {
+  uint32_t size;
+  char     name[REX_PROTO_FILE_NAME + 1];   // NUL-terminated after unpack
+};
+
+// FILE_DATA: the next chunk; offset must equal the bytes stored so far
+struct FileData {
+  uint32_t       offset;
+  const uint8_t* data;                      // points into the frame
+  uint8_t        len;
+};
+
+// FILE_END: CRC-16/CCITT-FALSE of the whole file; kept only if it matches
+struct FileEnd {
+  uint16_t crc;
+};
+static const size_t FILE_END_SIZE = 2;
+
+// FILE_ACK: result of the last FILE_* frame and the bytes stored so far
+struct FileAck {
+  uint8_t  status;                          // FileStatus
+  uint32_t offset;
+};
+static const size_t FILE_ACK_SIZE = 5;
+
+enum FileStatus : uint8_t {
+  FILE_OK = 0,
+  FILE_ERR_NAME,                            // bad or missing name
+  FILE_ERR_SIZE,                            // larger than the free space
+  FILE_ERR_OPEN,                            // filesystem not mounted / open failed
+  FILE_ERR_STATE,                           // DATA or END without BEGIN
+  FILE_ERR_OFFSET,                          // chunk does not continue the file
+  FILE_ERR_WRITE,                           // short write
+  FILE_ERR_CRC,                             // END with wrong size or CRC
+};
+
+// ========== Decoded Frame ==========
+// payload points into the caller's scratch buffer
+struct Frame {
+  uint8_t        type = 0;
+  uint8_t        seq  = 0;
+  const uint8_t* payload = nullptr;
+  uint8_t        len  = 0;
+};
+
+// ========== Codec ==========
+uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+
+// COBS encode/decode. Return the output length, 0 on error/overflow.
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out, size_t cap);
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t cap);
+
+// Build a complete wire frame (with both 0x00 delimiters) into out.
+// Returns bytes written, 0 if the payload or buffer is too large.
+size_t encode(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len,
+              uint8_t* out, size_t cap);
+
+// Decode the COBS bytes between delimiters. scratch must hold
+// REX_PROTO_MAX_RAW bytes. Returns false on COBS, length or CRC errors.
+bool decode(const uint8_t* cobs, size_t len, uint8_t* scratch, Frame& out);
+
+// ========== Payload Packing ==========
+// Return the packed size, or 0 if the frame payload has the wrong length
+size_t pack(const SetJoints& m, uint8_t* out);
+size_t pack(const SetGait& m, uint8_t* out);
+size_t pack(const Telemetry& m, uint8_t* out);
+size_t pack(const State& m, uint8_t* out);
+size_t pack(const FileBegin& m, uint8_t* out);
+size_t pack(const FileData& m, uint8_t* out);
+size_t pack(const FileEnd& m, uint8_t* out);
+size_t pack(const FileAck& m, uint8_t* out);
+bool   unpack(const Frame& f, SetJoints& m);
+bool   unpack(const Frame& f, SetGait& m);
+bool   unpack(const Frame& f, Telemetry& m);
+bool   unpack(const Frame& f, State& m);
+bool   unpack(const Frame& f, FileBegin& m);
+bool   unpack(const Frame& f, FileData& m);
+bool   unpack(const Frame& f, FileEnd& m);
+bool   unpack(const Frame& f, FileAck& m);
+
+} // namespace RexProto
@@ -2,6 +2,38 @@
 
 #include <Wire.h>
 
+#include "Log.h"
+
+#include "Trace.h"
+
+#include "Perf.h"
+
+#include "I2cBus.h"
+
+ 
+
+// Default load classes for the channel map in ServoBus.h
+
+static const uint8_t kDefaultLoad[SERVO_COUNT] = {
+
+  LOAD_BODY,  // ch 0  neck yaw
+
+  LOAD_AUX,   // ch 1  jaw
+
+  LOAD_BODY,  // ch 2  head pitch
+
+  LOAD_BODY,  // ch 3  pelvis roll
+
+  LOAD_BODY,  // ch 4  spine yaw
+
+  LOAD_AUX,   // ch 5  tail wag
+
+  LOAD_LEG, LOAD_LEG, LOAD_LEG, LOAD_LEG, LOAD_LEG,   // ch 6-10  right leg
+
+  LOAD_LEG, LOAD_LEG, LOAD_LEG, LOAD_LEG, LOAD_LEG,   // ch 11-15 left leg
+
+};
+
  
 
 // Map logical channels 0-5 to GPIO pins
@@ -66,13 +98,7 @@ bool ServoBus::begin(uint8_t i2c_addr, float freq_hz) {
 
   _pcaPresent = false;
 
-  Serial.println(F("[ServoBus] Initializing HYBRID servo system"));
-
-  Serial.println(F("  Channels 0-5:  ESP32 GPIO direct control"));
-
-  Serial.println(F("  Channels 6-15: PCA9685 I2C PWM driver"));
-
- 
+  _pcaAsleep = false;
 
   // Initialize per-channel defaults
 
@@ -80,10 +106,28 @@ bool ServoBus::begin(uint8_t i2c_addr, float freq_hz) {
 
     _attached[ch] = false;
 
+    _lastUs[ch]   = 0;
+
+    _targetUs[ch] = 0;
+
+    _load[ch]     = kDefaultLoad[ch];
+
+    _lastQ8[ch]   = -1;
+
     _limits[ch]   = ServoLimits();   // default 500–2500 µs, 0–180 deg
 
+    _attachLimits[ch] = _limits[ch];
+
+    _trimUs[ch]   = 0;
+
+    _buildTable(ch);
+
   }
 
+  _calMask = 0;
+
+  _setCountScale(freq_hz);
+
  
 
   // Store GPIO pins for channels 0-5
@@ -111,7 +155,7 @@ bool ServoBus::begin(uint8_t i2c_addr, float freq_hz) {
   ESP32PWM::allocateTimer(3);
 
 
-  Serial.println(F("[ServoBus] GPIO: Reserved all 4 LEDC timers for channels 0-5"));
+  LOG_D("[ServoBus] GPIO: Reserved all 4 LEDC timers for channels 0-5");
 
  
 
@@ -123,63 +167,54 @@ bool ServoBus::begin(uint8_t i2c_addr, float freq_hz) {
 
   Wire.setClock(100000);  // 100kHz for PCA9685 (standard I2C speed)
 
-  delay(50);
-
- 
-
-  Serial.print(F("[ServoBus] PCA9685: Initializing on Wire (SDA="));
+  Wire.setTimeOut(PCA9685_I2C_TIMEOUT_MS);
 
-  Serial.print(PCA9685_SDA_PIN);
+  // No settle delay: the PCA9685 oscillator is up 500 µs after power-on,
+  // and begin()/setPWMFreq() below wait for its restart themselves
 
-  Serial.print(F(", SCL="));
+  LOG_D("[ServoBus] PCA9685: Wire SDA=%d SCL=%d @ 0x%02X", PCA9685_SDA_PIN, PCA9685_SCL_PIN, _i2cAddr);
 
-  Serial.print(PCA9685_SCL_PIN);
+ 
 
-  Serial.print(F(") @ 0x"));
+  // Initialize PCA9685. The library creates its I2C device in begin()
 
-  Serial.println(_i2cAddr, HEX);
+  // even when nobody answers (it fails right after, without its delays),
 
- 
+  // so this is the only begin(): a late discovery in poll() is set up
 
-  // Initialize PCA9685
+  // with register writes alone
 
   _pca9685 = Adafruit_PWMServoDriver(_i2cAddr, Wire);
 
- 
-
-  // Check if PCA9685 responds
+  const bool answered = _pca9685.begin();
 
-  Serial.print(F("[ServoBus] PCA9685: Calling begin()... "));
+  _pcaStats = PcaLinkStats();
 
-  _pca9685.begin();
+  _pcaLostMs = millis();
 
  
 
-  // Verify I2C communication by reading MODE1 register
-
-  Wire.beginTransmission(_i2cAddr);
+  if (!answered) {
 
-  uint8_t i2c_error = Wire.endTransmission();
-
- 
+    // Once more for the Wire error code to report
 
-  if (i2c_error != 0) {
+    Wire.beginTransmission(_i2cAddr);
 
-    Serial.println(F("FAILED!"));
+    const uint8_t i2c_error = Wire.endTransmission();
 
-    Serial.print(F("[ServoBus] ERROR: PCA9685 not responding on I2C address 0x"));
+    LOG_E("[ServoBus] ERROR: PCA9685 not responding on I2C address 0x%02X (I2C error code: %u)", _i2cAddr, i2c_error);
 
-    Serial.print(_i2cAddr, HEX);
+    LOG_E("[ServoBus] Check: 1) Wiring  2) V+ power  3) I2C address jumpers");
 
-    Serial.print(F(" (I2C error code: "));
+    LOG_W("[ServoBus] PCA9685: retrying in the background (channels 6-15 attach and wait for it)");
 
-    Serial.print(i2c_error);
+    _pcaPresent = false;
 
-    Serial.println(F(")"));
+    _pcaLink = PCA_LINK_DOWN;
 
-    Serial.println(F("[ServoBus] Check: 1) Wiring  2) V+ power  3) I2C address jumpers"));
+    _pcaBackoffMs = PCA9685_RETRY_MIN_MS;
 
-    _pcaPresent = false;
+    _pcaDueMs = millis() + _pcaBackoffMs;
 
     return false;
 
@@ -187,31 +222,17 @@ bool ServoBus::begin(uint8_t i2c_addr, float freq_hz) {
 
  
 
-  Serial.println(F("SUCCESS!"));
-
   _pcaPresent = true;
 
   _pca9685.setPWMFreq(freq_hz);
 
-  delay(50);
-
- 
-
-  Serial.print(F("[ServoBus] PCA9685: Initialized at "));
-
-  Serial.print(freq_hz);
-
-  Serial.println(F(" Hz"));
-
-
-
-  Serial.print(F("[ServoBus] PCA9685 detected: "));
-
-  Serial.println(_pcaPresent ? F("YES") : F("NO"));
+  _pcaLink = PCA_LINK_UP;
 
+  _pcaDueMs = millis() + PCA9685_CHECK_MS;
 
+ 
 
-  Serial.println(F("[ServoBus] Hybrid servo system ready"));
+  LOG_I("[ServoBus] PCA9685 at 0x%02X, %.1f Hz; GPIO channels 0-5, PCA9685 channels 6-15", _i2cAddr, freq_hz);
 
   return true;
 
@@ -223,19 +244,19 @@ void ServoBus::setFrequency(float freq_hz) {
 
   _freq = freq_hz;
 
- 
+  _setCountScale(freq_hz);
 
-  // Only update PCA9685 frequency (GPIO servos are fixed at 50Hz)
+ 
 
-  _pca9685.setPWMFreq(freq_hz);
+  // Only update PCA9685 frequency (GPIO servos are fixed at 50Hz); a
 
- 
+  // missing PCA9685 gets it when it answers again
 
-  Serial.print(F("[ServoBus] PCA9685 frequency set to "));
+  if (_pcaPresent) _pca9685.setPWMFreq(freq_hz);
 
-  Serial.print(freq_hz);
+ 
 
-  Serial.println(F(" Hz"));
+  LOG_I("[ServoBus] PCA9685 frequency set to %.1f Hz", freq_hz);
 
 }
 
@@ -245,9 +266,7 @@ void ServoBus::attach(uint8_t channel, const ServoLimits& limits) {
 
   if (channel >= SERVO_COUNT) {
 
-    Serial.print(F("[ServoBus] ERROR: attach channel out of range: "));
-
-    Serial.println(channel);
+    LOG_E("[ServoBus] ERROR: attach channel out of range: %u", channel);
 
     return;
 
@@ -255,9 +274,17 @@ void ServoBus::attach(uint8_t channel, const ServoLimits& limits) {
 
  
 
-  // Store limits
+  // Store limits (calibrated channels keep theirs)
 
-  _limits[channel] = limits;
+  _attachLimits[channel] = limits;
+
+  if (!isCalibrated(channel)) {
+
+    _limits[channel] = limits;
+
+    _buildTable(channel);
+
+  }
 
  
 
@@ -287,23 +314,11 @@ void ServoBus::attach(uint8_t channel, const ServoLimits& limits) {
 
       _attached[channel] = true;
 
-      Serial.print(F("[ServoBus] GPIO: Attached ch="));
-
-      Serial.print(channel);
-
-      Serial.print(F(" -> GPIO "));
-
-      Serial.println(pin);
+      LOG_D("[ServoBus] GPIO: Attached ch=%u -> GPIO %u", channel, pin);
 
     } else {
 
-      Serial.print(F("[ServoBus] ERROR: GPIO attach failed ch="));
-
-      Serial.print(channel);
-
-      Serial.print(F(" to GPIO "));
-
-      Serial.println(pin);
+      LOG_E("[ServoBus] ERROR: GPIO attach failed ch=%u to GPIO %u", channel, pin);
 
       _attached[channel] = false;
 
@@ -313,29 +328,21 @@ void ServoBus::attach(uint8_t channel, const ServoLimits& limits) {
 
     // ========== PCA9685 Servo (Channels 6-15) ==========
 
-    if (!_pcaPresent) {
+    // Attached even while the PCA9685 is missing: writes are kept and
 
-      Serial.print(F("[ServoBus] ERROR: PCA9685 not detected, cannot attach ch="));
+    // poll() sends them when it answers. Reported once by the caller; one
 
-      Serial.println(channel);
+    // line per channel would flood the log.
 
-      _attached[channel] = false;
+    if (!_pcaPresent) {
 
-      return;
+      LOG_D("[ServoBus] PCA9685 not detected yet, ch=%u waits for it", channel);
 
     }
 
-    uint8_t pcaPort = _channelToPcaPort(channel);
-
     _attached[channel] = true;
 
-    Serial.print(F("[ServoBus] PCA9685: Attached ch="));
-
-    Serial.print(channel);
-
-    Serial.print(F(" -> PCA port "));
-
-    Serial.println(pcaPort);
+    LOG_D("[ServoBus] PCA9685: Attached ch=%u -> PCA port %u", channel, _channelToPcaPort(channel));
 
   }
 
@@ -359,9 +366,13 @@ void ServoBus::detach(uint8_t channel) {
 
       _attached[channel] = false;
 
-      Serial.print(F("[ServoBus] GPIO: Detached ch="));
+      _lastUs[channel] = 0;
 
-      Serial.println(channel);
+      _targetUs[channel] = 0;
+
+      _lastQ8[channel] = -1;
+
+      LOG_I("[ServoBus] GPIO: Detached ch=%u", channel);
 
     }
 
@@ -373,13 +384,17 @@ void ServoBus::detach(uint8_t channel) {
 
       uint8_t pcaPort = _channelToPcaPort(channel);
 
-      _pca9685.setPWM(pcaPort, 0, 0);  // Turn off PWM
+      if (_pcaPresent) _pca9685.setPWM(pcaPort, 0, 0);  // Turn off PWM
 
       _attached[channel] = false;
 
-      Serial.print(F("[ServoBus] PCA9685: Detached ch="));
+      _lastUs[channel] = 0;
+
+      _targetUs[channel] = 0;
+
+      _lastQ8[channel] = -1;
 
-      Serial.println(channel);
+      LOG_I("[ServoBus] PCA9685: Detached ch=%u", channel);
 
     }
 
@@ -395,31 +410,139 @@ void ServoBus::setLimits(uint8_t channel, const ServoLimits& limits) {
 
   _limits[channel] = limits;
 
+  _buildTable(channel);
+
 }
 
  
 
-uint16_t ServoBus::_degToUs(uint8_t ch, float deg) const {
+void ServoBus::setCalibration(uint8_t channel, const ServoLimits& limits, int16_t trimUs) {
 
-  if (ch >= SERVO_COUNT) return 1500;
+  if (channel >= SERVO_COUNT) return;
+
+  _calMask |= (uint16_t)(1u << channel);
+
+  _limits[channel] = limits;
+
+  _trimUs[channel] = trimUs;
+
+  _buildTable(channel);
+
+  _refresh(channel);
+
+}
+
+ 
+
+void ServoBus::clearCalibration(uint8_t channel) {
+
+  if (channel >= SERVO_COUNT) return;
+
+  _calMask &= (uint16_t)~(1u << channel);
+
+  _limits[channel] = _attachLimits[channel];
+
+  _trimUs[channel] = 0;
+
+  _buildTable(channel);
+
+  _refresh(channel);
+
+}
 
  
 
+// ---------------- Degree tables ----------------
+
+// The only float mapping: [minDeg, maxDeg] -> [minPulse, maxPulse] plus
+
+// trim, clamped, at every whole degree. Entries below minDeg / above
+
+// maxDeg repeat the end values, which clamps degree writes as before.
+
+void ServoBus::_buildTable(uint8_t ch) {
+
   const ServoLimits& lim = _limits[ch];
 
-  // Clamp degrees into allowed range
+  const float span = lim.maxDeg - lim.minDeg;
+
+  for (uint16_t deg = 0; deg <= SERVO_TABLE_DEGREES; ++deg) {
+
+    const float d = _clampF((float)deg, lim.minDeg, lim.maxDeg);
+
+    const float t = (span > 0.0f) ? (d - lim.minDeg) / span : 0.5f;
+
+    float us = lim.minPulse + t * (lim.maxPulse - lim.minPulse) + _trimUs[ch];
+
+    us = _clampF(us, lim.minPulse, lim.maxPulse);
+
+    _degTable[ch][deg] = (uint16_t)_clampF(us * 16.0f + 0.5f, 0.0f, 65535.0f);
+
+  }
+
+}
+
+ 
+
+// Degrees in 1/256 steps, clamped to the table
+
+int32_t ServoBus::_degToQ8(float deg) {
+
+  if (!(deg > 0.0f)) return 0;   // also catches NaN
+
+  if (deg >= (float)SERVO_TABLE_DEGREES) return SERVO_TABLE_DEGREES * 256;
 
-  float d = _clampF(deg, lim.minDeg, lim.maxDeg);
+  return (int32_t)(deg * 256.0f);
 
+}
+
+ 
+
+// Integer-only: two table entries and the fraction between them
+
+uint16_t ServoBus::_q8ToUs(uint8_t ch, int32_t q8) const {
+
+  if (ch >= SERVO_COUNT) return 1500;
+
+  const uint16_t* t = _degTable[ch];
+
+  const int32_t i = q8 >> 8;
+
+  if (i >= SERVO_TABLE_DEGREES) return (uint16_t)(t[SERVO_TABLE_DEGREES] >> 4);
+
+  const int32_t f = q8 & 0xFF;
+
+  const int32_t v = (int32_t)t[i] * 256 + ((int32_t)t[i + 1] - (int32_t)t[i]) * f;   // µs * 4096
+
+  return (uint16_t)(v >> 12);
+
+}
+
+ 
+
+// PCA9685 counts = µs * 4096 * freq / 1e6, as a Q32 factor rounded up so
+
+// pulses that land exactly on a count are not truncated below it
+
+void ServoBus::_setCountScale(float freq_hz) {
+
+  const double scale = 4096.0 * (double)freq_hz / 1000000.0;
+
+  _countScale = (uint32_t)ceil(scale * 4294967296.0);
+
+}
 
+ 
+
+// Re-send the last degree write through the (changed) table
 
-  // Map [minDeg, maxDeg] to [minPulse, maxPulse]
+void ServoBus::_refresh(uint8_t channel) {
 
-  float t = (d - lim.minDeg) / (lim.maxDeg - lim.minDeg);
+  if (_attached[channel] && _lastQ8[channel] >= 0) {
 
-  int32_t us = (int32_t)(lim.minPulse + t * (lim.maxPulse - lim.minPulse));
+    _writeUs(channel, _q8ToUs(channel, _lastQ8[channel]));
 
-  return _clampU16(us, lim.minPulse, lim.maxPulse);
+  }
 
 }
 
@@ -431,12 +554,54 @@ void ServoBus::writeMicroseconds(uint8_t channel, uint16_t us) {
 
   if (!_attached[channel]) return;
 
+  _lastQ8[channel] = -1;
+
+  _writeUs(channel, us);
+
+}
+
  
 
+void ServoBus::_writeUs(uint8_t channel, uint16_t us) {
+
   const ServoLimits& lim = _limits[channel];
 
   uint16_t clamped = _clampU16(us, lim.minPulse, lim.maxPulse);
 
+  _targetUs[channel] = clamped;
+
+ 
+
+  if (!_lastUs[channel]) {
+
+    // First pulse since attach: the horn position is unknown, start the model there
+
+    _estQ8[channel]  = (int32_t)clamped << 8;
+
+    _freeQ8[channel] = (int32_t)clamped << 8;
+
+  } else if (_budgetMa && _load[channel] != LOAD_LEG) {
+
+    clamped = _admit(channel);
+
+  }
+
+  _output(channel, clamped);
+
+}
+
+ 
+
+void ServoBus::_output(uint8_t channel, uint16_t clamped) {
+
+  PERF_SCOPE(SERVO_COMMIT);
+
+ 
+
+  const bool changed = (clamped != _lastUs[channel]);
+
+  _lastUs[channel] = clamped;
+
  
 
   if (_isGpioChannel(channel)) {
@@ -457,85 +622,689 @@ void ServoBus::writeMicroseconds(uint8_t channel, uint16_t us) {
 
     // Formula: pwm = (microseconds * 4096 * frequency) / 1,000,000
 
-    uint32_t pwm = (uint32_t)((clamped * 4096.0 * _freq) / 1000000.0);
+    uint32_t pwm = (uint32_t)(((uint64_t)clamped * _countScale) >> 32);
 
     pwm = (pwm > 4095) ? 4095 : pwm;  // Clamp to 12-bit max
 
-    _pca9685.setPWM(pcaPort, 0, pwm);
+    // While the PCA9685 is missing the pulse is only kept; a failed write
+
+    // hands the link to poll() so the rest of the frame skips the bus
+
+    if (_pcaPresent) {
+
+      bool ok;
+
+      {
+
+        I2cBus::Transfer xfer(I2cBus::PCA);
+
+        ok = (_pca9685.setPWM(pcaPort, 0, pwm) == 0);
+
+        if (!ok) xfer.fail();
+
+      }
+
+      if (!ok) _pcaLinkLost();
+
+    }
 
   }
 
+ 
+
+  if (changed) TRACE_MARK(COMMIT);
+
 }
 
  
 
-void ServoBus::writeDegrees(uint8_t channel, float deg) {
+// ---------------- PCA9685 sleep ----------------
 
-  if (channel >= SERVO_COUNT) return;
+void ServoBus::setPcaSleep(bool on) {
 
-  if (!_attached[channel]) return;
+  if (!_pcaPresent || on == _pcaAsleep) return;
+
+  _pcaAsleep = on;
+
+  if (on) {
+
+    _pca9685.sleep();
+
+    return;
+
+  }
 
  
 
-  uint16_t us = _degToUs(channel, deg);
+  // The oscillator needs 500 µs after SLEEP clears; rewriting every
+
+  // channel then restarts the outputs with the last committed frame
+
+  _pca9685.wakeup();
 
-  writeMicroseconds(channel, us);
+  delayMicroseconds(500);
+
+  _recommitPca();
 
 }
 
  
 
-void ServoBus::writeNeutral(uint8_t channel) {
+void ServoBus::_recommitPca() {
 
-  if (channel >= SERVO_COUNT) return;
+  for (uint8_t ch = PCA9685_FIRST_CHANNEL; ch < SERVO_COUNT; ++ch) {
 
-  if (!_attached[channel]) return;
+    if (_attached[ch] && _lastUs[ch]) _output(ch, _lastUs[ch]);
+
+  }
+
+}
 
  
 
-  const ServoLimits& lim = _limits[channel];
+// ---------------- PCA9685 link monitor ----------------
 
-  float mid = 0.5f * (lim.minDeg + lim.maxDeg);
+// Registers the monitor touches directly: the driver's begin() and
 
-  writeDegrees(channel, mid);
+// setPWMFreq() wait 15 ms between writes, which poll() must not
+
+static const uint8_t kPcaMode1    = 0x00;
+
+static const uint8_t kPcaPrescale = 0xFE;
+
+static const uint8_t kMode1Sleep  = 0x10;
+
+static const uint8_t kMode1AutoInc = 0x20;   // set by our setup, clear after power-on
+
+ 
+
+bool ServoBus::_writePca(uint8_t reg, uint8_t value) {
+
+  return I2cBus::writeReg(I2cBus::PCA, _i2cAddr, reg, value);
 
 }
 
  
 
-void ServoBus::setAllOff() {
+// MODE1, or -1 when the PCA9685 does not answer
+
+int ServoBus::_readPcaMode1() {
+
+  uint8_t mode1;
+
+  return I2cBus::readRegs(I2cBus::PCA, _i2cAddr, kPcaMode1, &mode1, 1) ? mode1 : -1;
 
-  Serial.println(F("[ServoBus] setAllOff() - detaching all channels"));
+}
 
  
 
-  // Detach GPIO servos (channels 0-5)
+void ServoBus::poll() {
 
-  for (uint8_t ch = 0; ch < PCA9685_FIRST_CHANNEL; ++ch) {
+  const uint32_t now = millis();
 
-    if (_attached[ch]) {
+  switch (_pcaLink) {
 
-      _gpioServos[ch].detach();
+    case PCA_LINK_STARTING:
 
-      _attached[ch] = false;
+      // The oscillator needs 500 µs after SLEEP clears
 
-    }
+      if ((uint32_t)(micros() - _pcaStartUs) >= 500) _pcaLinkUp();
 
-  }
+      return;
 
  
 
-  // Turn off PCA9685 servos (channels 6-15)
+    case PCA_LINK_UP: {
 
-  for (uint8_t ch = PCA9685_FIRST_CHANNEL; ch < SERVO_COUNT; ++ch) {
+      if ((int32_t)(now - _pcaDueMs) < 0) return;
 
-    if (_attached[ch]) {
+      _pcaDueMs = now + PCA9685_CHECK_MS;
 
-      uint8_t pcaPort = _channelToPcaPort(ch);
+      const int mode1 = _readPcaMode1();
 
-      _pca9685.setPWM(pcaPort, 0, 0);
+      if (mode1 < 0) {
 
-      _attached[ch] = false;
+        _pcaLinkLost();
+
+      } else if (!(mode1 & kMode1AutoInc)) {
+
+        // Answering with power-on registers: its supply dipped between two
+
+        // checks and the outputs are off
+
+        ++_pcaStats.resets;
+
+        _pcaLostMs = now;
+
+        LOG_W("[ServoBus] PCA9685 was reset (MODE1=0x%02X), setting it up again", (unsigned)mode1);
+
+        _pcaLinkStart();
+
+      }
+
+      return;
+
+    }
+
+ 
+
+    case PCA_LINK_DOWN:
+
+    default:
+
+      if ((int32_t)(now - _pcaDueMs) < 0) return;
+
+      ++_pcaStats.probes;
+
+      if (I2cBus::probe(I2cBus::PCA, _i2cAddr)) {
+
+        _pcaLinkStart();
+
+        if (_pcaLink == PCA_LINK_STARTING) return;
+
+      }
+
+      _pcaBackoffMs = (_pcaBackoffMs * 2 > PCA9685_RETRY_MAX_MS) ? PCA9685_RETRY_MAX_MS : _pcaBackoffMs * 2;
+
+      _pcaDueMs = now + _pcaBackoffMs;
+
+      return;
+
+  }
+
+}
+
+ 
+
+// A write or check failed: stop using the bus for channels 6-15 (their
+
+// pulses are still kept) and probe from now on
+
+void ServoBus::_pcaLinkLost() {
+
+  if (_pcaLink == PCA_LINK_DOWN) return;
+
+  _pcaPresent = false;
+
+  _pcaLink = PCA_LINK_DOWN;
+
+  _pcaLostMs = millis();
+
+  _pcaBackoffMs = PCA9685_RETRY_MIN_MS;
+
+  _pcaDueMs = _pcaLostMs + _pcaBackoffMs;
+
+  ++_pcaStats.losses;
+
+  LOG_W("[ServoBus] PCA9685 stopped answering: channels 6-15 limp, retrying");
+
+}
+
+ 
+
+// Answered: program the prescaler with the oscillator stopped, then start
+
+// it (or leave it asleep, see setPcaSleep()). Writes to channels 6-15 are
+
+// kept, not sent, until poll() finishes the start.
+
+void ServoBus::_pcaLinkStart() {
+
+  _pcaPresent = false;
+
+  _pcaFoundUs = micros();
+
+ 
+
+  const float prescale = (float)_pca9685.getOscillatorFrequency() / (_freq * 4096.0f) + 0.5f - 1.0f;
+
+  if (!_writePca(kPcaMode1, kMode1AutoInc | kMode1Sleep) ||
+
+      !_writePca(kPcaPrescale, (uint8_t)_clampF(prescale, 3.0f, 255.0f)) ||
+
+      !_writePca(kPcaMode1, _pcaAsleep ? (kMode1AutoInc | kMode1Sleep) : kMode1AutoInc)) {
+
+    _pcaLinkLost();
+
+    return;
+
+  }
+
+  _pcaStartUs = micros();
+
+  _pcaLink = PCA_LINK_STARTING;
+
+}
+
+ 
+
+// Oscillator running: re-send the last committed frame
+
+void ServoBus::_pcaLinkUp() {
+
+  _pcaPresent = true;
+
+  _pcaLink = PCA_LINK_UP;
+
+  if (!_pcaAsleep) _recommitPca();
+
+  if (!_pcaPresent) return;   // gone again during the restore
+
+ 
+
+  const uint32_t now = millis();
+
+  const uint32_t us = micros() - _pcaFoundUs;
+
+  _pcaDueMs = now + PCA9685_CHECK_MS;
+
+  _pcaBackoffMs = PCA9685_RETRY_MIN_MS;
+
+  ++_pcaStats.reconnects;
+
+  _pcaStats.lastOutageMs = now - _pcaLostMs;
+
+  _pcaStats.lastRestoreUs = us;
+
+  if (us > _pcaStats.maxRestoreUs) _pcaStats.maxRestoreUs = us;
+
+  LOG_I("[ServoBus] PCA9685 back after %lu ms at %.1f Hz, last frame restored in %lu us",
+
+        (unsigned long)_pcaStats.lastOutageMs, _freq, (unsigned long)us);
+
+}
+
+ 
+
+// ---------------- Current scheduler ----------------
+
+// Per load class: holding current, current while moving at full speed
+
+// under the class load, and that speed in 1/256 µs of pulse per ms
+
+// (500-2500 µs over 180 deg: 300 deg/s is 3.3 µs/ms). Positions are Q8 µs
+
+// and currents whole mA, so the write path stays integer.
+
+struct LoadModel {
+
+  uint16_t holdMa;
+
+  uint16_t moveMa;
+
+  uint16_t usPerMsQ8;
+
+};
+
+ 
+
+static const LoadModel kLoadModel[LOAD_CLASSES] = {
+
+  { 120, 900,  845 },   // LOAD_LEG:  3.3 µs/ms, MG996R class under body weight, ~0.2 s/60 deg
+
+  {  60, 600, 1126 },   // LOAD_BODY: 4.4 µs/ms, ~0.15 s/60 deg
+
+  {  30, 350, 1408 },   // LOAD_AUX:  5.5 µs/ms, light horn loads, ~0.12 s/60 deg
+
+};
+
+ 
+
+// Current above holding for a move of dist out of a full-speed reach (Q8 µs)
+
+static inline uint32_t moveMa(const LoadModel& m, uint32_t dist, uint32_t reach) {
+
+  if (dist > reach) dist = reach;
+
+  return (uint32_t)(m.moveMa - m.holdMa) * dist / reach;
+
+}
+
+ 
+
+// Move pos toward cmd by at most reach; returns the current drawn doing so
+
+static uint32_t track(int32_t& pos, uint16_t cmd, uint32_t reach, const LoadModel& m) {
+
+  const int32_t err = ((int32_t)cmd << 8) - pos;
+
+  uint32_t move = (uint32_t)(err < 0 ? -err : err);
+
+  if (move > reach) move = reach;
+
+  pos += (err < 0) ? -(int32_t)move : (int32_t)move;
+
+  return m.holdMa + moveMa(m, move, reach);
+
+}
+
+ 
+
+// Longest move the channel makes in one frame (Q8 µs)
+
+uint32_t ServoBus::_stepQ8(uint8_t channel) const {
+
+  return kLoadModel[_load[channel]].usPerMsQ8 * _periodUs / 1000;
+
+}
+
+ 
+
+// What moving from the modelled position toward us costs above holding
+
+uint32_t ServoBus::_costMa(uint8_t channel, uint16_t us) const {
+
+  const int32_t err = ((int32_t)us << 8) - _estQ8[channel];
+
+  return moveMa(kLoadModel[_load[channel]], (uint32_t)(err < 0 ? -err : err), _stepQ8(channel));
+
+}
+
+ 
+
+// Pulse for a body/aux channel: as far toward its target as the spare
+
+// current pays for this frame
+
+uint16_t ServoBus::_grant(uint8_t channel) {
+
+  const LoadModel& m = kLoadModel[_load[channel]];
+
+  const uint32_t span = m.moveMa - m.holdMa;
+
+  const uint32_t want = _costMa(channel, _targetUs[channel]);
+
+ 
+
+  // Never below the crawl share: a move requested while the legs use the
+
+  // whole budget still finishes, just slowly
+
+  const int32_t  share = _spareMa > (int32_t)(span / SERVO_CRAWL_DIV) ? _spareMa : (int32_t)(span / SERVO_CRAWL_DIV);
+
+  const uint32_t give  = want < (uint32_t)share ? want : (uint32_t)share;
+
+  _spareMa -= (int32_t)give;
+
+  // Paid in full: the servo runs to the target at its own pace
+
+  if (give >= want) return _targetUs[channel];
+
+  _held = true;
+
+  const int32_t step = (int32_t)(_stepQ8(channel) * give / span);
+
+  const int32_t est  = _estQ8[channel];
+
+  return (uint16_t)((est + (((int32_t)_targetUs[channel] << 8) < est ? -step : step) + 128) >> 8);
+
+}
+
+ 
+
+// Body/aux write between frames: hand back what the pulse already out
+
+// costs, then grant the new one. Only this channel is written; whatever
+
+// the budget holds back moves on at the next frame().
+
+uint16_t ServoBus::_admit(uint8_t channel) {
+
+  // A blocking move (ROAR, TAIL_WAG) keeps loop() from framing: bring the
+
+  // model up to date and charge the body/aux pulses already out
+
+  if ((uint32_t)(micros() - _frameUs) >= 2 * _periodUs && _advance()) {
+
+    for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+
+      if (_load[ch] == LOAD_LEG || !_attached[ch] || !_lastUs[ch]) continue;
+
+      _spareMa -= (int32_t)_costMa(ch, _lastUs[ch]);
+
+    }
+
+  }
+
+ 
+
+  _spareMa += (int32_t)_costMa(channel, _lastUs[channel]);
+
+  return _grant(channel);
+
+}
+
+ 
+
+// Model: each servo moves toward the pulse already out. Leaves the spare
+
+// budget as what the legs draw if they keep moving like this and body/aux
+
+// channels only hold, and counts the frame just ended if a grant in it
+
+// held a move back. False when no time has passed.
+
+bool ServoBus::_advance() {
+
+  const uint32_t now = micros();
+
+  const uint32_t dt = now - _frameUs;
+
+  if (!dt) return false;
+
+  _frameUs = now;
+
+  _periodUs = dt < 1000 ? 1000 : (dt > 200000 ? 200000 : dt);
+
+ 
+
+  uint32_t total = 0, unlimited = 0, next = 0;
+
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+
+    if (!_attached[ch] || !_lastUs[ch]) continue;
+
+    if ((_pcaAsleep || !_pcaPresent) && ch >= PCA9685_FIRST_CHANNEL) continue;   // limp, no draw
+
+    const LoadModel& m = kLoadModel[_load[ch]];
+
+    const uint32_t reach = _stepQ8(ch);
+
+    const uint32_t ma = track(_estQ8[ch], _lastUs[ch], reach, m);
+
+    total     += ma;
+
+    unlimited += track(_freeQ8[ch], _targetUs[ch], reach, m);
+
+    next      += (_load[ch] == LOAD_LEG) ? ma : m.holdMa;
+
+  }
+
+ 
+
+  ++_current.frames;
+
+  if (_held) ++_current.limited;
+
+  _held = false;
+
+  _current.nowMa = total;
+
+  if (total > _current.peakMa) _current.peakMa = total;
+
+  if (unlimited > _current.unlimitedPeakMa) _current.unlimitedPeakMa = unlimited;
+
+  if (_budgetMa && total > _budgetMa) ++_current.over;
+
+  _spareMa = (int32_t)_budgetMa - (int32_t)next;
+
+  return true;
+
+}
+
+ 
+
+void ServoBus::frame() {
+
+  if (!_advance() || !_budgetMa) return;
+
+ 
+
+  // Re-grant every body/aux channel from its modelled position: body
+
+  // before aux, the first channel served rotating each frame
+
+  for (uint8_t load = LOAD_BODY; load < LOAD_CLASSES; ++load) {
+
+    for (uint8_t i = 0; i < SERVO_COUNT; ++i) {
+
+      const uint8_t ch = (uint8_t)((_rotate + i) % SERVO_COUNT);
+
+      if (_load[ch] != load || !_attached[ch] || !_lastUs[ch]) continue;
+
+      const uint16_t us = _grant(ch);
+
+      if (us != _lastUs[ch]) _output(ch, us);
+
+    }
+
+  }
+
+  _rotate = (uint8_t)((_rotate + 1) % SERVO_COUNT);
+
+}
+
+ 
+
+void ServoBus::setCurrentBudget(uint32_t mA) {
+
+  _budgetMa = mA;
+
+  if (mA) return;
+
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+
+    if (_attached[ch] && _lastUs[ch] && _lastUs[ch] != _targetUs[ch]) _output(ch, _targetUs[ch]);
+
+  }
+
+}
+
+ 
+
+bool ServoBus::slewing() const {
+
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ++ch) {
+
+    if (_attached[ch] && _lastUs[ch] != _targetUs[ch]) return true;
+
+  }
+
+  return false;
+
+}
+
+ 
+
+void ServoBus::setLoadClass(uint8_t channel, ServoLoad load) {
+
+  if (channel >= SERVO_COUNT || load >= LOAD_CLASSES) return;
+
+  _load[channel] = load;
+
+}
+
+ 
+
+void ServoBus::resetCurrentStats() {
+
+  _current = ServoCurrentStats();
+
+}
+
+ 
+
+void ServoBus::writeDegrees(uint8_t channel, float deg) {
+
+  if (channel >= SERVO_COUNT) return;
+
+  if (!_attached[channel]) return;
+
+ 
+
+  const int32_t q8 = _degToQ8(deg);
+
+  _lastQ8[channel] = q8;
+
+  _writeUs(channel, _q8ToUs(channel, q8));
+
+}
+
+ 
+
+void ServoBus::writeNeutral(uint8_t channel) {
+
+  if (channel >= SERVO_COUNT) return;
+
+  if (!_attached[channel]) return;
+
+ 
+
+  const ServoLimits& lim = _limits[channel];
+
+  float mid = 0.5f * (lim.minDeg + lim.maxDeg);
+
+  writeDegrees(channel, mid);
+
+}
+
+ 
+
+void ServoBus::setAllOff() {
+
+  LOG_I("[ServoBus] setAllOff() - detaching all channels");
+
+ 
+
+  // Detach GPIO servos (channels 0-5)
+
+  for (uint8_t ch = 0; ch < PCA9685_FIRST_CHANNEL; ++ch) {
+
+    if (_attached[ch]) {
+
+      _gpioServos[ch].detach();
+
+      _attached[ch] = false;
+
+      _lastUs[ch] = 0;
+
+      _targetUs[ch] = 0;
+
+      _lastQ8[ch] = -1;
+
+    }
+
+  }
+
+ 
+
+  // Turn off PCA9685 servos (channels 6-15)
+
+  for (uint8_t ch = PCA9685_FIRST_CHANNEL; ch < SERVO_COUNT; ++ch) {
+
+    if (_attached[ch]) {
+
+      uint8_t pcaPort = _channelToPcaPort(ch);
+
+      if (_pcaPresent) _pca9685.setPWM(pcaPort, 0, 0);
+
+      _attached[ch] = false;
+
+      _lastUs[ch] = 0;
+
+      _targetUs[ch] = 0;
+
+      _lastQ8[ch] = -1;
 
     }
 
@@ -84,6 +84,48 @@
 
  
 
+// ---------------- PCA9685 link monitor ----------------
+
+// poll() checks a present PCA9685 every PCA9685_CHECK_MS (one MODE1 read)
+
+// and probes a missing one, first after PCA9685_RETRY_MIN_MS, then with
+
+// the wait doubling up to PCA9685_RETRY_MAX_MS
+
+#ifndef PCA9685_CHECK_MS
+
+#define PCA9685_CHECK_MS 250
+
+#endif
+
+ 
+
+#ifndef PCA9685_RETRY_MIN_MS
+
+#define PCA9685_RETRY_MIN_MS 50
+
+#endif
+
+ 
+
+#ifndef PCA9685_RETRY_MAX_MS
+
+#define PCA9685_RETRY_MAX_MS 2000
+
+#endif
+
+ 
+
+// Longest I2C transfer; a stuck bus costs this much, not the core's 50 ms
+
+#ifndef PCA9685_I2C_TIMEOUT_MS
+
+#define PCA9685_I2C_TIMEOUT_MS 5
+
+#endif
+
+ 
+
 // Total servo count
 
 #define SERVO_COUNT 16
@@ -120,6 +162,115 @@ struct ServoLimits {
 
  
 
+// ---------------- Degree tables ----------------
+
+// Each channel's limits and trim are compiled into a pulse table with one
+
+// entry per whole degree (µs in 1/16 steps). writeDegrees() only
+
+// interpolates between two entries; the tables are rebuilt by attach(),
+
+// setLimits() and setCalibration(), never on the write path.
+
+#define SERVO_TABLE_DEGREES 180
+
+ 
+
+// ---------------- Current budget ----------------
+
+// Estimated servo draw on the 5 V rail (mA) that frame() keeps the bus
+
+// under; 0 turns the scheduler off (the estimate is still kept).
+
+#ifndef SERVO_CURRENT_BUDGET_MA
+
+#define SERVO_CURRENT_BUDGET_MA 6000
+
+#endif
+ 
+
+// Held-back body/aux channels still move at 1/SERVO_CRAWL_DIV of full speed
+
+#ifndef SERVO_CRAWL_DIV
+
+#define SERVO_CRAWL_DIV 8
+
+#endif
+
+ 
+
+// Load classes of the current model, highest priority first. Leg channels
+
+// carry the body and are never held back; body and aux channels (jaw,
+
+// tail) are slewed, aux first, when the legs leave too little headroom.
+
+enum ServoLoad : uint8_t {
+
+  LOAD_LEG = 0,   // hips, knees, ankles, feet (channels 6-15)
+
+  LOAD_BODY,      // neck, head pitch, pelvis, spine
+
+  LOAD_AUX,       // jaw, tail
+
+  LOAD_CLASSES
+
+};
+
+ 
+
+struct ServoCurrentStats {
+
+  uint32_t nowMa;           // estimate for the last frame
+
+  uint32_t peakMa;          // highest frame estimate since reset
+
+  uint32_t unlimitedPeakMa; // the same had every write gone out unslewed
+
+  uint32_t frames;          // frames estimated
+
+  uint32_t limited;         // frames in which a body/aux move was slewed
+
+  uint32_t over;            // frames over budget anyway (legs alone)
+
+};
+
+ 
+
+// State of the I2C link to the PCA9685 (see ServoBus::poll())
+
+enum PcaLink : uint8_t {
+
+  PCA_LINK_UP = 0,    // answering; channels 6-15 are written
+
+  PCA_LINK_DOWN,      // not answering; probed with backoff
+
+  PCA_LINK_STARTING   // answered again; oscillator starting
+
+};
+
+ 
+
+struct PcaLinkStats {
+
+  uint32_t losses;          // times it stopped answering
+
+  uint32_t resets;          // times it answered with power-on registers
+
+  uint32_t probes;          // discovery attempts while down
+
+  uint32_t reconnects;      // times the last frame was restored
+
+  uint32_t lastOutageMs;    // lost -> restored, last time
+
+  uint32_t lastRestoreUs;   // answered -> frame restored, last time
+
+  uint32_t maxRestoreUs;
+
+};
+
+ 
+
 // --------------------------- ServoBus ---------------------------
 
 class ServoBus {
@@ -142,7 +293,11 @@ public:
 
  
 
-  // Attach/detach logical servo channels with limits
+  // Attach/detach logical servo channels with limits. Channels 6-15 attach
+
+  // while the PCA9685 is missing too: their writes are kept and go out
+
+  // when it answers.
 
   void attach(uint8_t channel, const ServoLimits& limits = ServoLimits());
 
@@ -152,6 +307,18 @@ public:
 
  
 
+  // Calibration (see Calibration.h): limits and a neutral trim (µs added
+
+  // to every degree write) that take precedence over the limits passed to
+
+  // attach() until cleared. The channel's last degree write is re-sent.
+
+  void setCalibration(uint8_t channel, const ServoLimits& limits, int16_t trimUs);
+
+  void clearCalibration(uint8_t channel);   // back to the attach() limits, no trim
+
+ 
+
   // Writes
 
   void writeMicroseconds(uint8_t channel, uint16_t us);
@@ -164,6 +331,96 @@ public:
 
  
 
+  // PCA9685 low-power sleep: the oscillator stops and channels 6-15 go
+
+  // limp. Waking restarts it and re-sends the last committed pulses.
+
+  void setPcaSleep(bool on);
+
+  inline bool isPcaAsleep() const { return _pcaAsleep; }
+
+ 
+
+  // ---------------- PCA9685 link monitor ----------------
+
+  // Main loop, outside the control frame. A pass makes a few short I2C
+
+  // transfers at most: a present PCA9685 has MODE1 read every
+
+  // PCA9685_CHECK_MS; a missing one (from begin(), a failed write or a
+
+  // failed check) is probed with backoff. When it answers, the prescaler
+
+  // is programmed with three register writes (the driver was begun once
+
+  // in begin(), so nothing is allocated or waited for) and, 500 µs later
+
+  // in a later pass, the last committed frame is re-sent, which takes as
+
+  // long as any frame commit. A chip that answers with power-on registers
+
+  // (supply glitch) is set up again the same way.
+
+  void poll();
+
+  inline PcaLink pcaLink() const { return (PcaLink)_pcaLink; }
+
+  inline const PcaLinkStats& pcaLinkStats() const { return _pcaStats; }
+
+ 
+
+  // ---------------- Current scheduler ----------------
+
+  // Once per control frame: advance the current model (each servo moves
+
+  // toward its pulse at its class speed, drawing between holding and
+
+  // full-speed current in proportion to how far it got), then move body
+
+  // and aux channels toward their requested pulses within the spare budget.
+
+  // Spare current goes to body channels before aux ones, rotating within a
+
+  // class, so short headroom staggers moves instead of stalling one joint.
+
+  // Body/aux writes between frames are admitted against what is left and
+
+  // only write their own channel; blocking moves (ROAR, TAIL_WAG) advance
+
+  // the model from the write itself, and held-back moves wait for frame().
+
+  void frame();
+
+  void setCurrentBudget(uint32_t mA);   // 0 = off; held-back moves finish at once
+
+  void setLoadClass(uint8_t channel, ServoLoad load);
+
+  void resetCurrentStats();
+
+  inline uint32_t currentBudget() const { return _budgetMa; }
+
+  inline const ServoCurrentStats& currentStats() const { return _current; }
+
+  inline ServoLoad loadClass(uint8_t ch) const {
+
+    return (ch < SERVO_COUNT) ? (ServoLoad)_load[ch] : LOAD_LEG;
+
+  }
+
+  // Pulse last requested for the channel; differs from lastMicroseconds()
+
+  // while the scheduler is slewing it
+
+  inline uint16_t targetMicroseconds(uint8_t ch) const {
+
+    return (ch < SERVO_COUNT) ? _targetUs[ch] : 0;
+
+  }
+
+  bool slewing() const;                 // a body/aux channel is still held back
+
+ 
+
   // Queries
 
   inline bool  isAttached(uint8_t ch) const {
@@ -172,9 +429,41 @@ public:
 
   }
 
+  // Last pulse actually sent to the channel (µs), 0 when off/detached
+  inline uint16_t lastMicroseconds(uint8_t ch) const {
+
+    return (ch < SERVO_COUNT) ? _lastUs[ch] : 0;
+
+  }
+
+  inline bool isCalibrated(uint8_t ch) const {
+
+    return (ch < SERVO_COUNT) && (_calMask & (1u << ch));
+
+  }
+
+  inline int16_t trim(uint8_t ch) const {
+
+    return (ch < SERVO_COUNT) ? _trimUs[ch] : 0;
+
+  }
+
   inline float frequency() const { return _freq; }
   inline bool  isPcaPresent() const { return _pcaPresent; }
 
+  inline const ServoLimits& limits(uint8_t ch) const {
+
+    return _limits[ch < SERVO_COUNT ? ch : 0];
+
+  }
+
+  // Pulse width writeDegrees() would send for deg (limits applied, no I/O)
+  inline uint16_t degToUs(uint8_t ch, float deg) const {
+
+    return (ch < SERVO_COUNT) ? _degToUs(ch, deg) : 0;
+
+  }
+
  
 
 private:
@@ -197,13 +486,72 @@ private:
 
   ServoLimits _limits[SERVO_COUNT];
   bool        _attached[SERVO_COUNT] = { false };
+  uint16_t    _lastUs[SERVO_COUNT] = { 0 };
+  int32_t     _lastQ8[SERVO_COUNT];               // last degree write (1/256 deg), -1 after a µs write
+  ServoLimits _attachLimits[SERVO_COUNT];         // as passed to attach()
+  int16_t     _trimUs[SERVO_COUNT] = { 0 };
+  uint16_t    _calMask = 0;                       // channels with calibrated limits
+  uint16_t    _degTable[SERVO_COUNT][SERVO_TABLE_DEGREES + 1];   // µs * 16 per whole degree
+  uint32_t    _countScale = 0;                    // PCA9685 counts per µs (Q32)
   bool        _pcaPresent = false;
+  bool        _pcaAsleep = false;
+  uint8_t     _pcaLink = PCA_LINK_DOWN;
+  uint32_t    _pcaDueMs = 0;                      // next check / probe
+  uint32_t    _pcaBackoffMs = PCA9685_RETRY_MIN_MS;
+  uint32_t    _pcaLostMs = 0;
+  uint32_t    _pcaFoundUs = 0;                    // answered again (restore timing)
+  uint32_t    _pcaStartUs = 0;                    // oscillator started
+  PcaLinkStats _pcaStats = {};
   float       _freq = 50.0f;
   uint8_t     _i2cAddr = PCA9685_I2C_ADDRESS;
 
+  // Current model and scheduler state
+  uint8_t     _load[SERVO_COUNT];
+  uint16_t    _targetUs[SERVO_COUNT] = { 0 };     // requested pulse (= _lastUs unless slewed)
+  int32_t     _estQ8[SERVO_COUNT];                // modelled horn position (1/256 µs)
+  int32_t     _freeQ8[SERVO_COUNT];               // same, following _targetUs
+  uint32_t    _budgetMa = SERVO_CURRENT_BUDGET_MA;
+  int32_t     _spareMa = 0;                       // budget left in this frame
+  bool        _held = false;                      // a grant this frame slewed a move
+  uint32_t    _frameUs = 0;
+  uint32_t    _periodUs = 20000;                  // measured frame period
+  uint8_t     _rotate = 0;                        // first body/aux channel served
+  ServoCurrentStats _current = {};
+
   // Helpers
 
-  uint16_t _degToUs(uint8_t ch, float deg) const;
+  uint16_t _degToUs(uint8_t ch, float deg) const { return _q8ToUs(ch, _degToQ8(deg)); }
+
+  static int32_t _degToQ8(float deg);
+
+  uint16_t _q8ToUs(uint8_t ch, int32_t q8) const;
+
+  void     _buildTable(uint8_t ch);
+
+  void     _setCountScale(float freq_hz);
+
+  void     _writeUs(uint8_t channel, uint16_t us);
+
+  void     _output(uint8_t channel, uint16_t us);
+
+  uint16_t _admit(uint8_t channel);
+
+  uint16_t _grant(uint8_t channel);
+
+  uint32_t _stepQ8(uint8_t channel) const;
+
+  uint32_t _costMa(uint8_t channel, uint16_t us) const;
+
+  bool     _advance();
+
+  void     _refresh(uint8_t channel);
+
+  void     _recommitPca();
+  void     _pcaLinkLost();
+  void     _pcaLinkStart();
+  void     _pcaLinkUp();
+  int      _readPcaMode1();
+  bool     _writePca(uint8_t reg, uint8_t value);
 
   uint8_t  _channelToGpioPin(uint8_t channel) const;
 
@@ -1,4 +1,6 @@
 #include "Head_Function.h"
+#include "../Log.h"
+#include "../Perf.h"
 
 namespace Head {
 
@@ -33,7 +35,7 @@ void begin(ServoBus* bus, const Map& map) {
   CH = map;
   
   if (!SB) {
-    Serial.println(F("[Head] ERROR: ServoBus is nullptr!"));
+    LOG_E("[Head] ERROR: ServoBus is nullptr!");
     return;
   }
   
@@ -45,11 +47,7 @@ void begin(ServoBus* bus, const Map& map) {
   SB->writeDegrees(CH.jaw,   NEUTRAL_JAW_DEG);
   SB->writeDegrees(CH.pitch, NEUTRAL_PITCH_DEG);
   
-  Serial.print(F("[Head] Initialized on PCA9685 channels "));
-  Serial.print(CH.jaw);
-  Serial.print(F(" (jaw) and "));
-  Serial.print(CH.pitch);
-  Serial.println(F(" (pitch)"));
+  LOG_D("[Head] Initialized on channels %u (jaw) and %u (pitch)", CH.jaw, CH.pitch);
 }
 
 // ========== Jaw Control ==========
@@ -117,8 +115,9 @@ void setPitch01(float amt01) {
 // Roar animation
 void roar() {
   if (!SB) return;
+  PERF_SCOPE(ANIMATION);
   
-  Serial.println(F("[Head] ROAR!"));
+  LOG_I("[Head] ROAR!");
   
   // Look up and open mouth
   SB->writeDegrees(CH.pitch, LIM_PITCH.maxDeg);
@@ -142,8 +141,9 @@ void roar() {
 // Snap animation
 void snap() {
   if (!SB) return;
+  PERF_SCOPE(ANIMATION);
   
-  Serial.println(F("[Head] Snap!"));
+  LOG_I("[Head] Snap!");
   
   // Quick jaw open and close
   SB->writeDegrees(CH.jaw, JAW_OPEN_DEG);
@@ -162,7 +162,7 @@ void center() {
   SB->writeDegrees(CH.jaw,   NEUTRAL_JAW_DEG);
   SB->writeDegrees(CH.pitch, NEUTRAL_PITCH_DEG);
   
-  Serial.println(F("[Head] Centered"));
+  LOG_I("[Head] Centered");
 }
 
 // Nudge jaw by relative angle
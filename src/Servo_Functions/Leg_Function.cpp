@@ -1,5 +1,8 @@
 #include "Leg_Function.h"
 #include <math.h>
+#include "../Log.h"
+#include "../Trace.h"
+#include "../Perf.h"
 //yaw
 namespace Leg {
 
@@ -17,13 +20,8 @@ static float NEUTRAL_ANKLE  = 90.0f;   // Ankle neutral (pivot)
 static float NEUTRAL_FOOT   = 90.0f;   // Foot neutral (tilt)
 
 // ========== Gait Parameters ==========
-// Per-joint amplitude scales (degrees per unit amplitude)
-// These control how much each joint moves during walking
-static float HIPX_STRIDE_SCALE  = 50.0f;  // Hip X swing range (forward/back)
-static float HIPY_LIFT_SCALE    = 35.0f;  // Hip Y lift range (up/down)
-static float KNEE_STRIDE_SCALE  = 35.0f;  // Knee bend range
-static float ANKLE_STRIDE_SCALE = 25.0f;  // Ankle rotation range
-static float FOOT_LIFT_SCALE    = 20.0f;  // Foot lift height
+// Per-joint amplitude scales and wave shape (see Leg::Tuning)
+static Tuning g_tuning;
 
 // ========== Servo Limits ==========
 // Safety limits per joint (µs pulse width / degrees)
@@ -44,6 +42,7 @@ static float g_lift_amp   = 0.8f;    // Foot lift amount (0..1)
 static float g_posture    = 0.5f;    // Overall stance height (0..1)
 
 static uint32_t g_t0_ms = 0;         // Gait start timestamp
+static float    g_phase = 0.0f;      // Phase computed by the last tick()
 
 // ========== Helper Functions ==========
 
@@ -59,64 +58,28 @@ static inline float lerp(float a, float b, float t) {
   return a + (b - a) * t; 
 }
 
-// ========== Leg Control Functions ==========
+// ========== Gait Kernel ==========
 
-// Write angles to right leg servos
-// swing: -1.0 (back) to +1.0 (forward)
+// Joint angles for one leg
+// swing: -1.0 to +1.0 hip X travel; gaitWave() plants the foot while it
+//        rises, so +1.0 is the end of the push (foot back under the body)
 // lift: 0.0 (on ground) to 1.0 (lifted)
-// posture01: 0.0 (crouch) to 1.0 (extend)
-static void writeRightLeg(float swing, float lift, float posture01) {
-  if (!SB) return;
-  
-  // Calculate joint angles based on gait parameters
-  const float hipX  = NEUTRAL_HIP_X  + swing * (HIPX_STRIDE_SCALE  * g_stride_amp);
-  const float hipY  = NEUTRAL_HIP_Y  - lift  * (HIPY_LIFT_SCALE    * g_lift_amp);
-  const float knee  = NEUTRAL_KNEE   - lift  * (KNEE_STRIDE_SCALE  * g_lift_amp);
-  const float ankle = NEUTRAL_ANKLE  - lift  * (ANKLE_STRIDE_SCALE * g_lift_amp);
-  const float foot  = NEUTRAL_FOOT   - lift  * (FOOT_LIFT_SCALE    * g_lift_amp);
-
+static void legPose(const Tuning& t, const Gait& g, float swing, float lift, float out[JOINT_COUNT]) {
   // Apply posture trim (adjust overall height)
-  const float trim = (posture01 - 0.5f) * 10.0f; // +/- ~5 degrees
-  
-  // Write to PCA9685 channels
-  SB->writeDegrees(CH.R_hipX,  hipX  + trim);
-  SB->writeDegrees(CH.R_hipY,  hipY  + trim);
-  SB->writeDegrees(CH.R_knee,  knee  + trim);
-  SB->writeDegrees(CH.R_ankle, ankle + trim);
-  SB->writeDegrees(CH.R_foot,  foot  + trim);
-}
+  const float trim = (g.posture - 0.5f) * 10.0f; // +/- ~5 degrees
 
-// Write angles to left leg servos
-// swing: -1.0 (back) to +1.0 (forward)
-// lift: 0.0 (on ground) to 1.0 (lifted)
-// posture01: 0.0 (crouch) to 1.0 (extend)
-static void writeLeftLeg(float swing, float lift, float posture01) {
-  if (!SB) return;
-  
-  // Calculate joint angles based on gait parameters
-  const float hipX  = NEUTRAL_HIP_X  + swing * (HIPX_STRIDE_SCALE  * g_stride_amp);
-  const float hipY  = NEUTRAL_HIP_Y  - lift  * (HIPY_LIFT_SCALE    * g_lift_amp);
-  const float knee  = NEUTRAL_KNEE   - lift  * (KNEE_STRIDE_SCALE  * g_lift_amp);
-  const float ankle = NEUTRAL_ANKLE  - lift  * (ANKLE_STRIDE_SCALE * g_lift_amp);
-  const float foot  = NEUTRAL_FOOT   - lift  * (FOOT_LIFT_SCALE    * g_lift_amp);
-
-  // Apply posture trim
-  const float trim = (posture01 - 0.5f) * 10.0f;
-  
-  // Write to PCA9685 channels
-  SB->writeDegrees(CH.L_hipX,  hipX  + trim);
-  SB->writeDegrees(CH.L_hipY,  hipY  + trim);
-  SB->writeDegrees(CH.L_knee,  knee  + trim);
-  SB->writeDegrees(CH.L_ankle, ankle + trim);
-  SB->writeDegrees(CH.L_foot,  foot  + trim);
+  out[HIP_X] = NEUTRAL_HIP_X + swing * (t.hipXScale  * g.stride) + trim;
+  out[HIP_Y] = NEUTRAL_HIP_Y - lift  * (t.hipYScale  * g.lift)   + trim;
+  out[KNEE]  = NEUTRAL_KNEE  - lift  * (t.kneeScale  * g.lift)   + trim;
+  out[ANKLE] = NEUTRAL_ANKLE - lift  * (t.ankleScale * g.lift)   + trim;
+  out[FOOT]  = NEUTRAL_FOOT  - lift  * (t.footScale  * g.lift)   + trim;
 }
 
-// ========== Gait Wave Generator ==========
 // Generate smooth walking motion using sine waves
 // phase01: 0.0 to 1.0 (one complete gait cycle)
 // swing_out: -1.0 to +1.0 (forward/back motion)
 // lift_out: 0.0 to 1.0 (foot lift height)
-static void gaitWave(float phase01, float& swing_out, float& lift_out) {
+static void gaitWave(float phase01, float liftExp, float& swing_out, float& lift_out) {
   const float theta = phase01 * TWO_PI; // TWO_PI from Arduino.h
   
   // Swing: sinusoidal forward/back motion
@@ -124,12 +87,91 @@ static void gaitWave(float phase01, float& swing_out, float& lift_out) {
   
   // Lift: peaks at mid-swing for natural foot clearance
   float lift = 0.5f * (sinf(theta - PI/2) + 1.0f); // 0..1, peaks mid-swing
-  lift = powf(lift, 1.2f); // Sharper peak for more ground contact time
+  lift = powf(lift, liftExp); // Sharper peak for more ground contact time
 
   swing_out = clampf(swing, -1.0f, 1.0f);
   lift_out  = clampf(lift,   0.0f, 1.0f);
 }
 
+void solve(const Tuning& t, const Gait& g, Mode m, float phase01, Pose& out) {
+  // Idle holds the neutral stance
+  if (m == IDLE) {
+    legPose(t, g, 0.0f, 0.0f, out.right);
+    legPose(t, g, 0.0f, 0.0f, out.left);
+    return;
+  }
+
+  // Generate gait signals for each leg
+  float swingR = 0, liftR = 0;
+  float swingL = 0, liftL = 0;
+
+  // Left leg is 180° out of phase with right leg
+  float phaseL = phase01 + 0.5f;
+  if (phaseL >= 1.0f) phaseL -= 1.0f;
+
+  gaitWave(phase01, t.liftExp, swingR, liftR);
+  gaitWave(phaseL,  t.liftExp, swingL, liftL);
+
+  // Modify gait based on current mode
+  if (m == WALK_BWD) {
+    // Reverse swing direction for backward walking
+    swingR = -swingR;
+    swingL = -swingL;
+  }
+  else if (m == TURN_L) {
+    // Reduce left leg swing, increase right leg swing
+    swingL *= t.turnInner;
+    swingR *= t.turnOuter;
+  } 
+  else if (m == TURN_R) {
+    // Increase left leg swing, reduce right leg swing
+    swingL *= t.turnOuter;
+    swingR *= t.turnInner;
+  }
+
+  legPose(t, g, swingR, liftR, out.right);
+  legPose(t, g, swingL, liftL, out.left);
+}
+
+const ServoLimits& limits(Joint j) {
+  static const ServoLimits* const kLimits[JOINT_COUNT] = { &LIM_HIP_X, &LIM_HIP_Y, &LIM_KNEE, &LIM_ANKLE, &LIM_FOOT };
+  return *kLimits[j < JOINT_COUNT ? j : HIP_X];
+}
+
+// ========== Leg Control Functions ==========
+
+// Current gait amplitudes as a kernel input
+static Gait currentGait(float posture01) {
+  Gait g;
+  g.stride  = g_stride_amp;
+  g.lift    = g_lift_amp;
+  g.posture = posture01;
+  return g;
+}
+
+// Write a pose to the PCA9685 channels
+static void writePose(const Pose& p) {
+  if (!SB) return;
+  SB->writeDegrees(CH.R_hipX,  p.right[HIP_X]);
+  SB->writeDegrees(CH.R_hipY,  p.right[HIP_Y]);
+  SB->writeDegrees(CH.R_knee,  p.right[KNEE]);
+  SB->writeDegrees(CH.R_ankle, p.right[ANKLE]);
+  SB->writeDegrees(CH.R_foot,  p.right[FOOT]);
+
+  SB->writeDegrees(CH.L_hipX,  p.left[HIP_X]);
+  SB->writeDegrees(CH.L_hipY,  p.left[HIP_Y]);
+  SB->writeDegrees(CH.L_knee,  p.left[KNEE]);
+  SB->writeDegrees(CH.L_ankle, p.left[ANKLE]);
+  SB->writeDegrees(CH.L_foot,  p.left[FOOT]);
+}
+
+// Neutral stance at the given posture
+static void writeNeutral(float posture01) {
+  Pose p;
+  solve(g_tuning, currentGait(posture01), IDLE, 0.0f, p);
+  writePose(p);
+}
+
 // ========== Public API Implementation ==========
 
 // Initialize leg control system
@@ -138,12 +180,11 @@ void begin(ServoBus* bus, const Map& map) {
   CH = map;
 
   if (!SB) {
-    Serial.println(F("[Leg] ERROR: ServoBus is nullptr!"));
+    LOG_E("[Leg] ERROR: ServoBus is nullptr!");
     return;
   }
 
   // Attach all leg servos to PCA9685 with limits
-  Serial.println(F("[Leg] Attaching servos..."));
   SB->attach(CH.R_hipX,  LIM_HIP_X);
   SB->attach(CH.R_hipY,  LIM_HIP_Y);
   SB->attach(CH.R_knee,  LIM_KNEE);
@@ -155,10 +196,8 @@ void begin(ServoBus* bus, const Map& map) {
   SB->attach(CH.L_knee,  LIM_KNEE);
   SB->attach(CH.L_ankle, LIM_ANKLE);
   SB->attach(CH.L_foot,  LIM_FOOT);
-  Serial.println(F("[Leg] All servos attached"));
 
   // Move to neutral stance
-  Serial.println(F("[Leg] Moving to neutral stance..."));
   SB->writeDegrees(CH.R_hipX,  NEUTRAL_HIP_X);
   SB->writeDegrees(CH.R_hipY,  NEUTRAL_HIP_Y);
   SB->writeDegrees(CH.R_knee,  NEUTRAL_KNEE);
@@ -170,106 +209,98 @@ void begin(ServoBus* bus, const Map& map) {
   SB->writeDegrees(CH.L_knee,  NEUTRAL_KNEE);
   SB->writeDegrees(CH.L_ankle, NEUTRAL_ANKLE);
   SB->writeDegrees(CH.L_foot,  NEUTRAL_FOOT);
-  Serial.println(F("[Leg] Neutral stance complete"));
 
   // Initialize gait state
   g_mode  = IDLE;
   g_t0_ms = millis();
 
-  Serial.println(F("[Leg] Initialized with ServoBus (HYBRID mode)"));
-  Serial.print(F("  Right leg: Channels "));
-  Serial.print(CH.R_hipX); Serial.print(F(","));
-  Serial.print(CH.R_hipY); Serial.print(F(","));
-  Serial.print(CH.R_knee); Serial.print(F(","));
-  Serial.print(CH.R_ankle); Serial.print(F(","));
-  Serial.print(CH.R_foot);
-  Serial.println(F(" (PCA ports 0,1,3,4,5)"));
-  Serial.print(F("  Left leg:  Channels "));
-  Serial.print(CH.L_hipX); Serial.print(F(","));
-  Serial.print(CH.L_hipY); Serial.print(F(","));
-  Serial.print(CH.L_knee); Serial.print(F(","));
-  Serial.print(CH.L_ankle); Serial.print(F(","));
-  Serial.print(CH.L_foot);
-  Serial.println(F(" (PCA ports 6,7,8,9 + GPIO6)"));
+  LOG_D("[Leg] Initialized: right leg channels %u-%u, left leg channels %u-%u",
+        CH.R_hipX, CH.R_foot, CH.L_hipX, CH.L_foot);
 }
 
 // ========== Locomotion Commands ==========
 
+// Change the gait frequency without a jump: g_t0_ms moves so the phase
+// tick() computes at the new rate is the one it computes now at the old
+static void retime(float hz) {
+  if (g_mode != IDLE && hz > 0.0f) {
+    const uint32_t now = millis();
+    const float cycle = (now - g_t0_ms) / 1000.0f * g_speed_hz;
+    const float phase = cycle - floorf(cycle);
+    g_t0_ms = now - (uint32_t)lroundf(phase * 1000.0f / hz);
+  }
+  g_speed_hz = hz;
+}
+
+// Switch locomotion mode. Repeated commands for the motion already in
+// progress (e.g. a held UI button) keep the gait phase running and stay
+// quiet; a new mode restarts the cycle, a new speed carries the phase on.
+static void enterMode(Mode m, float hz, const char* label) {
+  hz = clampf(hz, 0.1f, 3.0f);
+  const bool modeChanged = (g_mode != m);
+  if (!modeChanged && hz == g_speed_hz) return;
+
+  if (modeChanged) {
+    g_t0_ms = millis();
+    g_mode = m;
+    g_speed_hz = hz;
+  } else {
+    retime(hz);
+  }
+
+  LOG_I("[Leg] %s at %.2f Hz", label, g_speed_hz);
+}
+
 void walkForward(float speed_hz) { 
-  g_mode = WALK_FWD; 
-  g_speed_hz = clampf(speed_hz, 0.1f, 3.0f); 
-  g_t0_ms = millis();
-  Serial.print(F("[Leg] Walking forward at "));
-  Serial.print(g_speed_hz);
-  Serial.println(F(" Hz"));
+  enterMode(WALK_FWD, speed_hz, "Walking forward");
 }
 
 void walkBackward(float speed_hz) { 
-  g_mode = WALK_BWD; 
-  g_speed_hz = clampf(speed_hz, 0.1f, 3.0f); 
-  g_t0_ms = millis();
-  Serial.print(F("[Leg] Walking backward at "));
-  Serial.print(g_speed_hz);
-  Serial.println(F(" Hz"));
+  enterMode(WALK_BWD, speed_hz, "Walking backward");
 }
 
 void turnLeft(float rate_hz) { 
-  g_mode = TURN_L; 
-  g_speed_hz = clampf(rate_hz, 0.1f, 3.0f); 
-  g_t0_ms = millis();
-  Serial.print(F("[Leg] Turning left at "));
-  Serial.print(g_speed_hz);
-  Serial.println(F(" Hz"));
+  enterMode(TURN_L, rate_hz, "Turning left");
 }
 
 void turnRight(float rate_hz) { 
-  g_mode = TURN_R; 
-  g_speed_hz = clampf(rate_hz, 0.1f, 3.0f); 
-  g_t0_ms = millis();
-  Serial.print(F("[Leg] Turning right at "));
-  Serial.print(g_speed_hz);
-  Serial.println(F(" Hz"));
+  enterMode(TURN_R, rate_hz, "Turning right");
 }
 
 void stop() {
+  const bool wasMoving = (g_mode != IDLE);
   g_mode = IDLE;
-  writeRightLeg(0.0f, 0.0f, g_posture);
-  writeLeftLeg(0.0f, 0.0f, g_posture);
-  Serial.println(F("[Leg] Stopped - neutral stance"));
+  writeNeutral(g_posture);
+  if (wasMoving) LOG_I("[Leg] Stopped - neutral stance");
 }
 
 void emergencyStop() {
   g_mode = IDLE;
   if (!SB) return;
-  writeRightLeg(0.0f, 0.0f, 0.5f);
-  writeLeftLeg(0.0f, 0.0f, 0.5f);
-  Serial.println(F("[Leg] EMERGENCY STOP"));
+  writeNeutral(0.5f);
+  LOG_W("[Leg] EMERGENCY STOP");
 }
 
 // ========== Gait Parameter Control ==========
 
-void setGait(float speed_hz, float stride_amp, float lift_amp, const String& mode) {
-  g_speed_hz   = clampf(speed_hz,   0.05f, 4.0f);
+void setGait(float speed_hz, float stride_amp, float lift_amp, Pace pace) {
+  float hz     = clampf(speed_hz,   0.05f, 4.0f);
   g_stride_amp = clampf(stride_amp, 0.0f,  1.0f);
   g_lift_amp   = clampf(lift_amp,   0.0f,  1.0f);
   
   // Modify parameters for "run" mode
-  if (mode == "run") {
-    g_speed_hz = clampf(g_speed_hz * 1.3f, 0.1f, 5.0f); // 30% faster
+  if (pace == PACE_RUN) {
+    hz         = clampf(hz * 1.3f, 0.1f, 5.0f);         // 30% faster
     g_lift_amp = clampf(g_lift_amp * 0.8f, 0.0f, 1.0f); // 20% less lift
   }
+  retime(hz);
   
-  Serial.print(F("[Leg] Gait: "));
-  Serial.print(g_speed_hz); Serial.print(F("Hz, stride="));
-  Serial.print(g_stride_amp); Serial.print(F(", lift="));
-  Serial.println(g_lift_amp);
+  LOG_I("[Leg] Gait: %.2fHz, stride=%.2f, lift=%.2f", g_speed_hz, g_stride_amp, g_lift_amp);
 }
 
 void adjustSpeed(float d) { 
-  g_speed_hz = clampf(g_speed_hz + d, 0.05f, 4.0f);
-  Serial.print(F("[Leg] Speed adjusted to "));
-  Serial.print(g_speed_hz);
-  Serial.println(F(" Hz"));
+  retime(clampf(g_speed_hz + d, 0.05f, 4.0f));
+  LOG_I("[Leg] Speed adjusted to %.2f Hz", g_speed_hz);
 }
 
 void setStride(float v) { 
@@ -280,42 +311,30 @@ void setPosture(float v) {
   g_posture = clampf(v, 0.0f, 1.0f);
 }
 
-// ========== Command Parser ==========
-
-bool handleAction(const String& command, const String& phase) {
-  // Stop command
-  if (phase == "stop") { 
-    stop(); 
-    return true; 
-  }
-  
-  // Start/hold phase - set default gait parameters
-  if (phase == "start" || phase == "hold") {
-    g_stride_amp = 1.0f;   // Full stride
-    g_lift_amp   = 0.8f;   // 80% lift
-    g_speed_hz   = 1.0f;   // 1 Hz walking speed
-  }
-  
-  // Execute movement commands
-  if (command == "move_forward")  { walkForward(g_speed_hz);  return true; }
-  if (command == "move_backward") { walkBackward(g_speed_hz); return true; }
-  if (command == "move_left")     { turnLeft(g_speed_hz);     return true; }
-  if (command == "move_right")    { turnRight(g_speed_hz);    return true; }
-  if (command == "stop")          { stop();                   return true; }
-  
-  // Unknown command
-  return false;
+const Tuning& tuning() { return g_tuning; }
+
+void setTuning(const Tuning& t) {
+  g_tuning.hipXScale  = clampf(t.hipXScale,  0.0f, 80.0f);
+  g_tuning.hipYScale  = clampf(t.hipYScale,  0.0f, 80.0f);
+  g_tuning.kneeScale  = clampf(t.kneeScale,  0.0f, 80.0f);
+  g_tuning.ankleScale = clampf(t.ankleScale, 0.0f, 80.0f);
+  g_tuning.footScale  = clampf(t.footScale,  0.0f, 80.0f);
+  g_tuning.liftExp    = clampf(t.liftExp,    0.2f, 5.0f);
+  g_tuning.turnInner  = clampf(t.turnInner,  0.0f, 2.0f);
+  g_tuning.turnOuter  = clampf(t.turnOuter,  0.0f, 2.0f);
 }
 
 // ========== Main Update Loop ==========
 
 void tick() {
   if (!SB) return;
+  PERF_SCOPE(LEG_TICK);
+  TRACE_MARK(MOTION);
 
   // If idle, maintain neutral stance
   if (g_mode == IDLE) {
-    writeRightLeg(0.0f, 0.0f, g_posture);
-    writeLeftLeg(0.0f, 0.0f, g_posture);
+    g_phase = 0.0f;
+    writeNeutral(g_posture);
     return;
   }
 
@@ -324,38 +343,12 @@ void tick() {
   const float t = (now - g_t0_ms) / 1000.0f;  // Time in seconds
   const float cycle = t * g_speed_hz;         // Number of cycles completed
   float phase = cycle - floorf(cycle);        // Current phase (0.0 - 1.0)
-
-  // Generate gait signals for each leg
-  float swingR = 0, liftR = 0;
-  float swingL = 0, liftL = 0;
-
-  // Left leg is 180° out of phase with right leg
-  float phaseL = phase + 0.5f;
-  if (phaseL >= 1.0f) phaseL -= 1.0f;
-
-  gaitWave(phase,  swingR, liftR);
-  gaitWave(phaseL, swingL, liftL);
-
-  // Modify gait based on current mode
-  if (g_mode == WALK_BWD) {
-    // Reverse swing direction for backward walking
-    swingR = -swingR;
-    swingL = -swingL;
-  }
-  else if (g_mode == TURN_L) {
-    // Reduce left leg swing, increase right leg swing
-    swingL *= 0.6f;
-    swingR *= 1.2f;
-  } 
-  else if (g_mode == TURN_R) {
-    // Increase left leg swing, reduce right leg swing
-    swingL *= 1.2f;
-    swingR *= 0.6f;
-  }
+  g_phase = phase;
 
   // Write calculated positions to servos
-  writeRightLeg(swingR, liftR, g_posture);
-  writeLeftLeg (swingL, liftL, g_posture);
+  Pose p;
+  solve(g_tuning, currentGait(g_posture), g_mode, phase, p);
+  writePose(p);
 }
 
 // ========== State Query Functions ==========
@@ -365,5 +358,6 @@ float speedHz()    { return g_speed_hz; }
 float strideAmp()  { return g_stride_amp; }
 float liftAmp()    { return g_lift_amp; }
 float posture01()  { return g_posture; }
+float phase01()    { return g_phase; }
 
 } // namespace Leg
\ No newline at end of file
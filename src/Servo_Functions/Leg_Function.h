@@ -32,6 +32,43 @@ enum Mode : uint8_t {
   TURN_R         // Turning right (rotating in place)
 };
 
+// Gait character for setGait(): RUN is 30% faster with 20% less lift
+enum Pace : uint8_t {
+  PACE_WALK = 0,
+  PACE_RUN
+};
+
+// ========== Gait Tuning ==========
+// Shape of the gait wave: per-joint amplitude scales (degrees per unit
+// stride or lift), lift peak sharpness and turn swing multipliers.
+// Loaded at runtime with GAIT_TUNE; the host optimizer (opt/) searches it.
+struct Tuning {
+  float hipXScale  = 50.0f;   // Hip X swing range (forward/back)
+  float hipYScale  = 35.0f;   // Hip Y lift range (up/down)
+  float kneeScale  = 35.0f;   // Knee bend range
+  float ankleScale = 25.0f;   // Ankle rotation range
+  float footScale  = 20.0f;   // Foot lift height
+  float liftExp    = 1.2f;    // Lift curve exponent (higher = shorter swing)
+  float turnInner  = 0.6f;    // Swing multiplier on the inside leg of a turn
+  float turnOuter  = 1.2f;    // Swing multiplier on the outside leg of a turn
+};
+
+// Gait amplitudes and stance height (all 0..1)
+struct Gait {
+  float stride  = 1.0f;
+  float lift    = 0.8f;
+  float posture = 0.5f;
+};
+
+// Joint order within Pose
+enum Joint : uint8_t { HIP_X = 0, HIP_Y, KNEE, ANKLE, FOOT, JOINT_COUNT };
+
+// Commanded joint angles (degrees) for both legs
+struct Pose {
+  float right[JOINT_COUNT];
+  float left[JOINT_COUNT];
+};
+
 // ========== Initialization ==========
 // Initialize leg servos with ServoBus (GPIO control)
 // Must be called before any other leg functions
@@ -46,13 +83,21 @@ void stop();
 void emergencyStop();
 
 // ========== Gait Parameter Tuning ==========
-void setGait(float speed_hz, float stride_amp, float lift_amp, const String& mode = "walk");
+void setGait(float speed_hz, float stride_amp, float lift_amp, Pace pace = PACE_WALK);
 void adjustSpeed(float delta_hz);
 void setStride(float value01);
 void setPosture(float level01);
 
-// ========== Command Parsing Helper ==========
-bool handleAction(const String& command, const String& phase);
+const Tuning& tuning();
+void setTuning(const Tuning& t);
+
+// ========== Gait Kernel ==========
+// Joint angles for a mode at a right-leg phase (0..1). Pure: reads only
+// its arguments, so host tools can evaluate it from many threads.
+void solve(const Tuning& t, const Gait& g, Mode m, float phase01, Pose& out);
+
+// Angle limits each joint is attached with
+const ServoLimits& limits(Joint j);
 
 // ========== Main Update Loop ==========
 void tick();
@@ -63,5 +108,6 @@ float speedHz();     // Current walking speed in Hz
 float strideAmp();   // Current stride amplitude (0.0 - 1.0)
 float liftAmp();     // Current foot lift amplitude (0.0 - 1.0)
 float posture01();   // Current posture level (0.0 - 1.0)
+float phase01();     // Right-leg gait phase of the last tick (0.0 - 1.0)
 
 } // namespace Leg
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Neck_Function.h"
+#include "../Log.h"
 
 namespace Neck {
 
@@ -27,7 +28,7 @@ void begin(ServoBus* bus, const Map& map) {
   CH = map;
   
   if (!SB) {
-    Serial.println(F("[Neck] ERROR: ServoBus is nullptr!"));
+    LOG_E("[Neck] ERROR: ServoBus is nullptr!");
     return;
   }
   
@@ -37,8 +38,7 @@ void begin(ServoBus* bus, const Map& map) {
   // Move to neutral position
   SB->writeDegrees(CH.yaw, NEUTRAL_YAW_DEG);
   
-  Serial.print(F("[Neck] Initialized on PCA9685 channel "));
-  Serial.println(CH.yaw);
+  LOG_D("[Neck] Initialized on channel %u", CH.yaw);
 }
 
 // ========== Primary Control Functions ==========
@@ -102,7 +102,7 @@ void center() {
   
   SB->writeDegrees(CH.yaw, NEUTRAL_YAW_DEG);
   
-  Serial.println(F("[Neck] Centered"));
+  LOG_I("[Neck] Centered");
 }
 
 } // namespace Neck
\ No newline at end of file
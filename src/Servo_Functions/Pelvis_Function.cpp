@@ -1,4 +1,5 @@
 #include "Pelvis_Function.h"
+#include "../Log.h"
 
 namespace Pelvis {
 
@@ -38,7 +39,7 @@ void begin(ServoBus* bus, const Map& map) {
   CH = map;
   
   if (!SB) {
-    Serial.println(F("[Pelvis] ERROR: ServoBus is nullptr!"));
+    LOG_E("[Pelvis] ERROR: ServoBus is nullptr!");
     return;
   }
   
@@ -49,8 +50,7 @@ void begin(ServoBus* bus, const Map& map) {
   currentAngleDeg = NEUTRAL_ROLL_DEG;
   SB->writeDegrees(CH.roll, currentAngleDeg);
   
-  Serial.print(F("[Pelvis] Initialized on PCA9685 channel "));
-  Serial.println(CH.roll);
+  LOG_D("[Pelvis] Initialized on channel %u", CH.roll);
 }
 
 // ========== Primary Control Functions ==========
@@ -101,7 +101,7 @@ void center() {
   currentAngleDeg = NEUTRAL_ROLL_DEG;
   SB->writeDegrees(CH.roll, currentAngleDeg);
   
-  Serial.println(F("[Pelvis] Centered"));
+  LOG_I("[Pelvis] Centered");
 }
 
 // Nudge pelvis by relative angle in degrees
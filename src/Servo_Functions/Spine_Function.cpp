@@ -1,4 +1,5 @@
 #include "Spine_Function.h"
+#include "../Log.h"
 
 namespace Spine {
 
@@ -33,7 +34,7 @@ void begin(ServoBus* bus, const Map& map) {
   CH = map;
   
   if (!SB) {
-    Serial.println(F("[Spine] ERROR: ServoBus is nullptr!"));
+    LOG_E("[Spine] ERROR: ServoBus is nullptr!");
     return;
   }
   
@@ -43,8 +44,7 @@ void begin(ServoBus* bus, const Map& map) {
   // Move to neutral position
   SB->writeDegrees(CH.spineYaw, NEUTRAL_YAW_DEG);
   
-  Serial.print(F("[Spine] Initialized on PCA9685 channel "));
-  Serial.println(CH.spineYaw);
+  LOG_D("[Spine] Initialized on channel %u", CH.spineYaw);
 }
 
 // ========== Primary Control Functions ==========
@@ -53,14 +53,14 @@ void begin(ServoBus* bus, const Map& map) {
 void left() { 
   if (!SB) return;
   SB->writeDegrees(CH.spineYaw, UI_MIN_DEG);
-  Serial.println(F("[Spine] Twisted left"));
+  LOG_I("[Spine] Twisted left");
 }
 
 // Twist spine fully right
 void right() { 
   if (!SB) return;
   SB->writeDegrees(CH.spineYaw, UI_MAX_DEG);
-  Serial.println(F("[Spine] Twisted right"));
+  LOG_I("[Spine] Twisted right");
 }
 
 // Set spine position using normalized 0.0-1.0 input
@@ -110,7 +110,7 @@ void nudgeYawDeg(float delta) {
 void center() {
   if (!SB) return;
   SB->writeDegrees(CH.spineYaw, NEUTRAL_YAW_DEG);
-  Serial.println(F("[Spine] Centered"));
+  LOG_I("[Spine] Centered");
 }
 
 } // namespace Spine
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "Tail_Function.h"
+#include "../Log.h"
+#include "../Perf.h"
 
 namespace Tail {
 
@@ -33,7 +35,7 @@ void begin(ServoBus* bus, const Map& map) {
   CH = map;
   
   if (!SB) {
-    Serial.println(F("[Tail] ERROR: ServoBus is nullptr!"));
+    LOG_E("[Tail] ERROR: ServoBus is nullptr!");
     return;
   }
   
@@ -43,8 +45,7 @@ void begin(ServoBus* bus, const Map& map) {
   // Move to neutral position (straight behind)
   SB->writeDegrees(CH.wag, NEUTRAL_YAW_DEG);
   
-  Serial.print(F("[Tail] Initialized on PCA9685 channel "));
-  Serial.println(CH.wag);
+  LOG_D("[Tail] Initialized on channel %u", CH.wag);
 }
 
 // ========== Primary Control Functions ==========
@@ -67,8 +68,9 @@ void set(float amt01) {
 // Great for showing excitement or friendliness
 void wag() {
   if (!SB) return;
+  PERF_SCOPE(ANIMATION);
   
-  Serial.println(F("[Tail] Wagging!"));
+  LOG_I("[Tail] Wagging!");
   
   for (int i = 0; i < 3; ++i) {
     // Swing right
@@ -122,7 +124,7 @@ void nudgeYawDeg(float delta) {
 void center() {
   if (!SB) return;
   SB->writeDegrees(CH.wag, NEUTRAL_YAW_DEG);
-  Serial.println(F("[Tail] Centered"));
+  LOG_I("[Tail] Centered");
 }
 
 } // namespace Tail
\ No newline at end of file
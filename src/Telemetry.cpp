@@ -0,0 +1,112 @@
+#include "Telemetry.h"
+#include "CommandTable.h"
+#include "CommandRouter.h"
+#include "CommandQueue.h"
+#include "Log.h"
+#include "RexProtocol.h"
+#include "Transport.h"
+#include "Servo_Functions/Leg_Function.h"
+
+namespace Telemetry {
+
+// ---------------- Internal state ----------------
+static ServoBus*         SB = nullptr;
+static const LineReader* g_reader = nullptr;
+
+static uint16_t g_hz = 0;
+static uint32_t g_periodUs = 0;     // stream period (1e6 / hz)
+static uint32_t g_nextUs = 0;       // when the next frame is due
+
+// Latest control frame timing, from frameDone()
+static uint16_t g_framePeriodUs = 0;
+static uint16_t g_frameBusyUs = 0;
+static uint16_t g_overruns = 0;
+
+static Stats g_stats = { 0, 0 };
+
+static inline uint16_t sat16(uint32_t v) { return v > 0xFFFF ? 0xFFFF : (uint16_t)v; }
+static inline uint8_t  sat8(size_t v)    { return v > 0xFF ? 0xFF : (uint8_t)v; }
+
+static void send() {
+  RexProto::State s;
+  s.ms = millis();
+  for (uint8_t ch = 0; ch < REX_PROTO_JOINTS; ++ch) {
+    s.us[ch] = SB ? SB->lastMicroseconds(ch) : 0;
+  }
+  s.phase      = (uint16_t)(Leg::phase01() * 65535.0f);
+  s.periodUs   = g_framePeriodUs;
+  s.busyUs     = g_frameBusyUs;
+  s.overruns   = g_overruns;
+  s.legMode    = (uint8_t)Leg::mode();
+  s.flags      = CommandRouter::streaming() ? RexProto::STATE_FLAG_STREAMING : 0;
+  s.cmdQueue   = sat8(CommandQueue::depth());
+  s.logPending = sat8(Log::pending());
+  s.rxPending  = sat8(g_reader ? g_reader->pending() : 0);
+
+  uint8_t payload[RexProto::STATE_SIZE];
+  if (CommandRouter::sendFrame(RexProto::MSG_STATE, payload, RexProto::pack(s, payload))) {
+    ++g_stats.sent;
+  } else {
+    ++g_stats.dropped;
+  }
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+// TELEM [hz]  (no argument: report the current rate and counters)
+static void cmdTelem(const Args& a) {
+  Print& out = console();
+  if (a.present & 1) {
+    setRate((uint16_t)constrain(a.get(0, 0.0f), 0.0f, (float)TELEMETRY_MAX_HZ));
+  }
+  out.print(F("[Telem] rate="));
+  out.print(g_hz);
+  out.print(F(" Hz sent="));
+  out.print(g_stats.sent);
+  out.print(F(" dropped="));
+  out.println(g_stats.dropped);
+}
+
+static const CommandTable::Entry kTelemetryCommands[] = {
+  { CMD_VERB("TELEM"), cmdTelem },
+};
+
+// ---------------- Public API ----------------
+void begin(ServoBus* bus, const LineReader* reader) {
+  SB = bus;
+  g_reader = reader;
+  CommandTable::add(kTelemetryCommands);
+}
+
+void setRate(uint16_t hz) {
+  if (hz > TELEMETRY_MAX_HZ) hz = TELEMETRY_MAX_HZ;
+  g_hz = hz;
+  g_periodUs = hz ? 1000000UL / hz : 0;
+  g_nextUs = micros();
+}
+
+uint16_t rate() { return g_hz; }
+
+void frameDone(uint32_t periodUs, uint32_t busyUs, uint32_t overruns) {
+  g_framePeriodUs = sat16(periodUs);
+  g_frameBusyUs   = sat16(busyUs);
+  g_overruns      = (uint16_t)overruns;
+}
+
+void poll() {
+  if (!g_hz) return;
+
+  const uint32_t now = micros();
+  if ((int32_t)(now - g_nextUs) < 0) return;
+
+  // Keep the grid; after a long stall restart it rather than burst
+  g_nextUs += g_periodUs;
+  if ((int32_t)(now - g_nextUs) >= 0) g_nextUs = now + g_periodUs;
+
+  send();
+}
+
+const Stats& stats() { return g_stats; }
+
+} // namespace Telemetry
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include "ServoBus.h"
+#include "LineReader.h"
+
+// ========== Telemetry Configuration ==========
+// Highest accepted stream rate
+#ifndef TELEMETRY_MAX_HZ
+#define TELEMETRY_MAX_HZ 200
+#endif
+
+namespace Telemetry {
+
+// ========== Stream ==========
+// Periodic MSG_STATE frames (see RexProtocol.h): joint pulses, gait phase
+// and control loop timing. Off by default; "TELEM <hz>" sets the rate and
+// "TELEM 0" stops it. tools/rextelem.py records the stream to CSV.
+
+// Register the TELEM verb. bus supplies the commanded pulses and reader
+// the RX backlog.
+void begin(ServoBus* bus, const LineReader* reader);
+
+// 0 = off, clamped to TELEMETRY_MAX_HZ
+void     setRate(uint16_t hz);
+uint16_t rate();
+
+// Report the control frame that just ran: time since the previous frame
+// started, time it took, and the total overrun count.
+void frameDone(uint32_t periodUs, uint32_t busyUs, uint32_t overruns);
+
+// Call every loop pass; sends a frame when one is due. Frames the TX
+// buffer cannot take are dropped, never waited for.
+void poll();
+
+// ========== Statistics ==========
+struct Stats {
+  uint32_t sent;
+  uint32_t dropped;
+};
+const Stats& stats();
+
+} // namespace Telemetry
@@ -0,0 +1,115 @@
+#include "Trace.h"
+#include "CommandTable.h"
+#include "Transport.h"
+
+namespace Trace {
+
+// ---------------- Internal state ----------------
+static uint32_t  g_rxCycles = 0;             // last Serial pickup
+static uint32_t  g_stamp[STAGE_COUNT];       // cycle stamps of the open trace
+static int8_t    g_last = -1;                // last stamped stage, -1 = no trace
+static Histogram g_hist[STAGE_COUNT];
+static uint32_t  g_completed = 0;
+static uint32_t  g_abandoned = 0;
+
+static const char* const kStageNames[STAGE_COUNT] = {
+  "RX->COMMIT", "RX->LINE", "LINE->PARSE", "PARSE->DISPATCH", "DISPATCH->MOTION", "MOTION->COMMIT",
+};
+
+static void close() {
+  for (uint8_t s = LINE; s < STAGE_COUNT; ++s) {
+    g_hist[s].record(Cycles::toNs(g_stamp[s] - g_stamp[s - 1]));
+  }
+  g_hist[RX].record(Cycles::toNs(g_stamp[COMMIT] - g_stamp[RX]));
+  ++g_completed;
+  g_last = -1;
+}
+
+// ---------------- Trace points ----------------
+void rx() {
+  g_rxCycles = Cycles::now();
+}
+
+void start() {
+  if (g_last >= DISPATCH) {
+    // A dispatched command waiting for its servo write keeps the slot
+    // (commands usually arrive in bursts) until it times out
+    const uint32_t waited = Cycles::now() - g_stamp[DISPATCH];
+    if (waited < (uint32_t)TRACE_TIMEOUT_MS * 1000u * Cycles::perUs()) return;
+  }
+  if (g_last >= 0) ++g_abandoned;
+  g_stamp[RX]   = g_rxCycles;
+  g_stamp[LINE] = Cycles::now();
+  g_last = LINE;
+}
+
+void mark(Stage stage) {
+  if (g_last < 0 || (int8_t)stage <= g_last) return;
+  // Motion updates and servo writes only count once the command ran
+  if (stage >= MOTION && g_last < DISPATCH) return;
+
+  const uint32_t now = Cycles::now();
+  for (int8_t s = g_last + 1; s < (int8_t)stage; ++s) g_stamp[s] = g_stamp[g_last];
+  g_stamp[stage] = now;
+  g_last = stage;
+
+  if (stage == COMMIT) close();
+}
+
+// ---------------- Results ----------------
+const Histogram& histogram(Stage stage) { return g_hist[stage < STAGE_COUNT ? stage : RX]; }
+const char*      stageName(Stage stage) { return kStageNames[stage < STAGE_COUNT ? stage : RX]; }
+
+uint32_t completed() { return g_completed; }
+uint32_t abandoned() { return g_abandoned; }
+
+void reset() {
+  for (uint8_t s = 0; s < STAGE_COUNT; ++s) g_hist[s].reset();
+  g_completed = 0;
+  g_abandoned = 0;
+  g_last = -1;
+}
+
+// ---------------- Commands ----------------
+using CommandTable::Args;
+
+static void printUs(uint32_t ns) {
+  Print& out = console();
+  out.print(' ');
+  out.print(ns / 1000.0f, 1);
+}
+
+// TRACE: per-stage latency in µs (count, min, p50, p99, max)
+static void cmdTrace(const Args&) {
+  Print& out = console();
+  out.print(F("[Trace] completed="));
+  out.print(g_completed);
+  out.print(F(" abandoned="));
+  out.println(g_abandoned);
+  out.println(F("  stage: n min p50 p99 max (us)"));
+
+  for (uint8_t s = LINE; s <= STAGE_COUNT; ++s) {
+    const Stage st = (s == STAGE_COUNT) ? RX : (Stage)s;   // total last
+    const Histogram& h = g_hist[st];
+    out.print(F("  "));
+    out.print(kStageNames[st]);
+    out.print(F(": "));
+    out.print(h.count());
+    printUs(h.min());
+    printUs(h.percentile(50));
+    printUs(h.percentile(99));
+    printUs(h.max());
+    out.println();
+  }
+}
+
+static const CommandTable::Entry kTraceCommands[] = {
+  { CMD_VERB("TRACE"),       cmdTrace },
+  { CMD_VERB("TRACE_RESET"), [](const Args&) { reset(); } },
+};
+
+void begin() {
+  CommandTable::add(kTraceCommands);
+}
+
+} // namespace Trace
@@ -0,0 +1,68 @@
+#pragma once
+#include <Arduino.h>
+#include "Cycles.h"
+#include "Histogram.h"
+
+// ========== Trace Configuration ==========
+// Compile the latency trace points in (1) or out (0). Disabled trace
+// points expand to nothing.
+#ifndef REX_TRACE
+#define REX_TRACE 1
+#endif
+
+// A dispatched command that changes no servo within this time is dropped
+#ifndef TRACE_TIMEOUT_MS
+#define TRACE_TIMEOUT_MS 200
+#endif
+
+#if REX_TRACE
+#define TRACE_RX()          Trace::rx()
+#define TRACE_START()       Trace::start()
+#define TRACE_MARK(stage)   Trace::mark(Trace::stage)
+#else
+#define TRACE_RX()          ((void)0)
+#define TRACE_START()       ((void)0)
+#define TRACE_MARK(stage)   ((void)0)
+#endif
+
+namespace Trace {
+
+// ========== Stages ==========
+// One command is followed from its bytes arriving to the first servo
+// pulse it changes:
+//   RX        bytes holding the line's terminator were read from Serial
+//   LINE      LineReader returned the complete line / frame
+//   PARSE     tokens or JSON parsed, verb resolved
+//   DISPATCH  handler invoked
+//   MOTION    motion module update ran (Leg::tick)
+//   COMMIT    ServoBus wrote a pulse that differs from the previous one
+// Stages a command skips (e.g. ROAR writes servos straight from its
+// handler) take the previous stage's timestamp.
+enum Stage : uint8_t { RX = 0, LINE, PARSE, DISPATCH, MOTION, COMMIT, STAGE_COUNT };
+
+// Record when Serial bytes were picked up (LineReader::poll)
+void rx();
+
+// A complete line or frame starts a new trace. Only one trace is open at
+// a time: an undispatched or timed-out one is abandoned and counted,
+// while a dispatched one still waiting for its servo write is kept.
+void start();
+
+// Stamp a stage of the open trace. The first stamp of each stage wins;
+// COMMIT closes the trace and records the per-stage latencies.
+void mark(Stage stage);
+
+// ========== Results ==========
+// Histogram of stage s is the time from the previous stage to s (index
+// RX holds the full RX -> COMMIT latency). Samples are in nanoseconds.
+const Histogram& histogram(Stage stage);
+const char*      stageName(Stage stage);
+
+uint32_t completed();
+uint32_t abandoned();
+void     reset();
+
+// Register TRACE / TRACE_RESET with CommandTable
+void begin();
+
+} // namespace Trace
@@ -0,0 +1,96 @@
+#include "Transport.h"
+
+#if defined(REX_NATIVE)
+#include "HostTransport.h"
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+// ---------------- Instances ----------------
+#if defined(REX_NATIVE)
+
+Transport& defaultTransport() {
+  // REX_TRANSPORT=pty opens a pseudo-terminal for external tools;
+  // anything else reads stdin and writes stdout
+  static HostTransport host;
+  static bool configured = false;
+  if (!configured) {
+    const char* mode = getenv("REX_TRANSPORT");
+    host.configure((mode && strcmp(mode, "pty") == 0) ? HostTransport::PTY : HostTransport::STDIO);
+    configured = true;
+  }
+  return host;
+}
+
+#elif ARDUINO_USB_CDC_ON_BOOT && !defined(REX_TRANSPORT_UART0)
+
+static PortTransport<decltype(Serial)> g_usb(Serial, "usb-cdc", 115200);
+Transport& defaultTransport() { return g_usb; }
+
+#elif ARDUINO_USB_CDC_ON_BOOT
+
+static PortTransport<decltype(Serial0)> g_uart(Serial0, "uart0", 115200);
+Transport& defaultTransport() { return g_uart; }
+
+#else
+
+static PortTransport<decltype(Serial)> g_uart(Serial, "uart0", 115200);
+Transport& defaultTransport() { return g_uart; }
+
+#endif
+
+// ---------------- Waiting for input ----------------
+bool Transport::waitForInput(uint32_t timeoutMs) {
+  const uint32_t start = millis();
+  while (!available()) {
+    if ((uint32_t)(millis() - start) >= timeoutMs) return false;
+    delay(1);
+  }
+  return true;
+}
+
+#if !defined(REX_NATIVE)
+// The driver's RX callback runs in its event task (UART) or the USB task
+// (HWCDC); either way it only notifies the waiting loop task.
+static TaskHandle_t g_rxTask = nullptr;
+
+static void rxNotify() {
+  if (g_rxTask) xTaskNotifyGive(g_rxTask);
+}
+
+bool rxNotifyOnReceive(HardwareSerial& port) {
+  g_rxTask = xTaskGetCurrentTaskHandle();
+  port.onReceive(rxNotify, false);
+  return true;
+}
+
+#if ARDUINO_USB_MODE
+static void hwcdcEvent(void*, esp_event_base_t, int32_t, void*) { rxNotify(); }
+
+bool rxNotifyOnReceive(HWCDC& port) {
+  g_rxTask = xTaskGetCurrentTaskHandle();
+  port.onEvent(ARDUINO_HW_CDC_RX_EVENT, hwcdcEvent);
+  return true;
+}
+#endif
+
+void rxClear() {
+  ulTaskNotifyTake(pdTRUE, 0);
+}
+
+void rxWait(uint32_t timeoutMs) {
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+}
+#endif
+
+// ---------------- Active transport ----------------
+static Transport* g_console = nullptr;
+
+Transport& console() {
+  if (!g_console) g_console = &defaultTransport();
+  return *g_console;
+}
+
+void setConsole(Transport& t) {
+  g_console = &t;
+}
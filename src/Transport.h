@@ -0,0 +1,110 @@
+#pragma once
+#include <Arduino.h>
+
+// ========== Transport ==========
+// Byte stream in / byte stream out for the command channel. LineReader
+// polls the active transport, and every reply, binary frame and log line
+// is written to it. Boot diagnostics from setup(), the banner included,
+// go through the log ring like any other log line and reach console()
+// once the drain writes them out.
+//
+// Implementations:
+//   PortTransport<HWCDC / HardwareSerial>   USB-CDC or UART0 on the ESP32
+//   HostTransport (REX_NATIVE builds)       stdio pipe or a pseudo-terminal
+class Transport : public Stream {
+public:
+  virtual const char* name() const = 0;
+
+  // Open the link; false if it could not be opened
+  virtual bool begin() = 0;
+
+  // Stream / Print. write() of a whole buffer should hand the bytes to the
+  // driver in one call so frames and lines from different tasks do not
+  // interleave mid-record.
+  int    available() override = 0;
+  int    read() override = 0;
+  int    peek() override = 0;
+  size_t write(const uint8_t* data, size_t len) override = 0;
+  int    availableForWrite() override = 0;
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  using Print::write;
+
+  // Block until input is waiting or timeoutMs has passed; true when there
+  // is input. Used by the idle loop (Idle.h): the default polls once per
+  // millisecond, ports override it to sleep until the driver's RX event.
+  virtual bool waitForInput(uint32_t timeoutMs);
+};
+
+#if !defined(REX_NATIVE)
+#if ARDUINO_USB_MODE
+#include <HWCDC.h>
+#endif
+
+// ---------------- RX events ----------------
+// Route a port's receive event to a notification of the calling task, so
+// waitForInput() blocks instead of polling. False if the port has no RX
+// event (the default polling wait is used then).
+bool rxNotifyOnReceive(HardwareSerial& port);
+#if ARDUINO_USB_MODE
+bool rxNotifyOnReceive(HWCDC& port);
+#endif
+template <class Port>
+bool rxNotifyOnReceive(Port&) { return false; }
+
+// Wait for the notification (or timeoutMs); pending ones from input that
+// was already read are dropped first
+void rxClear();
+void rxWait(uint32_t timeoutMs);
+#endif
+
+// ========== Arduino Serial Ports ==========
+// Thin adapter over a core serial object (HWCDC, USBCDC, HardwareSerial)
+template <class Port>
+class PortTransport : public Transport {
+public:
+  PortTransport(Port& port, const char* name, uint32_t baud)
+    : _port(port), _name(name), _baud(baud) {}
+
+  const char* name() const override { return _name; }
+
+  bool begin() override {
+    _port.begin(_baud);
+    return true;
+  }
+
+  int    available() override { return _port.available(); }
+  int    read() override { return _port.read(); }
+  int    peek() override { return _port.peek(); }
+  size_t readBytes(char* buf, size_t len) { return _port.readBytes(buf, len); }
+  size_t write(const uint8_t* data, size_t len) override { return _port.write(data, len); }
+  int    availableForWrite() override { return _port.availableForWrite(); }
+  using Transport::write;
+
+#if !defined(REX_NATIVE)
+  bool waitForInput(uint32_t timeoutMs) override {
+    if (!_rxEvent) _rxEvent = rxNotifyOnReceive(_port) ? 1 : -1;
+    if (_rxEvent < 0) return Transport::waitForInput(timeoutMs);
+    rxClear();
+    if (_port.available()) return true;
+    rxWait(timeoutMs);
+    return _port.available() > 0;
+  }
+#endif
+
+private:
+  Port&       _port;
+  const char* _name;
+  uint32_t    _baud;
+  int8_t      _rxEvent = 0;    // RX event hooked: 0 not tried, 1 yes, -1 unsupported
+};
+
+// ========== Active Transport ==========
+// Build default: USB-CDC when ARDUINO_USB_CDC_ON_BOOT, otherwise UART0.
+// -DREX_TRANSPORT_UART0 forces UART0 on CDC builds; native builds use
+// HostTransport (REX_TRANSPORT=pty|stdio in the environment).
+Transport& defaultTransport();
+
+// Where replies, frames and log lines go (defaults to defaultTransport())
+Transport& console();
+void       setConsole(Transport& t);
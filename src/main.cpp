@@ -7,6 +7,23 @@
 
 // Servo control via ESP32 GPIO
 #include "ServoBus.h"
+#include "LineReader.h"
+#include "CommandTable.h"
+#include "CommandRouter.h"
+#include "CommandQueue.h"
+#include "Log.h"
+#include "Telemetry.h"
+#include "Trace.h"
+#include "Perf.h"
+#include "Recorder.h"
+#include "Boot.h"
+#include "Calibration.h"
+#include "Choreo.h"
+#include "Mem.h"
+#include "Idle.h"
+#include "I2cBus.h"
+#include "Imu.h"
+#include "Transport.h"
 #include "Servo_Functions/Neck_Function.h"
 #include "Servo_Functions/Head_Function.h"
 #include "Servo_Functions/Pelvis_Function.h"
@@ -16,7 +33,17 @@
 
 // ========== Global Variables ==========
 static ServoBus servoBus;  // ESP32 GPIO servo controller
-static String g_cmdBuffer;   // Serial command buffer
+static LineReader g_lineReader;  // Command line/frame assembler (fixed buffers)
+
+// ========== Control Frame Clock ==========
+// Commands are polled every pass; motion runs on a fixed CONTROL_PERIOD_MS grid
+// so scheduled commands land on a predictable frame.
+struct FrameClock {
+  uint32_t nextMs   = 0;   // start time of the next control frame
+  uint32_t frames   = 0;   // control frames run
+  uint32_t overruns = 0;   // frames started more than one period late
+  uint32_t startUs  = 0;   // micros() at the start of the last frame
+} g_frame;
 
 // ========== Sweep Test Configuration ==========
 #define ENABLE_SWEEP_TEST false
@@ -44,6 +71,7 @@ static inline void sweepAllTick() {
   const uint32_t now = millis();
   if (now - g_sweep.lastMs < g_sweep.intervalMs) return;
   g_sweep.lastMs = now;
+  PERF_SCOPE(ANIMATION);
 
   for (uint8_t ch : kAllCh) {
     servoBus.writeDegrees(ch, g_sweep.posDeg);
@@ -60,187 +88,288 @@ static inline void sweepAllTick() {
   }
 }
 
-// ========== Command Parser ==========
-static void handleCommand(const String& line) {
-  if (!line.length()) return;
-  
-  Serial.print(F("[CMD] RX: "));
-  Serial.println(line);
-  
-  // Neck
-  if (line == "LOOK_LEFT") {
-    Neck::lookLeft(1.0);
+// Anything that needs control frames keeps the robot out of idle mode
+static bool needsFrames() {
+  return g_sweep.enabled || Leg::mode() != Leg::IDLE || CommandRouter::streaming() ||
+         Choreo::playing() || CommandQueue::depth() || Telemetry::rate() || servoBus.slewing();
+}
+
+// ========== Command Handlers ==========
+using CommandTable::Args;
+
+static void cmdSweepOn(const Args&) {
+  g_sweep.enabled = true;
+  g_sweep.posDeg = g_sweep.minDeg;
+  g_sweep.dir = +1;
+  LOG_I("[CMD] Sweep test ENABLED");
+}
+
+static void cmdSweepOff(const Args&) {
+  g_sweep.enabled = false;
+  LOG_I("[CMD] Sweep test DISABLED");
+}
+
+static void cmdCenterAll(const Args&) {
+  Neck::center();
+  Head::center();
+  Pelvis::center();
+  Spine::center();
+  Tail::center();
+  Leg::stop();
+}
+
+// GAIT_TUNE <key> <value> sets one gait shape parameter; with no
+// arguments it prints the current set as loadable GAIT_TUNE lines.
+static const struct {
+  const char* key;
+  float Leg::Tuning::* field;
+} kGaitTuneKeys[] = {
+  { "hipx",  &Leg::Tuning::hipXScale },
+  { "hipy",  &Leg::Tuning::hipYScale },
+  { "knee",  &Leg::Tuning::kneeScale },
+  { "ankle", &Leg::Tuning::ankleScale },
+  { "foot",  &Leg::Tuning::footScale },
+  { "exp",   &Leg::Tuning::liftExp },
+  { "inner", &Leg::Tuning::turnInner },
+  { "outer", &Leg::Tuning::turnOuter },
+};
+
+static void cmdGaitTune(const Args& a) {
+  Leg::Tuning t = Leg::tuning();
+  if (a.word.len) {
+    for (const auto& k : kGaitTuneKeys) {
+      if (!a.word.equals(k.key)) continue;
+      t.*k.field = a.get(0, t.*k.field);
+      Leg::setTuning(t);
+      return;
+    }
+    LOG_W("[CMD] GAIT_TUNE: unknown key %s", Log::text(a.word.ptr, a.word.len));
+    return;
   }
-  else if (line == "LOOK_RIGHT") {
-    Neck::lookRight(1.0);
+
+  Print& out = console();
+  for (const auto& k : kGaitTuneKeys) {
+    out.print(F("GAIT_TUNE "));
+    out.print(k.key);
+    out.print(' ');
+    out.println(t.*k.field, 3);
   }
-  else if (line == "LOOK_CENTER") {
-    Neck::center();
+}
+
+// POWER prints the servo current estimate; POWER_BUDGET <mA> sets the
+// scheduler's cap (0 = off)
+static void cmdPower(const Args&) {
+  Print& out = console();
+  const ServoCurrentStats& cs = servoBus.currentStats();
+  out.print(F("[Power] now "));
+  out.print(cs.nowMa);
+  out.print(F(" mA, peak "));
+  out.print(cs.peakMa);
+  out.print(F(" mA ("));
+  out.print(cs.unlimitedPeakMa);
+  out.print(F(" mA unslewed), budget "));
+  if (servoBus.currentBudget()) {
+    out.print(servoBus.currentBudget());
+    out.println(F(" mA"));
+  } else {
+    out.println(F("off"));
+  }
+  out.print(F("[Power] "));
+  out.print(cs.frames);
+  out.print(F(" frames, "));
+  out.print(cs.limited);
+  out.print(F(" slewed, "));
+  out.print(cs.over);
+  out.println(F(" over budget"));
+}
+
+static void cmdPowerBudget(const Args& a) {
+  if (!(a.present & 1) || a.num[0] < 0) {
+    LOG_W("[CMD] POWER_BUDGET needs <mA> (0 = off)");
+    return;
   }
-  
+  servoBus.setCurrentBudget((uint32_t)a.num[0]);
+  LOG_I("[CMD] Servo current budget %lu mA", (unsigned long)servoBus.currentBudget());
+}
+
+static void cmdStatus(const Args&) {
+  Print& out = console();
+  out.println(F("[CMD] System Status:"));
+  out.print(F("  Transport: "));
+  out.println(console().name());
+  out.print(F("  Sweep enabled: "));
+  out.println(g_sweep.enabled ? "YES" : "NO");
+  if (g_sweep.enabled) {
+    out.print(F("  Sweep position: "));
+    out.print(g_sweep.posDeg);
+    out.println(F(" deg"));
+  }
+  out.print(F("  Control frames: "));
+  out.print(g_frame.frames);
+  out.print(F(" ("));
+  out.print(g_frame.overruns);
+  out.println(F(" overruns)"));
+  static const char* const kPcaLink[] = { "answering", "missing", "starting" };
+  const PcaLinkStats& pl = servoBus.pcaLinkStats();
+  out.print(F("  PCA9685: "));
+  out.print(kPcaLink[servoBus.pcaLink()]);
+  out.print(F(", "));
+  out.print(pl.losses);
+  out.print(F(" lost, "));
+  out.print(pl.resets);
+  out.print(F(" reset, "));
+  out.print(pl.reconnects);
+  out.print(F(" restored (last after "));
+  out.print(pl.lastOutageMs);
+  out.print(F(" ms, in "));
+  out.print(pl.lastRestoreUs);
+  out.println(F(" us)"));
+  out.print(F("  Leg mode: "));
+  out.println(Leg::mode());
+  out.print(F("  Speed: "));
+  out.print(Leg::speedHz());
+  out.println(F(" Hz"));
+
+  const CommandRouter::ProtoStats& ps = CommandRouter::protoStats();
+  out.print(F("  Binary frames: "));
+  out.print(ps.frames);
+  out.print(F(" ok, "));
+  out.print(ps.errors);
+  out.print(F(" bad, "));
+  out.print(ps.seqGaps);
+  out.print(F(" lost, "));
+  out.print(ps.duplicates);
+  out.print(F(" repeated, streaming="));
+  out.println(CommandRouter::streaming() ? "YES" : "NO");
+
+  const CommandRouter::CoalesceStats& cs = CommandRouter::coalesceStats();
+  out.print(F("  JSON commands: "));
+  out.print(cs.received);
+  out.print(F(" received, "));
+  out.print(cs.applied);
+  out.print(F(" applied, "));
+  out.print(cs.superseded);
+  out.println(F(" superseded"));
+
+  const Log::Stats ls = Log::stats();
+  out.print(F("  Log: "));
+  out.print(ls.written);
+  out.print(F(" written, "));
+  out.print(ls.dropped);
+  out.print(F(" dropped, peak "));
+  out.print(ls.highWater);
+  out.print(F("/"));
+  out.println(LOG_RING_SIZE);
+}
+
+static void cmdHelp(const Args&) {
+  Print& out = console();
+  out.println(F("\n[CMD] Available Commands:"));
+  out.println(F("  Neck:   LOOK_LEFT, LOOK_RIGHT, LOOK_CENTER"));
+  out.println(F("  Head:   JAW_OPEN, JAW_CLOSE, ROAR, SNAP"));
+  out.println(F("          HEAD_UP, HEAD_DOWN"));
+  out.println(F("  Pelvis: PELVIS_LEFT, PELVIS_RIGHT, PELVIS_CENTER"));
+  out.println(F("  Spine:  SPINE_LEFT, SPINE_RIGHT, SPINE_CENTER"));
+  out.println(F("  Tail:   TAIL_WAG, TAIL_CENTER"));
+  out.println(F("  Legs:   WALK_FORWARD, WALK_BACKWARD"));
+  out.println(F("          TURN_LEFT, TURN_RIGHT, STOP"));
+  out.println(F("          GAIT_TUNE [<key> <value>]"));
+  out.println(F("  System: CENTER_ALL, ALL_OFF, STATUS, BOOT, MEM, HELP"));
+  out.println(F("          I2C, I2C_RESET, IMU"));
+  out.println(F("  Power:  POWER, POWER_BUDGET <mA> (0 = off), POWER_RESET"));
+  out.println(F("          IDLE [<quiet_ms> [hold|release]]"));
+  out.println(F("  Calibrate: CAL, CAL_US <ch> <min> <max>, CAL_DEG <ch> <min> <max>"));
+  out.println(F("          CAL_TRIM <ch> <us>, CAL_CLEAR <ch>, CAL_COMMIT"));
+  out.println(F("  Timing: SYNC <host_ms>, QUEUE, QUEUE_CLEAR"));
+  out.println(F("          @<device_ms> CMD, @+<delay_ms> CMD"));
+  out.println(F("  Telemetry: TELEM <hz> (0 = off)"));
+  out.println(F("  Latency: TRACE, TRACE_RESET"));
+  out.println(F("  Profile: PERF, PERF_RESET"));
+  out.println(F("  Record: REC, REC_START, REC_STOP, REC_DUMP"));
+  out.println(F("  Shows:  CHOREO, CHOREO_LIST, CHOREO_PLAY <name>, CHOREO_STOP"));
+  out.println(F("          CHOREO_DELETE <name>, CHOREO_FORMAT ERASE"));
+  out.println(F("  Test:   SWEEP_ON, SWEEP_OFF"));
+  out.println(F("  Legacy: rex_* verbs and JSON lines (see CommandRouter.h)"));
+}
+
+// ========== Command Table ==========
+// Raw verbs handled here; CommandRouter registers the rex_* verbs into the
+// same table, so every text path resolves through one O(1) lookup.
+static const CommandTable::Entry kMainCommands[] = {
+  // Neck
+  { CMD_VERB("LOOK_LEFT"),     [](const Args&) { Neck::lookLeft(1.0); } },
+  { CMD_VERB("LOOK_RIGHT"),    [](const Args&) { Neck::lookRight(1.0); } },
+  { CMD_VERB("LOOK_CENTER"),   [](const Args&) { Neck::center(); } },
+
   // Head/Jaw
-  else if (line == "JAW_OPEN") {
-    Head::mouthOpen();
-  }
-  else if (line == "JAW_CLOSE") {
-    Head::mouthClose();
-  }
-  else if (line == "ROAR") {
-    Head::roar();
-  }
-  else if (line == "SNAP") {
-    Head::snap();
-  }
-  else if (line == "HEAD_UP") {
-    Head::lookUp(1.0);
-  }
-  else if (line == "HEAD_DOWN") {
-    Head::lookDown(1.0);
-  }
-  
+  { CMD_VERB("JAW_OPEN"),      [](const Args&) { Head::mouthOpen(); } },
+  { CMD_VERB("JAW_CLOSE"),     [](const Args&) { Head::mouthClose(); } },
+  { CMD_VERB("ROAR"),          [](const Args&) { Head::roar(); } },
+  { CMD_VERB("SNAP"),          [](const Args&) { Head::snap(); } },
+  { CMD_VERB("HEAD_UP"),       [](const Args&) { Head::lookUp(1.0); } },
+  { CMD_VERB("HEAD_DOWN"),     [](const Args&) { Head::lookDown(1.0); } },
+
   // Pelvis
-  else if (line == "PELVIS_LEFT") {
-    Pelvis::setRoll01(0.0);
-  }
-  else if (line == "PELVIS_RIGHT") {
-    Pelvis::setRoll01(1.0);
-  }
-  else if (line == "PELVIS_CENTER") {
-    Pelvis::center();
-  }
-  
+  { CMD_VERB("PELVIS_LEFT"),   [](const Args&) { Pelvis::setRoll01(0.0); } },
+  { CMD_VERB("PELVIS_RIGHT"),  [](const Args&) { Pelvis::setRoll01(1.0); } },
+  { CMD_VERB("PELVIS_CENTER"), [](const Args&) { Pelvis::center(); } },
+
   // Spine
-  else if (line == "SPINE_LEFT") {
-    Spine::left();
-  }
-  else if (line == "SPINE_RIGHT") {
-    Spine::right();
-  }
-  else if (line == "SPINE_CENTER") {
-    Spine::center();
-  }
-  
+  { CMD_VERB("SPINE_LEFT"),    [](const Args&) { Spine::left(); } },
+  { CMD_VERB("SPINE_RIGHT"),   [](const Args&) { Spine::right(); } },
+  { CMD_VERB("SPINE_CENTER"),  [](const Args&) { Spine::center(); } },
+
   // Tail
-  else if (line == "TAIL_WAG") {
-    Tail::wag();
-  }
-  else if (line == "TAIL_CENTER") {
-    Tail::center();
-  }
-  
+  { CMD_VERB("TAIL_WAG"),      [](const Args&) { Tail::wag(); } },
+  { CMD_VERB("TAIL_CENTER"),   [](const Args&) { Tail::center(); } },
+
   // Legs
-  else if (line == "WALK_FORWARD") {
-    Leg::walkForward(1.0);
-  }
-  else if (line == "WALK_BACKWARD") {
-    Leg::walkBackward(1.0);
-  }
-  else if (line == "TURN_LEFT") {
-    Leg::turnLeft(0.8);
-  }
-  else if (line == "TURN_RIGHT") {
-    Leg::turnRight(0.8);
-  }
-  else if (line == "STOP") {
-    Leg::stop();
-  }
-  
+  { CMD_VERB("WALK_FORWARD"),  [](const Args&) { Leg::walkForward(1.0); } },
+  { CMD_VERB("WALK_BACKWARD"), [](const Args&) { Leg::walkBackward(1.0); } },
+  { CMD_VERB("TURN_LEFT"),     [](const Args&) { Leg::turnLeft(0.8); } },
+  { CMD_VERB("TURN_RIGHT"),    [](const Args&) { Leg::turnRight(0.8); } },
+  { CMD_VERB("STOP"),          [](const Args&) { Leg::stop(); } },
+  { CMD_VERB("GAIT_TUNE"),     cmdGaitTune },
+
   // System
-  else if (line == "CENTER_ALL") {
-    Neck::center();
-    Head::center();
-    Pelvis::center();
-    Spine::center();
-    Tail::center();
-    Leg::stop();
-  }
-  else if (line == "ALL_OFF") {
-    servoBus.setAllOff();
-  }
-  else if (line == "SWEEP_ON") {
-    g_sweep.enabled = true;
-    g_sweep.posDeg = g_sweep.minDeg;
-    g_sweep.dir = +1;
-    Serial.println(F("[CMD] Sweep test ENABLED"));
-  }
-  else if (line == "SWEEP_OFF") {
-    g_sweep.enabled = false;
-    Serial.println(F("[CMD] Sweep test DISABLED"));
-  }
-  else if (line == "STATUS") {
-    Serial.println(F("[CMD] System Status:"));
-    Serial.print(F("  Sweep enabled: "));
-    Serial.println(g_sweep.enabled ? "YES" : "NO");
-    if (g_sweep.enabled) {
-      Serial.print(F("  Sweep position: "));
-      Serial.print(g_sweep.posDeg);
-      Serial.println(F(" deg"));
-    }
-    Serial.print(F("  Leg mode: "));
-    Serial.println(Leg::mode());
-    Serial.print(F("  Speed: "));
-    Serial.print(Leg::speedHz());
-    Serial.println(F(" Hz"));
-  }
-  else if (line == "HELP") {
-    Serial.println(F("\n[CMD] Available Commands:"));
-    Serial.println(F("  Neck:   LOOK_LEFT, LOOK_RIGHT, LOOK_CENTER"));
-    Serial.println(F("  Head:   JAW_OPEN, JAW_CLOSE, ROAR, SNAP"));
-    Serial.println(F("          HEAD_UP, HEAD_DOWN"));
-    Serial.println(F("  Pelvis: PELVIS_LEFT, PELVIS_RIGHT, PELVIS_CENTER"));
-    Serial.println(F("  Spine:  SPINE_LEFT, SPINE_RIGHT, SPINE_CENTER"));
-    Serial.println(F("  Tail:   TAIL_WAG, TAIL_CENTER"));
-    Serial.println(F("  Legs:   WALK_FORWARD, WALK_BACKWARD"));
-    Serial.println(F("          TURN_LEFT, TURN_RIGHT, STOP"));
-    Serial.println(F("  System: CENTER_ALL, ALL_OFF, STATUS, HELP"));
-    Serial.println(F("  Test:   SWEEP_ON, SWEEP_OFF"));
-  }
-  else {
-    Serial.print(F("[CMD] Unknown: "));
-    Serial.println(line);
-  }
+  { CMD_VERB("CENTER_ALL"),    cmdCenterAll },
+  { CMD_VERB("ALL_OFF"),       [](const Args&) { servoBus.setAllOff(); } },
+  { CMD_VERB("SWEEP_ON"),      cmdSweepOn },
+  { CMD_VERB("SWEEP_OFF"),     cmdSweepOff },
+  { CMD_VERB("STATUS"),        cmdStatus },
+  { CMD_VERB("POWER"),         cmdPower },
+  { CMD_VERB("POWER_BUDGET"),  cmdPowerBudget },
+  { CMD_VERB("POWER_RESET"),   [](const Args&) { servoBus.resetCurrentStats(); } },
+  { CMD_VERB("HELP"),          cmdHelp },
+};
+
+// ========== Command Parser ==========
+static void handleCommand(char* line, size_t len) {
+  if (!line || !len) return;
+  PERF_SCOPE(DISPATCH);
+
+  LOG_I("[CMD] RX: %s", Log::text(line, len));
+
+  Recorder::inputLine(line, len);
+  CommandRouter::handleLine(line, len);
+  Recorder::servoFrame();
 }
 
 // ========== Arduino Setup ==========
+// Servos first: the robot holds its neutral stance before setup() touches
+// the console, so a reset (e.g. a brownout) leaves it limp only for the
+// servo bring-up itself. Phase times are kept for the BOOT command.
 void setup() {
+  Boot::mark(Boot::SETUP);
+
   // Setup onboard LED for visual feedback (GPIO 48 on Freenove S3)
   pinMode(48, OUTPUT);
   digitalWrite(48, HIGH);  // LED ON to show power
 
-  // Initialize serial with longer delay for ESP32-S3 + CH340
-  Serial.begin(115200);
-  delay(2000);  // Increased delay for CH340 stability
-
-  // Wait for serial connection (with timeout)
-  unsigned long startWait = millis();
-  while (!Serial && (millis() - startWait < 3000)) {
-    delay(10);
-  }
-
-  // Basic bring-up heartbeat so the monitor always shows activity
-  Serial.println(F("Hello World! Serial link is active."));
-
-  Serial.println();
-  Serial.println(F("============================================"));
-  Serial.println(F("    ROBO REX - 16 SERVO HYBRID MODE"));
-  Serial.println(F("   GPIO (0-5) + PCA9685 (6-15)"));
-  Serial.println(F("============================================"));
-  Serial.println();
-
   // Initialize hybrid servo system (GPIO + PCA9685)
-  Serial.println(F("[Hybrid] Initializing servo system..."));
-  bool beginOk = servoBus.begin();
-  Serial.println(F("[Hybrid] Ready"));
-  Serial.print(F("[Hybrid] PCA9685 detected: "));
-  Serial.println(servoBus.isPcaPresent() ? F("YES") : F("NO"));
-  if (!beginOk) {
-    Serial.println(F("[Hybrid] WARNING: ServoBus initialization reported an error; check PCA9685 wiring"));
-  }
-
-  // Initialize servo functions
-  Serial.println(F("\n[Servos] Initializing 16 servos..."));
-  Serial.println(F("  Channels 0-5:  GPIO direct control"));
-  Serial.println(F("  Channels 6-15: PCA9685 I2C driver"));
+  const bool beginOk = servoBus.begin();
+  Calibration::begin(&servoBus);   // stored trims apply to the first stance
+  Boot::mark(Boot::SERVO_BUS);
 
   // Neck (1 servo - channel 0 -> GPIO 1)
   Neck::Map neckMap;
@@ -284,13 +413,42 @@ void setup() {
   legMap.L_foot  = 15;  // channel 15 -> PCA9685 port 9
   Leg::begin(&servoBus, legMap);
 
-  Serial.println(F("[Servos] All 16 servos initialized"));
+  // Command registry: raw verbs here, rex_* verbs and JSON via CommandRouter
+  // (which also sets the pelvis and spine to their mid positions)
+  CommandTable::add(kMainCommands);
+  CommandRouter::begin(&servoBus);
+  CommandQueue::begin();
+  Telemetry::begin(&servoBus, &g_lineReader);
+  Trace::begin();
+  Perf::begin();
+  Recorder::begin(&servoBus);
+  Choreo::begin(&servoBus);
+  Idle::begin(&servoBus);
+  I2cBus::begin();
+  Imu::begin();   // FIFO reads on the IMU bus, in its own worker
 
   // Explicitly attach all servos for sweep test
-  Serial.println(F("\n[Attach] Attaching all 16 servo channels..."));
   for (uint8_t ch = 0; ch < 16; ch++) {
     servoBus.attach(ch);  // Attach with default limits
   }
+  Boot::mark(Boot::POSE);
+
+  // Serial and the command channel (USB-CDC, UART0 or the host stand-in).
+  // Output from here on goes through the log ring, which the drain task
+  // writes out in the background once a host is listening.
+  Serial.begin(115200);
+#if !REX_FAST_BOOT
+  delay(2000);  // Increased delay for CH340 stability
+
+  // Wait for serial connection (with timeout)
+  unsigned long startWait = millis();
+  while (!Serial && (millis() - startWait < 3000)) {
+    delay(10);
+  }
+#endif
+  const bool consoleOk = console().begin();
+  Log::begin();
+  Boot::mark(Boot::CONSOLE);
 
   uint8_t gpioAttached = 0;
   uint8_t pcaAttached  = 0;
@@ -304,64 +462,132 @@ void setup() {
     }
   }
 
-  Serial.print(F("[Attach] GPIO channels attached: "));
-  Serial.print(gpioAttached);
-  Serial.println(F(" / 6"));
-
-  Serial.print(F("[Attach] PCA9685 channels attached: "));
-  Serial.print(pcaAttached);
-  Serial.println(F(" / 10"));
-
-  if (!servoBus.isPcaPresent()) {
-    Serial.println(F("[Attach] WARNING: PCA9685 missing - channels 6-15 will stay detached"));
+  // Banner
+  LOG_I("============================================");
+  LOG_I("    ROBO REX - 16 SERVO HYBRID MODE");
+  LOG_I("   GPIO (0-5) + PCA9685 (6-15)");
+  LOG_I("============================================");
+  if (!consoleOk) {
+    LOG_E("[Transport] ERROR: command channel failed to open");
+  }
+  LOG_I("[Transport] Commands on %s", console().name());
+  LOG_I("[Attach] GPIO channels attached: %u / 6, PCA9685 channels attached: %u / 10",
+        gpioAttached, pcaAttached);
+  if (!beginOk || !servoBus.isPcaPresent()) {
+    LOG_W("[Attach] WARNING: PCA9685 missing - channels 6-15 stay limp until it answers");
   }
 
   if (g_sweep.enabled) {
-    Serial.println();
-    Serial.println(F("============================================"));
-    Serial.println(F("  WARNING: SWEEP TEST MODE ENABLED"));
-    Serial.println(F("  All servos will sweep 10-170 degrees"));
-    Serial.println(F("  Send 'SWEEP_OFF' to disable"));
-    Serial.println(F("============================================"));
+    LOG_W("[Sweep] WARNING: SWEEP TEST MODE ENABLED - all servos sweep 10-170 degrees, send 'SWEEP_OFF' to disable");
   }
 
+  g_frame.nextMs = millis();
+  g_frame.startUs = micros();
+  Boot::mark(Boot::READY);
+  Boot::begin();
+
+  // Last in setup(): allocations from here on are steady-state regressions
+  Mem::begin();
+
   // Ready!
-  Serial.println();
-  Serial.println(F("============================================"));
-  Serial.println(F("           SYSTEM READY"));
-  Serial.println(F("============================================"));
-  Serial.println(F("Hybrid servo control mode active"));
-  Serial.println(F("  GPIO: 6 servos (channels 0-5)"));
-  Serial.println(F("  PCA9685: 10 servos (channels 6-15)"));
-  Serial.println(F("Type HELP for command list"));
-  Serial.println();
+  LOG_I("SYSTEM READY - type HELP for command list");
+}
+
+// ========== Control Frame ==========
+static void controlFrame(uint32_t frameMs) {
+  // Timestamped commands due in this frame
+  char* line;
+  size_t len;
+  while (CommandQueue::popDue(frameMs, line, len)) {
+    PERF_SCOPE(DISPATCH);
+    CommandRouter::execute(line, len);
+  }
+
+  // Apply coalesced JSON commands once per frame
+  {
+    PERF_SCOPE(DISPATCH);
+    CommandRouter::tick();
+  }
+
+  // Run a show, sweep test or leg control (streamed joint frames take precedence)
+  if (CommandRouter::streaming()) {
+    // servos hold the last streamed frame
+  } else if (Choreo::playing()) {
+    Choreo::tick();
+  } else if (g_sweep.enabled) {
+    sweepAllTick();
+  } else {
+    Leg::tick();
+  }
+
+  // Current model; slews body/aux channels when the legs leave no headroom
+  servoBus.frame();
+
+  Recorder::servoFrame();
 }
 
 // ========== Arduino Loop ==========
 void loop() {
-  // Handle serial commands
-  while (Serial.available()) {
-    char c = Serial.read();
-    if (c == '\r') continue;  // Ignore carriage return
-    if (c != '\n') {
-      g_cmdBuffer += c;
+  // Handle commands from the active transport
+  {
+    PERF_SCOPE(SERIAL_READ);
+    g_lineReader.poll(console());
+  }
+  Recorder::inputPolled();
+  char* data;
+  size_t len;
+  while (LineReader::Item item = g_lineReader.next(data, len)) {
+    Idle::activity();
+    if (item == LineReader::FRAME) {
+      PERF_SCOPE(DISPATCH);
+      Recorder::inputFrame((const uint8_t*)data, len);
+      CommandRouter::handleFrame((const uint8_t*)data, len);
+      Recorder::servoFrame();
     } else {
-      // Process complete line
-      String line = g_cmdBuffer;
-      line.trim();
-      g_cmdBuffer = "";
-      if (line.length() > 0) {
-        handleCommand(line);
-      }
+      handleCommand(data, len);
     }
   }
 
-  // Run sweep test or leg control
-  if (g_sweep.enabled) {
-    sweepAllTick();
-  } else {
-    Leg::tick();
+  // Fixed-rate control frame (50 Hz); none while idle
+  const uint32_t now = millis();
+  if (!Idle::asleep() && (int32_t)(now - g_frame.nextMs) >= 0) {
+    uint32_t frameMs = g_frame.nextMs;
+    if ((int32_t)(now - frameMs) >= CONTROL_PERIOD_MS) {
+      // More than a period behind: count it and re-align instead of bursting
+      ++g_frame.overruns;
+      frameMs = now;
+    }
+    g_frame.nextMs = frameMs + CONTROL_PERIOD_MS;
+    ++g_frame.frames;
+
+    const uint32_t startUs = micros();
+    {
+      PERF_SCOPE(FRAME);
+      controlFrame(frameMs);
+    }
+    Telemetry::frameDone(startUs - g_frame.startUs, micros() - startUs, g_frame.overruns);
+    g_frame.startUs = startUs;
   }
 
-  delay(20);  // 50 Hz update rate
-}
\ No newline at end of file
+  // Binary state stream (own rate, independent of the control frame)
+  Telemetry::poll();
+
+  // Show file reads stay out of the control frame
+  Choreo::poll();
+
+  // So do PCA9685 health checks and re-discovery
+  servoBus.poll();
+  I2cBus::poll();   // host only: bus jobs that run in worker tasks on the ESP32
+
+  Mem::poll();
+
+  // Nothing moving and no input for a while: stop framing, wait for input
+  Idle::poll(needsFrames());
+  if (Idle::asleep()) {
+    Idle::wait();
+    g_frame.nextMs = millis();   // on waking, frame as soon as the input is read
+    return;
+  }
+
+  delay(1);
+}
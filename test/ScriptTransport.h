@@ -0,0 +1,91 @@
+#pragma once
+// test/ScriptTransport.h - scripted command channel for the native tests
+// Boots the real firmware (src/main.cpp, linked by test_build_src) on the
+// virtual clock with this transport as its console. Tests feed input bytes
+// when they want them to arrive and read back what the firmware wrote.
+// Fixed buffers only, so a test can count the firmware's heap allocations
+// without the harness adding any.
+
+#include <Arduino.h>
+#include <NativeHost.h>
+#include <string.h>
+
+#include "Transport.h"
+
+void setup();
+void loop();
+
+class ScriptTransport : public Transport {
+public:
+  const char* name() const override { return "script"; }
+  bool begin() override { return true; }
+
+  int available() override { return (int)(_inLen - _inPos); }
+  int read() override { return _inPos < _inLen ? _in[_inPos++] : -1; }
+  int peek() override { return _inPos < _inLen ? _in[_inPos] : -1; }
+  int availableForWrite() override { return (int)sizeof(_out); }
+
+  // Keeps the newest output; older bytes scroll out
+  size_t write(const uint8_t* data, size_t len) override {
+    for (size_t i = 0; i < len; ++i) {
+      if (_outLen == sizeof(_out) - 1) {
+        memmove(_out, _out + sizeof(_out) / 2, _outLen - sizeof(_out) / 2);
+        _outLen -= sizeof(_out) / 2;
+      }
+      _out[_outLen++] = (char)data[i];
+    }
+    _out[_outLen] = '\0';
+    return len;
+  }
+  using Transport::write;
+
+  // Input from now on (false when it does not fit)
+  bool feed(const uint8_t* data, size_t len) {
+    if (_inPos) {   // drop what was read
+      memmove(_in, _in + _inPos, _inLen - _inPos);
+      _inLen -= _inPos;
+      _inPos = 0;
+    }
+    if (len > sizeof(_in) - _inLen) return false;
+    memcpy(_in + _inLen, data, len);
+    _inLen += len;
+    return true;
+  }
+  bool feed(const char* s) { return feed((const uint8_t*)s, strlen(s)); }
+
+  const char* output() const { return _out; }   // may hold binary frames
+  size_t      outputLen() const { return _outLen; }
+  // First occurrence of s, searching past the NUL delimiters of any binary
+  // frames (nullptr when absent)
+  const char* find(const char* s) const {
+    const size_t n = strlen(s);
+    for (size_t i = 0; i + n <= _outLen; ++i)
+      if (memcmp(_out + i, s, n) == 0) return _out + i;
+    return nullptr;
+  }
+  bool saw(const char* s) const { return find(s) != nullptr; }
+  void clearOutput() { _outLen = 0; _out[0] = '\0'; }
+
+private:
+  uint8_t _in[4096];
+  size_t  _inLen = 0;
+  size_t  _inPos = 0;
+  char    _out[16384] = "";
+  size_t  _outLen = 0;
+};
+
+// ---------------- Firmware session ----------------
+// setup() on the virtual clock with t as the console; firmware output to
+// stdout stays off so the test report is readable
+inline void bootFirmware(ScriptTransport& t) {
+  NativeHost::setClockMode(NativeHost::VIRTUAL);
+  NativeHost::setSerialEnabled(false);
+  setConsole(t);
+  setup();
+}
+
+// loop() until ms of firmware time have passed (each pass waits >= 1 ms)
+inline void runFor(uint32_t ms) {
+  const uint64_t end = NativeHost::nowUs() + (uint64_t)ms * 1000u;
+  while (NativeHost::nowUs() < end) loop();
+}
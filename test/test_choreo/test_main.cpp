@@ -0,0 +1,78 @@
+// test/test_choreo - a fresh LittleFS partition is never formatted behind a command
+//   pio test -e native -f test_choreo
+// REX_FS points the LittleFS stand-in at a directory that does not exist,
+// which it treats as an unformatted partition. Show commands and uploads
+// report the failed mount and leave it alone; only CHOREO_FORMAT ERASE
+// formats it.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../ScriptTransport.h"
+#include "Choreo.h"
+
+// ========== Helpers ==========
+static ScriptTransport g_console;
+static char g_fsDir[64];
+
+static bool formatted() {
+  struct stat st;
+  return stat(g_fsDir, &st) == 0;
+}
+
+static void send(const char* line) {
+  g_console.clearOutput();
+  g_console.feed(line);
+  g_console.feed("\n");
+  runFor(50);
+}
+
+// ========== Tests ==========
+static void test_fresh_partition_is_not_formatted() {
+  snprintf(g_fsDir, sizeof(g_fsDir), "/tmp/rex_test_choreo_%d", (int)getpid());
+  setenv("REX_FS", g_fsDir, 1);
+  bootFirmware(g_console);
+  runFor(100);
+
+  send("CHOREO_LIST");
+  TEST_ASSERT_TRUE(g_console.saw("LittleFS mount failed"));
+  TEST_ASSERT_FALSE(g_console.saw("show(s)"));
+
+  RexProto::FileBegin m;
+  m.size = 100;
+  strcpy(m.name, "walk");
+  TEST_ASSERT_EQUAL_UINT8(RexProto::FILE_ERR_OPEN, Choreo::fileBegin(m).status);
+
+  send("CHOREO_PLAY walk");
+  TEST_ASSERT_FALSE(Choreo::playing());
+  TEST_ASSERT_FALSE(formatted());
+}
+
+static void test_format_only_on_request() {
+  send("CHOREO_FORMAT");
+  TEST_ASSERT_TRUE(g_console.saw("send CHOREO_FORMAT ERASE"));
+  TEST_ASSERT_FALSE(formatted());
+
+  send("CHOREO_FORMAT ERASE");
+  TEST_ASSERT_TRUE(g_console.saw("Formatted in"));
+  TEST_ASSERT_TRUE(formatted());
+
+  send("CHOREO_LIST");
+  TEST_ASSERT_TRUE(g_console.saw("0 show(s)"));
+  rmdir(g_fsDir);
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fresh_partition_is_not_formatted);
+  RUN_TEST(test_format_only_on_request);
+  return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// test/test_heap - a recorded session runs without a heap allocation after boot
+//   pio test -e native -f test_heap
+// malloc/calloc/realloc are interposed here, so C library and third-party
+// allocations count as well as the operator new that src/Mem.cpp sees on
+// the host. Needs glibc (__libc_malloc); elsewhere the test is ignored.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdlib.h>
+
+#include "../ScriptTransport.h"
+#include "Mem.h"
+#include "RexProtocol.h"
+
+using namespace RexProto;
+
+// ========== Counting Allocator ==========
+static bool     g_counting = false;
+static uint32_t g_mallocs = 0;
+
+#if defined(__GLIBC__)
+#define HEAP_INTERPOSED 1
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t n);
+void  __libc_free(void* p);
+
+static inline void counted() {
+  if (__atomic_load_n(&g_counting, __ATOMIC_RELAXED)) __atomic_add_fetch(&g_mallocs, 1u, __ATOMIC_RELAXED);
+}
+
+void* malloc(size_t n)                { counted(); return __libc_malloc(n); }
+void* calloc(size_t n, size_t size)   { counted(); return __libc_calloc(n, size); }
+void* realloc(void* p, size_t n)      { counted(); return __libc_realloc(p, n); }
+void  free(void* p)                   { __libc_free(p); }
+}
+#else
+#define HEAP_INTERPOSED 0
+#endif
+
+// ========== Session ==========
+// A round of what a phone app and a host script send to a robot: raw
+// verbs, both JSON forms, timestamped lines and binary frames. Times are in
+// ms from the start of a round; records without a line send one of the
+// frames built below.
+struct Record {
+  uint32_t    ms;
+  const char* line;   // nullptr: send g_frames[frame]
+  uint8_t     frame;
+};
+
+static const Record kSession[] = {
+  {   0, "STATUS", 0 },
+  {  40, "TELEM 20", 0 },
+  { 100, "WALK_FORWARD", 0 },
+  { 400, "{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"move_forward\",\"phase\":\"start\"}", 0 },
+  { 700, "{\"cmd\":\"rex_gait\",\"speed\":1.3,\"stride\":0.8,\"lift\":0.5,\"mode\":\"run\"}", 0 },
+  { 900, "LOOK_LEFT", 0 },
+  { 950, "JAW_OPEN", 0 },
+  {1000, "@+200 JAW_CLOSE", 0 },
+  {1100, "SYNC 1718000000000", 0 },
+  {1150, "{\"cmd\":\"rex_speed_adjust\",\"delta\":0.2}", 0 },
+  {1300, nullptr, 0 },   // SET_GAIT
+  {1500, nullptr, 1 },   // TELEMETRY_REQ
+  {1600, "TURN_LEFT", 0 },
+  {1900, "{\"cmd\":\"rex_turn_right\"}", 0 },
+  {2200, "SPINE_LEFT", 0 },
+  {2400, "ROAR", 0 },
+  {3000, "SPINE_CENTER", 0 },
+  {3200, nullptr, 2 },   // SET_JOINTS (streaming)
+  {3220, nullptr, 2 },
+  {3240, nullptr, 2 },
+  {3800, "PERF", 0 },
+  {3850, "TRACE", 0 },
+  {3900, "QUEUE", 0 },
+  {3950, "MEM", 0 },
+  {4000, "WALK_BACKWARD", 0 },
+  {4500, "{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"move_forward\",\"phase\":\"stop\"}", 0 },
+  {4600, "NO_SUCH_COMMAND 1 2", 0 },
+  {4700, "{\"broken\": ", 0 },
+  {4800, "TELEM 0", 0 },
+  {5000, "STOP", 0 },
+  {5200, "IDLE", 0 },
+};
+
+static uint8_t g_frames[3][REX_PROTO_MAX_WIRE];
+static size_t  g_frameLen[3];
+
+// Built before the allocator counts
+static void buildFrames() {
+  uint8_t p[REX_PROTO_MAX_PAYLOAD];
+  const SetGait g = { 900, 150, 90, 0, 0 };
+  g_frameLen[0] = encode(MSG_SET_GAIT, 1, p, pack(g, p), g_frames[0], sizeof(g_frames[0]));
+  g_frameLen[1] = encode(MSG_TELEMETRY_REQ, 2, nullptr, 0, g_frames[1], sizeof(g_frames[1]));
+  SetJoints j;
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) j.us[i] = (uint16_t)(1400 + 10 * i);
+  g_frameLen[2] = encode(MSG_SET_JOINTS, 3, p, pack(j, p), g_frames[2], sizeof(g_frames[2]));
+}
+
+static ScriptTransport g_console;
+
+// ========== Tests ==========
+static void test_session_allocates_nothing_after_boot() {
+#if !HEAP_INTERPOSED
+  TEST_IGNORE_MESSAGE("malloc interposition needs glibc");
+#else
+  buildFrames();
+  bootFirmware(g_console);   // ends with Mem::begin()
+
+  g_counting = true;
+  const uint32_t t0 = millis();
+  for (uint32_t round = 0; round < 3; ++round) {
+    const uint32_t start = millis();
+    for (const Record& r : kSession) {
+      const uint32_t at = start + r.ms;
+      if ((int32_t)(at - millis()) > 0) runFor(at - millis());
+      if (r.line) {
+        g_console.feed(r.line);
+        g_console.feed("\n");
+      } else {
+        g_console.feed(g_frames[r.frame], g_frameLen[r.frame]);
+      }
+      loop();
+      g_console.clearOutput();
+    }
+    runFor(1000);
+  }
+  g_counting = false;
+
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(15000, millis() - t0);
+  TEST_ASSERT_EQUAL_UINT32(0, g_mallocs);
+  TEST_ASSERT_EQUAL_UINT32(0, Mem::allocsSinceBoot());
+#endif
+}
+
+// The counter itself works
+static void test_allocation_is_seen() {
+#if !HEAP_INTERPOSED
+  TEST_IGNORE_MESSAGE("malloc interposition needs glibc");
+#else
+  g_mallocs = 0;
+  g_counting = true;
+  void* volatile p = malloc(16);
+  g_counting = false;
+  free(p);
+  TEST_ASSERT_EQUAL_UINT32(1, g_mallocs);
+#endif
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_session_allocates_nothing_after_boot);
+  RUN_TEST(test_allocation_is_seen);
+  return UNITY_END();
+}
@@ -0,0 +1,89 @@
+// test/test_idle - no control frames while idle, one within a period of input
+//   pio test -e native -f test_idle
+// The firmware on the virtual clock with a scripted console: IDLE 500
+// release, then quiet well past the quiet period. Perf counts every FRAME
+// and LEG_TICK, so a frame run while idle shows up there.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ScriptTransport.h"
+#include "CommandQueue.h"   // CONTROL_PERIOD_MS
+#include "Idle.h"
+#include "Perf.h"
+
+// ========== Helpers ==========
+static ScriptTransport g_console;
+
+// Overruns in the STATUS reply ("Control frames: N (M overruns)")
+static uint32_t statusOverruns() {
+  g_console.clearOutput();
+  g_console.feed("STATUS\n");
+  loop();
+  const char* p = g_console.find("Control frames: ");
+  TEST_ASSERT_NOT_NULL(p);
+  p = strchr(p, '(');
+  TEST_ASSERT_NOT_NULL(p);
+  return strtoul(p + 1, nullptr, 10);
+}
+
+static uint32_t frames() {
+  return Perf::histogram(Perf::FRAME).count();
+}
+
+// ========== Tests ==========
+static void test_no_frames_while_idle() {
+  bootFirmware(g_console);
+  runFor(200);
+  g_console.feed("IDLE 500 release\n");
+  runFor(600);
+  TEST_ASSERT_TRUE(Idle::asleep());
+
+  const uint32_t overruns = statusOverruns();   // wakes it
+  runFor(600);
+  TEST_ASSERT_TRUE(Idle::asleep());
+  Perf::reset();
+
+  const uint32_t wakeups = Idle::stats().wakeups;
+  runFor(10000);
+  TEST_ASSERT_TRUE(Idle::asleep());
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(wakeups + 9, Idle::stats().wakeups);   // housekeeping ran
+  TEST_ASSERT_EQUAL_UINT32(0, frames());
+  TEST_ASSERT_EQUAL_UINT32(0, Perf::histogram(Perf::LEG_TICK).count());
+  TEST_ASSERT_EQUAL_UINT32(0, Perf::histogram(Perf::SERVO_COMMIT).count());
+  TEST_ASSERT_EQUAL_UINT32(overruns, statusOverruns());
+}
+
+// Input wakes it and a frame runs within one control period
+static void test_frame_within_a_period_of_input() {
+  g_console.feed("IDLE 500 release\n");
+  runFor(600);
+  TEST_ASSERT_TRUE(Idle::asleep());
+  runFor(2345);   // somewhere inside a housekeeping wait
+  Perf::reset();
+
+  g_console.feed("WALK_FORWARD\n");
+  const uint64_t inputUs = NativeHost::nowUs();
+  while (frames() == 0 && NativeHost::nowUs() - inputUs < 1000000u) loop();
+  TEST_ASSERT_FALSE(Idle::asleep());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(CONTROL_PERIOD_MS * 1000u, (uint32_t)(NativeHost::nowUs() - inputUs));
+
+  // Walking frames at the control rate again
+  runFor(1000);
+  TEST_ASSERT_UINT32_WITHIN(2, 1000 / CONTROL_PERIOD_MS + 1, frames());
+  g_console.feed("STOP\n");
+  runFor(100);
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_frames_while_idle);
+  RUN_TEST(test_frame_within_a_period_of_input);
+  return UNITY_END();
+}
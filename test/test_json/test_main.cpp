@@ -0,0 +1,84 @@
+// test/test_json - JSON command routing through the firmware's console
+//   pio test -e native -f test_json
+// Schema packets ({"target","part","command","phase"}) are coalesced and
+// applied by the next control frame; legacy {"cmd":"rex_*"} packets read
+// their arguments through the parser's key filter.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <math.h>
+
+#include "../ScriptTransport.h"
+#include "CommandQueue.h"   // CONTROL_PERIOD_MS
+#include "Leg_Function.h"
+
+// ========== Helpers ==========
+static ScriptTransport g_console;
+
+static void boot() {
+  static bool booted = false;
+  if (booted) return;
+  bootFirmware(g_console);
+  runFor(100);
+  booted = true;
+}
+
+static void send(const char* line) {
+  g_console.feed(line);
+  g_console.feed("\n");
+  runFor(2 * CONTROL_PERIOD_MS);
+}
+
+// ========== Schema ==========
+// A remote's release packet stops the legs whatever its command says
+static void test_stop_phase_stops_the_legs_for_any_command() {
+  boot();
+  send("{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"move_forward\",\"phase\":\"start\"}");
+  TEST_ASSERT_EQUAL(Leg::WALK_FWD, Leg::mode());
+  send("{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"release\",\"phase\":\"stop\"}");
+  TEST_ASSERT_EQUAL(Leg::IDLE, Leg::mode());
+
+  send("{\"target\":\"fullBody\",\"command\":\"up\",\"phase\":\"start\"}");
+  TEST_ASSERT_EQUAL(Leg::WALK_FWD, Leg::mode());
+  send("{\"target\":\"fullBody\",\"command\":\"whatever\",\"phase\":\"stop\"}");
+  TEST_ASSERT_EQUAL(Leg::IDLE, Leg::mode());
+}
+
+// An unknown command with an active phase does not replace a pending one
+static void test_unknown_command_does_not_supersede() {
+  boot();
+  g_console.feed("{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"move_left\",\"phase\":\"start\"}\n");
+  g_console.feed("{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"moonwalk\",\"phase\":\"start\"}\n");
+  runFor(2 * CONTROL_PERIOD_MS);
+  TEST_ASSERT_EQUAL(Leg::TURN_L, Leg::mode());
+  send("{\"target\":\"legsPelvis\",\"part\":\"legs\",\"command\":\"move_left\",\"phase\":\"stop\"}");
+  TEST_ASSERT_EQUAL(Leg::IDLE, Leg::mode());
+}
+
+// ========== Legacy ==========
+// Every key rex_gait reads gets through the filter
+static void test_legacy_keys_pass_the_filter() {
+  boot();
+  send("{\"cmd\":\"rex_walk_forward\"}");
+  send("{\"cmd\":\"rex_gait\",\"speed\":1.3,\"stride\":0.8,\"lift\":0.5}");
+  TEST_ASSERT_TRUE(fabsf(Leg::speedHz() - 1.3f) < 1e-3f);
+  TEST_ASSERT_TRUE(fabsf(Leg::strideAmp() - 0.8f) < 1e-3f);
+  TEST_ASSERT_TRUE(fabsf(Leg::liftAmp() - 0.5f) < 1e-3f);
+
+  send("{\"cmd\":\"rex_posture\",\"level\":0.7}");
+  TEST_ASSERT_TRUE(fabsf(Leg::posture01() - 0.7f) < 1e-3f);
+  send("{\"cmd\":\"rex_stop\"}");
+  TEST_ASSERT_FALSE(g_console.saw("JSON filter overflowed"));
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_stop_phase_stops_the_legs_for_any_command);
+  RUN_TEST(test_unknown_command_does_not_supersede);
+  RUN_TEST(test_legacy_keys_pass_the_filter);
+  return UNITY_END();
+}
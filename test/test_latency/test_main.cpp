@@ -0,0 +1,98 @@
+// test/test_latency - control-frame and command latency against stored budgets
+//   pio test -e native -f test_latency
+// Budgets are host nanoseconds (Perf and Trace time with a steady clock
+// off-target), about four times the p99 of an unoptimised build, for a
+// loaded CI machine. Histogram percentiles are log2 bucket bounds, so a
+// budget is one too (2^k - 1). A change that pushes a p99 past its budget
+// fails here; raise the budget only on purpose.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+
+#include "../ScriptTransport.h"
+#include "CommandQueue.h"   // CONTROL_PERIOD_MS
+#include "Perf.h"
+#include "Trace.h"
+
+// ========== Budgets ==========
+// p99 of one control frame while walking and taking commands
+#ifndef LATENCY_FRAME_P99_NS
+#define LATENCY_FRAME_P99_NS 65535
+#endif
+
+// p99 from a command's bytes arriving to its first servo write
+#ifndef LATENCY_COMMAND_P99_NS
+#define LATENCY_COMMAND_P99_NS 65535
+#endif
+
+// ========== Helpers ==========
+static ScriptTransport g_console;
+
+static void report(const char* what, const Histogram& h, uint32_t budget) {
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%s: n=%lu p50=%lu p99=%lu max=%lu ns (budget %lu)", what,
+           (unsigned long)h.count(), (unsigned long)h.percentile(50), (unsigned long)h.percentile(99),
+           (unsigned long)h.max(), (unsigned long)budget);
+  TEST_MESSAGE(msg);
+}
+
+// A steady walk with a command every few frames, as a host app sends them
+static void drive(uint32_t seconds) {
+  static const char* const kCommands[] = {
+    "WALK_FORWARD", "GAIT_TUNE hipx 50", "LOOK_LEFT", "JAW_OPEN", "SPINE_LEFT",
+    "TURN_LEFT", "JAW_CLOSE", "LOOK_CENTER", "SPINE_CENTER", "WALK_BACKWARD",
+  };
+  uint32_t i = 0;
+  for (uint32_t t = 0; t < seconds * 1000; t += 3 * CONTROL_PERIOD_MS) {
+    g_console.feed(kCommands[i++ % (sizeof(kCommands) / sizeof(kCommands[0]))]);
+    g_console.feed("\n");
+    runFor(3 * CONTROL_PERIOD_MS);
+    g_console.clearOutput();
+  }
+}
+
+// Each test boots (setup() runs once per process) and measures a drive of
+// its own, so either passes or fails alone and in any order
+static void bootAndDrive(uint32_t seconds) {
+  static bool booted = false;
+  if (!booted) {
+    bootFirmware(g_console);
+    booted = true;
+  }
+  g_console.feed("STOP\n");
+  runFor(200);
+  Perf::reset();
+  Trace::reset();
+  drive(seconds);
+}
+
+// ========== Tests ==========
+static void test_frame_p99_within_budget() {
+  bootAndDrive(20);
+
+  const Histogram& frame = Perf::histogram(Perf::FRAME);
+  report("FRAME", frame, LATENCY_FRAME_P99_NS);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(900, frame.count());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(LATENCY_FRAME_P99_NS, frame.percentile(99));
+}
+
+static void test_command_p99_within_budget() {
+  bootAndDrive(20);
+
+  const Histogram& total = Trace::histogram(Trace::RX);
+  report("RX->COMMIT", total, LATENCY_COMMAND_P99_NS);
+  TEST_ASSERT_GREATER_THAN_UINT32(100, Trace::completed());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(LATENCY_COMMAND_P99_NS, total.percentile(99));
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_p99_within_budget);
+  RUN_TEST(test_command_p99_within_budget);
+  return UNITY_END();
+}
@@ -0,0 +1,257 @@
+// test/test_linereader - LineReader framing, the verb table and the zero-allocation command path
+//   pio test -e native -f test_linereader
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "../ScriptTransport.h"
+#include "CommandTable.h"
+#include "LineReader.h"
+#include "Mem.h"
+
+// ========== Helpers ==========
+// Deterministic xorshift32, so a failure reproduces
+static uint32_t g_rng = 0x2545F491u;
+static uint32_t rnd() {
+  g_rng ^= g_rng << 13;
+  g_rng ^= g_rng >> 17;
+  g_rng ^= g_rng << 5;
+  return g_rng;
+}
+
+// Hands out at most `chunk` bytes per poll, like a UART FIFO between loops
+class ChunkStream : public Stream {
+public:
+  ChunkStream(const uint8_t* data, size_t len) : _data(data), _len(len) {}
+  void setChunk(size_t n) { _chunk = n; }
+  bool done() const { return _pos >= _len; }
+
+  int available() override {
+    const size_t left = _len - _pos;
+    return (int)(left < _chunk ? left : _chunk);
+  }
+  int read() override { return _pos < _len ? _data[_pos++] : -1; }
+  int peek() override { return _pos < _len ? _data[_pos] : -1; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+
+private:
+  const uint8_t* _data;
+  size_t _len;
+  size_t _pos = 0;
+  size_t _chunk = 1 << 20;
+};
+
+static bool isBlank(char c) { return c == ' ' || c == '\t'; }
+
+// Every item must be a well-formed line or frame; returns the line count
+static uint32_t drainChecked(LineReader& r, char (*lines)[LINE_READER_MAX_LINE + 1] = nullptr, uint32_t maxLines = 0) {
+  uint32_t n = 0;
+  char* data;
+  size_t len;
+  while (LineReader::Item item = r.next(data, len)) {
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LINE_READER_MAX_LINE, len);
+    if (item == LineReader::FRAME) {
+      TEST_ASSERT_NULL(memchr(data, 0, len));
+      continue;
+    }
+    TEST_ASSERT_EQUAL(LineReader::LINE, item);
+    TEST_ASSERT_EQUAL_UINT8(0, data[len]);
+    TEST_ASSERT_NULL(memchr(data, '\n', len));
+    TEST_ASSERT_NULL(memchr(data, '\r', len));
+    TEST_ASSERT_NULL(memchr(data, 0, len));
+    TEST_ASSERT_FALSE(isBlank(data[0]));
+    TEST_ASSERT_FALSE(isBlank(data[len - 1]));
+    if (lines && n < maxLines) memcpy(lines[n], data, len + 1);
+    ++n;
+  }
+  return n;
+}
+
+// Feed everything through poll() in chunks, draining between polls
+static uint32_t feedChunked(LineReader& r, const uint8_t* data, size_t len, size_t chunk,
+                            char (*lines)[LINE_READER_MAX_LINE + 1] = nullptr, uint32_t maxLines = 0) {
+  ChunkStream in(data, len);
+  in.setChunk(chunk);
+  uint32_t n = 0;
+  while (!in.done()) {
+    r.poll(in);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LINE_READER_RING_SIZE, r.pending());
+    n += drainChecked(r, lines ? lines + n : nullptr, maxLines > n ? maxLines - n : 0);
+  }
+  return n;
+}
+
+// ========== Framing ==========
+static void test_crlf_mixes_and_blanks() {
+  static const char kIn[] = "A\r\nB\n\r\nC\r\r\n  D  \n\t\n\r\n STATUS\tx \r\n";
+  LineReader r;
+  char lines[8][LINE_READER_MAX_LINE + 1];
+  const uint32_t n = feedChunked(r, (const uint8_t*)kIn, sizeof(kIn) - 1, 3, lines, 8);
+  TEST_ASSERT_EQUAL_UINT32(5, n);
+  TEST_ASSERT_EQUAL_STRING("A", lines[0]);
+  TEST_ASSERT_EQUAL_STRING("B", lines[1]);
+  TEST_ASSERT_EQUAL_STRING("C", lines[2]);
+  TEST_ASSERT_EQUAL_STRING("D", lines[3]);
+  TEST_ASSERT_EQUAL_STRING("STATUS\tx", lines[4]);
+  TEST_ASSERT_EQUAL_UINT32(5, r.linesRead());
+  TEST_ASSERT_EQUAL_UINT32(0, r.overflows());
+}
+
+static void test_overlong_lines_are_dropped_whole() {
+  static uint8_t buf[4 * LINE_READER_MAX_LINE];
+  size_t n = 0;
+  memset(buf + n, 'a', LINE_READER_MAX_LINE);          // exactly the limit: kept
+  n += LINE_READER_MAX_LINE;
+  buf[n++] = '\n';
+  memset(buf + n, 'b', LINE_READER_MAX_LINE + 1);      // one over: dropped
+  n += LINE_READER_MAX_LINE + 1;
+  buf[n++] = '\r';
+  buf[n++] = '\n';
+  memcpy(buf + n, "STOP\n", 5);
+  n += 5;
+
+  LineReader r;
+  char lines[4][LINE_READER_MAX_LINE + 1];
+  TEST_ASSERT_EQUAL_UINT32(2, feedChunked(r, buf, n, 17, lines, 4));
+  TEST_ASSERT_EQUAL_UINT32(LINE_READER_MAX_LINE, strlen(lines[0]));
+  TEST_ASSERT_EQUAL_STRING("STOP", lines[1]);
+  TEST_ASSERT_EQUAL_UINT32(1, r.overflows());
+}
+
+static void test_frames_between_lines() {
+  static const uint8_t kIn[] = { 'H', 'E', 'L', 'P', '\n', 0, 0, 3, 0x0A, 0x0D, 1, 0, 'S', 'T', 'O', 'P', '\n' };
+  LineReader r;
+  ChunkStream in(kIn, sizeof(kIn));
+  r.poll(in);
+  char* data;
+  size_t len;
+  TEST_ASSERT_EQUAL(LineReader::LINE, r.next(data, len));
+  TEST_ASSERT_EQUAL_STRING("HELP", data);
+  TEST_ASSERT_EQUAL(LineReader::FRAME, r.next(data, len));
+  TEST_ASSERT_EQUAL_UINT32(4, len);
+  TEST_ASSERT_EQUAL_MEMORY(kIn + 7, data, 4);           // CR/LF inside a frame are data
+  TEST_ASSERT_EQUAL(LineReader::LINE, r.next(data, len));
+  TEST_ASSERT_EQUAL_STRING("STOP", data);
+  TEST_ASSERT_EQUAL(LineReader::NONE, r.next(data, len));
+}
+
+// Random bytes weighted toward the interesting ones: NULs, CR, LF, blanks
+// and printable text, in random poll sizes. Nothing may come out malformed,
+// and the reader must frame clean input correctly afterwards.
+static void test_fuzz_random_bytes() {
+  static uint8_t buf[64 * 1024];
+  for (uint32_t round = 0; round < 50; ++round) {
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+      const uint32_t k = rnd() % 16;
+      buf[i] = k == 0 ? 0x00 : k == 1 ? '\r' : k == 2 ? '\n' : k == 3 ? ' ' : k == 4 ? '\t'
+             : k < 12 ? (uint8_t)('A' + rnd() % 26) : (uint8_t)rnd();
+    }
+    // Some rounds build over-long runs without a newline
+    if (round % 5 == 0) memset(buf + rnd() % 1024, 'x', 3 * LINE_READER_MAX_LINE);
+
+    LineReader r;
+    feedChunked(r, buf, sizeof(buf), 1 + rnd() % (2 * LINE_READER_RING_SIZE));
+
+    static const char kClean[] = "\nWALK_FORWARD\n";
+    r.reset();
+    char lines[2][LINE_READER_MAX_LINE + 1];
+    TEST_ASSERT_EQUAL_UINT32(1, feedChunked(r, (const uint8_t*)kClean, sizeof(kClean) - 1, 5, lines, 2));
+    TEST_ASSERT_EQUAL_STRING("WALK_FORWARD", lines[0]);
+  }
+}
+
+static void test_tokenize_in_place() {
+  static const char kLine[] = "CAL_US  7\t1500";
+  LineToken t[4];
+  TEST_ASSERT_EQUAL_UINT8(3, LineReader::tokenize(kLine, sizeof(kLine) - 1, t, 4));
+  TEST_ASSERT_TRUE(t[0].equals("CAL_US"));
+  TEST_ASSERT_TRUE(t[1].ptr == kLine + 8);
+  TEST_ASSERT_TRUE(t[2].equals("1500"));
+  TEST_ASSERT_FALSE(t[2].equals("150"));
+  TEST_ASSERT_EQUAL_UINT8(2, LineReader::tokenize(kLine, sizeof(kLine) - 1, t, 2));
+}
+
+// ========== Heap ==========
+// Every command line, known or not, is read, cut and dispatched without a
+// heap allocation (counted at operator new by src/Mem.cpp on the host)
+static ScriptTransport g_console;
+
+static void test_no_allocation_per_dispatched_command() {
+  static const char* const kCommands[] = {
+    "HELP", "STATUS", "WALK_FORWARD", "GAIT_TUNE 1.2 0.6 0.4", "TURN_LEFT", "STOP",
+    "LOOK_LEFT", "JAW_OPEN", "JAW_CLOSE", "LOOK_CENTER", "PERF", "TRACE", "QUEUE",
+    "SYNC 12345", "@+40 SPINE_LEFT", "SPINE_CENTER", "rex_walk", "NO_SUCH_COMMAND 1 2 3",
+    "   padded   ", "CAL", "MEM", "IDLE", "POWER", "WALK_BACKWARD", "STOP",
+  };
+
+  bootFirmware(g_console);
+  runFor(100);
+
+  for (uint32_t round = 0; round < 4; ++round) {
+    for (const char* cmd : kCommands) {
+      g_console.feed(cmd);
+      g_console.feed(round & 1 ? "\r\n" : "\n");
+      const uint32_t before = Mem::allocs();
+      loop();
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(before, Mem::allocs(), cmd);
+    }
+    // Garbage lines go down the same path
+    for (uint32_t i = 0; i < 32; ++i) {
+      char line[LINE_READER_MAX_LINE + 2];
+      const size_t len = 1 + rnd() % LINE_READER_MAX_LINE;
+      for (size_t j = 0; j < len; ++j) line[j] = (char)(0x20 + rnd() % 0x5F);
+      line[len] = '\n';
+      g_console.feed((const uint8_t*)line, len + 1);
+      const uint32_t before = Mem::allocs();
+      loop();
+      TEST_ASSERT_EQUAL_UINT32(before, Mem::allocs());
+    }
+    runFor(200);
+  }
+  TEST_ASSERT_TRUE(g_console.saw("[CMD] Unknown: "));
+  TEST_ASSERT_EQUAL_UINT32(0, Mem::allocsSinceBoot());
+}
+
+// ========== Table ==========
+// An entry whose id is not its name's hash could never be looked up:
+// add() refuses it and says so through the log, on the console
+static int g_tableHits = 0;
+
+static void test_table_rejects_mismatched_id() {
+  static const CommandTable::Entry kBad[] = {
+    { CMD_ID("T_ONE"), "T_TWO", [](const CommandTable::Args&) { ++g_tableHits; } },
+  };
+  static const CommandTable::Entry kGood[] = {
+    { CMD_VERB("T_TWO"), [](const CommandTable::Args&) { ++g_tableHits; } },
+  };
+
+  g_console.clearOutput();
+  TEST_ASSERT_FALSE(CommandTable::add(kBad));
+  TEST_ASSERT_NULL(CommandTable::find("T_TWO"));
+  TEST_ASSERT_NULL(CommandTable::find("T_ONE"));
+  runFor(50);
+  TEST_ASSERT_TRUE(g_console.saw("is not CMD_ID(\"T_TWO\")"));
+
+  TEST_ASSERT_TRUE(CommandTable::add(kGood));
+  g_console.feed("T_TWO\n");
+  runFor(50);
+  TEST_ASSERT_EQUAL_INT(1, g_tableHits);
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crlf_mixes_and_blanks);
+  RUN_TEST(test_overlong_lines_are_dropped_whole);
+  RUN_TEST(test_frames_between_lines);
+  RUN_TEST(test_fuzz_random_bytes);
+  RUN_TEST(test_tokenize_in_place);
+  RUN_TEST(test_no_allocation_per_dispatched_command);
+  RUN_TEST(test_table_rejects_mismatched_id);
+  return UNITY_END();
+}
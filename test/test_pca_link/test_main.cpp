@@ -0,0 +1,151 @@
+// test/test_pca_link - PCA9685 discovery and hot re-attach on the faulting I2C stand-in
+//   pio test -e native -f test_pca_link
+// A ServoBus of its own on the virtual clock, with the PCA9685 (0x40)
+// cut off by NativeHost::setI2cOutage(): missing at boot, then lost while
+// running. Asserts how soon it is back, that the last frame reaches it,
+// and that getting it back neither allocates (the driver is begun once)
+// nor holds up a poll() for longer than writing one frame takes.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeHost.h>
+
+#include "I2cBus.h"
+#include "Mem.h"
+#include "ServoBus.h"
+
+// ========== Helpers ==========
+static const uint8_t kPca = 0x40;
+static ServoBus g_bus;
+static uint16_t g_frameUs[SERVO_COUNT];
+static uint64_t g_pollMaxUs = 0;   // longest single g_bus.poll()
+
+// After the outage ends the next probe comes within one backoff step,
+// which doubles from PCA9685_RETRY_MIN_MS and so never exceeds the time
+// already spent down (plus the first step), capped at PCA9685_RETRY_MAX_MS.
+// Then 500 µs for the oscillator and one poll.
+static uint32_t reconnectBoundMs(uint32_t downMs) {
+  const uint32_t backoff = downMs + PCA9685_RETRY_MIN_MS;
+  return (backoff < PCA9685_RETRY_MAX_MS ? backoff : PCA9685_RETRY_MAX_MS) + 2;
+}
+
+// What the main loop does for the bus, 1 ms a pass
+static void runFor(uint32_t ms) {
+  const uint64_t end = NativeHost::nowUs() + (uint64_t)ms * 1000u;
+  while (NativeHost::nowUs() < end) {
+    const uint64_t t0 = NativeHost::nowUs();
+    g_bus.poll();
+    if (NativeHost::nowUs() - t0 > g_pollMaxUs) g_pollMaxUs = NativeHost::nowUs() - t0;
+    I2cBus::poll();
+    delay(1);
+  }
+}
+
+// Run until the link is up again; returns the virtual time it took
+static uint32_t runUntilUp(uint32_t limitMs) {
+  const uint64_t start = NativeHost::nowUs();
+  while (g_bus.pcaLink() != PCA_LINK_UP && NativeHost::nowUs() - start < (uint64_t)limitMs * 1000u) {
+    runFor(1);
+  }
+  return (uint32_t)((NativeHost::nowUs() - start) / 1000u);
+}
+
+// Returns the bus time it took
+static uint32_t writeLegs(uint16_t baseUs) {
+  const uint64_t t0 = NativeHost::nowUs();
+  for (uint8_t ch = PCA9685_FIRST_CHANNEL; ch < SERVO_COUNT; ++ch) {
+    g_frameUs[ch] = (uint16_t)(baseUs + 20 * (ch - PCA9685_FIRST_CHANNEL));
+    g_bus.writeMicroseconds(ch, g_frameUs[ch]);
+  }
+  return (uint32_t)(NativeHost::nowUs() - t0);
+}
+
+// Every leg port holds the counts for the last pulse written (50 Hz:
+// 4096 counts per 20000 µs, within the prescaler's rounding)
+static void assertFrameOnChip() {
+  for (uint8_t ch = PCA9685_FIRST_CHANNEL; ch < SERVO_COUNT; ++ch) {
+    const int32_t expect = (int32_t)g_frameUs[ch] * 4096 / 20000;
+    TEST_ASSERT_INT_WITHIN(4, expect, NativeHost::pcaCounts(kPca, ch - PCA9685_FIRST_CHANNEL));
+  }
+}
+
+// ========== Tests ==========
+static void test_missing_at_boot() {
+  NativeHost::setClockMode(NativeHost::VIRTUAL);
+  NativeHost::setSerialEnabled(false);
+  const uint32_t downMs = 700;
+  NativeHost::setI2cOutage(kPca, NativeHost::nowUs(), (uint64_t)downMs * 1000u);
+
+  I2cBus::begin();
+  const uint64_t bootUs = NativeHost::nowUs();
+  TEST_ASSERT_FALSE(g_bus.begin(kPca, 50.0f));
+  TEST_ASSERT_EQUAL(PCA_LINK_DOWN, g_bus.pcaLink());
+  const uint32_t allocs = Mem::allocs();
+
+  // Legs attach and take pulses while it is missing
+  for (uint8_t ch = PCA9685_FIRST_CHANNEL; ch < SERVO_COUNT; ++ch) g_bus.attach(ch);
+  writeLegs(1400);
+  TEST_ASSERT_EQUAL_UINT16(0, NativeHost::pcaCounts(kPca, 0));
+
+  const uint32_t leftMs = downMs - (uint32_t)((NativeHost::nowUs() - bootUs) / 1000u);
+  runFor(leftMs);
+  TEST_ASSERT_NOT_EQUAL(PCA_LINK_UP, g_bus.pcaLink());
+  const uint32_t tookMs = runUntilUp(PCA9685_RETRY_MAX_MS + 100);
+
+  TEST_ASSERT_EQUAL(PCA_LINK_UP, g_bus.pcaLink());
+  TEST_ASSERT_TRUE(g_bus.isPcaPresent());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(reconnectBoundMs(downMs), tookMs);
+  TEST_ASSERT_EQUAL_UINT32(1, g_bus.pcaLinkStats().reconnects);
+  assertFrameOnChip();
+
+  // No second driver begin() on the way up: nothing allocated, and no
+  // pass longer than the restore, which costs what a frame write does
+  TEST_ASSERT_EQUAL_UINT32(allocs, Mem::allocs());
+  const uint32_t frameUs = writeLegs(1600);
+  assertFrameOnChip();
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(frameUs + 200, (uint32_t)g_pollMaxUs);
+}
+
+static void test_lost_mid_run() {
+  runFor(300);
+  const PcaLinkStats before = g_bus.pcaLinkStats();
+  const uint32_t allocs = Mem::allocs();
+  writeLegs(1500);
+  runFor(50);
+
+  const uint32_t downMs = 450;
+  const uint64_t cutUs = NativeHost::nowUs() + 30000u;
+  NativeHost::setI2cOutage(kPca, cutUs, (uint64_t)downMs * 1000u);
+
+  // A check (or a write) notices within PCA9685_CHECK_MS
+  runFor(30 + PCA9685_CHECK_MS + 2);
+  TEST_ASSERT_NOT_EQUAL(PCA_LINK_UP, g_bus.pcaLink());
+  TEST_ASSERT_EQUAL_UINT32(before.losses + 1, g_bus.pcaLinkStats().losses);
+
+  // Writes made while it is gone are kept for the restore
+  writeLegs(1700);
+  const uint32_t leftMs = (uint32_t)((cutUs + (uint64_t)downMs * 1000u - NativeHost::nowUs()) / 1000u);
+  runFor(leftMs);
+  const uint32_t tookMs = runUntilUp(PCA9685_RETRY_MAX_MS + 100);
+
+  TEST_ASSERT_EQUAL(PCA_LINK_UP, g_bus.pcaLink());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(reconnectBoundMs(downMs), tookMs);
+  TEST_ASSERT_EQUAL_UINT32(before.reconnects + 1, g_bus.pcaLinkStats().reconnects);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(downMs + reconnectBoundMs(downMs) + PCA9685_CHECK_MS,
+                                   g_bus.pcaLinkStats().lastOutageMs);
+  TEST_ASSERT_EQUAL_UINT32(allocs, Mem::allocs());
+  assertFrameOnChip();
+  const uint32_t frameUs = writeLegs(1500);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(frameUs + 200, (uint32_t)g_pollMaxUs);
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_missing_at_boot);
+  RUN_TEST(test_lost_mid_run);
+  return UNITY_END();
+}
@@ -0,0 +1,318 @@
+// test/test_protocol - RexProtocol round trips, rejects and the firmware's frame counters
+//   pio test -e native -f test_protocol
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "../ScriptTransport.h"
+#include "CommandRouter.h"
+#include "LineReader.h"
+#include "RexProtocol.h"
+
+using namespace RexProto;
+
+// ========== Helpers ==========
+// Serves a buffer to LineReader::poll()
+class BufferStream : public Stream {
+public:
+  BufferStream(const uint8_t* data, size_t len) : _data(data), _len(len) {}
+  int available() override { return (int)(_len - _pos); }
+  int read() override { return _pos < _len ? _data[_pos++] : -1; }
+  int peek() override { return _pos < _len ? _data[_pos] : -1; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+
+private:
+  const uint8_t* _data;
+  size_t _len;
+  size_t _pos = 0;
+};
+
+// encode() -> the text reader's frame mode -> decode(), as the firmware does
+static uint8_t g_scratch[REX_PROTO_MAX_RAW];
+
+static Frame wireRoundTrip(uint8_t type, uint8_t seq, const uint8_t* payload, size_t len) {
+  uint8_t wire[REX_PROTO_MAX_WIRE];
+  const size_t n = encode(type, seq, payload, len, wire, sizeof(wire));
+  TEST_ASSERT_TRUE(n > 2);
+  TEST_ASSERT_EQUAL_UINT8(0, wire[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, wire[n - 1]);
+  TEST_ASSERT_NULL(memchr(wire + 1, 0, n - 2));
+
+  LineReader r;
+  BufferStream in(wire, n);
+  r.poll(in);
+  char* data;
+  size_t got;
+  TEST_ASSERT_EQUAL(LineReader::FRAME, r.next(data, got));
+
+  Frame f;
+  TEST_ASSERT_TRUE(decode((const uint8_t*)data, got, g_scratch, f));
+  TEST_ASSERT_EQUAL_UINT8(type, f.type);
+  TEST_ASSERT_EQUAL_UINT8(seq, f.seq);
+  TEST_ASSERT_EQUAL_UINT32(len, f.len);
+  return f;
+}
+
+// ========== Codec ==========
+static void test_round_trip_every_type() {
+  uint8_t p[REX_PROTO_MAX_PAYLOAD];
+
+  SetJoints j;
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) j.us[i] = (uint16_t)(i * 256 + (i & 1));   // zero bytes too
+  SetJoints j2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_SET_JOINTS, 1, p, pack(j, p)), j2));
+  TEST_ASSERT_EQUAL_MEMORY(j.us, j2.us, sizeof(j.us));
+
+  SetGait g = { 1200, 153, 102, 1, GAIT_FLAG_RUN };
+  SetGait g2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_SET_GAIT, 2, p, pack(g, p)), g2));
+  TEST_ASSERT_EQUAL_UINT16(g.speed_mhz, g2.speed_mhz);
+  TEST_ASSERT_EQUAL_UINT8(g.stride, g2.stride);
+  TEST_ASSERT_EQUAL_UINT8(g.lift, g2.lift);
+  TEST_ASSERT_EQUAL_UINT8(g.mode, g2.mode);
+  TEST_ASSERT_EQUAL_UINT8(g.flags, g2.flags);
+
+  wireRoundTrip(MSG_TELEMETRY_REQ, 3, nullptr, 0);
+
+  FileBegin b = {};
+  b.size = 70000;
+  strcpy(b.name, "walk_show-2");
+  FileBegin b2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_FILE_BEGIN, 4, p, pack(b, p)), b2));
+  TEST_ASSERT_EQUAL_UINT32(b.size, b2.size);
+  TEST_ASSERT_EQUAL_STRING(b.name, b2.name);
+
+  uint8_t chunk[REX_PROTO_FILE_CHUNK];
+  for (uint8_t i = 0; i < sizeof(chunk); ++i) chunk[i] = (uint8_t)(i * 37);
+  FileData d = { 0x01020304, chunk, sizeof(chunk) };
+  FileData d2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_FILE_DATA, 5, p, pack(d, p)), d2));
+  TEST_ASSERT_EQUAL_UINT32(d.offset, d2.offset);
+  TEST_ASSERT_EQUAL_UINT8(d.len, d2.len);
+  TEST_ASSERT_EQUAL_MEMORY(chunk, d2.data, sizeof(chunk));
+
+  FileEnd e = { crc16(chunk, sizeof(chunk)) };
+  FileEnd e2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_FILE_END, 6, p, pack(e, p)), e2));
+  TEST_ASSERT_EQUAL_UINT16(e.crc, e2.crc);
+
+  Telemetry t;
+  t.ms = 0xDEADBEEF;
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) t.us[i] = (uint16_t)(1000 + 40 * i);
+  t.legMode = 2;
+  t.streaming = 1;
+  Telemetry t2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_TELEMETRY, 7, p, pack(t, p)), t2));
+  TEST_ASSERT_EQUAL_UINT32(t.ms, t2.ms);
+  TEST_ASSERT_EQUAL_MEMORY(t.us, t2.us, sizeof(t.us));
+  TEST_ASSERT_EQUAL_UINT8(t.legMode, t2.legMode);
+  TEST_ASSERT_EQUAL_UINT8(t.streaming, t2.streaming);
+
+  State s;
+  s.ms = 123456;
+  for (uint8_t i = 0; i < REX_PROTO_JOINTS; ++i) s.us[i] = (uint16_t)(2000 - 30 * i);
+  s.phase = 40000;
+  s.periodUs = 20012;
+  s.busyUs = 850;
+  s.overruns = 3;
+  s.legMode = 1;
+  s.flags = STATE_FLAG_STREAMING;
+  s.cmdQueue = 4;
+  s.logPending = 5;
+  s.rxPending = 6;
+  State s2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_STATE, 8, p, pack(s, p)), s2));
+  TEST_ASSERT_EQUAL_UINT32(s.ms, s2.ms);
+  TEST_ASSERT_EQUAL_MEMORY(s.us, s2.us, sizeof(s.us));
+  TEST_ASSERT_EQUAL_UINT16(s.phase, s2.phase);
+  TEST_ASSERT_EQUAL_UINT16(s.periodUs, s2.periodUs);
+  TEST_ASSERT_EQUAL_UINT16(s.busyUs, s2.busyUs);
+  TEST_ASSERT_EQUAL_UINT16(s.overruns, s2.overruns);
+  TEST_ASSERT_EQUAL_UINT8(s.legMode, s2.legMode);
+  TEST_ASSERT_EQUAL_UINT8(s.flags, s2.flags);
+  TEST_ASSERT_EQUAL_UINT8(s.cmdQueue, s2.cmdQueue);
+  TEST_ASSERT_EQUAL_UINT8(s.logPending, s2.logPending);
+  TEST_ASSERT_EQUAL_UINT8(s.rxPending, s2.rxPending);
+
+  FileAck a = { FILE_ERR_OFFSET, 4096 };
+  FileAck a2;
+  TEST_ASSERT_TRUE(unpack(wireRoundTrip(MSG_FILE_ACK, 9, p, pack(a, p)), a2));
+  TEST_ASSERT_EQUAL_UINT8(a.status, a2.status);
+  TEST_ASSERT_EQUAL_UINT32(a.offset, a2.offset);
+
+  // The largest payload fits REX_PROTO_MAX_WIRE, and a wrong length is refused
+  memset(p, 0xFF, sizeof(p));
+  Frame big = wireRoundTrip(0x7F, 10, p, REX_PROTO_MAX_PAYLOAD);
+  TEST_ASSERT_FALSE(unpack(big, j2));
+  TEST_ASSERT_FALSE(unpack(big, a2));
+}
+
+// Frames written by tools/rexproto.py (encode(0x02, 7, set_gait(1.2, 0.6,
+// 0.4, 1, run=True)) and encode(0x04, 9, file_begin("walk", 1234)))
+static void test_host_tool_frames() {
+  static const uint8_t kGait[] = { 0x0B, 0x02, 0x07, 0xB0, 0x04, 0x99, 0x66, 0x01, 0x01, 0x45, 0xEA };
+  static const uint8_t kBegin[] = { 0x05, 0x04, 0x09, 0xD2, 0x04, 0x01, 0x07, 0x77, 0x61, 0x6C, 0x6B, 0xDC, 0xDA };
+
+  Frame f;
+  SetGait g;
+  TEST_ASSERT_TRUE(decode(kGait, sizeof(kGait), g_scratch, f));
+  TEST_ASSERT_EQUAL_UINT8(7, f.seq);
+  TEST_ASSERT_TRUE(unpack(f, g));
+  TEST_ASSERT_EQUAL_UINT16(1200, g.speed_mhz);
+  TEST_ASSERT_EQUAL_UINT8(153, g.stride);
+  TEST_ASSERT_EQUAL_UINT8(102, g.lift);
+  TEST_ASSERT_EQUAL_UINT8(GAIT_FLAG_RUN, g.flags);
+
+  FileBegin b;
+  TEST_ASSERT_TRUE(decode(kBegin, sizeof(kBegin), g_scratch, f));
+  TEST_ASSERT_EQUAL_UINT8(MSG_FILE_BEGIN, f.type);
+  TEST_ASSERT_TRUE(unpack(f, b));
+  TEST_ASSERT_EQUAL_UINT32(1234, b.size);
+  TEST_ASSERT_EQUAL_STRING("walk", b.name);
+}
+
+static void test_codec_rejects() {
+  uint8_t wire[REX_PROTO_MAX_WIRE];
+  const uint8_t payload[SET_GAIT_SIZE] = { 1, 2, 3, 4, 5, 6 };
+  const size_t n = encode(MSG_SET_GAIT, 1, payload, sizeof(payload), wire, sizeof(wire));
+  Frame f;
+
+  // Corrupted CRC (any single bit)
+  for (size_t i = 2; i < n - 1; ++i) {
+    uint8_t bad[REX_PROTO_MAX_WIRE];
+    memcpy(bad, wire, n);
+    bad[i] ^= 0x40;
+    if (bad[i] == 0) continue;
+    TEST_ASSERT_FALSE(decode(bad + 1, n - 2, g_scratch, f));
+  }
+
+  // Truncated COBS: the code byte points past the end
+  for (size_t cut = 1; cut < n - 2; ++cut) TEST_ASSERT_FALSE(decode(wire + 1, n - 2 - cut, g_scratch, f));
+
+  // Oversize: refused by encode(), and a longer frame does not decode
+  uint8_t big[REX_PROTO_MAX_PAYLOAD + 1] = {};
+  TEST_ASSERT_EQUAL_UINT32(0, encode(0x01, 0, big, sizeof(big), wire, sizeof(wire)));
+  uint8_t raw[REX_PROTO_MAX_RAW + 8];
+  memset(raw, 0x11, sizeof(raw));
+  uint8_t cobs[sizeof(raw) + 2];
+  const size_t c = cobsEncode(raw, sizeof(raw), cobs, sizeof(cobs));
+  TEST_ASSERT_TRUE(c > 0);
+  TEST_ASSERT_FALSE(decode(cobs, c, g_scratch, f));
+}
+
+// ========== Text/frame resync ==========
+static void test_stray_nul_does_not_swallow_lines() {
+  static const uint8_t kIn[] = "\0STOP\r\nWALK_FORWARD\n";
+  LineReader r;
+  BufferStream in(kIn, sizeof(kIn) - 1);
+  r.poll(in);
+  char* data;
+  size_t len;
+  TEST_ASSERT_EQUAL(LineReader::LINE, r.next(data, len));
+  TEST_ASSERT_EQUAL_STRING("STOP", data);
+  TEST_ASSERT_EQUAL(LineReader::LINE, r.next(data, len));
+  TEST_ASSERT_EQUAL_STRING("WALK_FORWARD", data);
+  TEST_ASSERT_EQUAL_UINT32(1, r.resyncs());
+
+  // Longer than any frame: the binary bytes go, the rest is text again, and
+  // a frame after it still arrives
+  static uint8_t buf[256];
+  size_t n = 0;
+  buf[n++] = 0;
+  buf[n++] = 0x02;                              // not text, so no early resync
+  for (uint8_t i = 0; i < 100; ++i) buf[n++] = 'x';
+  buf[n++] = '\n';
+  n += encode(MSG_TELEMETRY_REQ, 1, nullptr, 0, buf + n, sizeof(buf) - n);
+  LineReader r2;
+  BufferStream in2(buf, n);
+  r2.poll(in2);
+  TEST_ASSERT_EQUAL(LineReader::LINE, r2.next(data, len));
+  TEST_ASSERT_EQUAL_UINT32(101 - (REX_PROTO_MAX_WIRE - 2), len);
+  TEST_ASSERT_EQUAL('x', data[0]);
+  TEST_ASSERT_EQUAL(LineReader::FRAME, r2.next(data, len));
+  TEST_ASSERT_EQUAL(LineReader::NONE, r2.next(data, len));
+  TEST_ASSERT_EQUAL_UINT32(1, r2.resyncs());
+}
+
+// ========== Firmware counters ==========
+static ScriptTransport g_console;
+
+static void sendReq(uint8_t seq) {
+  uint8_t wire[REX_PROTO_MAX_WIRE];
+  g_console.feed(wire, encode(MSG_TELEMETRY_REQ, seq, nullptr, 0, wire, sizeof(wire)));
+  loop();
+}
+
+static uint32_t telemetryReplies() {
+  const uint8_t* out = (const uint8_t*)g_console.output();
+  const size_t len = g_console.outputLen();
+  uint32_t n = 0;
+  size_t open = SIZE_MAX;
+  for (size_t i = 0; i < len; ++i) {
+    if (out[i] != 0) continue;
+    Frame f;
+    if (open != SIZE_MAX && i > open + 1 && decode(out + open + 1, i - open - 1, g_scratch, f) &&
+        f.type == MSG_TELEMETRY) {
+      ++n;
+      open = SIZE_MAX;
+    } else {
+      open = i;
+    }
+  }
+  return n;
+}
+
+static void test_router_counts_sequence_and_rejects() {
+  bootFirmware(g_console);
+  runFor(100);
+  g_console.clearOutput();
+  const CommandRouter::ProtoStats before = CommandRouter::protoStats();
+
+  // 0 1 2 [3 4 lost] 5, then a repeat, a late one, and on
+  static const uint8_t kSeq[] = { 0, 1, 2, 5, 5, 4, 6 };
+  for (uint8_t s : kSeq) sendReq(s);
+
+  // Rejected: corrupted CRC, truncated COBS, oversize
+  uint8_t wire[REX_PROTO_MAX_WIRE];
+  size_t n = encode(MSG_TELEMETRY_REQ, 7, nullptr, 0, wire, sizeof(wire));
+  wire[n - 2] ^= 0x01;
+  g_console.feed(wire, n);
+  const uint8_t payload[SET_GAIT_SIZE] = { 1, 2, 3, 4, 5, 6 };
+  n = encode(MSG_SET_GAIT, 7, payload, sizeof(payload), wire, sizeof(wire));
+  g_console.feed(wire, n - 3);
+  g_console.feed(wire + n - 1, 1);
+  static uint8_t big[REX_PROTO_MAX_WIRE + 16];
+  memset(big, 0x81, sizeof(big));
+  big[0] = 0;
+  big[sizeof(big) - 1] = 0;
+  g_console.feed(big, sizeof(big));
+  loop();
+
+  // A stray 0x00 before a text command
+  g_console.feed((const uint8_t*)"\0STOP\n", 6);
+  sendReq(7);
+  runFor(50);   // log drain
+
+  const CommandRouter::ProtoStats& ps = CommandRouter::protoStats();
+  TEST_ASSERT_EQUAL_UINT32(8, ps.frames - before.frames);
+  TEST_ASSERT_EQUAL_UINT32(2, ps.seqGaps - before.seqGaps);
+  TEST_ASSERT_EQUAL_UINT32(2, ps.duplicates - before.duplicates);
+  TEST_ASSERT_EQUAL_UINT32(2, ps.errors - before.errors);
+  TEST_ASSERT_EQUAL_UINT32(8, telemetryReplies());
+  TEST_ASSERT_TRUE(g_console.saw("[CMD] RX: STOP"));
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_every_type);
+  RUN_TEST(test_host_tool_frames);
+  RUN_TEST(test_codec_rejects);
+  RUN_TEST(test_stray_nul_does_not_swallow_lines);
+  RUN_TEST(test_router_counts_sequence_and_rejects);
+  return UNITY_END();
+}
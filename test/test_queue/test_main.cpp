@@ -0,0 +1,193 @@
+// test/test_queue - timestamped commands on the virtual clock with loop jitter
+//   pio test -e native -f test_queue
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../ScriptTransport.h"
+#include "CommandQueue.h"
+#include "Leg_Function.h"
+
+// ========== Helpers ==========
+static ScriptTransport g_console;
+
+// Deterministic xorshift32, so a failure reproduces
+static uint32_t g_rng = 0x9E3779B9u;
+static uint32_t rnd() {
+  g_rng ^= g_rng << 13;
+  g_rng ^= g_rng >> 17;
+  g_rng ^= g_rng << 5;
+  return g_rng;
+}
+
+// Worst extra wait between two loop() passes. Up to half a frame the queue
+// still runs every command in the frame nearest its timestamp.
+static const uint32_t kJitterUs = (CONTROL_PERIOD_MS / 2 - 2) * 1000u;
+
+static void boot() {
+  static bool booted = false;
+  if (booted) return;
+  bootFirmware(g_console);
+  runFor(100);
+  booted = true;
+}
+
+// One loop() pass followed by a random stall (another task, a slow flash
+// write); returns the device time the pass ran at
+static uint32_t jitteredLoop() {
+  const uint32_t ms = millis();
+  loop();
+  NativeHost::advanceUs(rnd() % (kJitterUs + 1));
+  return ms;
+}
+
+static void runJittered(uint32_t ms) {
+  const uint32_t end = millis() + ms;
+  while ((int32_t)(millis() - end) < 0) jitteredLoop();
+}
+
+static void sendLine(const char* fmt, uint32_t a, uint32_t b) {
+  char line[LINE_READER_MAX_LINE + 2];
+  snprintf(line, sizeof(line), fmt, (unsigned long)a, (unsigned long)b);
+  g_console.feed(line);
+}
+
+// Device time in the "SYNC <tag> <device_ms>" reply, false when absent
+static bool syncReply(uint32_t tag, uint32_t& deviceMs) {
+  char key[24];
+  snprintf(key, sizeof(key), "SYNC %lu ", (unsigned long)tag);
+  const char* p = g_console.find(key);
+  if (!p) return false;
+  deviceMs = strtoul(p + strlen(key), nullptr, 10);
+  return true;
+}
+
+// ========== SYNC ==========
+static void test_sync_echoes_host_time() {
+  boot();
+  g_console.clearOutput();
+  g_console.feed("SYNC 1718000000123\n");   // wider than 32 bits: echoed verbatim
+  const uint32_t now = jitteredLoop();
+  char expect[48];
+  snprintf(expect, sizeof(expect), "SYNC 1718000000123 %lu\r\n", (unsigned long)now);
+  TEST_ASSERT_TRUE_MESSAGE(g_console.saw(expect), expect);
+
+  g_console.feed("SYNC\n");
+  jitteredLoop();
+  TEST_ASSERT_TRUE(g_console.saw("SYNC 0 "));
+}
+
+// ========== Scheduling ==========
+// Absolute and relative lines, a batch at a time, each run by the frame
+// nearest its timestamp however the loop stalls
+static void test_scheduled_lines_run_within_a_frame() {
+  boot();
+  const CommandQueue::Stats before = CommandQueue::stats();
+  static const uint32_t kBatch = 8;
+  uint32_t tag = 100;
+
+  for (uint32_t round = 0; round < 12; ++round) {
+    g_console.clearOutput();
+    uint32_t at[kBatch];
+    for (uint32_t i = 0; i < kBatch; ++i) {
+      const uint32_t delay = CONTROL_PERIOD_MS + rnd() % 400;
+      at[i] = millis() + delay;   // the next pass reads the line at millis()
+      if (i & 1) {
+        sendLine("@+%lu SYNC %lu\n", delay, tag + i);
+      } else {
+        sendLine("@%lu SYNC %lu\n", at[i], tag + i);
+      }
+      jitteredLoop();
+    }
+    runJittered(500);
+
+    for (uint32_t i = 0; i < kBatch; ++i) {
+      uint32_t ranMs;
+      TEST_ASSERT_TRUE(syncReply(tag + i, ranMs));
+      TEST_ASSERT_INT_WITHIN(CONTROL_PERIOD_MS, (int32_t)at[i], (int32_t)ranMs);
+    }
+    tag += kBatch;
+  }
+
+  const CommandQueue::Stats& after = CommandQueue::stats();
+  TEST_ASSERT_EQUAL_UINT32(before.executed + 12 * kBatch, after.executed);
+  TEST_ASSERT_EQUAL_UINT32(before.late, after.late);
+  TEST_ASSERT_EQUAL_UINT32(0, CommandQueue::depth());
+}
+
+// {"at": ...} JSON lines are queued whole and routed when due
+static void test_json_at_runs_within_a_frame() {
+  boot();
+  Leg::stop();
+  const uint32_t walkAt = millis() + 240;
+  const uint32_t stopAt = walkAt + 330;
+  sendLine("{\"at\":%lu,\"cmd\":\"rex_walk_forward\"}\n{\"at\":%lu,\"cmd\":\"rex_stop\"}\n", walkAt, stopAt);
+
+  uint32_t walkMs = 0, stopMs = 0;
+  bool walking = false;
+  const uint32_t end = stopAt + 100;
+  while ((int32_t)(millis() - end) < 0) {
+    const uint32_t ms = jitteredLoop();
+    const bool now = Leg::mode() != Leg::IDLE;
+    if (now && !walking) walkMs = ms;
+    if (!now && walking) stopMs = ms;
+    walking = now;
+  }
+  TEST_ASSERT_FALSE(walking);
+  TEST_ASSERT_INT_WITHIN(CONTROL_PERIOD_MS, (int32_t)walkAt, (int32_t)walkMs);
+  TEST_ASSERT_INT_WITHIN(CONTROL_PERIOD_MS, (int32_t)stopAt, (int32_t)stopMs);
+}
+
+// ========== Late and rejected ==========
+static void test_stalls_count_late_commands() {
+  boot();
+  runFor(100);
+  const CommandQueue::Stats before = CommandQueue::stats();
+
+  // Due in 5 ms, but the loop stalls for 150 ms
+  g_console.feed("@+5 SYNC 900\n");
+  jitteredLoop();
+  NativeHost::advanceUs(150000);
+  jitteredLoop();
+
+  // Already past on arrival
+  sendLine("@%lu SYNC %lu\n", millis() - 100, 901);
+  runJittered(60);
+
+  // Beyond CMD_QUEUE_HORIZON_MS: refused, never run
+  sendLine("@+%lu SYNC %lu\n", CMD_QUEUE_HORIZON_MS + 1000, 902);
+  runJittered(60);
+
+  const CommandQueue::Stats& after = CommandQueue::stats();
+  uint32_t ranMs;
+  TEST_ASSERT_TRUE(syncReply(900, ranMs));
+  TEST_ASSERT_TRUE(syncReply(901, ranMs));
+  TEST_ASSERT_FALSE(syncReply(902, ranMs));
+  TEST_ASSERT_EQUAL_UINT32(before.late + 2, after.late);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(140, after.maxLateMs);
+  TEST_ASSERT_EQUAL_UINT32(before.rejected + 1, after.rejected);
+  TEST_ASSERT_TRUE(g_console.saw("[CMD] Schedule rejected"));
+
+  g_console.clearOutput();
+  g_console.feed("QUEUE\n");
+  jitteredLoop();
+  char expect[48];
+  snprintf(expect, sizeof(expect), " late=%lu (max %lu ms)",
+           (unsigned long)after.late, (unsigned long)after.maxLateMs);
+  TEST_ASSERT_TRUE_MESSAGE(g_console.saw(expect), expect);
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sync_echoes_host_time);
+  RUN_TEST(test_scheduled_lines_run_within_a_frame);
+  RUN_TEST(test_json_at_runs_within_a_frame);
+  RUN_TEST(test_stalls_count_late_commands);
+  return UNITY_END();
+}
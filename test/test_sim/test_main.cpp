@@ -0,0 +1,92 @@
+// test/test_sim - the kinematic model walks the way the gait commands
+//   pio test -e native -f test_sim
+// Leg_Function drives its own ServoBus on the virtual clock, as in
+// env:sim, and Sim::Model (default Config) follows the written pulses.
+// Checks the direction of travel and turn and that a straight walk only
+// wobbles a few degrees per step.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <NativeHost.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "CommandQueue.h"   // CONTROL_PERIOD_MS
+#include "ServoBus.h"
+#include "Servo_Functions/Leg_Function.h"
+#include "../../sim/SimModel.cpp"   // env:sim sources are outside test_build_src
+
+// ========== Helpers ==========
+static ServoBus   g_bus;
+static Sim::Model g_model;
+
+// Settle for 2 s, then measure `seconds` of the mode at 1 Hz
+static Sim::Stats walk(void (*start)(float), uint32_t seconds) {
+  static bool begun = false;
+  if (!begun) {
+    NativeHost::setClockMode(NativeHost::VIRTUAL);
+    NativeHost::setSerialEnabled(false);
+    g_bus.begin();
+    Leg::begin(&g_bus, Sim::Channels().legs);
+    NativeHost::setAdvanceHook([] { g_model.advanceTo(NativeHost::nowUs()); });
+    begun = true;
+  }
+
+  Leg::stop();
+  g_model.begin(&g_bus);
+  start(1.0f);
+  for (uint32_t ms = 0; ms < (2 + seconds) * 1000; ms += CONTROL_PERIOD_MS) {
+    if (ms == 2000) g_model.resetStats();
+    Leg::tick();
+    g_bus.frame();
+    delay(CONTROL_PERIOD_MS);
+  }
+  return g_model.stats();
+}
+
+static void report(const char* what, const Sim::Stats& s) {
+  char msg[128];
+  snprintf(msg, sizeof(msg), "%s: %.1f mm/s, %+.2f deg/s, %u steps, wobble %.1f deg/step", what,
+           s.pathMm / s.seconds, s.yawDeg / s.seconds, (unsigned)s.steps, s.wobbleDeg);
+  TEST_MESSAGE(msg);
+}
+
+// ========== Tests ==========
+static void test_walk_forward_travels_forward() {
+  const Sim::Stats s = walk(Leg::walkForward, 20);
+  report("WALK_FORWARD", s);
+  TEST_ASSERT_TRUE(s.pathMm > 20.0f * s.seconds);           // > 20 mm/s
+  TEST_ASSERT_TRUE(s.distanceMm > 0.9f * s.pathMm);         // in a line
+  TEST_ASSERT_TRUE(fabsf(s.yawDeg) < 3.0f * s.seconds);     // < 3 deg/s drift
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(35, s.steps);
+  TEST_ASSERT_TRUE(s.wobbleDeg < 10.0f);
+}
+
+static void test_walk_backward_travels_backward() {
+  const Sim::Stats s = walk(Leg::walkBackward, 20);
+  report("WALK_BACKWARD", s);
+  TEST_ASSERT_TRUE(s.pathMm < -20.0f * s.seconds);
+  TEST_ASSERT_TRUE(s.wobbleDeg < 10.0f);
+}
+
+// Positive yaw is to the left (counter-clockwise from above)
+static void test_turns_follow_the_command() {
+  const Sim::Stats l = walk(Leg::turnLeft, 20);
+  report("TURN_LEFT", l);
+  TEST_ASSERT_TRUE(l.yawDeg > 5.0f * l.seconds);
+  const Sim::Stats r = walk(Leg::turnRight, 20);
+  report("TURN_RIGHT", r);
+  TEST_ASSERT_TRUE(r.yawDeg < -5.0f * r.seconds);
+}
+
+// ========== Runner ==========
+void setUp() {}
+void tearDown() {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_walk_forward_travels_forward);
+  RUN_TEST(test_walk_backward_travels_backward);
+  RUN_TEST(test_turns_follow_the_command);
+  return UNITY_END();
+}
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Capture, compare and check Robo Rex micro-benchmark results.
+
+The bench firmware (bench/bench_main.cpp) prints one JSON object per line;
+every other line (boot prints, logs) is ignored. Result files are those
+JSON lines as-is, so they diff cleanly.
+
+Usage:
+    pio run -e bench -t exec > base.jsonl            # host
+    python3 tools/rexbench.py capture /dev/ttyACM0 -o base.jsonl
+    python3 tools/rexbench.py show base.jsonl
+    python3 tools/rexbench.py compare base.jsonl new.jsonl --threshold 10
+    python3 tools/rexbench.py check new.jsonl --max pipeline_rx_line=2000 --no-allocs
+    python3 tools/rexbench.py check new.jsonl --max-stack router_line_json=1024
+compare exits 1 when a benchmark is slower than --threshold percent or
+allocates more than before; check exits 1 when a --max ns/op limit, a
+--max-stack peak stack limit (bytes, one iteration) or --no-allocs is
+violated, for use as a CI gate.
+"""
+
+import argparse
+import json
+import sys
+import time
+
+from rexproto import open_port
+
+
+def parse_lines(lines):
+    """Return (header, {bench: result}) from an iterable of text lines."""
+    header, results = {}, {}
+    for line in lines:
+        line = line.strip()
+        if not line.startswith("{"):
+            continue
+        try:
+            obj = json.loads(line)
+        except ValueError:
+            continue
+        if "bench" in obj:
+            results[obj["bench"]] = obj
+        elif obj.get("suite") == "rexbench":
+            header = obj
+        elif obj.get("suite_done"):
+            header.update(obj)
+    return header, results
+
+
+def load(path):
+    with (sys.stdin if path == "-" else open(path)) as f:
+        return parse_lines(f)
+
+
+def cmd_capture(args):
+    ser = open_port(args.port, timeout=0.1)
+    ser.write(b"\n")   # ask a running bench firmware for a fresh run
+    out = open(args.output, "w") if args.output else sys.stdout
+    buf = b""
+    deadline = time.monotonic() + args.timeout
+    while time.monotonic() < deadline:
+        buf += ser.read(4096)
+        while b"\n" in buf:
+            raw, buf = buf.split(b"\n", 1)
+            line = raw.decode("utf-8", "replace").strip()
+            if not line.startswith("{"):
+                continue
+            out.write(line + "\n")
+            out.flush()
+            if '"suite_done"' in line:
+                return 0
+    print("timed out waiting for the suite to finish", file=sys.stderr)
+    return 1
+
+
+def cmd_show(args):
+    header, results = load(args.file)
+    print("target %s" % header.get("target", "?"))
+    print("%-24s %12s %12s %10s %10s %8s" % ("bench", "ns/op", "cycles/op", "allocs/op", "ops/s", "stack"))
+    for name, r in results.items():
+        ops = 1e9 / r["ns_op"] if r["ns_op"] else 0.0
+        print("%-24s %12.1f %12.1f %10.3f %10.0f %8d" %
+              (name, r["ns_op"], r["cycles_op"], r["allocs_op"], ops, r.get("stack_bytes", 0)))
+    return 0
+
+
+def cmd_compare(args):
+    _, base = load(args.base)
+    _, new = load(args.new)
+    failed = False
+    print("%-24s %12s %12s %8s  %s" % ("bench", "base ns/op", "new ns/op", "delta", "allocs/op"))
+    for name in list(base) + [n for n in new if n not in base]:
+        b, n = base.get(name), new.get(name)
+        if not b or not n:
+            print("%-24s %s" % (name, "only in base" if b else "only in new"))
+            continue
+        delta = (n["ns_op"] - b["ns_op"]) * 100.0 / b["ns_op"] if b["ns_op"] else 0.0
+        flag = ""
+        if delta > args.threshold:
+            flag, failed = " SLOWER", True
+        if n["allocs_op"] > b["allocs_op"]:
+            flag, failed = flag + " ALLOCS", True
+        print("%-24s %12.1f %12.1f %+7.1f%%  %.3f -> %.3f%s" %
+              (name, b["ns_op"], n["ns_op"], delta, b["allocs_op"], n["allocs_op"], flag))
+    return 1 if failed else 0
+
+
+def cmd_check(args):
+    _, results = load(args.file)
+    failed = False
+    for spec in args.max:
+        name, _, limit = spec.partition("=")
+        r = results.get(name)
+        if r is None:
+            print("%s: missing" % name)
+            failed = True
+        elif r["ns_op"] > float(limit):
+            print("%s: %.1f ns/op exceeds %s" % (name, r["ns_op"], limit))
+            failed = True
+    for spec in args.max_stack:
+        name, _, limit = spec.partition("=")
+        r = results.get(name)
+        if r is None or "stack_bytes" not in r:
+            print("%s: no stack figure" % name)
+            failed = True
+        elif r["stack_bytes"] > int(limit):
+            print("%s: %d stack bytes exceeds %s" % (name, r["stack_bytes"], limit))
+            failed = True
+    if args.no_allocs:
+        for name, r in results.items():
+            if r["allocs_op"] > 0:
+                print("%s: %.3f allocs/op" % (name, r["allocs_op"]))
+                failed = True
+    if not results:
+        print("no benchmark results found")
+        failed = True
+    print("FAIL" if failed else "OK")
+    return 1 if failed else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("capture", help="read a run from the bench firmware")
+    p.add_argument("port")
+    p.add_argument("-o", "--output")
+    p.add_argument("--timeout", type=float, default=120.0)
+    p.set_defaults(fn=cmd_capture)
+
+    p = sub.add_parser("show", help="print a result file as a table")
+    p.add_argument("file")
+    p.set_defaults(fn=cmd_show)
+
+    p = sub.add_parser("compare", help="diff two result files")
+    p.add_argument("base")
+    p.add_argument("new")
+    p.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent")
+    p.set_defaults(fn=cmd_compare)
+
+    p = sub.add_parser("check", help="enforce absolute limits")
+    p.add_argument("file")
+    p.add_argument("--max", action="append", default=[], metavar="BENCH=NS", help="ns/op ceiling")
+    p.add_argument("--max-stack", action="append", default=[], metavar="BENCH=BYTES",
+                   help="peak stack ceiling")
+    p.add_argument("--no-allocs", action="store_true", help="fail if any benchmark allocates")
+    p.set_defaults(fn=cmd_check)
+
+    args = ap.parse_args()
+    sys.exit(args.fn(args))
+
+
+if __name__ == "__main__":
+    main()
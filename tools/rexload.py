@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Load-test the Robo Rex command stack over any transport.
+
+Sends a mix of raw verbs, legacy rex_* verbs, JSON schema messages and
+binary SET_JOINTS frames at a fixed rate. A "SYNC <n>" marker goes out
+every --sync-every commands; its reply gives the round-trip time and
+proves that every line before it was read (lines are handled in order).
+Ends with STATUS and QUEUE so the device-side counters land in the log.
+
+Against the native build (pio run -e native):
+    REX_TRANSPORT=pty .pio/build/native/program &    # prints the pty path
+    python3 tools/rexload.py /dev/pts/N --rate 5000 --seconds 10
+Against hardware:
+    python3 tools/rexload.py /dev/ttyACM0 --rate 500 --seconds 10
+"""
+
+import argparse
+import itertools
+import sys
+import time
+
+from rexproto import FrameReader, MSG_SET_JOINTS, encode, open_port, set_joints
+
+MIX = [
+    b"WALK_FORWARD\n",
+    b"rex_speed_adjust 0.01\n",
+    b'{"target":"legsPelvis","part":"legs","command":"move_left","phase":"hold"}\n',
+    b"PELVIS_LEFT\n",
+    b'{"cmd":"rex_posture","level":0.6}\n',
+    b"TURN_RIGHT\n",
+    None,   # binary SET_JOINTS frame
+    b"STOP\n",
+]
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p / 100.0 * len(values)))]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port")
+    ap.add_argument("--rate", type=float, default=1000.0, help="commands per second")
+    ap.add_argument("--seconds", type=float, default=5.0)
+    ap.add_argument("--sync-every", type=int, default=25)
+    ap.add_argument("--echo", action="store_true", help="print device text lines")
+    args = ap.parse_args()
+
+    ser = open_port(args.port, timeout=0)
+    reader = FrameReader()
+    sent_at = {}          # sync id -> host send time
+    rtts = []
+    lines = 0
+
+    def pump():
+        nonlocal lines
+        for kind, item in reader.feed(ser.read(65536)):
+            if kind != "line":
+                continue
+            lines += 1
+            if args.echo:
+                print(item)
+            parts = item.split()
+            if len(parts) == 3 and parts[0] == "SYNC" and parts[1].isdigit():
+                t = sent_at.pop(int(parts[1]), None)
+                if t is not None:
+                    rtts.append(time.monotonic() - t)
+
+    period = 1.0 / args.rate
+    seq = 0
+    sent = syncs = 0
+    t0 = time.monotonic()
+    next_t = t0
+    for i in itertools.count():
+        if time.monotonic() - t0 >= args.seconds:
+            break
+        if i % args.sync_every == args.sync_every - 1:
+            sent_at[syncs] = time.monotonic()
+            ser.write(b"SYNC %d\n" % syncs)
+            syncs += 1
+        else:
+            msg = MIX[i % len(MIX)]
+            if msg is None:
+                msg = encode(MSG_SET_JOINTS, seq, set_joints([1500 + (i % 50)] * 16))
+                seq = (seq + 1) & 0xFF
+            ser.write(msg)
+        sent += 1
+        next_t += period
+        pump()
+        delay = next_t - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+    elapsed = time.monotonic() - t0
+
+    # Drain outstanding replies, then ask for the device-side counters
+    deadline = time.monotonic() + 2.0
+    while sent_at and time.monotonic() < deadline:
+        pump()
+    args.echo = True
+    ser.write(b"STATUS\nQUEUE\n")
+    deadline = time.monotonic() + 0.5
+    while time.monotonic() < deadline:
+        pump()
+
+    ms = [r * 1000.0 for r in rtts]
+    print("sent %d commands in %.2f s (%.0f/s)" % (sent, elapsed, sent / elapsed))
+    print("sync replies %d/%d, rtt ms p50 %.2f p99 %.2f max %.2f" %
+          (len(rtts), syncs, percentile(ms, 50), percentile(ms, 99), max(ms) if ms else 0.0))
+    print("device text lines received: %d" % lines)
+    sys.exit(0 if len(rtts) == syncs else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,421 @@
+#!/usr/bin/env python3
+"""Compile and manage Robo Rex choreography files (src/Choreo.h).
+
+Shows are RXM1 files in the robot's LittleFS partition: a 16-byte header
+and delta-encoded PCA9685 counts per control frame. Uploads use the
+FILE_BEGIN / FILE_DATA / FILE_END frames of the binary protocol; every
+frame is acknowledged, and a lost ack resumes from the device's offset.
+
+`compile` turns a timeline of (channel, time, angle) keyframes into a show.
+Channels are numbers (0-15) or joint names (see JOINTS), times are seconds
+and angles degrees, mapped with the same pulse limits as the firmware
+modules. CSV needs a header row with channel,time,angle columns; JSON is a
+list of {"channel", "time", "angle"} objects or {"keyframes": [...]}.
+Every channel is interpolated onto the 20 ms control frame grid,
+quantized to PCA9685 counts, and written only on the frames it changes.
+
+Usage:
+    python3 tools/rexmotion.py compile tools/shows/roar_wag.csv -o roar_wag.rxm [--interp smooth]
+    python3 tools/rexmotion.py info show.rxm [--frames]
+    python3 tools/rexmotion.py upload /dev/ttyACM0 show.rxm [--name roar_wag]
+    python3 tools/rexmotion.py list /dev/ttyACM0
+    python3 tools/rexmotion.py play /dev/ttyACM0 roar_wag
+    python3 tools/rexmotion.py stop /dev/ttyACM0
+"""
+
+import argparse
+import csv
+import json
+import math
+import os
+import re
+import struct
+import sys
+import time
+
+MAGIC = b"RXM1"
+HEADER_FORMAT = "<4sHHHHI"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+SERVO_COUNT = 16
+PCA_STEPS = 4096
+FRAME_MS = 20          # CONTROL_PERIOD_MS
+PERIOD_US = 20000      # 50 Hz servo PWM
+NAME_RE = re.compile(r"^[A-Za-z0-9_-]{1,24}$")
+
+# Channel map of src/main.cpp and the limits each module attaches with
+# (ServoLimits: minPulse, maxPulse, minDeg, maxDeg). Keep in step with
+# src/Servo_Functions; calibration trims are added on the robot.
+_LEG = (500, 2500, 10.0, 170.0)
+JOINTS = {
+    "neck.yaw":    (0,  (500, 2500, 30.0, 150.0)),
+    "head.jaw":    (1,  (500, 2500, 30.0, 150.0)),
+    "head.pitch":  (2,  (500, 2500, 30.0, 150.0)),
+    "pelvis.roll": (3,  (700, 2400, 0.0, 180.0)),
+    "spine.yaw":   (4,  (500, 2500, 0.0, 180.0)),
+    "tail.wag":    (5,  (500, 2500, 0.0, 180.0)),
+    "leg.R_hipX":  (6,  _LEG),
+    "leg.R_hipY":  (7,  _LEG),
+    "leg.R_knee":  (8,  _LEG),
+    "leg.R_ankle": (9,  _LEG),
+    "leg.R_foot":  (10, _LEG),
+    "leg.L_hipX":  (11, _LEG),
+    "leg.L_hipY":  (12, _LEG),
+    "leg.L_knee":  (13, _LEG),
+    "leg.L_ankle": (14, _LEG),
+    "leg.L_foot":  (15, _LEG),
+}
+LIMITS = {ch: lim for ch, lim in JOINTS.values()}
+
+
+# ========== File Format ==========
+
+def varint(buf, pos):
+    value, shift = 0, 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+def parse_header(buf):
+    magic, frame_ms, period_us, mask, flags, frames = struct.unpack_from(HEADER_FORMAT, buf)
+    if magic != MAGIC:
+        raise ValueError("not an RXM1 file (bad magic)")
+    return {"frame_ms": frame_ms, "period_us": period_us, "mask": mask, "flags": flags, "frames": frames}
+
+
+def records(buf):
+    """Yield (frame, mask, counts) per record; counts is the full 16-channel state."""
+    pos, frame = HEADER_SIZE, 0
+    counts = [0] * SERVO_COUNT
+    while pos < len(buf):
+        delta, pos = varint(buf, pos)
+        frame += delta
+        mask = buf[pos] | (buf[pos + 1] << 8)
+        pos += 2
+        for ch in range(SERVO_COUNT):
+            if mask & (1 << ch):
+                z, pos = varint(buf, pos)
+                counts[ch] = (counts[ch] + ((z >> 1) ^ -(z & 1))) & 0xFFFF
+        yield frame, mask, list(counts)
+
+
+def counts_to_us(counts, period_us):
+    return (counts * period_us + PCA_STEPS // 2) // PCA_STEPS
+
+
+def put_varint(out, v):
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+
+
+def zigzag(v):
+    return v << 1 if v >= 0 else ((-v) << 1) - 1
+
+
+def encode_show(frames, states):
+    """states: list of (frame, {channel: counts}) in frame order, each the
+    full state of the channels that have started. Returns the file bytes."""
+    mask_all, body = 0, bytearray()
+    prev, last_frame = [0] * SERVO_COUNT, 0
+    for frame, values in states:
+        mask, deltas = 0, bytearray()
+        for ch in range(SERVO_COUNT):
+            if ch in values and values[ch] != prev[ch]:
+                mask |= 1 << ch
+                put_varint(deltas, zigzag(values[ch] - prev[ch]))
+                prev[ch] = values[ch]
+        if not mask:
+            continue
+        put_varint(body, frame - last_frame)
+        body += struct.pack("<H", mask) + deltas
+        last_frame = frame
+        mask_all |= mask
+    return struct.pack(HEADER_FORMAT, MAGIC, FRAME_MS, PERIOD_US, mask_all, 0, frames) + bytes(body)
+
+
+# ========== Compiler ==========
+
+def channel_of(name):
+    name = str(name).strip()
+    if name in JOINTS:
+        return JOINTS[name][0]
+    if name.isdigit() and int(name) < SERVO_COUNT:
+        return int(name)
+    raise ValueError("unknown channel %r (0-15 or one of %s)" % (name, ", ".join(JOINTS)))
+
+
+def load_timeline(path):
+    """Return {channel: [(time_s, angle_deg), ...]} sorted by time."""
+    with open(path, newline="") as f:
+        if path.lower().endswith(".json"):
+            doc = json.load(f)
+            rows = doc["keyframes"] if isinstance(doc, dict) else doc
+        else:
+            rows = [r for r in csv.DictReader(f) if any((v or "").strip() for v in r.values())]
+    tracks = {}
+    for r in rows:
+        ch = channel_of(r["channel"])
+        tracks.setdefault(ch, []).append((float(r["time"]), float(r["angle"])))
+    for keys in tracks.values():
+        keys.sort(key=lambda k: k[0])
+    return tracks
+
+
+def sample(keys, t, interp):
+    """Angle of one track at time t (holds before the first / after the last key)."""
+    if t <= keys[0][0]:
+        return keys[0][1]
+    for (t0, a0), (t1, a1) in zip(keys, keys[1:]):
+        if t < t1:
+            u = (t - t0) / (t1 - t0)
+            if interp == "step":
+                u = 0.0
+            elif interp == "smooth":
+                u = 0.5 - 0.5 * math.cos(math.pi * u)
+            return a0 + (a1 - a0) * u
+    return keys[-1][1]
+
+
+def angle_to_counts(ch, deg):
+    """Degrees -> PCA9685 counts, with ServoBus's clamp and linear map."""
+    min_us, max_us, min_deg, max_deg = LIMITS[ch]
+    d = min(max(deg, min_deg), max_deg)
+    us = min_us + (d - min_deg) / (max_deg - min_deg) * (max_us - min_us)
+    return int(round(us * PCA_STEPS / PERIOD_US))
+
+
+def compile_timeline(tracks, interp="linear", hold_s=0.0, deadband=0):
+    """Resample onto the frame grid; returns (frames, states) for encode_show()."""
+    end_s = max(keys[-1][0] for keys in tracks.values()) + hold_s
+    frames = int(math.floor(end_s * 1000 / FRAME_MS + 1e-9)) + 1
+    states, last = [], {}
+    for frame in range(frames):
+        t = frame * FRAME_MS / 1000.0
+        values = {}
+        for ch, keys in tracks.items():
+            if t + 1e-9 < keys[0][0]:
+                continue   # not started: the channel keeps whatever it was doing
+            c = angle_to_counts(ch, sample(keys, t, interp))
+            # Deadband: skip changes smaller than `deadband` counts, but
+            # always land exactly on a keyframe
+            on_key = any(abs(t - k[0]) < FRAME_MS / 2000.0 for k in keys)
+            if ch in last and abs(c - last[ch]) < deadband and not on_key:
+                c = last[ch]
+            values[ch] = last[ch] = c
+        states.append((frame, values))
+    return frames, states
+
+
+# ========== Device I/O ==========
+
+def send_line(ser, line):
+    ser.write(line.encode() + b"\n")
+
+
+def read_lines(ser, until, timeout):
+    """Print device lines until one matches `until` (regex); return it or None."""
+    buf = b""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        buf += ser.read(4096)
+        while b"\n" in buf:
+            raw, buf = buf.split(b"\n", 1)
+            line = raw.replace(b"\x00", b"").decode("utf-8", "replace").strip()
+            if not line:
+                continue
+            print(line)
+            if re.search(until, line):
+                return line
+    return None
+
+
+def upload(ser, name, data, timeout=2.0, retries=5):
+    """Send data as /<name>.rxm; returns True when the device stored it."""
+    from rexproto import (MSG_FILE_ACK, MSG_FILE_BEGIN, MSG_FILE_DATA, MSG_FILE_END, FILE_CHUNK,
+                          FILE_STATUS, FrameReader, encode, file_begin, file_data, file_end,
+                          parse_file_ack)
+
+    reader = FrameReader()
+    seq = [0]
+
+    def request(msg_type, payload):
+        for _ in range(retries):
+            ser.write(encode(msg_type, seq[0], payload))
+            seq[0] = (seq[0] + 1) & 0xFF
+            deadline = time.monotonic() + timeout
+            while time.monotonic() < deadline:
+                for kind, item in reader.feed(ser.read(256)):
+                    if kind == "frame" and item[0] == MSG_FILE_ACK:
+                        return parse_file_ack(item[2])
+        raise TimeoutError("no FILE_ACK from the device")
+
+    ser.reset_input_buffer()
+    ack = request(MSG_FILE_BEGIN, file_begin(name, len(data)))
+    if ack["status"] != 0:
+        print("upload refused: %s" % FILE_STATUS[ack["status"]], file=sys.stderr)
+        return False
+
+    offset, t0 = 0, time.monotonic()
+    while offset < len(data):
+        ack = request(MSG_FILE_DATA, file_data(offset, data[offset:offset + FILE_CHUNK]))
+        if ack["status"] not in (0, FILE_STATUS.index("ERR_OFFSET")):
+            print("upload failed at byte %d: %s" % (offset, FILE_STATUS[ack["status"]]), file=sys.stderr)
+            return False
+        offset = ack["offset"]   # resumes after a lost ack
+    ack = request(MSG_FILE_END, file_end(data))
+    if ack["status"] != 0:
+        print("upload failed: %s" % FILE_STATUS[ack["status"]], file=sys.stderr)
+        return False
+
+    dt = time.monotonic() - t0
+    print("%s: %d bytes in %.2f s (%.0f bytes/s)" % (name, len(data), dt, len(data) / dt if dt else 0.0))
+    return True
+
+
+# ========== CLI ==========
+
+def cmd_compile(args):
+    tracks = load_timeline(args.timeline)
+    if not tracks:
+        print("%s: no keyframes" % args.timeline, file=sys.stderr)
+        return 1
+    frames, states = compile_timeline(tracks, args.interp, args.hold, args.deadband)
+    data = encode_show(frames, states)
+    out = args.output or os.path.splitext(args.timeline)[0] + ".rxm"
+    with open(out, "wb") as f:
+        f.write(data)
+
+    # Uncompressed equivalent: every used channel as u16 counts in every frame
+    seconds = frames * FRAME_MS / 1000.0
+    raw = frames * len(tracks) * 2
+    sizes = [(frame, len(r)) for frame, r in records_of(data)]
+    window = 1000 // FRAME_MS
+    peak_rate = max((sum(n for f, n in sizes if start <= f < start + window) for start, _ in sizes), default=0)
+    keys = sum(len(k) for k in tracks.values())
+    print("%s: %d keyframes on %d channels -> %d frames (%.2f s), %d records" %
+          (out, keys, len(tracks), frames, seconds, len(sizes)))
+    print("  %d bytes, raw %d bytes per-frame u16 counts: ratio %.1f:1" % (len(data), raw, raw / len(data)))
+    print("  playback %.0f bytes/s average, %d bytes/s peak (1 s window), largest record %d bytes" %
+          (len(data) / seconds, peak_rate, max((n for _, n in sizes), default=0)))
+    return 0
+
+
+def records_of(buf):
+    """(frame, record bytes) per record, for size statistics."""
+    pos, frame = HEADER_SIZE, 0
+    while pos < len(buf):
+        start = pos
+        delta, pos = varint(buf, pos)
+        frame += delta
+        mask = buf[pos] | (buf[pos + 1] << 8)
+        pos += 2
+        for _ in range(bin(mask).count("1")):
+            _, pos = varint(buf, pos)
+        yield frame, buf[start:pos]
+
+
+def cmd_info(args):
+    with open(args.file, "rb") as f:
+        buf = f.read()
+    h = parse_header(buf)
+    n = 0
+    for frame, mask, counts in records(buf):
+        n += 1
+        if args.frames:
+            us = [counts_to_us(c, h["period_us"]) if h["mask"] & (1 << ch) else 0 for ch, c in enumerate(counts)]
+            print("%6d  %04x  %s" % (frame, mask, " ".join("%4d" % v for v in us)))
+    seconds = h["frames"] * h["frame_ms"] / 1000.0
+    print("%s: %d bytes, %d frames of %d ms (%.2f s), %d records, channels %04x, %.0f bytes/s" %
+          (args.file, len(buf), h["frames"], h["frame_ms"], seconds, n, h["mask"],
+           len(buf) / seconds if seconds else 0.0))
+    return 0
+
+
+def cmd_upload(args):
+    from rexproto import open_port
+
+    name = args.name or os.path.splitext(os.path.basename(args.file))[0]
+    if not NAME_RE.match(name):
+        print("bad name %r (A-Z a-z 0-9 _ -, up to 24 characters)" % name, file=sys.stderr)
+        return 1
+    with open(args.file, "rb") as f:
+        data = f.read()
+    parse_header(data)
+    return 0 if upload(open_port(args.port, timeout=0.05), name, data) else 1
+
+
+def cmd_list(args):
+    from rexproto import open_port
+
+    ser = open_port(args.port, timeout=0.1)
+    send_line(ser, "CHOREO_LIST")
+    return 0 if read_lines(ser, r"\[Choreo\] \d+ show", args.timeout) else 1
+
+
+def cmd_play(args):
+    from rexproto import open_port
+
+    ser = open_port(args.port, timeout=0.1)
+    send_line(ser, "CHOREO_PLAY " + args.name)
+    return 0 if read_lines(ser, r"\[Choreo\] (Playing|No show|ERROR)", args.timeout) else 1
+
+
+def cmd_stop(args):
+    from rexproto import open_port
+
+    send_line(open_port(args.port, timeout=0.1), "CHOREO_STOP")
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("compile", help="compile a CSV/JSON timeline into an RXM1 show")
+    p.add_argument("timeline")
+    p.add_argument("-o", "--output", help="default: the timeline name with .rxm")
+    p.add_argument("--interp", choices=["linear", "smooth", "step"], default="linear",
+                   help="between keyframes: straight, eased (cosine) or hold")
+    p.add_argument("--hold", type=float, default=0.0, help="seconds to hold the last pose")
+    p.add_argument("--deadband", type=int, default=0,
+                   help="drop changes smaller than this many counts (1 count = 4.9 us)")
+    p.set_defaults(fn=cmd_compile)
+
+    p = sub.add_parser("info", help="summarize (or dump) an RXM1 file")
+    p.add_argument("file")
+    p.add_argument("--frames", action="store_true", help="print the pulses of every record")
+    p.set_defaults(fn=cmd_info)
+
+    p = sub.add_parser("upload", help="store a show on the robot")
+    p.add_argument("port")
+    p.add_argument("file")
+    p.add_argument("--name", help="name on the robot (default: file name without extension)")
+    p.set_defaults(fn=cmd_upload)
+
+    p = sub.add_parser("list", help="list the shows stored on the robot")
+    p.add_argument("port")
+    p.add_argument("--timeout", type=float, default=3.0)
+    p.set_defaults(fn=cmd_list)
+
+    p = sub.add_parser("play", help="start a stored show")
+    p.add_argument("port")
+    p.add_argument("name")
+    p.add_argument("--timeout", type=float, default=3.0)
+    p.set_defaults(fn=cmd_play)
+
+    p = sub.add_parser("stop", help="stop the show playing")
+    p.add_argument("port")
+    p.set_defaults(fn=cmd_stop)
+
+    args = ap.parse_args()
+    sys.exit(args.fn(args))
+
+
+if __name__ == "__main__":
+    main()
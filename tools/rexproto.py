@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+"""Host side of the Robo Rex binary protocol (see src/RexProtocol.h).
+
+Frame (before COBS):  type:u8  seq:u8  payload  crc16:u16le
+Wire:                 0x00  COBS(frame)  0x00
+
+Usage as a library:
+    from rexproto import encode, FrameReader, set_joints
+Usage from the shell (pyserial, or any POSIX tty without it):
+    python3 tools/rexproto.py /dev/ttyACM0 stream --hz 100 --seconds 5
+    python3 tools/rexproto.py /dev/ttyACM0 gait --speed 1.0 --stride 0.8 --lift 0.6 --mode 1
+    python3 tools/rexproto.py /dev/ttyACM0 telemetry
+"""
+
+import argparse
+import math
+import struct
+import sys
+import time
+
+MSG_SET_JOINTS = 0x01
+MSG_SET_GAIT = 0x02
+MSG_TELEMETRY_REQ = 0x03
+MSG_FILE_BEGIN = 0x04
+MSG_FILE_DATA = 0x05
+MSG_FILE_END = 0x06
+MSG_TELEMETRY = 0x83
+MSG_STATE = 0x84
+MSG_FILE_ACK = 0x85
+
+JOINTS = 16
+MAX_PAYLOAD = 64
+GAIT_FLAG_RUN = 0x01
+STATE_FLAG_STREAMING = 0x01
+
+FILE_NAME_MAX = 24
+FILE_CHUNK = MAX_PAYLOAD - 4
+MAX_RAW = 2 + MAX_PAYLOAD + 2
+MAX_BODY = MAX_RAW + MAX_RAW // 254 + 1   # COBS bytes between the delimiters
+FILE_STATUS = ["OK", "ERR_NAME", "ERR_SIZE", "ERR_OPEN", "ERR_STATE", "ERR_OFFSET", "ERR_WRITE", "ERR_CRC"]
+
+
+# ========== Codec ==========
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_idx, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_idx] = code
+            code_idx, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_idx] = code
+                code_idx, code = len(out), 1
+                out.append(0)
+    out[code_idx] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            raise ValueError("bad COBS block")
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode(msg_type, seq, payload=b""):
+    if len(payload) > MAX_PAYLOAD:
+        raise ValueError("payload too large")
+    raw = bytes([msg_type, seq & 0xFF]) + bytes(payload)
+    raw += struct.pack("<H", crc16(raw))
+    return b"\x00" + cobs_encode(raw) + b"\x00"
+
+
+def decode(body):
+    """Decode the bytes between delimiters -> (type, seq, payload)."""
+    raw = cobs_decode(body)
+    if len(raw) < 4:
+        raise ValueError("short frame")
+    (crc,) = struct.unpack("<H", raw[-2:])
+    if crc16(raw[:-2]) != crc:
+        raise ValueError("crc mismatch")
+    return raw[0], raw[1], raw[2:-2]
+
+
+class FrameReader:
+    """Splits a mixed text/binary byte stream into frames and text lines.
+
+    Like the firmware's LineReader, frame mode is abandoned (the bytes are
+    text again) past MAX_BODY bytes, or at a newline after nothing but text:
+    a frame's second byte is its type, which is never printable. Only
+    printable bytes carry over into the line.
+    """
+
+    def __init__(self):
+        self._buf = bytearray()
+        self._in_frame = False
+        self._text = False
+
+    def feed(self, data):
+        """Yield ('frame', (type, seq, payload)), ('error', body) or ('line', str) items."""
+        for b in data:
+            if self._in_frame:
+                if b == 0:
+                    if not self._buf:
+                        continue
+                    body, self._buf, self._in_frame = bytes(self._buf), bytearray(), False
+                    try:
+                        yield "frame", decode(body)
+                    except ValueError:
+                        yield "error", body
+                    continue
+                if not (b == 0x0A and self._buf and self._text) and len(self._buf) < MAX_BODY:
+                    self._buf.append(b)
+                    self._text = self._text and (0x20 <= b < 0x7F or b in (0x09, 0x0D))
+                    continue
+                self._in_frame = False
+                self._buf = self._buf.replace(b"\r", b"") if self._text else bytearray()
+            if b == 0:
+                self._in_frame, self._buf, self._text = True, bytearray(), True
+            elif b == 0x0A:
+                line, self._buf = self._buf.decode(errors="replace").strip(), bytearray()
+                if line:
+                    yield "line", line
+            elif b != 0x0D:
+                self._buf.append(b)
+
+
+# ========== Payloads ==========
+
+def set_joints(us):
+    """us: 16 pulse widths in microseconds (0 = leave unchanged)."""
+    if len(us) != JOINTS:
+        raise ValueError("need 16 channels")
+    return struct.pack("<16H", *[int(v) for v in us])
+
+
+def set_gait(speed_hz, stride, lift, mode, run=False):
+    return struct.pack("<HBBBB",
+                       int(round(speed_hz * 1000)),
+                       int(round(max(0.0, min(1.0, stride)) * 255)),
+                       int(round(max(0.0, min(1.0, lift)) * 255)),
+                       int(mode),
+                       GAIT_FLAG_RUN if run else 0)
+
+
+def parse_telemetry(payload):
+    ms, *rest = struct.unpack("<I16HBB", payload)
+    return {"ms": ms, "us": rest[:JOINTS], "leg_mode": rest[JOINTS], "streaming": rest[JOINTS + 1]}
+
+
+def file_begin(name, size):
+    raw = name.encode()
+    if not 1 <= len(raw) <= FILE_NAME_MAX:
+        raise ValueError("file name must be 1..%d characters" % FILE_NAME_MAX)
+    return struct.pack("<I", size) + raw
+
+
+def file_data(offset, chunk):
+    if len(chunk) > FILE_CHUNK:
+        raise ValueError("chunk too large")
+    return struct.pack("<I", offset) + bytes(chunk)
+
+
+def file_end(data):
+    return struct.pack("<H", crc16(data))
+
+
+def parse_file_ack(payload):
+    status, offset = struct.unpack("<BI", payload)
+    return {"status": status, "offset": offset}
+
+
+STATE_FORMAT = "<I16HHHHHBBBBB"
+
+
+def parse_state(payload):
+    ms, *rest = struct.unpack(STATE_FORMAT, payload)
+    (phase, period_us, busy_us, overruns,
+     leg_mode, flags, cmd_queue, log_pending, rx_pending) = rest[JOINTS:]
+    return {"ms": ms, "us": rest[:JOINTS], "phase": phase / 65535.0,
+            "period_us": period_us, "busy_us": busy_us, "overruns": overruns,
+            "leg_mode": leg_mode, "streaming": flags & STATE_FLAG_STREAMING,
+            "cmd_queue": cmd_queue, "log_pending": log_pending, "rx_pending": rx_pending}
+
+
+# ========== Ports ==========
+
+class _RawTTY:
+    """Minimal pyserial stand-in for POSIX ttys and the native build's pty."""
+
+    def __init__(self, path, timeout):
+        import os
+        import termios
+        import tty
+        self._os = os
+        self.timeout = timeout
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        if os.isatty(self.fd):
+            tty.setraw(self.fd)
+            attrs = termios.tcgetattr(self.fd)
+            attrs[4] = attrs[5] = termios.B115200
+            termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+
+    def read(self, n):
+        import select
+        r, _, _ = select.select([self.fd], [], [], self.timeout)
+        return self._os.read(self.fd, n) if r else b""
+
+    def write(self, data):
+        view = memoryview(data)
+        while view:
+            view = view[self._os.write(self.fd, view):]
+
+    def reset_input_buffer(self):
+        while self.read(4096):
+            pass
+
+    def close(self):
+        self._os.close(self.fd)
+
+
+def open_port(path, timeout=0.05):
+    """pyserial when installed, otherwise a raw POSIX tty (Linux/macOS)."""
+    try:
+        import serial
+    except ImportError:
+        return _RawTTY(path, timeout)
+    return serial.Serial(path, 115200, timeout=timeout)
+
+
+# ========== CLI ==========
+
+def _open(port):
+    return open_port(port)
+
+
+def _cmd_stream(ser, args):
+    period = 1.0 / args.hz
+    seq = 0
+    t0 = time.monotonic()
+    next_t = t0
+    while time.monotonic() - t0 < args.seconds:
+        t = time.monotonic() - t0
+        us = [int(1500 + args.amp * math.sin(2 * math.pi * 0.5 * t + ch * 0.4)) for ch in range(JOINTS)]
+        ser.write(encode(MSG_SET_JOINTS, seq, set_joints(us)))
+        seq = (seq + 1) & 0xFF
+        next_t += period
+        time.sleep(max(0.0, next_t - time.monotonic()))
+    print("sent %d frames in %.2f s" % (int(args.seconds * args.hz), time.monotonic() - t0))
+
+
+def _cmd_gait(ser, args):
+    ser.write(encode(MSG_SET_GAIT, 0, set_gait(args.speed, args.stride, args.lift, args.mode, args.run)))
+
+
+def _cmd_telemetry(ser, args):
+    ser.reset_input_buffer()
+    ser.write(encode(MSG_TELEMETRY_REQ, 0))
+    reader = FrameReader()
+    deadline = time.monotonic() + 1.0
+    while time.monotonic() < deadline:
+        for kind, item in reader.feed(ser.read(256)):
+            if kind == "frame" and item[0] == MSG_TELEMETRY:
+                print(parse_telemetry(item[2]))
+                return
+    print("no telemetry reply", file=sys.stderr)
+    sys.exit(1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    s = sub.add_parser("stream", help="stream a sine pattern to all 16 joints")
+    s.add_argument("--hz", type=float, default=100.0)
+    s.add_argument("--seconds", type=float, default=5.0)
+    s.add_argument("--amp", type=float, default=200.0, help="pulse amplitude in us")
+
+    g = sub.add_parser("gait", help="send SET_GAIT")
+    g.add_argument("--speed", type=float, default=1.0)
+    g.add_argument("--stride", type=float, default=1.0)
+    g.add_argument("--lift", type=float, default=0.8)
+    g.add_argument("--mode", type=int, default=1, help="0 idle, 1 fwd, 2 bwd, 3 left, 4 right")
+    g.add_argument("--run", action="store_true")
+
+    sub.add_parser("telemetry", help="request one telemetry frame")
+
+    args = ap.parse_args()
+    ser = _open(args.port)
+    {"stream": _cmd_stream, "gait": _cmd_gait, "telemetry": _cmd_telemetry}[args.cmd](ser, args)
+
+
+if __name__ == "__main__":
+    main()
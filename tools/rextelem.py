@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Record the Robo Rex binary state stream (MSG_STATE) to CSV.
+
+Starts the stream with "TELEM <hz>", writes one CSV row per frame and
+stops it again on exit. Text lines from the device go to stderr.
+
+Usage:
+    python3 tools/rextelem.py /dev/ttyACM0 --hz 100 --seconds 10 -o run.csv
+Decode a raw capture instead of a live port:
+    python3 tools/rextelem.py --input capture.bin -o run.csv
+"""
+
+import argparse
+import csv
+import sys
+import time
+
+from rexproto import FrameReader, MSG_STATE, JOINTS, open_port, parse_state
+
+COLUMNS = (["host_s", "seq", "ms"] + ["us%d" % ch for ch in range(JOINTS)] +
+           ["phase", "period_us", "busy_us", "overruns", "leg_mode", "streaming",
+            "cmd_queue", "log_pending", "rx_pending"])
+
+
+class Recorder:
+    def __init__(self, out):
+        self.writer = csv.writer(out)
+        self.writer.writerow(COLUMNS)
+        self.reader = FrameReader()
+        self.t0 = time.monotonic()
+        self.frames = self.errors = self.gaps = 0
+        self.last_seq = None
+
+    def feed(self, data):
+        for kind, item in self.reader.feed(data):
+            if kind == "line":
+                print(item, file=sys.stderr)
+            elif kind == "error":
+                self.errors += 1
+            elif item[0] == MSG_STATE:
+                self._row(item[1], item[2])
+
+    def _row(self, seq, payload):
+        try:
+            s = parse_state(payload)
+        except Exception:
+            self.errors += 1
+            return
+        # The device shares one TX sequence between all frame types, so a
+        # gap here may also be a reply frame rather than a lost state frame.
+        if self.last_seq is not None and seq != (self.last_seq + 1) & 0xFF:
+            self.gaps += 1
+        self.last_seq = seq
+        self.frames += 1
+        self.writer.writerow(["%.4f" % (time.monotonic() - self.t0), seq, s["ms"]] + list(s["us"]) +
+                             ["%.4f" % s["phase"], s["period_us"], s["busy_us"], s["overruns"],
+                              s["leg_mode"], s["streaming"], s["cmd_queue"], s["log_pending"],
+                              s["rx_pending"]])
+
+    def summary(self):
+        return "%d frames, %d bad, %d sequence gaps" % (self.frames, self.errors, self.gaps)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", nargs="?")
+    ap.add_argument("--input", help="decode a raw byte capture instead of a port")
+    ap.add_argument("--hz", type=int, default=100)
+    ap.add_argument("--seconds", type=float, default=0, help="0 = until Ctrl-C")
+    ap.add_argument("-o", "--out", help="CSV file (default stdout)")
+    args = ap.parse_args()
+
+    out = open(args.out, "w", newline="") if args.out else sys.stdout
+    rec = Recorder(out)
+
+    if args.input:
+        with open(args.input, "rb") as f:
+            rec.feed(f.read())
+    elif args.port:
+        ser = open_port(args.port)
+        ser.write(b"TELEM %d\n" % args.hz)
+        try:
+            while not args.seconds or time.monotonic() - rec.t0 < args.seconds:
+                rec.feed(ser.read(4096))
+        except KeyboardInterrupt:
+            pass
+        finally:
+            ser.write(b"TELEM 0\n")
+    else:
+        ap.error("need a port or --input")
+
+    print(rec.summary(), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
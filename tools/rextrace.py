@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Pull and inspect Robo Rex command/servo traces (src/Recorder.h).
+
+Traces come from the host build (REX_RECORD=<file>) or from the robot's
+RAM buffer (REC_START ... REC_STOP, then `pull`, which sends REC_DUMP).
+replay/ checks a trace against the current firmware.
+
+Usage:
+    python3 tools/rextrace.py pull /dev/ttyACM0 -o golden.rxt
+    python3 tools/rextrace.py show golden.rxt [--servos]
+"""
+
+import argparse
+import sys
+import time
+
+MAGIC = b"RXT1"
+TAG_LINE, TAG_FRAME, TAG_SERVOS = 1, 2, 3
+SERVO_COUNT = 16
+
+
+def varint(buf, pos):
+    value, shift = 0, 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+def records(buf):
+    """Yield (time_us, tag, payload) where payload is bytes or the pulse list."""
+    if buf[:4] != MAGIC:
+        raise ValueError("not a trace (bad magic)")
+    pos, t = 4, 0
+    pulses = [0] * SERVO_COUNT
+    while pos < len(buf):
+        tag = buf[pos]
+        dt, pos = varint(buf, pos + 1)
+        t += dt
+        if tag in (TAG_LINE, TAG_FRAME):
+            _wait, pos = varint(buf, pos)
+            n, pos = varint(buf, pos)
+            yield t, tag, bytes(buf[pos:pos + n])
+            pos += n
+        elif tag == TAG_SERVOS:
+            mask = buf[pos] | (buf[pos + 1] << 8)
+            pos += 2
+            for ch in range(SERVO_COUNT):
+                if mask & (1 << ch):
+                    z, pos = varint(buf, pos)
+                    pulses[ch] += (z >> 1) ^ -(z & 1)
+            yield t, tag, list(pulses)
+        else:
+            raise ValueError("unknown record tag %d at byte %d" % (tag, pos - 1))
+
+
+def cmd_pull(args):
+    from rexproto import open_port
+
+    ser = open_port(args.port, timeout=0.1)
+    ser.write(b"REC_DUMP\n")
+    data, buf = bytearray(), b""
+    deadline = time.monotonic() + args.timeout
+    while time.monotonic() < deadline:
+        buf += ser.read(4096)
+        while b"\n" in buf:
+            raw, buf = buf.split(b"\n", 1)
+            line = raw.decode("ascii", "replace").strip()
+            if line.startswith("REC_END"):
+                size = int(line.split()[1])
+                if size != len(data):
+                    print("size mismatch: device %d, received %d" % (size, len(data)), file=sys.stderr)
+                    return 1
+                with open(args.output, "wb") as f:
+                    f.write(data)
+                print("%s: %d bytes" % (args.output, size))
+                return 0
+            if line.startswith("REC "):
+                data += bytes.fromhex(line[4:])
+    print("timed out waiting for REC_END", file=sys.stderr)
+    return 1
+
+
+def cmd_show(args):
+    with open(args.file, "rb") as f:
+        buf = f.read()
+    counts = {TAG_LINE: 0, TAG_FRAME: 0, TAG_SERVOS: 0}
+    end = 0
+    for t, tag, payload in records(buf):
+        counts[tag] += 1
+        end = t
+        if tag == TAG_LINE:
+            print("%10.3f  line   %s" % (t / 1e6, payload.decode("utf-8", "replace")))
+        elif tag == TAG_FRAME:
+            print("%10.3f  frame  %d bytes" % (t / 1e6, len(payload)))
+        elif args.servos:
+            print("%10.3f  servos %s" % (t / 1e6, " ".join("%4d" % us for us in payload)))
+    print("%d bytes, %.3f s: %d lines, %d frames, %d servo states (%.0f bytes/s)" %
+          (len(buf), end / 1e6, counts[TAG_LINE], counts[TAG_FRAME], counts[TAG_SERVOS],
+           len(buf) / (end / 1e6) if end else 0.0))
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("pull", help="download the robot's RAM trace")
+    p.add_argument("port")
+    p.add_argument("-o", "--output", required=True)
+    p.add_argument("--timeout", type=float, default=30.0)
+    p.set_defaults(fn=cmd_pull)
+
+    p = sub.add_parser("show", help="list the records of a trace file")
+    p.add_argument("file")
+    p.add_argument("--servos", action="store_true", help="also print every servo state")
+    p.set_defaults(fn=cmd_show)
+
+    args = ap.parse_args()
+    sys.exit(args.fn(args))
+
+
+if __name__ == "__main__":
+    main()